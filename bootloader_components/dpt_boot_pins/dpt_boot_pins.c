@@ -0,0 +1,38 @@
+/**
+ * @file dpt_boot_pins.c
+ * @brief Gate outputs to their idle levels from the start of the bootloader
+ *
+ * From reset the output pins are inputs without pulls, and the app only
+ * drives them once app_main() runs, after the bootloader has loaded it.
+ * This hook drives them from the first moment the second-stage bootloader
+ * runs, a few milliseconds after reset. The app takes the pins over at the
+ * same levels (dpt_rmt_pins_safe()), so there is no edge in between.
+ * Before this hook runs, only external pull resistors keep the gates off.
+ */
+
+#include "esp_rom_gpio.h"
+#include "hal/gpio_ll.h"
+#include "soc/gpio_sig_map.h"
+#include "soc/gpio_struct.h"
+
+// Must match RMT_TX_GPIO_P/N in src/dpt_rmt.h and DPT_IDLE_LEVEL_P/N in src/dpt_plan.h
+#define BOOT_GPIO_P         7
+#define BOOT_GPIO_N         8
+#define BOOT_IDLE_LEVEL_P   0
+#define BOOT_IDLE_LEVEL_N   1
+
+void dpt_boot_pins_include(void) {
+}
+
+static void drive_idle(uint32_t gpio_num, uint32_t level) {
+    // Output register first, so enabling the output drives the idle level at once
+    gpio_ll_set_level(&GPIO, gpio_num, level);
+    esp_rom_gpio_pad_select_gpio(gpio_num);
+    esp_rom_gpio_connect_out_signal(gpio_num, SIG_GPIO_OUT_IDX, false, false);
+    gpio_ll_output_enable(&GPIO, gpio_num);
+}
+
+void bootloader_before_init(void) {
+    drive_idle(BOOT_GPIO_P, BOOT_IDLE_LEVEL_P);
+    drive_idle(BOOT_GPIO_N, BOOT_IDLE_LEVEL_N);
+}
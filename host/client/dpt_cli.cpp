@@ -0,0 +1,153 @@
+/**
+ * @file dpt_cli.cpp
+ * @brief Command-line front end for the DPT host client library
+ *
+ * Usage:
+ *   dpt_cli [-h host] [-p port] [-n max_in_flight] status
+ *   dpt_cli ... set <p1h> <p1l> <p2h> <p2l>
+ *   dpt_cli ... fire [count]
+ *   dpt_cli ... plan
+ *   dpt_cli ... upload <plan.bin>
+ *   dpt_cli ... sweep <p1h|p1l|p2h|p2l> <start> <stop> <step>
+ *
+ * A sweep pipelines one set + fire pair per point on a single connection.
+ */
+
+#include "dpt_client.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+static void usage() {
+    fprintf(stderr,
+            "usage: dpt_cli [-h host] [-p port] [-n max_in_flight] <command>\n"
+            "  status\n"
+            "  set <p1h> <p1l> <p2h> <p2l>\n"
+            "  fire [count]\n"
+            "  plan\n"
+            "  upload <plan.bin>\n"
+            "  sweep <p1h|p1l|p2h|p2l> <start> <stop> <step>\n");
+}
+
+static void print_status(const dpt::Status &s) {
+    printf("p1h=%.3f p1l=%.3f p2h=%.3f p2l=%.3f us\n", s.p1h_us, s.p1l_us, s.p2h_us, s.p2l_us);
+    printf("source=%s hash=0x%08x items=%u total_ticks=%llu shots=%u free_heap=%u\n", s.source.c_str(),
+           s.hash, s.items, (unsigned long long)s.total_ticks, s.shots, s.free_heap);
+}
+
+int main(int argc, char **argv) {
+    std::string host = "192.168.4.1";
+    uint16_t port = 80;
+    size_t in_flight = 8;
+
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i += 2) {
+        if (i + 1 >= argc) {
+            usage();
+            return 2;
+        }
+        if (strcmp(argv[i], "-h") == 0) {
+            host = argv[i + 1];
+        } else if (strcmp(argv[i], "-p") == 0) {
+            port = (uint16_t)atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "-n") == 0) {
+            in_flight = (size_t)atoi(argv[i + 1]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (i >= argc) {
+        usage();
+        return 2;
+    }
+    std::string cmd = argv[i++];
+    int nargs = argc - i;
+
+    try {
+        dpt::Client client(host, port, in_flight);
+
+        if (cmd == "status") {
+            print_status(client.status().get());
+        } else if (cmd == "set" && nargs == 4) {
+            dpt::DoublePulse dp{ atof(argv[i]), atof(argv[i + 1]), atof(argv[i + 2]), atof(argv[i + 3]) };
+            dpt::Response r = client.set(dp).get();
+            printf("%d %s\n", r.status, r.body.c_str());
+        } else if (cmd == "fire" && nargs <= 1) {
+            int count = nargs ? atoi(argv[i]) : 1;
+            std::vector<std::future<dpt::Response>> shots;
+            for (int k = 0; k < count; k++) {
+                shots.push_back(client.fire());
+            }
+            for (auto &f : shots) {
+                dpt::Response r = f.get();
+                printf("%d %s\n", r.status, r.body.c_str());
+            }
+        } else if (cmd == "plan" && nargs == 0) {
+            dpt::EdgeList list = client.plan().get();
+            printf("hash=0x%08x total_ticks=%u\n", list.hash, list.total_ticks);
+            for (size_t ch = 0; ch < list.channels.size(); ch++) {
+                const dpt::ChannelEdges &c = list.channels[ch];
+                printf("channel %zu: gpio=%u idle=%u items=%u edges=%zu\n", ch, c.gpio, c.idle, c.items, c.edges.size());
+                for (const dpt::Edge &e : c.edges) {
+                    printf("  %10u %u\n", e.tick, e.level);
+                }
+            }
+        } else if (cmd == "upload" && nargs == 1) {
+            std::ifstream in(argv[i], std::ios::binary);
+            if (!in) {
+                fprintf(stderr, "dpt_cli: cannot read %s\n", argv[i]);
+                return 1;
+            }
+            std::string blob((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            dpt::Response r = client.upload(blob).get();
+            printf("%d %s\n", r.status, r.body.c_str());
+            if (!r.ok()) {
+                return 1;
+            }
+        } else if (cmd == "sweep" && nargs == 4) {
+            std::string param = argv[i];
+            double start = atof(argv[i + 1]), stop = atof(argv[i + 2]), step = atof(argv[i + 3]);
+            if (step <= 0) {
+                usage();
+                return 2;
+            }
+            dpt::DoublePulse dp;
+            std::vector<std::future<dpt::Response>> replies;
+            auto t0 = std::chrono::steady_clock::now();
+            for (double v = start; v <= stop + step * 1e-6; v += step) {
+                if (param == "p1h") dp.p1h_us = v;
+                else if (param == "p1l") dp.p1l_us = v;
+                else if (param == "p2h") dp.p2h_us = v;
+                else if (param == "p2l") dp.p2l_us = v;
+                else {
+                    usage();
+                    return 2;
+                }
+                replies.push_back(client.set(dp));
+                replies.push_back(client.fire());
+            }
+            int failed = 0;
+            for (auto &f : replies) {
+                failed += f.get().ok() ? 0 : 1;
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            printf("%zu points in %.1f ms (%d failed requests)\n", replies.size() / 2, ms, failed);
+            return failed ? 1 : 0;
+        } else {
+            usage();
+            return 2;
+        }
+    } catch (const std::exception &e) {
+        fprintf(stderr, "dpt_cli: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
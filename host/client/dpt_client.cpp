@@ -0,0 +1,393 @@
+/**
+ * @file dpt_client.cpp
+ * @brief Host client library for the DPT signal generator
+ */
+
+#include "dpt_client.hpp"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace dpt {
+
+// ---------------------- Recipes ----------------------
+std::string DoublePulse::encode() const {
+    char buf[160];
+    snprintf(buf, sizeof(buf), "p1h=%.4f&p1l=%.4f&p2h=%.4f&p2l=%.4f", p1h_us, p1l_us, p2h_us, p2l_us);
+    return buf;
+}
+
+// ---------------------- Responses ----------------------
+// Minimal lookup of "key":value in a flat JSON object
+static const char *json_value(const std::string &json, const char *key) {
+    std::string needle = std::string("\"") + key + "\":";
+    size_t pos = json.find(needle);
+    if (pos == std::string::npos) {
+        return nullptr;
+    }
+    const char *v = json.c_str() + pos + needle.size();
+    while (*v == ' ') {
+        v++;
+    }
+    if (*v == '"') {
+        v++;
+    }
+    return v;
+}
+
+static double json_number(const std::string &json, const char *key) {
+    const char *v = json_value(json, key);
+    return v ? strtod(v, nullptr) : 0.0;
+}
+
+Status Status::parse(const std::string &json) {
+    Status s;
+    s.p1h_us = json_number(json, "p1h");
+    s.p1l_us = json_number(json, "p1l");
+    s.p2h_us = json_number(json, "p2h");
+    s.p2l_us = json_number(json, "p2l");
+    if (const char *v = json_value(json, "source")) {
+        s.source.assign(v, strcspn(v, "\""));
+    }
+    if (const char *v = json_value(json, "hash")) {
+        s.hash = (uint32_t)strtoul(v, nullptr, 16);
+    }
+    s.items = (uint32_t)json_number(json, "items");
+    if (const char *v = json_value(json, "total_ticks")) {
+        s.total_ticks = strtoull(v, nullptr, 10);
+    }
+    s.shots = (uint32_t)json_number(json, "shots");
+    if (const char *v = json_value(json, "uptime_us")) {
+        s.uptime_us = strtoll(v, nullptr, 10);
+    }
+    s.free_heap = (uint32_t)json_number(json, "free_heap");
+    return s;
+}
+
+static uint16_t get_u16(const std::string &b, size_t off) {
+    return (uint16_t)((uint8_t)b[off] | ((uint8_t)b[off + 1] << 8));
+}
+
+static uint32_t get_u32(const std::string &b, size_t off) {
+    return (uint32_t)get_u16(b, off) | ((uint32_t)get_u16(b, off + 2) << 16);
+}
+
+EdgeList EdgeList::decode(const std::string &bin) {
+    if (bin.size() < 16 || bin.compare(0, 4, "DPTE") != 0 || (uint8_t)bin[4] != 1) {
+        throw std::runtime_error("not a version 1 DPTE edge list");
+    }
+    EdgeList list;
+    uint8_t channels = (uint8_t)bin[5];
+    list.hash = get_u32(bin, 8);
+    list.total_ticks = get_u32(bin, 12);
+
+    size_t off = 16;
+    for (uint8_t ch = 0; ch < channels; ch++) {
+        if (off + 8 > bin.size()) {
+            throw std::runtime_error("truncated channel header");
+        }
+        ChannelEdges c;
+        c.items = get_u16(bin, off);
+        c.gpio = (uint8_t)bin[off + 2];
+        c.idle = (uint8_t)bin[off + 3];
+        uint32_t count = get_u32(bin, off + 4);
+        off += 8;
+        if (off + (size_t)count * 4 > bin.size()) {
+            throw std::runtime_error("truncated edge array");
+        }
+        c.edges.reserve(count);
+        for (uint32_t i = 0; i < count; i++, off += 4) {
+            uint32_t e = get_u32(bin, off);
+            c.edges.push_back({ e >> 1, (uint8_t)(e & 1) });
+        }
+        list.channels.push_back(std::move(c));
+    }
+    return list;
+}
+
+// ---------------------- Client ----------------------
+Client::Client(std::string host, uint16_t port, size_t max_in_flight)
+    : host_(std::move(host)), port_(port), max_in_flight_(max_in_flight ? max_in_flight : 1) {
+    reader_ = std::thread(&Client::reader_loop, this);
+}
+
+Client::~Client() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        stopping_ = true;
+        if (fd_ >= 0) {
+            shutdown(fd_, SHUT_RDWR);  // Unblock the reader
+        }
+    }
+    cv_.notify_all();
+    reader_.join();
+
+    std::lock_guard<std::mutex> lk(mutex_);
+    fail_pending_locked("client destroyed");
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+void Client::connect_locked() {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *res = nullptr;
+    std::string port = std::to_string(port_);
+    if (getaddrinfo(host_.c_str(), port.c_str(), &hints, &res) != 0) {
+        throw std::runtime_error("cannot resolve " + host_);
+    }
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd < 0) {
+        throw std::runtime_error("cannot connect to " + host_ + ":" + port);
+    }
+
+    // Small requests must not wait for Nagle
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fd_ = fd;
+}
+
+void Client::fail_pending_locked(const std::string &why) {
+    while (!pending_.empty()) {
+        pending_.front().promise.set_exception(std::make_exception_ptr(std::runtime_error(why)));
+        pending_.pop_front();
+    }
+    cv_.notify_all();
+}
+
+std::future<Response> Client::request(const std::string &method, const std::string &path,
+                                      const std::string &body, const std::string &content_type) {
+    std::string req = method + " " + path + " HTTP/1.1\r\nHost: " + host_ + "\r\nConnection: keep-alive\r\n";
+    if (!body.empty() || method == "POST") {
+        if (!content_type.empty()) {
+            req += "Content-Type: " + content_type + "\r\n";
+        }
+        req += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    req += "\r\n";
+    req += body;
+
+    std::unique_lock<std::mutex> lk(mutex_);
+    cv_.wait(lk, [&] { return stopping_ || pending_.size() < max_in_flight_; });
+
+    std::promise<Response> failed;
+    if (stopping_) {
+        failed.set_exception(std::make_exception_ptr(std::runtime_error("client destroyed")));
+        return failed.get_future();
+    }
+    if (fd_ < 0) {
+        // The reader closes dead connections; only reconnect when nothing is in flight
+        cv_.wait(lk, [&] { return stopping_ || pending_.empty(); });
+        if (fd_ < 0) {
+            try {
+                connect_locked();
+            } catch (...) {
+                failed.set_exception(std::current_exception());
+                return failed.get_future();
+            }
+        }
+    }
+
+    pending_.emplace_back();
+    std::future<Response> fut = pending_.back().promise.get_future();
+
+    // Write while holding the lock so pipelined requests stay in promise order
+    size_t sent = 0;
+    while (sent < req.size()) {
+        ssize_t n = send(fd_, req.data() + sent, req.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            // The reader sees the shutdown and fails everything in flight
+            shutdown(fd_, SHUT_RDWR);
+            break;
+        }
+        sent += (size_t)n;
+    }
+    cv_.notify_all();
+    return fut;
+}
+
+std::future<Response> Client::set(const DoublePulse &recipe) {
+    return request("POST", "/set", recipe.encode(), "application/x-www-form-urlencoded");
+}
+
+std::future<Response> Client::fire() {
+    return request("GET", "/trigger");
+}
+
+std::future<Status> Client::status() {
+    std::shared_future<Response> f = request("GET", "/status").share();
+    return std::async(std::launch::deferred, [f] { return Status::parse(f.get().body); });
+}
+
+std::future<EdgeList> Client::plan() {
+    std::shared_future<Response> f = request("GET", "/plan?format=bin").share();
+    return std::async(std::launch::deferred, [f] { return EdgeList::decode(f.get().body); });
+}
+
+std::future<Response> Client::upload(const std::string &blob) {
+    return request("POST", "/plan", blob, "application/octet-stream");
+}
+
+void Client::wait_idle() {
+    std::unique_lock<std::mutex> lk(mutex_);
+    cv_.wait(lk, [&] { return stopping_ || pending_.empty(); });
+}
+
+// ---------------------- Reader ----------------------
+bool Client::fill(int fd) {
+    char tmp[4096];
+    ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+    if (n <= 0) {
+        return false;
+    }
+    rbuf_.append(tmp, (size_t)n);
+    return true;
+}
+
+bool Client::read_response(int fd, Response &resp, bool &close_after) {
+    size_t hdr_end;
+    while ((hdr_end = rbuf_.find("\r\n\r\n")) == std::string::npos) {
+        if (!fill(fd)) {
+            return false;
+        }
+    }
+    std::string head = rbuf_.substr(0, hdr_end);
+    rbuf_.erase(0, hdr_end + 4);
+
+    // Status line: HTTP/1.1 200 OK
+    size_t sp = head.find(' ');
+    if (sp == std::string::npos) {
+        return false;
+    }
+    resp.status = atoi(head.c_str() + sp + 1);
+
+    long content_length = -1;
+    bool chunked = false;
+    close_after = false;
+    size_t pos = head.find("\r\n");
+    while (pos != std::string::npos && pos < head.size()) {
+        size_t next = head.find("\r\n", pos + 2);
+        std::string line = head.substr(pos + 2, next == std::string::npos ? std::string::npos : next - pos - 2);
+        size_t colon = line.find(':');
+        if (colon != std::string::npos) {
+            std::string name = line.substr(0, colon);
+            std::string value = line.substr(colon + 1);
+            value.erase(0, value.find_first_not_of(' '));
+            for (auto &c : name) {
+                c = (char)tolower((unsigned char)c);
+            }
+            if (name == "content-length") {
+                content_length = atol(value.c_str());
+            } else if (name == "transfer-encoding" && value.find("chunked") != std::string::npos) {
+                chunked = true;
+            } else if (name == "connection" && value.find("close") != std::string::npos) {
+                close_after = true;
+            } else if (name == "content-type") {
+                resp.content_type = value;
+            }
+        }
+        pos = next;
+    }
+
+    if (chunked) {
+        for (;;) {
+            size_t eol;
+            while ((eol = rbuf_.find("\r\n")) == std::string::npos) {
+                if (!fill(fd)) {
+                    return false;
+                }
+            }
+            size_t len = strtoul(rbuf_.c_str(), nullptr, 16);
+            while (rbuf_.size() < eol + 2 + len + 2) {
+                if (!fill(fd)) {
+                    return false;
+                }
+            }
+            resp.body.append(rbuf_, eol + 2, len);
+            rbuf_.erase(0, eol + 2 + len + 2);
+            if (len == 0) {
+                break;
+            }
+        }
+    } else if (content_length >= 0) {
+        while (rbuf_.size() < (size_t)content_length) {
+            if (!fill(fd)) {
+                return false;
+            }
+        }
+        resp.body = rbuf_.substr(0, (size_t)content_length);
+        rbuf_.erase(0, (size_t)content_length);
+    } else {
+        // No framing: the body runs to the end of the connection
+        while (fill(fd)) {
+        }
+        resp.body.swap(rbuf_);
+        rbuf_.clear();
+        close_after = true;
+    }
+    return true;
+}
+
+void Client::reader_loop() {
+    std::unique_lock<std::mutex> lk(mutex_);
+    for (;;) {
+        cv_.wait(lk, [&] { return stopping_ || (!pending_.empty() && fd_ >= 0); });
+        if (stopping_) {
+            return;
+        }
+        int fd = fd_;
+        lk.unlock();
+
+        Response resp;
+        bool close_after = false;
+        bool ok = read_response(fd, resp, close_after);
+
+        lk.lock();
+        if (!ok) {
+            fail_pending_locked("connection lost");
+        } else {
+            std::promise<Response> p = std::move(pending_.front().promise);
+            pending_.pop_front();
+            if (close_after) {
+                // Anything pipelined behind this response was never answered
+                fail_pending_locked("server closed the connection");
+            }
+            cv_.notify_all();
+            lk.unlock();
+            p.set_value(std::move(resp));
+            lk.lock();
+        }
+        if (!ok || close_after) {
+            close(fd);
+            fd_ = -1;
+            rbuf_.clear();
+        }
+    }
+}
+
+} // namespace dpt
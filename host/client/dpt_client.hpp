@@ -0,0 +1,129 @@
+/**
+ * @file dpt_client.hpp
+ * @brief Host client library for the DPT signal generator
+ *
+ * Keeps one HTTP/1.1 connection open and pipelines requests on it: every
+ * call writes its request immediately and returns a future, and a reader
+ * thread completes the futures in order as responses arrive. Up to
+ * max_in_flight requests may be outstanding before callers block.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dpt {
+
+// ---------------------- Recipes ----------------------
+// Classic double pulse; times in microseconds, as accepted by POST /set
+struct DoublePulse {
+    double p1h_us = 5.0;
+    double p1l_us = 1.0;
+    double p2h_us = 3.0;
+    double p2l_us = 10000.0;
+
+    // application/x-www-form-urlencoded body for POST /set
+    std::string encode() const;
+};
+
+// ---------------------- Responses ----------------------
+struct Response {
+    int status = 0;
+    std::string content_type;
+    std::string body;
+
+    bool ok() const { return status >= 200 && status < 300; }
+};
+
+// GET /status
+struct Status {
+    double p1h_us = 0, p1l_us = 0, p2h_us = 0, p2l_us = 0;
+    std::string source;         // "params", "upload" or "baked"
+    uint32_t hash = 0;
+    uint32_t items = 0;
+    uint64_t total_ticks = 0;
+    uint32_t shots = 0;
+    int64_t uptime_us = 0;
+    uint32_t free_heap = 0;
+
+    static Status parse(const std::string &json);
+};
+
+// GET /plan?format=bin
+struct Edge {
+    uint32_t tick;
+    uint8_t level;
+};
+
+struct ChannelEdges {
+    uint16_t items = 0;
+    uint8_t gpio = 0;
+    uint8_t idle = 0;
+    std::vector<Edge> edges;
+};
+
+struct EdgeList {
+    uint32_t hash = 0;
+    uint32_t total_ticks = 0;
+    std::vector<ChannelEdges> channels;
+
+    // Throws std::runtime_error on a malformed buffer
+    static EdgeList decode(const std::string &bin);
+};
+
+// ---------------------- Client ----------------------
+class Client {
+public:
+    explicit Client(std::string host, uint16_t port = 80, size_t max_in_flight = 8);
+    ~Client();
+
+    Client(const Client &) = delete;
+    Client &operator=(const Client &) = delete;
+
+    std::future<Response> set(const DoublePulse &recipe);
+    std::future<Response> fire();
+    std::future<Status> status();
+    std::future<EdgeList> plan();
+    // Arm a binary plan produced by dptc (POST /plan)
+    std::future<Response> upload(const std::string &blob);
+
+    // Generic request; body is sent as-is with the given content type
+    std::future<Response> request(const std::string &method, const std::string &path,
+                                  const std::string &body = "", const std::string &content_type = "");
+
+    // Block until every outstanding request has completed
+    void wait_idle();
+
+private:
+    struct Pending {
+        std::promise<Response> promise;
+    };
+
+    void connect_locked();
+    void fail_pending_locked(const std::string &why);
+    void reader_loop();
+    bool read_response(int fd, Response &resp, bool &close_after);
+    bool fill(int fd);
+
+    std::string host_;
+    uint16_t port_;
+    size_t max_in_flight_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Pending> pending_;
+    int fd_ = -1;               // Closed by the reader thread only
+    bool stopping_ = false;
+
+    std::string rbuf_;          // Reader thread only
+    std::thread reader_;
+};
+
+} // namespace dpt
@@ -0,0 +1,553 @@
+/**
+ * @file dptc.c
+ * @brief Host-side recipe compiler for the DPT signal generator
+ *
+ * Compiles a recipe file with the firmware's own plan compiler
+ * (src/dpt_plan.c) into a device-ready binary plan, and prints a
+ * feasibility report. The device only has to validate the upload.
+ *
+ * Usage: dptc [-o plan.bin] [-q] [-s] recipe.txt
+ *        dptc -c baked.c [-q] [-s] recipe.txt...
+ *
+ * With -s the plan is also sent through the simulated RMT of the emulator
+ * HAL, and the captured edges are checked against the plan and, for
+ * carrier channels, against the gate edges they must be aligned to.
+ *
+ * With -c the compiled plans are written as a C source of const plans
+ * for the firmware (see src/dpt_baked.h), one per recipe, named after
+ * the recipe file without its extension. The build runs this on
+ * recipes/ so the device fires them without compiling anything. If any
+ * recipe fails, nothing is written.
+ *
+ * Recipe files hold one directive per line; times are in microseconds
+ * unless noted, and '#' starts a comment:
+ *
+ *   double_pulse <p1h> <p1l> <p2h> <p2l>   Same as the web form
+ *   high <us>                              Positive output high
+ *   low <us>                               Positive output low
+ *   burst <count> <high> <low>             count x (high, low)
+ *   spwm <carrier_hz> <fund_hz> <index> <cycles>
+ *                                          Centre-aligned sine PWM
+ *   dead_time <ns>                         Applied once, after all segments
+ *   carrier <p|n|pn> <freq_hz> <duty_%>    Modulates the channels' on-time,
+ *                                          applied after the dead time
+ *
+ * The negative output is the complement of the positive one, with both
+ * held low for the dead time around every transition.
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "host_sim.h"
+#include "dpt_plan.h"
+#include "dpt_rmt.h"
+
+// carrier directive
+typedef struct {
+    uint8_t channels;               // Bit per DPT_CHANNEL_x
+    double freq_hz;
+    double duty;                    // Percent
+    uint32_t period_ticks;
+    uint32_t high_ticks;
+} carrier_cfg_t;
+
+static dpt_recipe_t recipe;
+static dpt_recipe_t gates;          // Recipe before the carrier was applied
+static carrier_cfg_t carrier;
+static dpt_plan_t plan;
+static uint8_t blob[DPT_BLOB_MAX_SIZE];
+
+// ---------------------- Recipe Parsing ----------------------
+static int parse_error(const char *path, int line, const char *msg) {
+    fprintf(stderr, "%s:%d: %s\n", path, line, msg);
+    return -1;
+}
+
+static esp_err_t add_us(uint8_t level, double us) {
+    return dpt_recipe_add(&recipe, level, dpt_us_to_ticks((float)us));
+}
+
+// Centre-aligned sine PWM: one low/high/low triple per carrier period
+static esp_err_t add_spwm(double carrier_hz, double fund_hz, double index, double cycles) {
+    uint32_t period = (uint32_t)(DPT_TICKS_PER_US * 1e6 / carrier_hz + 0.5);
+    uint32_t periods = (uint32_t)(carrier_hz / fund_hz * cycles + 0.5);
+    for (uint32_t i = 0; i < periods; i++) {
+        double t = (i + 0.5) / carrier_hz;
+        double duty = 0.5 * (1.0 + index * sin(2.0 * M_PI * fund_hz * t));
+        uint32_t high = (uint32_t)(duty * period + 0.5);
+        uint32_t low1 = (period - high) / 2;
+        uint32_t low2 = period - high - low1;
+        esp_err_t err = dpt_recipe_add(&recipe, 0, low1);
+        if (err == ESP_OK) err = dpt_recipe_add(&recipe, 1, high);
+        if (err == ESP_OK) err = dpt_recipe_add(&recipe, 0, low2);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+static int load_recipe(const char *path, double *dead_ns) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "dptc: %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    char buf[256];
+    int line = 0;
+    int rc = 0;
+    memset(&recipe, 0, sizeof(recipe));
+    memset(&carrier, 0, sizeof(carrier));
+    *dead_ns = 0;
+    while (rc == 0 && fgets(buf, sizeof(buf), f)) {
+        line++;
+        char *hash = strchr(buf, '#');
+        if (hash) {
+            *hash = '\0';
+        }
+        char cmd[32];
+        double a[4];
+        int n = sscanf(buf, "%31s %lf %lf %lf %lf", cmd, &a[0], &a[1], &a[2], &a[3]);
+        if (n <= 0) {
+            continue;
+        }
+
+        esp_err_t err = ESP_OK;
+        if (strcmp(cmd, "double_pulse") == 0 && n == 5) {
+            err = add_us(1, a[0]);
+            if (err == ESP_OK) err = add_us(0, a[1]);
+            if (err == ESP_OK) err = add_us(1, a[2]);
+            if (err == ESP_OK) err = add_us(0, a[3]);
+        } else if (strcmp(cmd, "high") == 0 && n == 2) {
+            err = add_us(1, a[0]);
+        } else if (strcmp(cmd, "low") == 0 && n == 2) {
+            err = add_us(0, a[0]);
+        } else if (strcmp(cmd, "burst") == 0 && n == 4 && a[0] >= 1) {
+            for (int i = 0; i < (int)a[0] && err == ESP_OK; i++) {
+                err = add_us(1, a[1]);
+                if (err == ESP_OK) err = add_us(0, a[2]);
+            }
+        } else if (strcmp(cmd, "spwm") == 0 && n == 5 && a[0] > 0 && a[1] > 0 && a[2] >= 0 && a[2] <= 1) {
+            err = add_spwm(a[0], a[1], a[2], a[3]);
+        } else if (strcmp(cmd, "dead_time") == 0 && n == 2 && a[0] >= 0) {
+            *dead_ns = a[0];
+        } else if (strcmp(cmd, "carrier") == 0) {
+            char chans[8];
+            if (sscanf(buf, "%*s %7s %lf %lf", chans, &carrier.freq_hz, &carrier.duty) != 3 ||
+                strspn(chans, "pn") != strlen(chans) || carrier.freq_hz <= 0 ||
+                carrier.duty <= 0 || carrier.duty >= 100) {
+                rc = parse_error(path, line, "expected: carrier <p|n|pn> <freq_hz> <duty_percent>");
+            } else {
+                carrier.channels = (strchr(chans, 'p') ? 1 << DPT_CHANNEL_P : 0) |
+                                   (strchr(chans, 'n') ? 1 << DPT_CHANNEL_N : 0);
+                carrier.period_ticks = (uint32_t)(DPT_TICKS_PER_US * 1e6 / carrier.freq_hz + 0.5);
+                carrier.high_ticks = (uint32_t)(carrier.period_ticks * carrier.duty / 100.0 + 0.5);
+            }
+        } else {
+            rc = parse_error(path, line, "unknown directive or wrong argument count");
+        }
+        if (err != ESP_OK) {
+            rc = parse_error(path, line, "too many segments for one plan");
+        }
+    }
+    fclose(f);
+    if (rc == 0 && recipe.num_segments == 0) {
+        rc = parse_error(path, line, "recipe has no segments");
+    }
+    return rc;
+}
+
+// ---------------------- Feasibility Report ----------------------
+static int report(const char *path, esp_err_t dead_err, esp_err_t carrier_err, esp_err_t compile_err,
+                  size_t blob_size, bool quiet) {
+    int errors = 0;
+    uint32_t min_high = UINT32_MAX, min_low = UINT32_MAX;
+    uint64_t total = 0;
+    for (uint16_t k = 0; k < recipe.num_segments; k++) {
+        const dpt_segment_t *seg = &recipe.seg[k];
+        total += seg->ticks;
+        if (seg->level && seg->ticks < min_high) min_high = seg->ticks;
+        if (!seg->level && seg->ticks < min_low) min_low = seg->ticks;
+    }
+
+    if (!quiet) {
+        printf("recipe:       %s\n", path);
+        printf("segments:     %u (max %d)\n", recipe.num_segments, DPT_MAX_SEGMENTS);
+        printf("dead time:    %u ticks (%.1f ns)\n", recipe.dead_ticks, recipe.dead_ticks * 12.5);
+        if (carrier.channels) {
+            printf("carrier:      %s%s, %u/%u ticks high (%.1f kHz, %.1f%%)\n",
+                   carrier.channels & (1 << DPT_CHANNEL_P) ? "P" : "", carrier.channels & (1 << DPT_CHANNEL_N) ? "N" : "",
+                   carrier.high_ticks, carrier.period_ticks, DPT_TICKS_PER_US * 1e3 / carrier.period_ticks,
+                   100.0 * carrier.high_ticks / carrier.period_ticks);
+        }
+        printf("duration:     %llu ticks (%.3f us)\n", (unsigned long long)total, total / (double)DPT_TICKS_PER_US);
+        if (min_high != UINT32_MAX) printf("min high:     %u ticks (%.3f us)\n", min_high, min_high / (double)DPT_TICKS_PER_US);
+        if (min_low != UINT32_MAX) printf("min low:      %u ticks (%.3f us)\n", min_low, min_low / (double)DPT_TICKS_PER_US);
+    }
+
+    if (dead_err != ESP_OK) {
+        fprintf(stderr, "error: dead time does not fit: %s\n",
+                dead_err == ESP_ERR_INVALID_ARG ? "a low segment is shorter than its dead bands"
+                                                : "too many segments after inserting dead bands");
+        return 1;
+    }
+    if (carrier_err != ESP_OK) {
+        fprintf(stderr, "error: carrier does not fit: %s\n",
+                carrier_err == ESP_ERR_INVALID_ARG ? "high time must be at least the minimum pulse and less than the period"
+                                                   : "too many segments after modulation");
+        return 1;
+    }
+    if (min_high < DPT_MIN_TICKS_HIGH) {
+        fprintf(stderr, "error: high segment of %u ticks is below the %d tick minimum\n", min_high, DPT_MIN_TICKS_HIGH);
+        errors++;
+    }
+    if (compile_err != ESP_OK) {
+        fprintf(stderr, "error: compile failed: %s%s\n", esp_err_to_name(compile_err),
+                compile_err == ESP_ERR_INVALID_SIZE ? " (more item words than a plan can hold)" : "");
+        return 1;
+    }
+
+    dpt_rmt_layout_t layout;
+    dpt_rmt_layout_for(&plan, &layout);
+    bool direct = plan.num_words[DPT_CHANNEL_P] <= layout.blocks[DPT_CHANNEL_P] * RMT_BLOCK_WORDS &&
+                  plan.num_words[DPT_CHANNEL_N] <= layout.blocks[DPT_CHANNEL_N] * RMT_BLOCK_WORDS;
+    if (!quiet) {
+        printf("items:        %u/%u words P/N incl. end marker (max %d)\n", plan.num_words[DPT_CHANNEL_P],
+               plan.num_words[DPT_CHANNEL_N], DPT_PLAN_MAX_WORDS);
+        printf("RMT RAM:      P %u + N %u block(s) of %d words%s\n", layout.blocks[DPT_CHANNEL_P],
+               layout.blocks[DPT_CHANNEL_N], RMT_BLOCK_WORDS,
+               !direct ? " - exceeds TX RAM, sent through driver refill" :
+               dpt_rmt_fits(&plan) ? " - loads directly, fits a trigger preset" : " - loads directly");
+        printf("hash:         0x%08x\n", plan.hash);
+        printf("blob:         %zu bytes\n", blob_size);
+    }
+    return errors ? 1 : 0;
+}
+
+// ---------------------- Simulation ----------------------
+static uint8_t channel_level(const dpt_segment_t *seg, int ch) {
+    return (ch == DPT_CHANNEL_P) ? seg->level : seg->n_level;
+}
+
+// Edges the simulated RMT emitted must be the plan's, one for one
+static int check_edges(int ch, const rmt_sim_capture_t *cap) {
+    dpt_edge_iter_t it;
+    uint32_t tick;
+    uint8_t level;
+    uint32_t k = 0;
+    dpt_edge_iter_init(&it, &plan, ch);
+    while (dpt_edge_iter_next(&it, &tick, &level)) {
+        if (k >= cap->num_edges || cap->edges[k].tick != tick || cap->edges[k].level != level) {
+            fprintf(stderr, "error: sim %c: edge %u is not the planned %s edge at tick %u\n",
+                    "PN"[ch], k, level ? "rising" : "falling", tick);
+            return 1;
+        }
+        k++;
+    }
+    if (k != cap->num_edges) {
+        fprintf(stderr, "error: sim %c: %u edges captured, %u planned\n", "PN"[ch], cap->num_edges, k);
+        return 1;
+    }
+    return 0;
+}
+
+// Every gate on-time must start with a carrier rising edge at the gate
+// edge, and rising edges must then follow at the carrier period
+static int check_carrier(int ch, const rmt_sim_capture_t *cap, bool quiet) {
+    uint32_t bursts = 0, pulses = 0, max_phase = 0;
+    uint32_t min_high = UINT32_MAX, max_high = 0, bad_period = 0;
+    uint32_t t = 0, e = 0;
+
+    for (uint16_t k = 0; k < gates.num_segments; k++) {
+        const dpt_segment_t *seg = &gates.seg[k];
+        uint32_t t0 = t;
+        t += seg->ticks;
+        if (!channel_level(seg, ch) || (k > 0 && channel_level(&gates.seg[k - 1], ch))) {
+            continue;
+        }
+        // The gate stays on through following segments at the same level
+        uint32_t t1 = t;
+        for (uint16_t j = k + 1; j < gates.num_segments && channel_level(&gates.seg[j], ch); j++) {
+            t1 += gates.seg[j].ticks;
+        }
+
+        while (e < cap->num_edges && cap->edges[e].tick < t0) {
+            e++;
+        }
+        if (e >= cap->num_edges || !cap->edges[e].level) {
+            fprintf(stderr, "error: sim %c: no carrier pulse at the gate edge at tick %u\n", "PN"[ch], t0);
+            return 1;
+        }
+        uint32_t phase = cap->edges[e].tick - t0;
+        if (phase > max_phase) max_phase = phase;
+        bursts++;
+
+        uint32_t prev_rise = 0;
+        for (; e < cap->num_edges && cap->edges[e].tick < t1; e++) {
+            if (!cap->edges[e].level) {
+                continue;
+            }
+            uint32_t rise = cap->edges[e].tick;
+            if (rise != t0 && rise - prev_rise != carrier.period_ticks) {
+                bad_period++;
+            }
+            prev_rise = rise;
+            pulses++;
+            // A pulse cut by the gate edge is not a full carrier high
+            uint32_t fall = (e + 1 < cap->num_edges) ? cap->edges[e + 1].tick : cap->total_ticks;
+            if (fall < t1) {
+                uint32_t high = fall - rise;
+                if (high < min_high) min_high = high;
+                if (high > max_high) max_high = high;
+            }
+        }
+    }
+
+    if (!quiet) {
+        printf("sim %c:        %u burst(s), %u carrier pulse(s), phase error %u ticks", "PN"[ch], bursts, pulses, max_phase);
+        if (min_high != UINT32_MAX) {
+            printf(", high %u..%u ticks", min_high, max_high);
+        }
+        printf("\n");
+    }
+    if (max_phase != 0 || bad_period != 0) {
+        fprintf(stderr, "error: sim %c: carrier not aligned to the gate (phase %u ticks, %u period error(s))\n",
+                "PN"[ch], max_phase, bad_period);
+        return 1;
+    }
+    return 0;
+}
+
+// Loads the plan the way the firmware does and transmits it once
+static int simulate(bool quiet) {
+    static rmt_sim_capture_t cap;
+    static bool rmt_ready = false;
+
+    if (!rmt_ready) {
+        esp_log_level_set("*", ESP_LOG_WARN);
+        dpt_rmt_pins_safe();
+        if (dpt_rmt_init() != ESP_OK) {
+            fprintf(stderr, "error: simulated RMT failed to start\n");
+            return 1;
+        }
+        rmt_ready = true;
+    }
+    if (dpt_rmt_claim(0) != ESP_OK || dpt_rmt_load(&plan, false) != ESP_OK ||
+        dpt_rmt_start() != ESP_OK || dpt_rmt_wait_done(1000) != ESP_OK) {
+        fprintf(stderr, "error: simulated transmission failed\n");
+        return 1;
+    }
+    dpt_rmt_release();
+
+    // The load may have moved N to another channel
+    dpt_rmt_layout_t layout;
+    uint32_t changes;
+    dpt_rmt_get_layout(&layout, &changes);
+    int errors = 0;
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        if (!rmt_sim_get_capture((rmt_channel_t)layout.channel[ch], &cap) || cap.truncated) {
+            fprintf(stderr, "error: sim %c: no complete capture\n", "PN"[ch]);
+            errors++;
+            continue;
+        }
+        errors += check_edges(ch, &cap);
+        if (!quiet) {
+            printf("sim %c:        %u edges over %u ticks match the plan\n", "PN"[ch], cap.num_edges, cap.total_ticks);
+        }
+        if (carrier.channels & (1 << ch)) {
+            errors += check_carrier(ch, &cap, quiet);
+        }
+    }
+    return errors ? 1 : 0;
+}
+
+// ---------------------- Baked Plans ----------------------
+// C identifier from the recipe file name: "recipes/spwm_1khz.recipe" -> "spwm_1khz"
+static void baked_name(const char *path, char *name, size_t size) {
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    size_t len = strcspn(base, ".");
+    if (len >= size) {
+        len = size - 1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        name[i] = isalnum((unsigned char)base[i]) ? base[i] : '_';
+    }
+    name[len] = '\0';
+}
+
+static void emit_u16_array(FILE *f, const uint16_t *values, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        fprintf(f, "%s%u%s", i % 16 ? " " : "\n        ", values[i], i + 1 < count ? "," : "");
+    }
+}
+
+static void emit_plan(FILE *f, const char *path, const char *name) {
+    fprintf(f, "// %s: %u segment(s), %u word(s)/channel\n", path, plan.recipe.num_segments,
+            plan.num_words[DPT_CHANNEL_P]);
+    fprintf(f, "static const dpt_plan_t plan_%s = {\n    .words = {", name);
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        fprintf(f, "\n        [%d] = {", ch);
+        for (uint32_t i = 0; i < plan.num_words[ch]; i++) {
+            fprintf(f, "%s0x%08x%s", i % 6 ? " " : "\n            ", plan.words[ch][i],
+                    i + 1 < plan.num_words[ch] ? "," : "");
+        }
+        fprintf(f, "\n        },");
+    }
+    fprintf(f, "\n    },\n    .num_words = { %u, %u },\n", plan.num_words[DPT_CHANNEL_P], plan.num_words[DPT_CHANNEL_N]);
+    fprintf(f, "    .seg_first_half = {");
+    emit_u16_array(f, plan.seg_first_half, plan.recipe.num_segments);
+    fprintf(f, "\n    },\n    .seg_num_halves = {");
+    emit_u16_array(f, plan.seg_num_halves, plan.recipe.num_segments);
+    fprintf(f, "\n    },\n    .recipe = {\n        .seg = {");
+    for (uint16_t k = 0; k < plan.recipe.num_segments; k++) {
+        const dpt_segment_t *seg = &plan.recipe.seg[k];
+        fprintf(f, "%s{ %u, %u, %u }%s", k % 4 ? " " : "\n            ", seg->level, seg->n_level, seg->ticks,
+                k + 1 < plan.recipe.num_segments ? "," : "");
+    }
+    fprintf(f, "\n        },\n        .num_segments = %u,\n        .dead_ticks = %u,\n    },\n",
+            plan.recipe.num_segments, plan.recipe.dead_ticks);
+    fprintf(f, "    .hash = 0x%08x,\n    .dirty_first = %u,\n    .dirty_last = %u,\n};\n\n",
+            plan.hash, plan.dirty_first, plan.dirty_last);
+}
+
+// ---------------------- Compile ----------------------
+// Compiles one recipe into plan/blob and prints its report
+static int compile_recipe(const char *path, bool quiet, size_t *size) {
+    double dead_ns;
+    if (load_recipe(path, &dead_ns) != 0) {
+        return 1;
+    }
+
+    uint32_t dead_ticks = (uint32_t)(dead_ns / 12.5 + 0.5);
+    esp_err_t dead_err = dpt_recipe_apply_dead_time(&recipe, dead_ticks);
+    gates = recipe;
+    esp_err_t carrier_err = ESP_OK;
+    for (int ch = 0; ch < DPT_NUM_CHANNELS && dead_err == ESP_OK && carrier_err == ESP_OK; ch++) {
+        if (carrier.channels & (1 << ch)) {
+            carrier_err = dpt_recipe_apply_carrier(&recipe, ch, carrier.period_ticks, carrier.high_ticks);
+        }
+    }
+    esp_err_t compile_err = (dead_err == ESP_OK && carrier_err == ESP_OK) ? dpt_plan_compile(&plan, &recipe) : ESP_FAIL;
+
+    *size = 0;
+    if (compile_err == ESP_OK) {
+        *size = dpt_plan_serialize(&plan, blob, sizeof(blob));
+        // Run the device's upload check on our own output
+        static dpt_plan_t check;
+        esp_err_t err = dpt_plan_deserialize(&check, blob, *size);
+        if (err != ESP_OK || check.hash != plan.hash) {
+            fprintf(stderr, "error: plan failed verification: %s\n", esp_err_to_name(err));
+            return 1;
+        }
+    }
+    return report(path, dead_err, carrier_err, compile_err, *size, quiet);
+}
+
+static int bake(const char *out_path, char **paths, int num_paths, bool quiet, bool sim) {
+    FILE *f = fopen(out_path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "dptc: %s: %s\n", out_path, strerror(errno));
+        return 1;
+    }
+    fprintf(f, "// Generated by dptc -c from %d recipe(s); do not edit\n\n#include \"dpt_baked.h\"\n\n", num_paths);
+
+    int rc = 0;
+    for (int i = 0; i < num_paths && rc == 0; i++) {
+        char name[64];
+        size_t size;
+        baked_name(paths[i], name, sizeof(name));
+        rc = compile_recipe(paths[i], quiet, &size);
+        if (rc == 0 && sim) {
+            rc = simulate(quiet);
+        }
+        if (rc == 0) {
+            emit_plan(f, paths[i], name);
+        }
+    }
+
+    fprintf(f, "const dpt_baked_recipe_t dpt_baked_recipes[] = {\n");
+    for (int i = 0; i < num_paths; i++) {
+        char name[64];
+        baked_name(paths[i], name, sizeof(name));
+        fprintf(f, "    { \"%s\", &plan_%s },\n", name, name);
+    }
+    if (num_paths == 0) {
+        fprintf(f, "    { NULL, NULL },\n");     // No empty arrays in C
+    }
+    fprintf(f, "};\n\nconst size_t dpt_baked_count = %d;\n", num_paths);
+
+    if (fclose(f) != 0 && rc == 0) {
+        fprintf(stderr, "dptc: %s: %s\n", out_path, strerror(errno));
+        rc = 1;
+    }
+    if (rc != 0) {
+        remove(out_path);       // A half-written table must not be built
+    } else if (!quiet) {
+        printf("wrote:        %s (%d plan(s))\n", out_path, num_paths);
+    }
+    return rc;
+}
+
+// ---------------------- Main ----------------------
+int main(int argc, char **argv) {
+    const char *out_path = NULL;
+    const char *c_path = NULL;
+    char *in_paths[64];
+    int num_in = 0;
+    bool quiet = false;
+    bool sim = false;
+    bool usage = false;
+
+    for (int i = 1; i < argc && !usage; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            c_path = argv[++i];
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "-s") == 0) {
+            sim = true;
+        } else if (argv[i][0] != '-' && num_in < (int)(sizeof(in_paths) / sizeof(in_paths[0]))) {
+            in_paths[num_in++] = argv[i];
+        } else {
+            usage = true;
+        }
+    }
+    if (usage || (c_path == NULL && num_in != 1) || (c_path != NULL && out_path != NULL)) {
+        fprintf(stderr, "usage: dptc [-o plan.bin] [-q] [-s] recipe.txt\n"
+                        "       dptc -c baked.c [-q] [-s] recipe.txt...\n");
+        return 2;
+    }
+    if (c_path) {
+        return bake(c_path, in_paths, num_in, quiet, sim);
+    }
+
+    size_t size;
+    int rc = compile_recipe(in_paths[0], quiet, &size);
+    if (rc == 0 && sim) {
+        rc = simulate(quiet);
+    }
+    if (rc != 0 || out_path == NULL) {
+        return rc;
+    }
+
+    FILE *f = fopen(out_path, "wb");
+    if (f == NULL || fwrite(blob, 1, size, f) != size) {
+        fprintf(stderr, "dptc: %s: %s\n", out_path, strerror(errno));
+        if (f) fclose(f);
+        return 1;
+    }
+    fclose(f);
+    if (!quiet) {
+        printf("wrote:        %s\n", out_path);
+    }
+    return 0;
+}
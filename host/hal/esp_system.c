@@ -0,0 +1,127 @@
+/**
+ * @file esp_system.c
+ * @brief Host stand-ins for esp_timer, esp_system, logging, NVS and WiFi
+ */
+
+#include <malloc.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "nvs_flash.h"
+
+#define TAG "HOST_HAL"
+
+// ---------------------- Time ----------------------
+static struct timespec boot_time;
+
+__attribute__((constructor)) static void record_boot_time(void) {
+    clock_gettime(CLOCK_MONOTONIC, &boot_time);
+}
+
+int64_t esp_timer_get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)(ts.tv_sec - boot_time.tv_sec) * 1000000LL + (ts.tv_nsec - boot_time.tv_nsec) / 1000;
+}
+
+uint32_t esp_log_timestamp(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+// ---------------------- Logging ----------------------
+static esp_log_level_t log_level = ESP_LOG_INFO;    // CONFIG_LOG_DEFAULT_LEVEL
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    // Per-tag levels are not kept; "*" and any tag set the global level
+    (void)tag;
+    log_level = level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...) {
+    (void)tag;
+    if (level > log_level) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    flockfile(stdout);
+    vfprintf(stdout, format, args);
+    fflush(stdout);
+    funlockfile(stdout);
+    va_end(args);
+}
+
+// ---------------------- System ----------------------
+static uint32_t min_free_heap = HOST_HEAP_SIZE;
+
+uint32_t esp_get_free_heap_size(void) {
+    struct mallinfo2 mi = mallinfo2();
+    uint32_t free_heap = mi.uordblks < HOST_HEAP_SIZE ? HOST_HEAP_SIZE - (uint32_t)mi.uordblks : 0;
+    if (free_heap < min_free_heap) {
+        min_free_heap = free_heap;
+    }
+    return free_heap;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void) {
+    esp_get_free_heap_size();
+    return min_free_heap;
+}
+
+void esp_restart(void) {
+    ESP_LOGW(TAG, "esp_restart() called, exiting");
+    exit(3);
+}
+
+// ---------------------- NVS / Network ----------------------
+// The host network stack is already up; these only keep app_main's
+// start-up sequence intact.
+esp_err_t nvs_flash_init(void) { return ESP_OK; }
+esp_err_t nvs_flash_erase(void) { return ESP_OK; }
+esp_err_t esp_netif_init(void) { return ESP_OK; }
+esp_err_t esp_event_loop_create_default(void) { return ESP_OK; }
+
+esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t id, esp_event_handler_t handler, void *arg) {
+    (void)base;
+    (void)id;
+    (void)handler;
+    (void)arg;
+    return ESP_OK;
+}
+
+static int netif_placeholder;
+
+esp_netif_t *esp_netif_create_default_wifi_ap(void) { return (esp_netif_t *)&netif_placeholder; }
+esp_netif_t *esp_netif_create_default_wifi_sta(void) { return (esp_netif_t *)&netif_placeholder; }
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config) {
+    return config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) {
+    (void)mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf) {
+    if (interface == WIFI_IF_AP) {
+        ESP_LOGI(TAG, "WiFi AP \"%.32s\" is emulated; clients connect over the host network", conf->ap.ssid);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type) {
+    (void)type;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void) { return ESP_OK; }
+esp_err_t esp_wifi_stop(void) { return ESP_OK; }
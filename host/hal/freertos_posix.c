@@ -0,0 +1,234 @@
+/**
+ * @file freertos_posix.c
+ * @brief FreeRTOS tasks, queues and semaphores on pthreads
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+
+// ---------------------- Time ----------------------
+static struct timespec deadline_after(TickType_t ticks) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    int64_t ns = ts.tv_nsec + (int64_t)ticks * (1000000000LL / configTICK_RATE_HZ);
+    ts.tv_sec += ns / 1000000000LL;
+    ts.tv_nsec = ns % 1000000000LL;
+    return ts;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(esp_timer_get_time() / (1000000LL / configTICK_RATE_HZ));
+}
+
+void vTaskDelay(TickType_t ticks) {
+    struct timespec ts = deadline_after(ticks);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+BaseType_t xPortGetCoreID(void) {
+    return 0;
+}
+
+// ---------------------- Tasks ----------------------
+typedef struct {
+    TaskFunction_t fn;
+    void *arg;
+    char name[16];
+} host_task_t;
+
+static __thread host_task_t *current_task;
+static host_task_t main_task = { .name = "main" };
+
+static void *task_entry(void *p) {
+    current_task = p;
+    current_task->fn(current_task->arg);
+    // A FreeRTOS task must not return; treat it like vTaskDelete(NULL)
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core_id) {
+    (void)priority;
+    (void)core_id;
+    host_task_t *task = calloc(1, sizeof(*task));
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    strncpy(task->name, name ? name : "", sizeof(task->name) - 1);
+
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    // FreeRTOS stack depth is in bytes on ESP-IDF; host code needs more headroom
+    pthread_attr_setstacksize(&attr, stack_depth * 4 < 256 * 1024 ? 256 * 1024 : stack_depth * 4);
+    int rc = pthread_create(&thread, &attr, task_entry, task);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    if (handle) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle) {
+    return xTaskCreatePinnedToCore(fn, name, stack_depth, arg, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t handle) {
+    if (handle == NULL || handle == current_task) {
+        pthread_exit(NULL);
+    }
+    abort();    // Deleting another task is not supported on the host
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return current_task ? current_task : &main_task;
+}
+
+char *pcTaskGetName(TaskHandle_t handle) {
+    host_task_t *task = handle ? handle : xTaskGetCurrentTaskHandle();
+    return task->name;
+}
+
+// ---------------------- Queues ----------------------
+// Semaphores are queues with zero-size items, as in FreeRTOS
+struct host_queue {
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t count;
+    UBaseType_t head;
+    uint8_t storage[];
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    struct host_queue *q = calloc(1, sizeof(*q) + (size_t)length * item_size);
+    if (q == NULL) {
+        return NULL;
+    }
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&q->mutex, NULL);
+    pthread_cond_init(&q->not_empty, &attr);
+    pthread_cond_init(&q->not_full, &attr);
+    pthread_condattr_destroy(&attr);
+    q->length = length;
+    q->item_size = item_size;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q) {
+    pthread_mutex_destroy(&q->mutex);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_cond_destroy(&q->not_full);
+    free(q);
+}
+
+// Wait on cond until pred holds or the FreeRTOS timeout passes; mutex held
+static bool wait_for(struct host_queue *q, pthread_cond_t *cond, bool (*pred)(struct host_queue *),
+                     TickType_t wait) {
+    if (pred(q)) {
+        return true;
+    }
+    if (wait == 0) {
+        return false;
+    }
+    if (wait == portMAX_DELAY) {
+        while (!pred(q)) {
+            pthread_cond_wait(cond, &q->mutex);
+        }
+        return true;
+    }
+    struct timespec ts = deadline_after(wait);
+    while (!pred(q)) {
+        if (pthread_cond_timedwait(cond, &q->mutex, &ts) == ETIMEDOUT) {
+            return pred(q);
+        }
+    }
+    return true;
+}
+
+static bool has_space(struct host_queue *q) { return q->count < q->length; }
+static bool has_item(struct host_queue *q) { return q->count > 0; }
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait) {
+    pthread_mutex_lock(&q->mutex);
+    if (!wait_for(q, &q->not_full, has_space, wait)) {
+        pthread_mutex_unlock(&q->mutex);
+        return pdFAIL;
+    }
+    if (q->item_size) {
+        UBaseType_t tail = (q->head + q->count) % q->length;
+        memcpy(&q->storage[tail * q->item_size], item, q->item_size);
+    }
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->mutex);
+    return pdPASS;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xQueueSend(q, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait) {
+    pthread_mutex_lock(&q->mutex);
+    if (!wait_for(q, &q->not_empty, has_item, wait)) {
+        pthread_mutex_unlock(&q->mutex);
+        return pdFAIL;
+    }
+    if (q->item_size) {
+        memcpy(item, &q->storage[q->head * q->item_size], q->item_size);
+        q->head = (q->head + 1) % q->length;
+    }
+    q->count--;
+    pthread_cond_signal(&q->not_full);
+    pthread_mutex_unlock(&q->mutex);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    pthread_mutex_lock(&q->mutex);
+    UBaseType_t count = q->count;
+    pthread_mutex_unlock(&q->mutex);
+    return count;
+}
+
+// ---------------------- Semaphores ----------------------
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    // Starts available; no priority inheritance or recursion on the host
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+    struct host_queue *q = xQueueCreate(max_count, 0);
+    if (q) {
+        q->count = initial_count;
+    }
+    return q;
+}
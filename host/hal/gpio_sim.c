@@ -0,0 +1,254 @@
+/**
+ * @file gpio_sim.c
+ * @brief Simulated GPIO matrix: pin levels, pulls and edge interrupts
+ *
+ * An output pad follows either its GPIO output register or the peripheral
+ * signal routed to it, unless the pad is held. Every change of the pad
+ * level, from outside or from an output, is an edge for the pin's
+ * interrupt, as it is for a pad with its input enabled.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include "driver/gpio.h"
+#include "host_sim.h"
+
+typedef struct {
+    gpio_mode_t mode;
+    gpio_int_type_t intr_type;
+    bool intr_enabled;
+    int level;              // Pad level
+    int out_reg;            // GPIO output register
+    bool periph;            // Pad driven by a peripheral signal instead
+    int periph_level;
+    bool held;              // gpio_hold_en(): pad frozen
+    gpio_isr_t isr;
+    void *isr_arg;
+} sim_pin_t;
+
+static sim_pin_t pins[GPIO_NUM_MAX];
+static bool isr_service_installed = false;
+static pthread_mutex_t gpio_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool valid_pin(gpio_num_t gpio_num) {
+    return gpio_num >= 0 && gpio_num < GPIO_NUM_MAX;
+}
+
+// Set the pad level and run the pin's ISR if the change matches its
+// interrupt type. Called with gpio_lock held; releases it.
+static void set_pad_unlock(sim_pin_t *pin, int level) {
+    int old = pin->level;
+    pin->level = level ? 1 : 0;
+
+    bool fire = false;
+    switch (pin->intr_type) {
+    case GPIO_INTR_POSEDGE:    fire = !old && pin->level; break;
+    case GPIO_INTR_NEGEDGE:    fire = old && !pin->level; break;
+    case GPIO_INTR_ANYEDGE:    fire = old != pin->level; break;
+    case GPIO_INTR_LOW_LEVEL:  fire = !pin->level; break;
+    case GPIO_INTR_HIGH_LEVEL: fire = pin->level; break;
+    default:                   break;
+    }
+    gpio_isr_t isr = pin->isr;
+    void *arg = pin->isr_arg;
+    fire = fire && pin->intr_enabled && isr != NULL;
+    pthread_mutex_unlock(&gpio_lock);
+
+    if (fire) {
+        isr(arg);
+    }
+}
+
+// Re-evaluate an output pad after its source changed; gpio_lock held, released
+static void update_output_unlock(sim_pin_t *pin) {
+    if ((pin->mode & GPIO_MODE_OUTPUT) && !pin->held) {
+        set_pad_unlock(pin, pin->periph ? pin->periph_level : pin->out_reg);
+    } else {
+        pthread_mutex_unlock(&gpio_lock);
+    }
+}
+
+esp_err_t gpio_config(const gpio_config_t *config) {
+    if (config == NULL || config->pin_bit_mask == 0 || (config->pin_bit_mask >> GPIO_NUM_MAX) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int n = 0; n < GPIO_NUM_MAX; n++) {
+        if (!(config->pin_bit_mask & (1ULL << n))) {
+            continue;
+        }
+        pthread_mutex_lock(&gpio_lock);
+        pins[n].mode = config->mode;
+        pins[n].periph = false;
+        pins[n].intr_type = config->intr_type;
+        pins[n].intr_enabled = config->intr_type != GPIO_INTR_DISABLE;
+        if (config->mode & GPIO_MODE_OUTPUT) {
+            update_output_unlock(&pins[n]);
+            continue;
+        }
+        // An undriven input settles to its pull
+        if (config->pull_up_en) {
+            pins[n].level = 1;
+        } else if (config->pull_down_en) {
+            pins[n].level = 0;
+        }
+        pthread_mutex_unlock(&gpio_lock);
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&gpio_lock);
+    pins[gpio_num] = (sim_pin_t){ .mode = GPIO_MODE_INPUT, .level = 1 };   // Input with pull-up
+    pthread_mutex_unlock(&gpio_lock);
+    return ESP_OK;
+}
+
+esp_err_t gpio_pullup_en(gpio_num_t gpio_num) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&gpio_lock);
+    if (pins[gpio_num].mode == GPIO_MODE_INPUT) {
+        pins[gpio_num].level = 1;       // An undriven input settles to its pull
+    }
+    pthread_mutex_unlock(&gpio_lock);
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&gpio_lock);
+    pins[gpio_num].mode = mode;
+    pins[gpio_num].periph = false;      // As the driver: back to the GPIO output register
+    update_output_unlock(&pins[gpio_num]);
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&gpio_lock);
+    pins[gpio_num].out_reg = level ? 1 : 0;
+    if (pins[gpio_num].periph) {
+        pthread_mutex_unlock(&gpio_lock);
+        return ESP_OK;
+    }
+    update_output_unlock(&pins[gpio_num]);
+    return ESP_OK;
+}
+
+esp_err_t gpio_hold_en(gpio_num_t gpio_num) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&gpio_lock);
+    pins[gpio_num].held = true;
+    pthread_mutex_unlock(&gpio_lock);
+    return ESP_OK;
+}
+
+esp_err_t gpio_hold_dis(gpio_num_t gpio_num) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&gpio_lock);
+    pins[gpio_num].held = false;
+    update_output_unlock(&pins[gpio_num]);
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+    return valid_pin(gpio_num) ? pins[gpio_num].level : 0;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pins[gpio_num].intr_type = intr_type;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pins[gpio_num].intr_enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pins[gpio_num].intr_enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags) {
+    (void)intr_alloc_flags;
+    if (isr_service_installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    isr_service_installed = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!isr_service_installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    pthread_mutex_lock(&gpio_lock);
+    pins[gpio_num].isr = isr_handler;
+    pins[gpio_num].isr_arg = args;
+    pthread_mutex_unlock(&gpio_lock);
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num) {
+    return gpio_isr_handler_add(gpio_num, NULL, NULL);
+}
+
+// ---------------------- Simulator ----------------------
+void gpio_sim_drive(gpio_num_t gpio_num, int level) {
+    if (!valid_pin(gpio_num)) {
+        return;
+    }
+    pthread_mutex_lock(&gpio_lock);
+    set_pad_unlock(&pins[gpio_num], level);
+}
+
+void gpio_sim_connect_signal(gpio_num_t gpio_num, int level) {
+    if (!valid_pin(gpio_num)) {
+        return;
+    }
+    pthread_mutex_lock(&gpio_lock);
+    sim_pin_t *pin = &pins[gpio_num];
+    pin->mode |= GPIO_MODE_OUTPUT;
+    pin->periph = true;
+    pin->periph_level = level ? 1 : 0;
+    update_output_unlock(pin);
+}
+
+void gpio_sim_signal(gpio_num_t gpio_num, int level) {
+    if (!valid_pin(gpio_num)) {
+        return;
+    }
+    pthread_mutex_lock(&gpio_lock);
+    sim_pin_t *pin = &pins[gpio_num];
+    pin->periph_level = level ? 1 : 0;
+    if (!pin->periph) {
+        pthread_mutex_unlock(&gpio_lock);
+        return;
+    }
+    update_output_unlock(pin);
+}
@@ -0,0 +1,606 @@
+/**
+ * @file httpd_posix.c
+ * @brief esp_http_server on POSIX sockets
+ *
+ * One thread polls the listening socket and up to max_open_sockets
+ * sessions and runs handlers one request at a time, as the IDF server
+ * task does; a slow handler therefore stalls every client, on the host
+ * as on the device. Requests already buffered on a session are handled
+ * back to back, which is what lets pipelined clients work.
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "host_sim.h"
+
+#define TAG "httpd"
+
+#define SESSION_BUF_SIZE    (HTTPD_MAX_REQ_HDR_LEN + HTTPD_MAX_URI_LEN + 64)
+#define RESP_HDR_SIZE       512
+
+typedef struct {
+    int fd;
+    uint64_t last_used;
+    size_t len;                     // Bytes buffered in buf
+    char buf[SESSION_BUF_SIZE];
+} session_t;
+
+typedef struct {
+    httpd_config_t config;
+    int listen_fd;
+    int wake_pipe[2];
+    pthread_t thread;
+    httpd_uri_t *handlers;
+    uint16_t num_handlers;
+    session_t *sessions;
+    uint64_t use_counter;
+} server_t;
+
+// Per-request state behind httpd_req_t.aux
+typedef struct {
+    session_t *sess;
+    size_t body_left;               // Request body bytes not yet read
+    char req_hdrs[HTTPD_MAX_REQ_HDR_LEN];
+    const char *status;
+    const char *content_type;
+    char resp_hdrs[RESP_HDR_SIZE];
+    size_t resp_hdrs_len;
+    uint16_t num_resp_hdrs;
+    bool chunked;                   // Chunked response started
+    bool close;                     // Close the session after this request
+} req_aux_t;
+
+static char listen_addr[64] = "127.0.0.1";
+static uint16_t listen_port = 0;
+
+void httpd_sim_listen(const char *addr, uint16_t port) {
+    if (addr) {
+        snprintf(listen_addr, sizeof(listen_addr), "%s", addr);
+    }
+    listen_port = port;
+}
+
+// ---------------------- Socket I/O ----------------------
+static esp_err_t send_all(session_t *sess, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(sess->fd, buf, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return ESP_ERR_HTTPD_RESP_SEND;
+        }
+        buf += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+static void consume(session_t *sess, size_t n) {
+    memmove(sess->buf, sess->buf + n, sess->len - n);
+    sess->len -= n;
+}
+
+// ---------------------- Requests ----------------------
+int httpd_req_recv(httpd_req_t *r, char *buf, size_t buf_len) {
+    req_aux_t *aux = r->aux;
+    session_t *sess = aux->sess;
+    size_t want = buf_len < aux->body_left ? buf_len : aux->body_left;
+    if (want == 0) {
+        return 0;
+    }
+    if (sess->len > 0) {
+        size_t n = want < sess->len ? want : sess->len;
+        memcpy(buf, sess->buf, n);
+        consume(sess, n);
+        aux->body_left -= n;
+        return (int)n;
+    }
+    ssize_t n = recv(sess->fd, buf, want, 0);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return HTTPD_SOCK_ERR_TIMEOUT;
+    }
+    if (n <= 0) {
+        return HTTPD_SOCK_ERR_FAIL;
+    }
+    aux->body_left -= n;
+    return (int)n;
+}
+
+static const char *find_header(req_aux_t *aux, const char *field, size_t *len) {
+    size_t flen = strlen(field);
+    for (const char *line = aux->req_hdrs; *line; ) {
+        const char *eol = strstr(line, "\r\n");
+        size_t line_len = eol ? (size_t)(eol - line) : strlen(line);
+        if (line_len > flen && strncasecmp(line, field, flen) == 0 && line[flen] == ':') {
+            const char *v = line + flen + 1;
+            while (*v == ' ' || *v == '\t') {
+                v++;
+            }
+            *len = line_len - (v - line);
+            return v;
+        }
+        line += line_len + (eol ? 2 : 0);
+    }
+    return NULL;
+}
+
+size_t httpd_req_get_hdr_value_len(httpd_req_t *r, const char *field) {
+    size_t len;
+    return find_header(r->aux, field, &len) ? len : 0;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *r, const char *field, char *val, size_t val_size) {
+    size_t len;
+    const char *v = find_header(r->aux, field, &len);
+    if (v == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (val_size == 0) {
+        return ESP_ERR_HTTPD_RESULT_TRUNC;
+    }
+    size_t n = len < val_size - 1 ? len : val_size - 1;
+    memcpy(val, v, n);
+    val[n] = '\0';
+    return n < len ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+}
+
+size_t httpd_req_get_url_query_len(httpd_req_t *r) {
+    const char *q = strchr(r->uri, '?');
+    return q ? strlen(q + 1) : 0;
+}
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t *r, char *buf, size_t buf_len) {
+    const char *q = strchr(r->uri, '?');
+    if (q == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (buf_len == 0) {
+        return ESP_ERR_HTTPD_RESULT_TRUNC;
+    }
+    snprintf(buf, buf_len, "%s", q + 1);
+    return strlen(q + 1) < buf_len ? ESP_OK : ESP_ERR_HTTPD_RESULT_TRUNC;
+}
+
+esp_err_t httpd_query_key_value(const char *qry, const char *key, char *val, size_t val_size) {
+    if (qry == NULL || key == NULL || val == NULL || val_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t klen = strlen(key);
+    for (const char *p = qry; *p; ) {
+        size_t pair_len = strcspn(p, "&");
+        if (pair_len > klen && strncmp(p, key, klen) == 0 && p[klen] == '=') {
+            size_t vlen = pair_len - klen - 1;
+            size_t n = vlen < val_size - 1 ? vlen : val_size - 1;
+            memcpy(val, p + klen + 1, n);
+            val[n] = '\0';
+            return n < vlen ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+        }
+        p += pair_len + (p[pair_len] == '&');
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+// ---------------------- Responses ----------------------
+esp_err_t httpd_resp_set_status(httpd_req_t *r, const char *status) {
+    ((req_aux_t *)r->aux)->status = status;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type) {
+    ((req_aux_t *)r->aux)->content_type = type;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *r, const char *field, const char *value) {
+    req_aux_t *aux = r->aux;
+    server_t *hd = r->handle;
+    if (aux->num_resp_hdrs >= hd->config.max_resp_headers) {
+        return ESP_ERR_HTTPD_RESP_HDR;
+    }
+    int n = snprintf(aux->resp_hdrs + aux->resp_hdrs_len, sizeof(aux->resp_hdrs) - aux->resp_hdrs_len,
+                     "%s: %s\r\n", field, value);
+    if (n < 0 || (size_t)n >= sizeof(aux->resp_hdrs) - aux->resp_hdrs_len) {
+        return ESP_ERR_HTTPD_RESP_HDR;
+    }
+    aux->resp_hdrs_len += n;
+    aux->num_resp_hdrs++;
+    return ESP_OK;
+}
+
+static esp_err_t send_head(httpd_req_t *r, const char *length_hdr) {
+    req_aux_t *aux = r->aux;
+    char head[RESP_HDR_SIZE + 256];
+    int n = snprintf(head, sizeof(head), "HTTP/1.1 %s\r\nContent-Type: %s\r\n%s%s\r\n",
+                     aux->status, aux->content_type, length_hdr, aux->resp_hdrs);
+    return send_all(aux->sess, head, n);
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len) {
+    if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = buf ? (ssize_t)strlen(buf) : 0;
+    }
+    char length_hdr[48];
+    snprintf(length_hdr, sizeof(length_hdr), "Content-Length: %zd\r\n", buf_len);
+    esp_err_t err = send_head(r, length_hdr);
+    if (err == ESP_OK && buf_len > 0) {
+        err = send_all(((req_aux_t *)r->aux)->sess, buf, buf_len);
+    }
+    return err;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len) {
+    req_aux_t *aux = r->aux;
+    if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = buf ? (ssize_t)strlen(buf) : 0;
+    }
+    if (!aux->chunked) {
+        esp_err_t err = send_head(r, "Transfer-Encoding: chunked\r\n");
+        if (err != ESP_OK) {
+            return err;
+        }
+        aux->chunked = true;
+    }
+    char size_line[16];
+    int n = snprintf(size_line, sizeof(size_line), "%zx\r\n", buf_len);
+    esp_err_t err = send_all(aux->sess, size_line, n);
+    if (err == ESP_OK && buf_len > 0) {
+        err = send_all(aux->sess, buf, buf_len);
+    }
+    if (err == ESP_OK) {
+        err = send_all(aux->sess, "\r\n", 2);
+    }
+    return err;
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *usr_msg) {
+    const char *status, *msg;
+    switch (error) {
+    case HTTPD_400_BAD_REQUEST:
+        status = "400 Bad Request";                 msg = "Bad request syntax"; break;
+    case HTTPD_404_NOT_FOUND:
+        status = "404 Not Found";                   msg = "This URI does not exist"; break;
+    case HTTPD_405_METHOD_NOT_ALLOWED:
+        status = "405 Method Not Allowed";          msg = "Request method for this URI is not handled by server"; break;
+    case HTTPD_408_REQ_TIMEOUT:
+        status = "408 Request Timeout";             msg = "Server closed this connection"; break;
+    case HTTPD_411_LENGTH_REQUIRED:
+        status = "411 Length Required";             msg = "Chunked encoding not supported"; break;
+    case HTTPD_414_URI_TOO_LONG:
+        status = "414 URI Too Long";                msg = "URI is too long"; break;
+    case HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE:
+        status = "431 Request Header Fields Too Large"; msg = "Header fields are too long"; break;
+    case HTTPD_501_METHOD_NOT_IMPLEMENTED:
+        status = "501 Method Not Implemented";      msg = "Server does not support this method"; break;
+    case HTTPD_503_SERVICE_UNAVAILABLE:
+        status = "503 Service Unavailable";         msg = "Server is busy"; break;
+    default:
+        status = "500 Internal Server Error";       msg = "Server has encountered an unexpected error"; break;
+    }
+    httpd_resp_set_status(req, status);
+    httpd_resp_set_type(req, "text/html");
+    return httpd_resp_send(req, usr_msg ? usr_msg : msg, HTTPD_RESP_USE_STRLEN);
+}
+
+// ---------------------- Dispatch ----------------------
+static int parse_method(const char *m) {
+    static const char *const names[] = { "DELETE", "GET", "HEAD", "POST", "PUT" };
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+        if (strcmp(m, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Same as httpd_uri_match_simple(): the whole path, query excluded
+static bool uri_matches(const char *templ, const char *uri) {
+    size_t len = strcspn(uri, "?");
+    return strlen(templ) == len && strncmp(templ, uri, len) == 0;
+}
+
+// Handle one complete request at the front of the session buffer.
+// Returns false if the session must be closed.
+static bool handle_request(server_t *hd, session_t *sess, size_t header_len) {
+    httpd_req_t req = { .handle = hd };
+    req_aux_t *aux = calloc(1, sizeof(*aux));
+    if (aux == NULL) {
+        return false;
+    }
+    aux->sess = sess;
+    aux->status = "200 OK";
+    aux->content_type = "text/html";
+    req.aux = aux;
+
+    char method[8] = "";
+    char *line_end = strstr(sess->buf, "\r\n");
+    char *uri = NULL;
+    bool keep = true;
+    *line_end = '\0';
+    char *sp1 = strchr(sess->buf, ' ');
+    char *sp2 = sp1 ? strchr(sp1 + 1, ' ') : NULL;
+    if (sp1 && sp2 && sp1 - sess->buf < (long)sizeof(method)) {
+        memcpy(method, sess->buf, sp1 - sess->buf);
+        uri = sp1 + 1;
+        *sp2 = '\0';
+    }
+    // Header lines without the request line and the final blank line
+    size_t hdrs_len = header_len - 2 - (line_end + 2 - sess->buf);
+    if (hdrs_len >= sizeof(aux->req_hdrs)) {
+        hdrs_len = sizeof(aux->req_hdrs) - 1;
+    }
+    memcpy(aux->req_hdrs, line_end + 2, hdrs_len);
+
+    char value[32];
+    req.method = parse_method(method);
+    if (httpd_req_get_hdr_value_str(&req, "Content-Length", value, sizeof(value)) == ESP_OK) {
+        req.content_len = strtoul(value, NULL, 10);
+    }
+    if (httpd_req_get_hdr_value_str(&req, "Connection", value, sizeof(value)) == ESP_OK &&
+        strcasecmp(value, "close") == 0) {
+        aux->close = true;
+    }
+    aux->body_left = req.content_len;
+
+    if (uri == NULL) {
+        consume(sess, header_len);
+        httpd_resp_send_err(&req, HTTPD_400_BAD_REQUEST, NULL);
+        free(aux);
+        return false;
+    }
+    if (strlen(uri) > HTTPD_MAX_URI_LEN) {
+        consume(sess, header_len);
+        httpd_resp_send_err(&req, HTTPD_414_URI_TOO_LONG, NULL);
+        free(aux);
+        return false;
+    }
+    snprintf((char *)req.uri, sizeof(req.uri), "%s", uri);
+    consume(sess, header_len);
+
+    const httpd_uri_t *match = NULL;
+    bool path_known = false;
+    for (uint16_t i = 0; i < hd->num_handlers; i++) {
+        if (uri_matches(hd->handlers[i].uri, req.uri)) {
+            path_known = true;
+            if ((int)hd->handlers[i].method == req.method) {
+                match = &hd->handlers[i];
+                break;
+            }
+        }
+    }
+
+    if (match == NULL) {
+        httpd_resp_send_err(&req, path_known ? HTTPD_405_METHOD_NOT_ALLOWED : HTTPD_404_NOT_FOUND, NULL);
+        keep = path_known;
+    } else {
+        req.user_ctx = match->user_ctx;
+        if (match->handler(&req) != ESP_OK) {
+            ESP_LOGW(TAG, "uri handler execution failed for %s", req.uri);
+            keep = false;
+        }
+    }
+
+    // Drop whatever part of the body the handler did not read
+    char scratch[256];
+    while (keep && aux->body_left > 0) {
+        int n = httpd_req_recv(&req, scratch, sizeof(scratch));
+        if (n <= 0 && n != HTTPD_SOCK_ERR_TIMEOUT) {
+            keep = false;
+        }
+    }
+    keep = keep && !aux->close;
+    free(aux);
+    return keep;
+}
+
+// Read from the session and handle every complete request buffered
+static bool serve_session(server_t *hd, session_t *sess) {
+    ssize_t n = recv(sess->fd, sess->buf + sess->len, sizeof(sess->buf) - 1 - sess->len, 0);
+    if (n <= 0) {
+        return n < 0 && (errno == EAGAIN || errno == EINTR);
+    }
+    sess->len += n;
+    sess->last_used = ++hd->use_counter;
+
+    while (sess->len > 0) {
+        sess->buf[sess->len] = '\0';
+        char *end = strstr(sess->buf, "\r\n\r\n");
+        if (end == NULL) {
+            if (sess->len >= sizeof(sess->buf) - 1) {
+                httpd_req_t req = { .handle = hd };
+                req_aux_t aux = { .sess = sess, .status = "200 OK", .content_type = "text/html" };
+                req.aux = &aux;
+                httpd_resp_send_err(&req, HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE, NULL);
+                return false;
+            }
+            return true;    // Wait for the rest of the header
+        }
+        if (!handle_request(hd, sess, end + 4 - sess->buf)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void close_session(session_t *sess) {
+    close(sess->fd);
+    sess->fd = -1;
+    sess->len = 0;
+}
+
+static void accept_session(server_t *hd) {
+    int fd = accept(hd->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+    session_t *free_slot = NULL, *lru = NULL;
+    for (uint16_t i = 0; i < hd->config.max_open_sockets; i++) {
+        session_t *s = &hd->sessions[i];
+        if (s->fd < 0 && free_slot == NULL) {
+            free_slot = s;
+        } else if (s->fd >= 0 && (lru == NULL || s->last_used < lru->last_used)) {
+            lru = s;
+        }
+    }
+    if (free_slot == NULL) {
+        // Only reached with lru_purge_enable; otherwise accept is not polled when full
+        ESP_LOGW(TAG, "Closing least recently used session (fd %d)", lru->fd);
+        close_session(lru);
+        free_slot = lru;
+    }
+
+    int one = 1;
+    struct timeval rcv = { .tv_sec = hd->config.recv_wait_timeout };
+    struct timeval snd = { .tv_sec = hd->config.send_wait_timeout };
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &rcv, sizeof(rcv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &snd, sizeof(snd));
+    free_slot->fd = fd;
+    free_slot->len = 0;
+    free_slot->last_used = ++hd->use_counter;
+}
+
+static void *server_main(void *arg) {
+    server_t *hd = arg;
+    uint16_t max = hd->config.max_open_sockets;
+    struct pollfd *fds = calloc(max + 2, sizeof(*fds));
+
+    while (1) {
+        int open = 0;
+        for (uint16_t i = 0; i < max; i++) {
+            fds[i] = (struct pollfd){ .fd = hd->sessions[i].fd, .events = POLLIN };
+            open += hd->sessions[i].fd >= 0;
+        }
+        bool can_accept = open < max || hd->config.lru_purge_enable;
+        fds[max] = (struct pollfd){ .fd = can_accept ? hd->listen_fd : -1, .events = POLLIN };
+        fds[max + 1] = (struct pollfd){ .fd = hd->wake_pipe[0], .events = POLLIN };
+
+        if (poll(fds, max + 2, -1) < 0) {
+            continue;
+        }
+        if (fds[max + 1].revents) {
+            break;
+        }
+        for (uint16_t i = 0; i < max; i++) {
+            if (fds[i].fd >= 0 && (fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                if (!serve_session(hd, &hd->sessions[i])) {
+                    close_session(&hd->sessions[i]);
+                }
+            }
+        }
+        if (fds[max].fd >= 0 && (fds[max].revents & POLLIN)) {
+            accept_session(hd);
+        }
+    }
+    free(fds);
+    return NULL;
+}
+
+// ---------------------- Server ----------------------
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config) {
+    if (handle == NULL || config == NULL || config->max_open_sockets == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    server_t *hd = calloc(1, sizeof(*hd));
+    if (hd == NULL) {
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    hd->config = *config;
+    hd->handlers = calloc(config->max_uri_handlers, sizeof(httpd_uri_t));
+    hd->sessions = calloc(config->max_open_sockets, sizeof(session_t));
+    if ((config->max_uri_handlers && hd->handlers == NULL) || hd->sessions == NULL) {
+        free(hd->handlers);
+        free(hd->sessions);
+        free(hd);
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    for (uint16_t i = 0; i < config->max_open_sockets; i++) {
+        hd->sessions[i].fd = -1;
+    }
+
+    uint16_t port = listen_port ? listen_port : config->server_port;
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port) };
+    int one = 1;
+    hd->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (hd->listen_fd < 0 || inet_pton(AF_INET, listen_addr, &addr.sin_addr) != 1 ||
+        setsockopt(hd->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0 ||
+        bind(hd->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(hd->listen_fd, config->backlog_conn) < 0 || pipe(hd->wake_pipe) < 0) {
+        ESP_LOGE(TAG, "Cannot listen on %s:%u: %s", listen_addr, port, strerror(errno));
+        if (hd->listen_fd >= 0) {
+            close(hd->listen_fd);
+        }
+        free(hd->handlers);
+        free(hd->sessions);
+        free(hd);
+        return ESP_ERR_HTTPD_TASK;
+    }
+    if (pthread_create(&hd->thread, NULL, server_main, hd) != 0) {
+        close(hd->listen_fd);
+        close(hd->wake_pipe[0]);
+        close(hd->wake_pipe[1]);
+        free(hd->handlers);
+        free(hd->sessions);
+        free(hd);
+        return ESP_ERR_HTTPD_TASK;
+    }
+    ESP_LOGI(TAG, "Started server on %s:%u", listen_addr, port);
+    *handle = hd;
+    return ESP_OK;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle) {
+    server_t *hd = handle;
+    if (hd == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (write(hd->wake_pipe[1], "x", 1) != 1) {
+        return ESP_FAIL;
+    }
+    pthread_join(hd->thread, NULL);
+    for (uint16_t i = 0; i < hd->config.max_open_sockets; i++) {
+        if (hd->sessions[i].fd >= 0) {
+            close_session(&hd->sessions[i]);
+        }
+    }
+    close(hd->listen_fd);
+    close(hd->wake_pipe[0]);
+    close(hd->wake_pipe[1]);
+    free(hd->handlers);
+    free(hd->sessions);
+    free(hd);
+    return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler) {
+    server_t *hd = handle;
+    if (hd == NULL || uri_handler == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (uint16_t i = 0; i < hd->num_handlers; i++) {
+        if (hd->handlers[i].method == uri_handler->method && strcmp(hd->handlers[i].uri, uri_handler->uri) == 0) {
+            ESP_LOGW(TAG, "handler %s already exists", uri_handler->uri);
+            return ESP_ERR_HTTPD_HANDLER_EXISTS;
+        }
+    }
+    if (hd->num_handlers >= hd->config.max_uri_handlers) {
+        ESP_LOGW(TAG, "no slots left for registering handler %s (max_uri_handlers = %u)",
+                 uri_handler->uri, hd->config.max_uri_handlers);
+        return ESP_ERR_HTTPD_HANDLERS_FULL;
+    }
+    hd->handlers[hd->num_handlers++] = *uri_handler;
+    return ESP_OK;
+}
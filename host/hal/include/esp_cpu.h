@@ -0,0 +1,26 @@
+/**
+ * @file esp_cpu.h
+ * @brief Host stand-in for the CPU cycle counter
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#include "esp_rom_sys.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Monotonic time scaled to the device's CPU clock
+static inline uint32_t esp_cpu_get_cycle_count(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    return (uint32_t)(ns * esp_rom_get_cpu_ticks_per_us() / 1000);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,22 @@
+/**
+ * @file esp_netif.h
+ * @brief Host stand-in for esp_netif; the host's own network stack is used
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct esp_netif_obj esp_netif_t;
+
+esp_err_t esp_netif_init(void);
+esp_netif_t *esp_netif_create_default_wifi_ap(void);
+esp_netif_t *esp_netif_create_default_wifi_sta(void);
+
+#ifdef __cplusplus
+}
+#endif
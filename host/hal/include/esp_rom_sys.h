@@ -0,0 +1,28 @@
+/**
+ * @file esp_rom_sys.h
+ * @brief Host stand-in for the ROM system helpers
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ in sdkconfig.um_tinys3
+static inline uint32_t esp_rom_get_cpu_ticks_per_us(void) {
+    return 160;
+}
+
+// Sleeps rather than spins; nothing on the host depends on the exact wait
+static inline void esp_rom_delay_us(uint32_t us) {
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (long)(us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,24 @@
+/**
+ * @file esp_system.h
+ * @brief Host stand-in for esp_system.h
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HOST_HEAP_SIZE      (320 * 1024)    // Nominal heap that free-heap figures are taken from
+
+// HOST_HEAP_SIZE minus what malloc currently has handed out
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
+void esp_restart(void) __attribute__((noreturn));
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,28 @@
+/**
+ * @file semphr.h
+ * @brief Host stand-in for FreeRTOS semaphores (zero-size-item queues)
+ */
+
+#pragma once
+
+#include "queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count);
+
+#define xSemaphoreTake(sem, wait)           xQueueReceive(sem, NULL, wait)
+#define xSemaphoreGive(sem)                 xQueueSend(sem, NULL, 0)
+#define xSemaphoreGiveFromISR(sem, woken)   xQueueSendFromISR(sem, NULL, woken)
+#define vSemaphoreDelete(sem)               vQueueDelete(sem)
+#define uxSemaphoreGetCount(sem)            uxQueueMessagesWaiting(sem)
+
+#ifdef __cplusplus
+}
+#endif
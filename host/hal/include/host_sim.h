@@ -0,0 +1,79 @@
+/**
+ * @file host_sim.h
+ * @brief Simulator hooks of the host HAL, not part of ESP-IDF
+ *
+ * Lets host code drive simulated inputs and look at what the simulated
+ * peripherals emitted.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driver/rmt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ---------------------- GPIO ----------------------
+/**
+ * @brief Drive an input pin from outside, as a wire would
+ *
+ * Runs the pin's ISR handler on the calling thread if the change matches
+ * its interrupt type and the interrupt is enabled.
+ */
+void gpio_sim_drive(gpio_num_t gpio_num, int level);
+
+/**
+ * @brief Route a peripheral output signal to a pin, at its current level
+ *
+ * Used by the simulated peripherals, as esp_rom_gpio_connect_out_signal()
+ * is by their drivers. gpio_set_direction() routes the GPIO output
+ * register back.
+ */
+void gpio_sim_connect_signal(gpio_num_t gpio_num, int level);
+
+/**
+ * @brief New level of the peripheral signal routed to a pin
+ */
+void gpio_sim_signal(gpio_num_t gpio_num, int level);
+
+// ---------------------- HTTP Server ----------------------
+/**
+ * @brief Address and port httpd_start() listens on
+ *
+ * Defaults to 127.0.0.1 and the port in the httpd config. A port of 0
+ * keeps the configured one.
+ */
+void httpd_sim_listen(const char *addr, uint16_t port);
+
+// ---------------------- RMT ----------------------
+#define RMT_SIM_MAX_EDGES   1024
+
+typedef struct {
+    uint32_t tick;          // Ticks of the channel clock since the channel started
+    uint8_t level;
+} rmt_sim_edge_t;
+
+// Output of a channel's most recent transmission
+typedef struct {
+    uint32_t shots;         // Transmissions since start-up
+    int64_t start_ns;       // Host monotonic time the channel was started
+    uint32_t total_ticks;   // Until the return to idle
+    uint8_t idle_level;
+    bool truncated;         // More than RMT_SIM_MAX_EDGES edges, or no end marker
+    uint16_t num_edges;
+    rmt_sim_edge_t edges[RMT_SIM_MAX_EDGES];
+} rmt_sim_capture_t;
+
+/**
+ * @brief Copy out the capture of a channel's last transmission
+ *
+ * @return false if the channel has never transmitted
+ */
+bool rmt_sim_get_capture(rmt_channel_t channel, rmt_sim_capture_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,28 @@
+/**
+ * @file rmt_struct.h
+ * @brief Host stand-in for the RMT RAM layout
+ *
+ * RMTMEM is plain memory in the simulator; the RMT model reads a
+ * channel's items from here when it is started.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "soc/soc_caps.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    struct {
+        volatile uint32_t data32[SOC_RMT_MEM_WORDS_PER_CHANNEL];
+    } chan[SOC_RMT_CHANNELS_PER_GROUP];
+} rmt_mem_t;
+
+extern rmt_mem_t RMTMEM;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,13 @@
+/**
+ * @file soc_caps.h
+ * @brief Host stand-in for the ESP32-S3 capabilities the firmware uses
+ */
+
+#pragma once
+
+#define SOC_RMT_GROUPS                  1
+#define SOC_RMT_TX_CANDIDATES_PER_GROUP 4
+#define SOC_RMT_RX_CANDIDATES_PER_GROUP 4
+#define SOC_RMT_CHANNELS_PER_GROUP      8
+#define SOC_RMT_MEM_WORDS_PER_CHANNEL   48
+#define SOC_RMT_SUPPORT_TX_SYNCHRO      1
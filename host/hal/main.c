@@ -0,0 +1,86 @@
+/**
+ * @file main.c
+ * @brief Entry point of the Linux emulator build of the firmware
+ *
+ * Runs app_main() from src/main_rmt.c on the host HAL and keeps the
+ * process alive for its tasks. SIGUSR1 presses the boot button, SIGUSR2
+ * closes a bouncing contact on trigger input 0.
+ *
+ * Usage: dpt_emu [-a addr] [-p port]    (default 127.0.0.1:8080)
+ */
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_sim.h"
+
+#define EMU_DEFAULT_PORT    8080
+#define EMU_BUTTON_GPIO     0       // BUTTON_GPIO in main_rmt.c
+#define EMU_TRIGGER_GPIO    1       // trigger_gpio[0] in main_rmt.c
+#define EMU_TRIGGER_BOUNCES 3
+
+void app_main(void);
+
+// Presses and releases the button for every SIGUSR1. SIGUSR2 closes the
+// trigger 0 contact with a few bounces, which the lockout has to absorb.
+static void *signal_thread(void *arg) {
+    sigset_t *set = arg;
+    int sig;
+    while (sigwait(set, &sig) == 0) {
+        if (sig == SIGUSR1) {
+            gpio_sim_drive(EMU_BUTTON_GPIO, 0);
+            vTaskDelay(pdMS_TO_TICKS(50));
+            gpio_sim_drive(EMU_BUTTON_GPIO, 1);
+        } else if (sig == SIGUSR2) {
+            for (int bounce = 0; bounce < EMU_TRIGGER_BOUNCES; bounce++) {
+                gpio_sim_drive(EMU_TRIGGER_GPIO, 0);
+                usleep(200);
+                gpio_sim_drive(EMU_TRIGGER_GPIO, 1);
+                usleep(200);
+            }
+            gpio_sim_drive(EMU_TRIGGER_GPIO, 0);
+            vTaskDelay(pdMS_TO_TICKS(50));
+            gpio_sim_drive(EMU_TRIGGER_GPIO, 1);
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    const char *addr = "127.0.0.1";
+    int port = EMU_DEFAULT_PORT;
+    int opt;
+    while ((opt = getopt(argc, argv, "a:p:")) != -1) {
+        switch (opt) {
+        case 'a': addr = optarg; break;
+        case 'p': port = atoi(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-a addr] [-p port]\n", argv[0]);
+            return 2;
+        }
+    }
+    httpd_sim_listen(addr, (uint16_t)port);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    // Every thread created from here on inherits the blocked signals
+    static sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    sigaddset(&set, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+    pthread_t thread;
+    pthread_create(&thread, NULL, signal_thread, &set);
+    pthread_detach(thread);
+
+    printf("DPT emulator, pid %d; kill -USR1 %d presses the button, -USR2 trigger input 0\n",
+           (int)getpid(), (int)getpid());
+    app_main();
+
+    // app_main returns on the device too; its tasks keep running
+    pthread_exit(NULL);
+}
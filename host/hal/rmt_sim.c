@@ -0,0 +1,376 @@
+/**
+ * @file rmt_sim.c
+ * @brief Simulated RMT TX channels behind the legacy driver API
+ *
+ * A started channel decodes its items the way the hardware does - each
+ * word is two (level, duration) halves and a zero duration ends the
+ * transmission - and records the edges it would put on its pin. A single
+ * "interrupt" thread raises the TX end callback when the real duration of
+ * the items has passed, so waiting on it takes as long as on the device.
+ *
+ * Channels added to the TX sync group start together: each one started
+ * waits until every member of the group is started.
+ *
+ * The channel output is routed to its pin in the simulated GPIO matrix.
+ * The edges of a transmission reach the pin all at once when it starts,
+ * and setup and teardown change the pin the way the legacy driver does.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include "driver/rmt.h"
+#include "soc/rmt_struct.h"
+#include "esp_log.h"
+#include "host_sim.h"
+
+#define TAG "RMT_SIM"
+
+#define RMT_SIM_APB_HZ      80000000    // RMT source clock
+
+rmt_mem_t RMTMEM;
+
+typedef struct {
+    bool configured;
+    bool installed;
+    rmt_config_t config;
+    bool busy;
+    int64_t end_ns;
+    uint8_t out_level;      // Channel output signal
+    rmt_sim_capture_t capture;
+    // Held by the sync group until every member is started
+    const volatile uint32_t *sync_words;
+    uint32_t sync_max_words;
+    bool sync_end_implied;
+} sim_channel_t;
+
+static sim_channel_t channels[RMT_CHANNEL_MAX];
+static rmt_tx_end_callback_t tx_end_callback;
+static pthread_mutex_t rmt_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rmt_cond;
+static pthread_t isr_thread;
+static bool isr_thread_started = false;
+static uint32_t sync_mask;          // TX sync group members
+static uint32_t sync_started;       //   started and waiting for the rest
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static bool valid_tx(rmt_channel_t channel) {
+    return channel >= 0 && channel < SOC_RMT_TX_CANDIDATES_PER_GROUP && channels[channel].installed &&
+           channels[channel].config.rmt_mode == RMT_MODE_TX;
+}
+
+// ---------------------- Interrupt Thread ----------------------
+static void *isr_thread_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&rmt_lock);
+    while (1) {
+        int next = -1;
+        for (int ch = 0; ch < RMT_CHANNEL_MAX; ch++) {
+            if (channels[ch].busy && (next < 0 || channels[ch].end_ns < channels[next].end_ns)) {
+                next = ch;
+            }
+        }
+        if (next < 0) {
+            pthread_cond_wait(&rmt_cond, &rmt_lock);
+            continue;
+        }
+        int64_t end = channels[next].end_ns;
+        if (now_ns() < end) {
+            struct timespec ts = { .tv_sec = end / 1000000000LL, .tv_nsec = end % 1000000000LL };
+            pthread_cond_timedwait(&rmt_cond, &rmt_lock, &ts);
+            continue;
+        }
+
+        channels[next].busy = false;
+        pthread_cond_broadcast(&rmt_cond);
+        rmt_tx_end_callback_t cb = tx_end_callback;
+        pthread_mutex_unlock(&rmt_lock);
+        if (cb.function) {
+            cb.function((rmt_channel_t)next, cb.arg);
+        }
+        pthread_mutex_lock(&rmt_lock);
+    }
+    return NULL;
+}
+
+// ---------------------- Output Signal ----------------------
+static void set_output(sim_channel_t *c, uint8_t level) {
+    c->out_level = level;
+    if (c->configured) {
+        gpio_sim_signal(c->config.gpio_num, level);
+    }
+}
+
+// ---------------------- Transmission ----------------------
+// Decode items into the channel's capture and schedule its end; rmt_lock held.
+// end_implied: the driver appends an end marker after the last word
+static void transmit(rmt_channel_t channel, const volatile uint32_t *words, uint32_t max_words, bool end_implied,
+                     int64_t start_ns) {
+    sim_channel_t *c = &channels[channel];
+    rmt_sim_capture_t *cap = &c->capture;
+    uint8_t idle = c->config.tx_config.idle_level;
+    uint8_t level = idle;
+    uint32_t tick = 0;
+    bool ended = false;
+
+    cap->shots++;
+    cap->start_ns = start_ns;
+    cap->idle_level = idle;
+    cap->truncated = false;
+    cap->num_edges = 0;
+
+    for (uint32_t w = 0; w < max_words && !ended; w++) {
+        uint32_t word = words[w];
+        for (int h = 0; h < 2; h++) {
+            uint32_t half = h ? word >> 16 : word & 0xFFFF;
+            uint32_t duration = half & 0x7FFF;
+            uint8_t half_level = half >> 15;
+            if (duration == 0) {
+                ended = true;
+                break;
+            }
+            if (half_level != level) {
+                if (cap->num_edges < RMT_SIM_MAX_EDGES) {
+                    cap->edges[cap->num_edges++] = (rmt_sim_edge_t){ tick, half_level };
+                } else {
+                    cap->truncated = true;
+                }
+                level = half_level;
+            }
+            tick += duration;
+        }
+    }
+    if (!ended && !end_implied) {
+        ESP_LOGW(TAG, "Channel %d ran off its %u RAM words without an end marker", channel, max_words);
+        cap->truncated = true;
+    }
+    if (c->config.tx_config.idle_output_en && level != idle) {
+        if (cap->num_edges < RMT_SIM_MAX_EDGES) {
+            cap->edges[cap->num_edges++] = (rmt_sim_edge_t){ tick, idle };
+        } else {
+            cap->truncated = true;
+        }
+    }
+    cap->total_ticks = tick;
+    for (uint16_t e = 0; e < cap->num_edges; e++) {
+        set_output(c, cap->edges[e].level);
+    }
+
+    double tick_ns = 1e9 * (c->config.clk_div ? c->config.clk_div : 256) / RMT_SIM_APB_HZ;
+    c->end_ns = cap->start_ns + (int64_t)(tick * tick_ns);
+    c->busy = true;
+    pthread_cond_broadcast(&rmt_cond);
+}
+
+// A member of the sync group waits until the whole group is started, then
+// every member starts at the same instant; rmt_lock held
+static void start_tx(rmt_channel_t channel, const volatile uint32_t *words, uint32_t max_words, bool end_implied) {
+    if (!(sync_mask & (1u << channel))) {
+        transmit(channel, words, max_words, end_implied, now_ns());
+        return;
+    }
+    sim_channel_t *c = &channels[channel];
+    c->sync_words = words;
+    c->sync_max_words = max_words;
+    c->sync_end_implied = end_implied;
+    sync_started |= 1u << channel;
+    if (sync_started != sync_mask) {
+        return;
+    }
+    int64_t start = now_ns();
+    sync_started = 0;
+    for (int ch = 0; ch < RMT_CHANNEL_MAX; ch++) {
+        if (sync_mask & (1u << ch)) {
+            transmit(ch, channels[ch].sync_words, channels[ch].sync_max_words, channels[ch].sync_end_implied, start);
+        }
+    }
+}
+
+// ---------------------- Driver API ----------------------
+esp_err_t rmt_config(const rmt_config_t *rmt_param) {
+    if (rmt_param == NULL || rmt_param->channel >= RMT_CHANNEL_MAX || rmt_param->mem_block_num == 0 ||
+        rmt_param->channel + rmt_param->mem_block_num > SOC_RMT_CHANNELS_PER_GROUP) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (rmt_param->rmt_mode == RMT_MODE_TX && rmt_param->channel >= SOC_RMT_TX_CANDIDATES_PER_GROUP) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&rmt_lock);
+    sim_channel_t *c = &channels[rmt_param->channel];
+    c->config = *rmt_param;
+    c->configured = true;
+    // The driver routes the pin before it programs the idle level, so the
+    // pin shows the channel's current output (low after reset) in between
+    gpio_sim_connect_signal(rmt_param->gpio_num, c->out_level);
+    if (rmt_param->rmt_mode == RMT_MODE_TX && rmt_param->tx_config.idle_output_en) {
+        set_output(c, rmt_param->tx_config.idle_level);
+    }
+    pthread_mutex_unlock(&rmt_lock);
+    return ESP_OK;
+}
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags) {
+    (void)rx_buf_size;
+    (void)intr_alloc_flags;
+    if (channel < 0 || channel >= RMT_CHANNEL_MAX || !channels[channel].configured) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&rmt_lock);
+    if (channels[channel].installed) {
+        pthread_mutex_unlock(&rmt_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    channels[channel].installed = true;
+    if (!isr_thread_started) {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&rmt_cond, &attr);
+        pthread_condattr_destroy(&attr);
+        pthread_create(&isr_thread, NULL, isr_thread_main, NULL);
+        pthread_detach(isr_thread);
+        isr_thread_started = true;
+    }
+    pthread_mutex_unlock(&rmt_lock);
+    return ESP_OK;
+}
+
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel) {
+    if (channel < 0 || channel >= RMT_CHANNEL_MAX || !channels[channel].installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    pthread_mutex_lock(&rmt_lock);
+    channels[channel].installed = false;
+    channels[channel].busy = false;
+    // Uninstalling the last channel disables the RMT module, which resets
+    // every channel's output to low
+    bool any_installed = false;
+    for (int ch = 0; ch < RMT_CHANNEL_MAX; ch++) {
+        any_installed |= channels[ch].installed;
+    }
+    for (int ch = 0; ch < RMT_CHANNEL_MAX && !any_installed; ch++) {
+        set_output(&channels[ch], 0);
+    }
+    pthread_mutex_unlock(&rmt_lock);
+    return ESP_OK;
+}
+
+esp_err_t rmt_tx_start(rmt_channel_t channel, bool tx_idx_rst) {
+    (void)tx_idx_rst;   // Always starts from the top of the channel's RAM
+    if (!valid_tx(channel)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&rmt_lock);
+    // A channel with several blocks owns the following channels' RAM as well
+    const volatile uint32_t *ram = RMTMEM.chan[channel].data32;
+    start_tx(channel, ram, channels[channel].config.mem_block_num * SOC_RMT_MEM_WORDS_PER_CHANNEL, false);
+    pthread_mutex_unlock(&rmt_lock);
+    return ESP_OK;
+}
+
+esp_err_t rmt_add_channel_to_group(rmt_channel_t channel) {
+    if (!valid_tx(channel)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&rmt_lock);
+    sync_mask |= 1u << channel;
+    pthread_mutex_unlock(&rmt_lock);
+    return ESP_OK;
+}
+
+esp_err_t rmt_remove_channel_from_group(rmt_channel_t channel) {
+    if (channel < 0 || channel >= SOC_RMT_TX_CANDIDATES_PER_GROUP) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&rmt_lock);
+    sync_mask &= ~(1u << channel);
+    sync_started &= ~(1u << channel);
+    pthread_mutex_unlock(&rmt_lock);
+    return ESP_OK;
+}
+
+esp_err_t rmt_tx_stop(rmt_channel_t channel) {
+    if (!valid_tx(channel)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&rmt_lock);
+    channels[channel].busy = false;
+    pthread_cond_broadcast(&rmt_cond);
+    pthread_mutex_unlock(&rmt_lock);
+    return ESP_OK;
+}
+
+esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t *rmt_item, int item_num, bool wait_tx_done) {
+    if (!valid_tx(channel) || rmt_item == NULL || item_num <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&rmt_lock);
+    // The driver refills the RAM from rmt_item, so the whole buffer is sent
+    start_tx(channel, (const volatile uint32_t *)&rmt_item[0].val, (uint32_t)item_num, true);
+    pthread_mutex_unlock(&rmt_lock);
+    return wait_tx_done ? rmt_wait_tx_done(channel, portMAX_DELAY) : ESP_OK;
+}
+
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time) {
+    if (!valid_tx(channel)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = ESP_OK;
+    pthread_mutex_lock(&rmt_lock);
+    if (wait_time == portMAX_DELAY) {
+        while (channels[channel].busy) {
+            pthread_cond_wait(&rmt_cond, &rmt_lock);
+        }
+    } else {
+        int64_t end = now_ns() + (int64_t)wait_time * (1000000000LL / configTICK_RATE_HZ);
+        struct timespec ts = { .tv_sec = end / 1000000000LL, .tv_nsec = end % 1000000000LL };
+        while (channels[channel].busy) {
+            if (pthread_cond_timedwait(&rmt_cond, &rmt_lock, &ts) == ETIMEDOUT) {
+                err = channels[channel].busy ? ESP_ERR_TIMEOUT : ESP_OK;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&rmt_lock);
+    return err;
+}
+
+esp_err_t rmt_set_idle_level(rmt_channel_t channel, bool idle_out_en, rmt_idle_level_t level) {
+    if (channel < 0 || channel >= RMT_CHANNEL_MAX || !channels[channel].configured) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&rmt_lock);
+    channels[channel].config.tx_config.idle_output_en = idle_out_en;
+    channels[channel].config.tx_config.idle_level = level;
+    if (idle_out_en && !channels[channel].busy) {
+        set_output(&channels[channel], level);
+    }
+    pthread_mutex_unlock(&rmt_lock);
+    return ESP_OK;
+}
+
+rmt_tx_end_callback_t rmt_register_tx_end_callback(rmt_tx_end_fn_t function, void *arg) {
+    pthread_mutex_lock(&rmt_lock);
+    rmt_tx_end_callback_t previous = tx_end_callback;
+    tx_end_callback.function = function;
+    tx_end_callback.arg = arg;
+    pthread_mutex_unlock(&rmt_lock);
+    return previous;
+}
+
+// ---------------------- Simulator ----------------------
+bool rmt_sim_get_capture(rmt_channel_t channel, rmt_sim_capture_t *out) {
+    if (channel < 0 || channel >= RMT_CHANNEL_MAX) {
+        return false;
+    }
+    pthread_mutex_lock(&rmt_lock);
+    *out = channels[channel].capture;
+    pthread_mutex_unlock(&rmt_lock);
+    return out->shots > 0;
+}
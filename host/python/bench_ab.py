@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+"""
+Run the timing benchmark on a build and compare two builds' results.
+
+Flash one profile (pio run -e um_tinys3), record a run, flash the other
+(pio run -e um_tinys3_lowjitter), record again, then compare:
+
+    python3 host/python/bench_ab.py run -H 192.168.4.1 -o default.json
+    python3 host/python/bench_ab.py run -H 192.168.4.1 -o lowjitter.json
+    python3 host/python/bench_ab.py compare default.json lowjitter.json
+
+Each result is the final GET /bench body: trigger latency (alarm to both
+channels started), ISR entry and task wake-up latency, and the captured
+edge time error of the P output, all in ns.
+"""
+
+import argparse
+import asyncio
+import json
+import sys
+
+from dpt_client import Client
+
+STATS = ("start", "entry", "wake", "edge_error")
+
+
+async def run(host, port, recipe, shots, interval_ms):
+    async with Client(host, port) as dpt:
+        resp = await dpt.start_bench(recipe, shots, interval_ms)
+        if not resp.ok:
+            raise SystemExit("POST /bench failed: HTTP %d %s" % (resp.status, resp.body.decode(errors="replace")))
+        while True:
+            await asyncio.sleep(0.5)
+            status = await dpt.bench()
+            print("\r%s %d/%d" % (status["state"], status["shots"], shots), end="", file=sys.stderr)
+            if status["state"] != "running":
+                print(file=sys.stderr)
+                return status
+
+
+def describe(result):
+    p = result.get("profile", {})
+    return "%s (%s MHz, %s Hz tick)" % (p.get("name", "?"), p.get("cpu_mhz", "?"), p.get("tick_hz", "?"))
+
+
+def compare(a, b):
+    print("A: %s, %d shots, %s" % (describe(a), a["shots"], a["state"]))
+    print("B: %s, %d shots, %s" % (describe(b), b["shots"], b["state"]))
+    print()
+    print("%-12s %-6s %12s %12s %10s" % ("ns", "", "A", "B", "B/A"))
+    for name in STATS:
+        sa, sb = a.get(name), b.get(name)
+        if not sa or not sb or not sa["count"] or not sb["count"]:
+            continue
+        for key in ("mean_ns", "std_ns", "max_ns"):
+            va, vb = sa[key], sb[key]
+            ratio = "%.2f" % (vb / va) if va else "-"
+            print("%-12s %-6s %12.1f %12.1f %10s" % (name, key[:-3], va, vb, ratio))
+    for key in ("busy", "edge_mismatches"):
+        print("%-19s %12d %12d" % (key, a[key], b[key]))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    r = sub.add_parser("run", help="Run the benchmark and save the result")
+    r.add_argument("-H", "--host", default="192.168.4.1")
+    r.add_argument("-p", "--port", type=int, default=80)
+    r.add_argument("--recipe", help="Baked recipe (default: the first one)")
+    r.add_argument("--shots", type=int, default=2000)
+    r.add_argument("--interval-ms", type=int, default=5)
+    r.add_argument("-o", "--output", help="Result JSON")
+    c = sub.add_parser("compare", help="Compare two saved results")
+    c.add_argument("a")
+    c.add_argument("b")
+    args = ap.parse_args()
+
+    if args.cmd == "run":
+        result = asyncio.run(run(args.host, args.port, args.recipe, args.shots, args.interval_ms))
+        if args.output:
+            with open(args.output, "w") as f:
+                json.dump(result, f, indent=1)
+        else:
+            json.dump(result, sys.stdout, indent=1)
+            print()
+        return 0 if result["state"] == "done" else 1
+
+    with open(args.a) as f:
+        a = json.load(f)
+    with open(args.b) as f:
+        b = json.load(f)
+    compare(a, b)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,483 @@
+"""
+Host client library for the DPT signal generator (Python).
+
+Mirrors host/client/dpt_client.hpp: one keep-alive HTTP/1.1 connection,
+requests are written as soon as they are issued and responses are matched
+to them in order, so independent calls pipeline when awaited together:
+
+    async with Client("192.168.4.1") as dpt:
+        await asyncio.gather(dpt.set(DoublePulse(p1h_us=10)), dpt.fire(), dpt.status())
+"""
+
+import asyncio
+import collections
+import dataclasses
+import json
+import struct
+
+__all__ = ["DoublePulse", "Response", "Status", "Edge", "ChannelEdges", "EdgeList", "TraceEvent", "TraceDump", "Client"]
+
+
+# ---------------------- Recipes ----------------------
+@dataclasses.dataclass
+class DoublePulse:
+    """Classic double pulse; times in microseconds, as accepted by POST /set."""
+    p1h_us: float = 5.0
+    p1l_us: float = 1.0
+    p2h_us: float = 3.0
+    p2l_us: float = 10000.0
+
+    def encode(self) -> bytes:
+        return ("p1h=%.4f&p1l=%.4f&p2h=%.4f&p2l=%.4f"
+                % (self.p1h_us, self.p1l_us, self.p2h_us, self.p2l_us)).encode()
+
+
+# ---------------------- Responses ----------------------
+@dataclasses.dataclass
+class Response:
+    status: int
+    content_type: str
+    body: bytes
+
+    @property
+    def ok(self) -> bool:
+        return 200 <= self.status < 300
+
+
+@dataclasses.dataclass
+class Status:
+    p1h_us: float
+    p1l_us: float
+    p2h_us: float
+    p2l_us: float
+    hash: int
+    items: int
+    total_ticks: int
+    shots: int
+    uptime_us: int
+    free_heap: int
+    source: str = "params"
+
+    @classmethod
+    def parse(cls, body: bytes) -> "Status":
+        d = json.loads(body)
+        return cls(d["p1h"], d["p1l"], d["p2h"], d["p2l"], int(d["hash"], 16), d["items"],
+                   d["total_ticks"], d["shots"], d["uptime_us"], d["free_heap"], d.get("source", "params"))
+
+
+@dataclasses.dataclass
+class Edge:
+    tick: int
+    level: int
+
+
+@dataclasses.dataclass
+class ChannelEdges:
+    items: int
+    gpio: int
+    idle: int
+    edges: list
+
+
+@dataclasses.dataclass
+class EdgeList:
+    hash: int
+    total_ticks: int
+    channels: list
+
+    @classmethod
+    def decode(cls, data: bytes) -> "EdgeList":
+        """Decode the binary form of GET /plan?format=bin."""
+        if len(data) < 16 or data[:4] != b"DPTE" or data[4] != 1:
+            raise ValueError("not a version 1 DPTE edge list")
+        nch = data[5]
+        hash_, total = struct.unpack_from("<II", data, 8)
+        off = 16
+        channels = []
+        for _ in range(nch):
+            items, gpio, idle, count = struct.unpack_from("<HBBI", data, off)
+            off += 8
+            raw = struct.unpack_from("<%dI" % count, data, off)
+            off += 4 * count
+            channels.append(ChannelEdges(items, gpio, idle, [Edge(e >> 1, e & 1) for e in raw]))
+        return cls(hash_, total, channels)
+
+
+# Event types and markers in GET /trace (src/dpt_trace.h)
+TRACE_TASK_IN, TRACE_ISR_ENTER, TRACE_ISR_EXIT, TRACE_MARK = 1, 2, 3, 4
+TRACE_MARKS = {1: "armed", 2: "shot_begin", 3: "rmt_start", 4: "rmt_done", 5: "shot_end"}
+TRACE_ISRS = {0x100: "button", 0x101: "rmt_tx_end", 0x102: "trigger"}
+TRACE_ISR_CPU_INT = 0x200      # + CPU interrupt number, from the interrupt wrappers
+
+
+@dataclasses.dataclass
+class TraceEvent:
+    time_us: float      # esp_timer time, aligned across cores
+    core: int
+    type: int
+    arg: int
+
+
+@dataclasses.dataclass
+class TraceDump:
+    cpu_hz: int
+    lost: int
+    pre_us: int
+    post_us: int
+    recording: bool
+    window_cut: bool
+    tasks: dict         # handle -> name
+    events: list
+
+    @classmethod
+    def decode(cls, data: bytes) -> "TraceDump":
+        """Decode GET /trace."""
+        if len(data) < 32 or data[:4] != b"DPTT" or data[4] != 1:
+            raise ValueError("not a version 1 DPTT trace")
+        cores, ntasks = data[5], struct.unpack_from("<H", data, 6)[0]
+        cpu_hz, count, lost, pre_us, post_us, flags = struct.unpack_from("<6I", data, 8)
+        off = 32
+        sync = []
+        for _ in range(cores):
+            sync.append(struct.unpack_from("<qII", data, off))
+            off += 16
+        tasks = {}
+        for _ in range(ntasks):
+            handle, name = struct.unpack_from("<I16s", data, off)
+            tasks[handle] = name.split(b"\0", 1)[0].decode(errors="replace")
+            off += 20
+        mhz = cpu_hz / 1e6
+        events = []
+        for _ in range(count):
+            cycles, arg, type_, core = struct.unpack_from("<IIBB", data, off)
+            off += 12
+            time_us, base, _valid = sync[core]
+            delta = (cycles - base) & 0xFFFFFFFF
+            if delta >= 1 << 31:
+                delta -= 1 << 32
+            events.append(TraceEvent(time_us + delta / mhz, core, type_, arg))
+        return cls(cpu_hz, lost, pre_us, post_us, bool(flags & 1), bool(flags & 2), tasks, events)
+
+
+# ---------------------- Client ----------------------
+class Client:
+    def __init__(self, host: str, port: int = 80, max_in_flight: int = 8):
+        self.host = host
+        self.port = port
+        self._window = asyncio.Semaphore(max(1, max_in_flight))
+        self._write_lock = asyncio.Lock()
+        self._pending = collections.deque()
+        self._reader = None
+        self._writer = None
+        self._reader_task = None
+        self._wakeup = asyncio.Event()
+        self._closing = False
+
+    async def __aenter__(self):
+        await self.connect()
+        return self
+
+    async def __aexit__(self, *exc):
+        await self.close()
+
+    async def connect(self):
+        self._closing = False
+        self._reader, self._writer = await asyncio.open_connection(self.host, self.port)
+        self._reader_task = asyncio.ensure_future(self._read_loop())
+
+    async def close(self):
+        self._closing = True
+        self._wakeup.set()
+        if self._writer is not None:
+            self._writer.close()
+            try:
+                await self._writer.wait_closed()
+            except OSError:
+                pass
+        if self._reader_task is not None:
+            await asyncio.gather(self._reader_task, return_exceptions=True)
+        self._writer = self._reader = self._reader_task = None
+
+    async def request(self, method: str, path: str, body: bytes = b"", content_type: str = "") -> Response:
+        head = "%s %s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n" % (method, path, self.host)
+        if body or method == "POST":
+            if content_type:
+                head += "Content-Type: %s\r\n" % content_type
+            head += "Content-Length: %d\r\n" % len(body)
+        data = (head + "\r\n").encode() + body
+
+        async with self._window:
+            async with self._write_lock:
+                if self._writer is None:
+                    await self.connect()
+                fut = asyncio.get_running_loop().create_future()
+                # Queue before writing so responses are matched in send order
+                self._pending.append(fut)
+                self._wakeup.set()
+                self._writer.write(data)
+                await self._writer.drain()
+            return await fut
+
+    async def set(self, recipe: DoublePulse) -> Response:
+        return await self.request("POST", "/set", recipe.encode(), "application/x-www-form-urlencoded")
+
+    async def fire(self) -> Response:
+        return await self.request("GET", "/trigger")
+
+    async def status(self) -> Status:
+        return Status.parse((await self.request("GET", "/status")).body)
+
+    async def plan(self) -> EdgeList:
+        return EdgeList.decode((await self.request("GET", "/plan?format=bin")).body)
+
+    async def upload(self, blob: bytes) -> Response:
+        """Arm a binary plan produced by dptc."""
+        return await self.request("POST", "/plan", blob, "application/octet-stream")
+
+    async def shots(self, n: int = 16) -> list:
+        """Most recent shot records, newest first (GET /shots)."""
+        return json.loads((await self.request("GET", "/shots?n=%d" % n)).body)
+
+    async def pin_selftest(self, n: int = 10, shot: bool = False) -> dict:
+        """Reconfigure the RMT n times and count edges on the outputs (GET /selftest/pins)."""
+        return json.loads((await self.request("GET", "/selftest/pins?n=%d&shot=%d" % (n, shot))).body)
+
+    async def trace(self) -> TraceDump:
+        """Timeline of the last shot."""
+        return TraceDump.decode((await self.request("GET", "/trace")).body)
+
+    async def trace_window(self, pre_us: int, post_us: int, enable: bool = True) -> Response:
+        body = "enable=%d&pre_us=%d&post_us=%d" % (enable, pre_us, post_us)
+        return await self.request("POST", "/trace", body.encode(), "application/x-www-form-urlencoded")
+
+    async def downloads(self) -> dict:
+        """Throughput of the trace, shot log and plan downloads."""
+        return json.loads((await self.request("GET", "/downloads")).body)
+
+    async def recipes(self) -> list:
+        """Plans baked into the firmware image."""
+        return json.loads((await self.request("GET", "/recipes")).body)
+
+    async def arm_recipe(self, name: str) -> Response:
+        return await self.request("POST", "/recipes", ("name=%s" % name).encode(), "application/x-www-form-urlencoded")
+
+    async def store_preset(self, preset: int, blob: bytes = b"") -> Response:
+        """Store a compiled plan in a preset slot; an empty blob stores the armed plan."""
+        return await self.request("POST", "/preset?id=%d" % preset, blob, "application/octet-stream")
+
+    async def clear_preset(self, preset: int) -> Response:
+        return await self.request("POST", "/preset?id=%d&clear=1" % preset)
+
+    async def triggers(self) -> dict:
+        """Trigger inputs with their counters, and the preset slots."""
+        return json.loads((await self.request("GET", "/triggers")).body)
+
+    async def configure_triggers(self, filter_ns: int = None, lockout_us: int = None, presets: dict = None) -> Response:
+        """presets maps a trigger GPIO to a preset slot, or -1 to disconnect it."""
+        fields = []
+        if filter_ns is not None:
+            fields.append("filter_ns=%d" % filter_ns)
+        if lockout_us is not None:
+            fields.append("lockout_us=%d" % lockout_us)
+        fields += ["gpio%d=%d" % (gpio, preset) for gpio, preset in (presets or {}).items()]
+        return await self.request("POST", "/triggers", "&".join(fields).encode(), "application/x-www-form-urlencoded")
+
+    async def start_sweep(self, param: str, start_us: float, step_us: float, points: int, interval_ms: int = 0) -> Response:
+        """Step one of p1h, p1l, p2h, p2l; the others keep their /set values. 409 while a sweep runs."""
+        body = "param=%s&start=%g&step=%g&points=%d&interval_ms=%d" % (param, start_us, step_us, points, interval_ms)
+        return await self.request("POST", "/sweep", body.encode(), "application/x-www-form-urlencoded")
+
+    async def stop_sweep(self) -> Response:
+        return await self.request("POST", "/sweep", b"stop=1", "application/x-www-form-urlencoded")
+
+    async def sweep(self) -> dict:
+        """Progress and pipeline statistics of the running or last sweep."""
+        return json.loads((await self.request("GET", "/sweep")).body)
+
+    async def configure_logic(self, enable: bool = True, rate_mhz: int = None, aux: list = None) -> Response:
+        """rate_mhz is 10, 20 or 40; aux lists up to six GPIOs sampled as bits 2-7. 503 without LCD_CAM."""
+        fields = ["enable=%d" % enable]
+        if rate_mhz is not None:
+            fields.append("rate_mhz=%d" % rate_mhz)
+        if aux is not None:
+            fields.append("aux=%s" % ",".join(str(g) for g in aux))
+        return await self.request("POST", "/logic", "&".join(fields).encode(), "application/x-www-form-urlencoded")
+
+    async def logic(self) -> dict:
+        """Last logic capture and how its P/N edges compare to the plan."""
+        return json.loads((await self.request("GET", "/logic")).body)
+
+    async def logic_vcd(self) -> str:
+        return (await self.request("GET", "/logic?format=vcd")).body.decode()
+
+    async def configure_delay(self, enable: bool = True, gate: int = None, vds: int = None,
+                              gate_on: str = None, vds_on: str = None, reset: bool = False) -> Response:
+        """Comparator inputs for td(on)/td(off); gate_on/vds_on is "rise" or "fall". 503 without MCPWM."""
+        fields = ["enable=%d" % enable]
+        for key, value in (("gate", gate), ("vds", vds), ("gate_on", gate_on), ("vds_on", vds_on)):
+            if value is not None:
+                fields.append("%s=%s" % (key, value))
+        if reset:
+            fields.append("reset=1")
+        return await self.request("POST", "/delay", "&".join(fields).encode(), "application/x-www-form-urlencoded")
+
+    async def delay(self) -> dict:
+        """Switching delay statistics and the last shot's delays per commanded edge."""
+        return json.loads((await self.request("GET", "/delay")).body)
+
+    async def configure_adc(self, enable: bool = True, **inputs) -> Response:
+        """Analog capture; inputs are current_/vbus_ gpio, scale (A or V per V at the pad) and offset_mv.
+        503 without the continuous ADC."""
+        fields = ["enable=%d" % enable] + ["%s=%s" % item for item in inputs.items()]
+        return await self.request("POST", "/adc", "&".join(fields).encode(), "application/x-www-form-urlencoded")
+
+    async def adc(self) -> dict:
+        """Latest analog values and the last shot's peaks."""
+        return json.loads((await self.request("GET", "/adc")).body)
+
+    async def configure_interlock(self, enable: bool = True, vbus_min: float = None, vbus_max: float = None,
+                                  frames: int = None, timeout_ms: int = None, reset: bool = False) -> Response:
+        """Hold shots until the bus voltage is in [vbus_min, vbus_max]. 503 without a vbus input."""
+        fields = ["enable=%d" % enable]
+        for key, value in (("vbus_min", vbus_min), ("vbus_max", vbus_max), ("frames", frames),
+                           ("timeout_ms", timeout_ms)):
+            if value is not None:
+                fields.append("%s=%s" % (key, value))
+        if reset:
+            fields.append("reset=1")
+        return await self.request("POST", "/interlock", "&".join(fields).encode(), "application/x-www-form-urlencoded")
+
+    async def interlock(self) -> dict:
+        """Bus window and the waits shots had for it."""
+        return json.loads((await self.request("GET", "/interlock")).body)
+
+    async def configure_thermal(self, dut: int = None, select: bool = False, enable: bool = None,
+                                rth: list = None, tau_ms: list = None, reset: bool = False, **params) -> Response:
+        """Junction temperature model of a DUT; params are p_on_w, e_on_uj, e_off_uj, t_case, limit, margin
+        and max_wait_ms."""
+        fields = ["%s=%s" % item for item in params.items()]
+        if dut is not None:
+            fields.append("dut=%d" % dut)
+        if enable is not None:
+            fields.append("enable=%d" % enable)
+        if rth is not None:
+            fields.append("rth=" + ",".join("%g" % r for r in rth))
+        if tau_ms is not None:
+            fields.append("tau_ms=" + ",".join("%g" % t for t in tau_ms))
+        if select:
+            fields.append("select=1")
+        if reset:
+            fields.append("reset=1")
+        return await self.request("POST", "/thermal", "&".join(fields).encode(), "application/x-www-form-urlencoded")
+
+    async def thermal(self) -> dict:
+        """Junction temperature estimates and throttling counters of every DUT."""
+        return json.loads((await self.request("GET", "/thermal")).body)
+
+    async def start_target(self, target_a: float, **limits) -> Response:
+        """Closed-loop first pulse for a peak current; limits are tol_a, limit_a, p1h_min, p1h_max,
+        max_step, shots and interval_ms."""
+        fields = ["target_a=%s" % target_a] + ["%s=%s" % item for item in limits.items()]
+        return await self.request("POST", "/target", "&".join(fields).encode(), "application/x-www-form-urlencoded")
+
+    async def stop_target(self) -> Response:
+        return await self.request("POST", "/target", b"stop=1", "application/x-www-form-urlencoded")
+
+    async def target(self) -> dict:
+        """State of the running or last targeting run, one step per shot."""
+        return json.loads((await self.request("GET", "/target")).body)
+
+    async def start_batch(self, duts: list, recipes: list, lines: list = None, limits: list = None,
+                          **options) -> Response:
+        """Test each matrix position with the baked recipes. limits are (metric, min, max) or
+        (metric, min, max, recipe index) with None for an open side; options are enable, matrix,
+        active_low, settle_ms, shots and interval_ms."""
+        fields = ["duts=" + ",".join(str(d) for d in duts), "recipes=" + ",".join(recipes)]
+        if lines is not None:
+            fields.append("lines=" + ",".join(str(g) for g in lines))
+        if limits is not None:
+            entries = []
+            for limit in limits:
+                metric, lo, hi = limit[:3]
+                name = metric if len(limit) < 4 else "%s@%d" % (metric, limit[3])
+                entries.append("%s:%s:%s" % (name, "" if lo is None else lo, "" if hi is None else hi))
+            fields.append("limits=" + ",".join(entries))
+        fields += ["%s=%s" % (k, int(v) if isinstance(v, bool) else v) for k, v in options.items()]
+        return await self.request("POST", "/batch", "&".join(fields).encode(), "application/x-www-form-urlencoded")
+
+    async def stop_batch(self) -> Response:
+        return await self.request("POST", "/batch", b"stop=1", "application/x-www-form-urlencoded")
+
+    async def batch(self) -> dict:
+        """Verdict and last metrics of each position in the running or last batch."""
+        return json.loads((await self.request("GET", "/batch")).body)
+
+    async def start_bench(self, recipe: str = None, shots: int = None, interval_ms: int = None) -> Response:
+        """Fire a baked recipe shots times for trigger latency and edge jitter."""
+        fields = ["%s=%s" % (k, v) for k, v in (("recipe", recipe), ("shots", shots), ("interval_ms", interval_ms))
+                  if v is not None]
+        return await self.request("POST", "/bench", "&".join(fields).encode(), "application/x-www-form-urlencoded")
+
+    async def stop_bench(self) -> Response:
+        return await self.request("POST", "/bench", b"stop=1", "application/x-www-form-urlencoded")
+
+    async def bench(self) -> dict:
+        """State, build profile and timing statistics of the running or last benchmark."""
+        return json.loads((await self.request("GET", "/bench")).body)
+
+    # ---------------------- Reader ----------------------
+    async def _read_response(self) -> (Response, bool):
+        status_line = await self._reader.readline()
+        if not status_line:
+            raise ConnectionError("connection closed")
+        status = int(status_line.split(b" ", 2)[1])
+        headers = {}
+        while True:
+            line = await self._reader.readline()
+            if line in (b"\r\n", b"\n", b""):
+                break
+            name, _, value = line.decode("latin-1").partition(":")
+            headers[name.strip().lower()] = value.strip()
+
+        close_after = "close" in headers.get("connection", "").lower()
+        if "chunked" in headers.get("transfer-encoding", ""):
+            body = bytearray()
+            while True:
+                size = int((await self._reader.readline()).strip() or b"0", 16)
+                chunk = await self._reader.readexactly(size + 2)
+                body += chunk[:size]
+                if size == 0:
+                    break
+            body = bytes(body)
+        elif "content-length" in headers:
+            body = await self._reader.readexactly(int(headers["content-length"]))
+        else:
+            body = await self._reader.read()
+            close_after = True
+        return Response(status, headers.get("content-type", ""), body), close_after
+
+    async def _read_loop(self):
+        try:
+            while True:
+                if not self._pending:
+                    # Nothing in flight; wait for the next request
+                    self._wakeup.clear()
+                    await self._wakeup.wait()
+                    if self._closing and not self._pending:
+                        return
+                    continue
+                resp, close_after = await self._read_response()
+                self._pending.popleft().set_result(resp)
+                if close_after:
+                    break
+        except (ConnectionError, asyncio.IncompleteReadError, OSError) as e:
+            err = e
+        else:
+            err = ConnectionError("server closed the connection")
+        while self._pending:
+            fut = self._pending.popleft()
+            if not fut.done():
+                fut.set_exception(err)
+        if self._writer is not None:
+            self._writer.close()
+        self._writer = None
@@ -0,0 +1,207 @@
+"""
+Loopback stand-in for the DPT signal generator's HTTP API.
+
+Serves /set, /trigger, /status and /plan (GET and POST) on localhost with the same
+request and response formats as the firmware, including keep-alive and
+pipelined requests, so the host client libraries can be exercised on a
+machine without a device:
+
+    python3 host/python/loopback_server.py --port 8080 &
+    dpt_cli -h 127.0.0.1 -p 8080 sweep p1h 1 20 1
+
+Timing is simulated: a trigger only sleeps for --fire-delay-ms. The plan
+hash is a CRC of the edge list, not the firmware's item hash, except for
+uploaded plans, which keep the hash from their header. Uploads are only
+checked for magic, version and CRC, not item consistency.
+"""
+
+import argparse
+import asyncio
+import json
+import struct
+import time
+import urllib.parse
+import zlib
+
+TICKS_PER_US = 80
+ITEM_MAX_TICKS = 32767
+MIN_TICKS_HIGH = 2
+GPIO = (7, 8)
+IDLE = (0, 1)
+REASONS = {200: b"OK", 400: b"Bad Request", 404: b"Not Found"}
+
+# Same limits as set_params_handler() in src/main_rmt.c
+LIMITS = {"p1h": (0.025, 65535.0), "p1l": (0.125, 65535.0),
+          "p2h": (0.025, 65535.0), "p2l": (0.125, 65535.0)}
+
+
+class Device:
+    def __init__(self, fire_delay_ms):
+        self.params = {"p1h": 5.0, "p1l": 1.0, "p2h": 3.0, "p2l": 10000.0}
+        self.shots = 0
+        self.fire_delay = fire_delay_ms / 1000.0
+        self.boot = time.monotonic()
+        self.uploaded = None    # (hash, total, channels) of an uploaded plan
+
+    def upload(self, blob):
+        """Arm a DPTP plan; returns an error name or None."""
+        if len(blob) < 24 or blob[:4] != b"DPTP":
+            return "ESP_ERR_INVALID_SIZE"
+        version, n_ch, n_segs, n_words, _, h, _ = struct.unpack_from("<BBHHHII", blob, 4)
+        if version != 1 or n_ch != 2:
+            return "ESP_ERR_INVALID_VERSION"
+        if len(blob) != 20 + 8 * n_words + 8 * n_segs + 4:
+            return "ESP_ERR_INVALID_SIZE"
+        if zlib.crc32(blob[:-4]) != struct.unpack_from("<I", blob, len(blob) - 4)[0]:
+            return "ESP_ERR_INVALID_CRC"
+        channels, total = [], 0
+        for ch in range(2):
+            words = struct.unpack_from("<%dI" % n_words, blob, 20 + 4 * n_words * ch)
+            edges, tick, level = [], 0, IDLE[ch]
+            for w in words:
+                for half in (w & 0xFFFF, w >> 16):
+                    ticks, out = half & 0x7FFF, half >> 15
+                    if ticks == 0:
+                        break
+                    if out != level:
+                        edges.append((tick, out))
+                        level = out
+                    tick += ticks
+                else:
+                    continue
+                break
+            if level != IDLE[ch]:
+                edges.append((tick, IDLE[ch]))
+            channels.append((n_words, edges))
+            total = max(total, tick)
+        self.uploaded = (h, total, channels)
+        return None
+
+    def segments(self):
+        p = self.params
+        ticks = [int(p[k] * TICKS_PER_US + 0.5) for k in ("p1h", "p1l", "p2h", "p2l")]
+        ticks[0] = max(ticks[0], MIN_TICKS_HIGH)
+        ticks[2] = max(ticks[2], MIN_TICKS_HIGH)
+        return list(zip((1, 0, 1, 0), ticks))
+
+    def plan(self):
+        if self.uploaded:
+            return self.uploaded
+        segs = self.segments()
+        halves = sum((t + ITEM_MAX_TICKS - 1) // ITEM_MAX_TICKS for _, t in segs)
+        items = (halves + 2) // 2
+        channels = []
+        for ch in range(2):
+            edges, tick, level = [], 0, IDLE[ch]
+            for seg_level, t in segs:
+                out = seg_level ^ ch
+                if out != level:
+                    edges.append((tick, out))
+                    level = out
+                tick += t
+            if level != IDLE[ch]:
+                edges.append((tick, IDLE[ch]))
+            channels.append((items, edges))
+        total = sum(t for _, t in segs)
+        h = zlib.crc32(repr(channels).encode())
+        return h, total, channels
+
+    def status(self):
+        h, total, channels = self.plan()
+        d = dict(self.params)
+        d.update(source="upload" if self.uploaded else "params", hash="0x%08x" % h, items=channels[0][0], total_ticks=total, shots=self.shots,
+                 uptime_us=int((time.monotonic() - self.boot) * 1e6), free_heap=0)
+        return json.dumps(d, separators=(",", ":")).encode()
+
+    def plan_json(self):
+        h, total, channels = self.plan()
+        return json.dumps({
+            "hash": "0x%08x" % h, "total_ticks": total, "tick_ns": 12.5,
+            "channels": [{"name": n, "gpio": GPIO[ch], "idle": IDLE[ch], "items": items,
+                          "edges": [list(e) for e in edges]}
+                         for ch, (n, (items, edges)) in enumerate(zip("PN", channels))]},
+                          separators=(",", ":")).encode()
+
+    def plan_bin(self):
+        h, total, channels = self.plan()
+        out = bytearray(b"DPTE" + struct.pack("<BBHII", 1, len(channels), 0, h, total))
+        for ch, (items, edges) in enumerate(channels):
+            out += struct.pack("<HBBI", items, GPIO[ch], IDLE[ch], len(edges))
+            out += struct.pack("<%dI" % len(edges), *[(t << 1) | lv for t, lv in edges])
+        return bytes(out)
+
+
+async def handle(device, reader, writer):
+    try:
+        while True:
+            request_line = await reader.readline()
+            if not request_line:
+                break
+            method, target, _ = request_line.decode("latin-1").split(" ", 2)
+            headers = {}
+            while True:
+                line = await reader.readline()
+                if line in (b"\r\n", b"\n", b""):
+                    break
+                name, _, value = line.decode("latin-1").partition(":")
+                headers[name.strip().lower()] = value.strip()
+            body = await reader.readexactly(int(headers.get("content-length", "0")))
+
+            path, _, query = target.partition("?")
+            status, ctype, payload = 200, "text/html", b""
+            if method == "POST" and path == "/set":
+                form = urllib.parse.parse_qs(body.decode())
+                for key, (lo, hi) in LIMITS.items():
+                    if key in form:
+                        value = float(form[key][0])
+                        if lo <= value <= hi:
+                            device.params[key] = value
+                device.uploaded = None
+                payload = b"Parameters Set!"
+            elif method == "GET" and path == "/trigger":
+                await asyncio.sleep(device.fire_delay)
+                device.shots += 1
+                payload = b"Triggered!"
+            elif method == "GET" and path == "/status":
+                ctype, payload = "application/json", device.status()
+            elif method == "POST" and path == "/plan":
+                error = device.upload(body)
+                if error:
+                    status, payload = 400, error.encode()
+                else:
+                    payload = b"Plan armed: 0x%08x" % device.uploaded[0]
+            elif method == "GET" and path == "/plan":
+                if urllib.parse.parse_qs(query).get("format", ["json"])[0] == "bin":
+                    ctype, payload = "application/octet-stream", device.plan_bin()
+                else:
+                    ctype, payload = "application/json", device.plan_json()
+            else:
+                status, payload = 404, b"Not Found"
+
+            writer.write(b"HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %d\r\n\r\n"
+                         % (status, REASONS[status], ctype.encode(), len(payload))
+                         + payload)
+            await writer.drain()
+    except (ConnectionError, asyncio.IncompleteReadError, ValueError):
+        pass
+    finally:
+        writer.close()
+
+
+async def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("--host", default="127.0.0.1")
+    ap.add_argument("--port", type=int, default=8080)
+    ap.add_argument("--fire-delay-ms", type=float, default=0.0,
+                    help="simulated time per trigger (the firmware waits 1000 ms)")
+    args = ap.parse_args()
+
+    device = Device(args.fire_delay_ms)
+    server = await asyncio.start_server(lambda r, w: handle(device, r, w), args.host, args.port)
+    print("DPT loopback server on %s:%d" % (args.host, args.port), flush=True)
+    async with server:
+        await server.serve_forever()
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
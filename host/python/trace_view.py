@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""
+Fetch the last shot's timeline from GET /trace and convert it for viewing.
+
+Writes Chrome trace-event JSON, which ui.perfetto.dev and chrome://tracing
+open directly: one track per core with the running task, ISRs nested on
+top, and the shot markers as instants. Also prints which tasks and ISRs
+ran on each core between the start of the shot and the end of the RMT
+transmission:
+
+    python3 host/python/trace_view.py -H 192.168.4.1 -o shot.json
+    python3 host/python/trace_view.py --dump shot.dptt -o shot.json
+"""
+
+import argparse
+import asyncio
+import collections
+import json
+import sys
+
+from dpt_client import (Client, TraceDump, TRACE_TASK_IN, TRACE_ISR_ENTER, TRACE_ISR_EXIT, TRACE_MARK,
+                        TRACE_MARKS, TRACE_ISRS, TRACE_ISR_CPU_INT)
+
+
+def isr_name(source):
+    if source >= TRACE_ISR_CPU_INT:
+        return "cpu_int %d" % (source - TRACE_ISR_CPU_INT)
+    return TRACE_ISRS.get(source, "isr %d" % source)
+
+
+def to_chrome(dump):
+    """Chrome trace events; timestamps in microseconds from the first event."""
+    out = []
+    if not dump.events:
+        return out
+    t0 = min(ev.time_us for ev in dump.events)
+    running = {}        # core -> (task name, start)
+    isr_depth = collections.Counter()
+    for ev in sorted(dump.events, key=lambda e: e.time_us):
+        ts = ev.time_us - t0
+        if ev.type == TRACE_TASK_IN:
+            if ev.core in running:
+                name, start = running[ev.core]
+                out.append({"name": name, "ph": "X", "ts": start, "dur": ts - start, "pid": 0, "tid": ev.core})
+            running[ev.core] = (dump.tasks.get(ev.arg, "0x%08x" % ev.arg), ts)
+        elif ev.type == TRACE_ISR_ENTER:
+            isr_depth[ev.core] += 1
+            out.append({"name": isr_name(ev.arg), "cat": "isr", "ph": "B", "ts": ts, "pid": 0, "tid": ev.core})
+        elif ev.type == TRACE_ISR_EXIT and isr_depth[ev.core] > 0:
+            isr_depth[ev.core] -= 1
+            out.append({"ph": "E", "ts": ts, "pid": 0, "tid": ev.core})
+        elif ev.type == TRACE_MARK:
+            out.append({"name": TRACE_MARKS.get(ev.arg, "mark %d" % ev.arg), "cat": "shot", "ph": "i", "s": "g",
+                        "ts": ts, "pid": 0, "tid": ev.core})
+    end = max(ev.time_us for ev in dump.events) - t0
+    for core, (name, start) in running.items():
+        out.append({"name": name, "ph": "X", "ts": start, "dur": end - start, "pid": 0, "tid": core})
+    for core in sorted({ev.core for ev in dump.events}):
+        out.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": core, "args": {"name": "core %d" % core}})
+    return out
+
+
+def summarize(dump):
+    marks = {TRACE_MARKS.get(ev.arg): ev.time_us for ev in dump.events if ev.type == TRACE_MARK}
+    print("%d events, %d lost to the ring, window %d us before / %d us after%s%s"
+          % (len(dump.events), dump.lost, dump.pre_us, dump.post_us,
+             ", pre window cut short" if dump.window_cut else "", ", still recording" if dump.recording else ""))
+    begin, done = marks.get("shot_begin"), marks.get("rmt_done")
+    if begin is None or done is None:
+        print("no complete shot in the capture")
+        return
+    for a, b in (("shot_begin", "rmt_start"), ("rmt_start", "rmt_done"), ("rmt_done", "shot_end")):
+        if a in marks and b in marks:
+            print("  %-10s -> %-10s %10.1f us" % (a, b, marks[b] - marks[a]))
+
+    # Who held each core during the shot
+    busy = collections.defaultdict(collections.Counter)
+    running = {}
+    isr_start = collections.defaultdict(list)   # Nested handlers count towards each level
+    for ev in sorted(dump.events, key=lambda e: e.time_us):
+        t = min(max(ev.time_us, begin), done)
+        if ev.type == TRACE_TASK_IN:
+            if ev.core in running:
+                name, start = running[ev.core]
+                busy[ev.core][name] += t - start
+            running[ev.core] = (dump.tasks.get(ev.arg, "0x%08x" % ev.arg), t)
+        elif ev.type == TRACE_ISR_ENTER:
+            isr_start[ev.core].append((isr_name(ev.arg), t))
+        elif ev.type == TRACE_ISR_EXIT and isr_start[ev.core]:
+            name, start = isr_start[ev.core].pop()
+            busy[ev.core]["[%s]" % name] += t - start
+    for core, (name, start) in running.items():
+        busy[core][name] += done - start
+    for core in sorted(busy):
+        print("  core %d:" % core)
+        for name, us in busy[core].most_common():
+            if us > 0:
+                print("    %-20s %10.1f us" % (name, us))
+
+
+async def fetch(host, port):
+    async with Client(host, port) as dpt:
+        resp = await dpt.request("GET", "/trace")
+        if not resp.ok:
+            raise SystemExit("GET /trace failed: HTTP %d" % resp.status)
+        return resp.body
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("-H", "--host", default="192.168.4.1")
+    ap.add_argument("-p", "--port", type=int, default=80)
+    ap.add_argument("--dump", help="Read a saved GET /trace body instead of fetching one")
+    ap.add_argument("--save", help="Save the raw GET /trace body here")
+    ap.add_argument("-o", "--output", help="Chrome trace JSON output")
+    args = ap.parse_args()
+
+    if args.dump:
+        with open(args.dump, "rb") as f:
+            data = f.read()
+    else:
+        data = asyncio.run(fetch(args.host, args.port))
+    if args.save:
+        with open(args.save, "wb") as f:
+            f.write(data)
+
+    dump = TraceDump.decode(data)
+    summarize(dump)
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump({"traceEvents": to_chrome(dump), "displayTimeUnit": "ns"}, f)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
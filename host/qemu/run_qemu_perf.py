@@ -0,0 +1,301 @@
+#!/usr/bin/env python3
+"""
+End-to-end performance harness for the firmware image in Espressif's QEMU.
+
+Boots the "qemu" PlatformIO build (sdkconfig.qemu: OpenETH instead of
+WiFi) in qemu-system-xtensa, forwards the web server to localhost through
+QEMU's user-mode network stack (or uses a tap interface), runs /status,
+/set and /trigger workloads with the host client, and compares boot time,
+handler latency, plan update time and heap figures against thresholds:
+
+    pio run -e qemu
+    python3 host/qemu/run_qemu_perf.py --build-dir .pio/build/qemu
+
+Exits 0 when every metric is within its threshold, 1 on a regression and
+2 if the image could not be booted or reached.
+"""
+
+import argparse
+import asyncio
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "python"))
+from dpt_client import Client, DoublePulse  # noqa: E402
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+FLASH_SIZE = "2MB"      # CONFIG_ESPTOOLPY_FLASHSIZE
+LOG_LINE = re.compile(r"^([EWIDV]) \((\d+)\) ([^:]+): (.*)$")
+PLAN_LINE = re.compile(r"Plan (compiled|patched): .* in (\d+) us, loaded in (\d+) us")
+
+
+# ---------------------- Image ----------------------
+def merge_image(build_dir, out_path):
+    """Merge bootloader, partition table and app into one flash image."""
+    parts = [("0x0", "bootloader.bin"), ("0x8000", "partitions.bin"), ("0x10000", "firmware.bin")]
+    args = [sys.executable, "-m", "esptool", "--chip", "esp32s3", "merge_bin", "-o", out_path,
+            "--fill-flash-size", FLASH_SIZE]
+    for offset, name in parts:
+        path = os.path.join(build_dir, name)
+        if not os.path.exists(path):
+            raise SystemExit("missing %s; build with 'pio run -e qemu' first" % path)
+        args += [offset, path]
+    subprocess.run(args, check=True, stdout=subprocess.DEVNULL)
+
+
+# ---------------------- QEMU ----------------------
+class Qemu:
+    """qemu-system-xtensa with the serial console captured line by line."""
+
+    def __init__(self, args, image):
+        if args.tap:
+            nic = "tap,ifname=%s,script=no,downscript=no,model=open_eth" % args.tap
+        else:
+            nic = "user,model=open_eth,hostfwd=tcp:127.0.0.1:%d-:80" % args.port
+        self.cmd = [args.qemu, "-nographic", "-machine", "esp32s3",
+                    "-drive", "file=%s,if=mtd,format=raw" % image,
+                    "-global", "driver=timer.esp32s3.timg,property=wdt_disable,value=true",
+                    "-nic", nic] + args.qemu_arg
+        self.lines = []             # (host seconds since launch, line)
+        self.cond = threading.Condition()
+        self.log = open(args.log, "w") if args.log else None
+
+    def start(self):
+        self.t0 = time.monotonic()
+        self.proc = subprocess.Popen(self.cmd, stdin=subprocess.DEVNULL, stdout=subprocess.PIPE,
+                                     stderr=subprocess.STDOUT)
+        threading.Thread(target=self._reader, daemon=True).start()
+
+    def _reader(self):
+        for raw in self.proc.stdout:
+            line = raw.decode("utf-8", "replace").rstrip("\r\n")
+            # Strip ANSI colour codes in case the log colours are on
+            line = re.sub(r"\x1b\[[0-9;]*m", "", line)
+            if self.log:
+                self.log.write(line + "\n")
+            with self.cond:
+                self.lines.append((time.monotonic() - self.t0, line))
+                self.cond.notify_all()
+
+    def wait_for(self, pattern, timeout):
+        """Host time of the first line matching pattern, or None."""
+        regex = re.compile(pattern)
+        deadline = time.monotonic() + timeout
+        checked = 0
+        with self.cond:
+            while True:
+                for t, line in self.lines[checked:]:
+                    if regex.search(line):
+                        return t
+                checked = len(self.lines)
+                left = deadline - time.monotonic()
+                if left <= 0 or self.proc.poll() is not None:
+                    return None
+                self.cond.wait(left)
+
+    def device_logs(self):
+        """Parsed ESP_LOGx lines: (level, device ms, tag, message)."""
+        with self.cond:
+            out = []
+            for _, line in self.lines:
+                m = LOG_LINE.match(line)
+                if m:
+                    out.append((m.group(1), int(m.group(2)), m.group(3), m.group(4)))
+            return out
+
+    def stop(self):
+        if self.proc.poll() is None:
+            self.proc.terminate()
+            try:
+                self.proc.wait(5)
+            except subprocess.TimeoutExpired:
+                self.proc.kill()
+        if self.log:
+            self.log.close()
+
+
+# ---------------------- Workloads ----------------------
+def percentile(values, p):
+    if not values:
+        return None
+    s = sorted(values)
+    k = (len(s) - 1) * p / 100.0
+    lo = int(k)
+    hi = min(lo + 1, len(s) - 1)
+    return s[lo] + (s[hi] - s[lo]) * (k - lo)
+
+
+async def timed(coro):
+    t = time.perf_counter()
+    result = await coro
+    return (time.perf_counter() - t) * 1000.0, result
+
+
+async def wait_http(host, port, timeout):
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        try:
+            async with Client(host, port, max_in_flight=1) as dpt:
+                return await asyncio.wait_for(dpt.status(), 5)
+        except (OSError, asyncio.TimeoutError, ConnectionError):
+            await asyncio.sleep(0.2)
+    return None
+
+
+async def run_workloads(host, port, args, metrics):
+    async with Client(host, port, max_in_flight=1) as dpt:
+        first = await dpt.status()
+        metrics["free_heap_start"] = first.free_heap
+
+        # Sequential round trips, one request in flight
+        lat = [(await timed(dpt.status()))[0] for _ in range(args.status)]
+        metrics["status_p50_ms"] = percentile(lat, 50)
+        metrics["status_p95_ms"] = percentile(lat, 95)
+
+        # Alternate small p1h steps (in-place patches) with p2l jumps across
+        # item boundaries (full compiles)
+        lat = []
+        for i in range(args.sets):
+            p2l = 10000.0 if i % 10 else 100.0 + i
+            ms, resp = await timed(dpt.set(DoublePulse(p1h_us=1.0 + (i % 50) * 0.1, p2l_us=p2l)))
+            if not resp.ok:
+                metrics["failed_requests"] = metrics.get("failed_requests", 0) + 1
+            lat.append(ms)
+        metrics["set_p50_ms"] = percentile(lat, 50)
+        metrics["set_p95_ms"] = percentile(lat, 95)
+
+        # Shots include the firmware's 1 s pre-trigger delay
+        lat = []
+        for _ in range(args.triggers):
+            ms, resp = await timed(dpt.fire())
+            if not resp.ok:
+                metrics["failed_requests"] = metrics.get("failed_requests", 0) + 1
+            lat.append(ms)
+        metrics["trigger_p95_ms"] = percentile(lat, 95)
+
+    # Pipelined burst on a fresh connection
+    async with Client(host, port, max_in_flight=args.in_flight) as dpt:
+        t = time.perf_counter()
+        results = await asyncio.gather(*(dpt.set(DoublePulse(p1h_us=2.0 + (i % 20) * 0.5))
+                                         for i in range(args.sets)))
+        elapsed = time.perf_counter() - t
+        metrics["pipelined_sets_per_s"] = len(results) / elapsed if elapsed > 0 else None
+        metrics["failed_requests"] = metrics.get("failed_requests", 0) + sum(not r.ok for r in results)
+        last = await dpt.status()
+        metrics["free_heap_end"] = last.free_heap
+        metrics["heap_drift_bytes"] = first.free_heap - last.free_heap
+
+
+def device_metrics(qemu, metrics):
+    logs = qemu.device_logs()
+    updates = [int(m.group(2)) for _, _, _, msg in logs for m in [PLAN_LINE.search(msg)] if m]
+    metrics["plan_update_p95_us"] = percentile(updates, 95)
+    metrics["plan_updates_logged"] = len(updates)
+    metrics["device_errors"] = sum(1 for level, _, _, msg in logs
+                                   if level == "E" and "Timed out waiting for RMT" not in msg)
+    # QEMU may not model the RMT; count its timeouts separately
+    metrics["rmt_timeouts"] = sum(1 for _, _, _, msg in logs if "Timed out waiting for RMT" in msg)
+    for _, ms, _, msg in logs:
+        if "Starting DPT System" in msg:
+            metrics["app_main_device_ms"] = ms
+            break
+
+
+# ---------------------- Thresholds ----------------------
+def check(metrics, thresholds):
+    failures = []
+    for name, limit in thresholds.get("max", {}).items():
+        value = metrics.get(name)
+        if value is None or value > limit:
+            failures.append("%s = %s (max %s)" % (name, value, limit))
+    for name, limit in thresholds.get("min", {}).items():
+        value = metrics.get(name)
+        if value is None or value < limit:
+            failures.append("%s = %s (min %s)" % (name, value, limit))
+    return failures
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    src = ap.add_mutually_exclusive_group(required=True)
+    src.add_argument("--build-dir", help="PlatformIO build directory to merge an image from")
+    src.add_argument("--image", help="Merged flash image")
+    ap.add_argument("--qemu", default="qemu-system-xtensa")
+    ap.add_argument("--qemu-arg", action="append", default=[], help="Extra QEMU argument (repeatable)")
+    ap.add_argument("--port", type=int, default=8080, help="Host port forwarded to the device's port 80")
+    ap.add_argument("--tap", help="Use this tap interface instead of user-mode networking")
+    ap.add_argument("--device-ip", help="Device address on the tap network (default: from its log)")
+    ap.add_argument("--thresholds", default=os.path.join(HERE, "thresholds.json"))
+    ap.add_argument("--boot-timeout", type=float, default=60.0)
+    ap.add_argument("--status", type=int, default=50, help="Sequential /status requests")
+    ap.add_argument("--sets", type=int, default=100, help="Sequential and pipelined /set requests")
+    ap.add_argument("--triggers", type=int, default=3, help="Sequential /trigger requests")
+    ap.add_argument("--in-flight", type=int, default=8)
+    ap.add_argument("--log", help="Write the serial console here")
+    ap.add_argument("--json", help="Write the metrics here")
+    args = ap.parse_args()
+
+    with open(args.thresholds) as f:
+        thresholds = json.load(f)
+
+    tmp = None
+    image = args.image
+    if args.build_dir:
+        tmp = tempfile.NamedTemporaryFile(suffix=".bin", delete=False)
+        tmp.close()
+        image = tmp.name
+        merge_image(args.build_dir, image)
+
+    metrics = {}
+    qemu = Qemu(args, image)
+    qemu.start()
+    try:
+        got_ip = qemu.wait_for(r"Ethernet got IP: (\S+)", args.boot_timeout)
+        if got_ip is None:
+            print("device did not bring up its network within %.0f s" % args.boot_timeout)
+            return 2
+        metrics["boot_to_ip_ms"] = got_ip * 1000.0
+        host, port = "127.0.0.1", args.port
+        if args.tap:
+            port = 80
+            host = args.device_ip or re.search(r"Ethernet got IP: (\S+)",
+                                               "\n".join(l for _, l in qemu.lines)).group(1)
+
+        status = asyncio.run(wait_http(host, port, args.boot_timeout))
+        if status is None:
+            print("web server at %s:%d did not answer" % (host, port))
+            return 2
+        metrics["boot_to_http_ms"] = (time.monotonic() - qemu.t0) * 1000.0
+
+        asyncio.run(run_workloads(host, port, args, metrics))
+        device_metrics(qemu, metrics)
+    finally:
+        qemu.stop()
+        if tmp:
+            os.unlink(tmp.name)
+
+    failures = check(metrics, thresholds)
+    width = max(len(k) for k in metrics)
+    for name in sorted(metrics):
+        value = metrics[name]
+        print("%-*s  %s" % (width, name, "%.2f" % value if isinstance(value, float) else value))
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump({"metrics": metrics, "failures": failures}, f, indent=2)
+    if failures:
+        print("\nREGRESSION:")
+        for line in failures:
+            print("  " + line)
+        return 1
+    print("\nall metrics within thresholds")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
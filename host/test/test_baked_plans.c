@@ -0,0 +1,105 @@
+/**
+ * @file test_baked_plans.c
+ * @brief The baked plan tables against dptc's binary plans
+ *
+ * Usage: test_baked_plans plan.bin...
+ *
+ * Each argument is dptc -o output for one recipe file, named after it.
+ * The build compiles them from the same recipes/ that are baked into
+ * dpt_baked_recipes.c, so this checks the C tables dptc -c writes against
+ * what dptc compiles: every recipe baked, every plan identical.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "dpt_baked.h"
+#include "dpt_plan.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+static uint8_t blob[DPT_BLOB_MAX_SIZE];
+static dpt_plan_t plan;
+
+// Recipe name from a path: file name without extension
+static void name_of(const char *path, char *name, size_t size) {
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    snprintf(name, size, "%s", base);
+    char *dot = strrchr(name, '.');
+    if (dot) {
+        *dot = '\0';
+    }
+}
+
+static bool same_recipe(const dpt_recipe_t *a, const dpt_recipe_t *b) {
+    if (a->num_segments != b->num_segments || a->dead_ticks != b->dead_ticks) {
+        return false;
+    }
+    for (int k = 0; k < a->num_segments; k++) {
+        if (a->seg[k].level != b->seg[k].level || a->seg[k].n_level != b->seg[k].n_level ||
+            a->seg[k].ticks != b->seg[k].ticks) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void check_plan(const char *path) {
+    char name[64];
+    name_of(path, name, sizeof(name));
+    const dpt_baked_recipe_t *baked = dpt_baked_find(name);
+    CHECK(baked != NULL, "%s: not baked", name);
+    if (baked == NULL) {
+        return;
+    }
+
+    FILE *f = fopen(path, "rb");
+    CHECK(f != NULL, "%s: cannot open %s", name, path);
+    if (f == NULL) {
+        return;
+    }
+    size_t len = fread(blob, 1, sizeof(blob), f);
+    fclose(f);
+    esp_err_t err = dpt_plan_deserialize(&plan, blob, len);
+    CHECK(err == ESP_OK, "%s: %s", name, esp_err_to_name(err));
+    if (err != ESP_OK) {
+        return;
+    }
+
+    const dpt_plan_t *b = baked->plan;
+    CHECK(b->hash == plan.hash, "%s: hash 0x%08x baked, 0x%08x compiled", name, b->hash, plan.hash);
+    CHECK(dpt_plan_rehash(b) == b->hash, "%s: baked words do not match the baked hash", name);
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        CHECK(b->num_words[ch] == plan.num_words[ch] &&
+              memcmp(b->words[ch], plan.words[ch], plan.num_words[ch] * sizeof(uint32_t)) == 0,
+              "%s: channel %d words differ", name, ch);
+    }
+    CHECK(same_recipe(&b->recipe, &plan.recipe), "%s: segments differ", name);
+    size_t halves = plan.recipe.num_segments * sizeof(uint16_t);
+    CHECK(memcmp(b->seg_first_half, plan.seg_first_half, halves) == 0 &&
+          memcmp(b->seg_num_halves, plan.seg_num_halves, halves) == 0, "%s: segment layout differs", name);
+}
+
+int main(int argc, char **argv) {
+    CHECK((size_t)(argc - 1) == dpt_baked_count, "%d recipe(s) compiled, %zu baked", argc - 1, dpt_baked_count);
+    for (int i = 1; i < argc; i++) {
+        check_plan(argv[i]);
+    }
+    CHECK(dpt_baked_verify() == ESP_OK, "dpt_baked_verify()");
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("%zu baked plan(s) match dptc\n", dpt_baked_count);
+    return 0;
+}
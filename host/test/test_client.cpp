@@ -0,0 +1,124 @@
+/**
+ * @file test_client.cpp
+ * @brief dpt_client against the loopback server
+ *
+ * Starts host/python/loopback_server.py, then pipelines set, fire and
+ * status over one connection and checks each response, including that
+ * the status reflects the set and the fire queued ahead of it.
+ *
+ * Usage: test_client <python3> <loopback_server.py> <port>
+ */
+
+#include "dpt_client.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+// Polls GET /status until the server answers or ~5 s pass
+static bool wait_for_server(dpt::Client &client) {
+    for (int i = 0; i < 100; i++) {
+        try {
+            client.status().get();
+            return true;
+        } catch (const std::exception &) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+    return false;
+}
+
+static void run(dpt::Client &client) {
+    dpt::Status before = client.status().get();
+    CHECK(before.source == "params", "source %s", before.source.c_str());
+
+    dpt::DoublePulse recipe;
+    recipe.p1h_us = 7.5;
+    recipe.p1l_us = 2.0;
+    recipe.p2h_us = 4.0;
+    recipe.p2l_us = 500.0;
+
+    // All three are written before the first response is read
+    std::future<dpt::Response> set = client.set(recipe);
+    std::future<dpt::Response> fire = client.fire();
+    std::future<dpt::Status> status = client.status();
+
+    dpt::Response r = set.get();
+    CHECK(r.status == 200 && r.body == "Parameters Set!", "set: %d %s", r.status, r.body.c_str());
+    r = fire.get();
+    CHECK(r.status == 200 && r.body == "Triggered!", "fire: %d %s", r.status, r.body.c_str());
+
+    dpt::Status s = status.get();
+    CHECK(s.p1h_us == 7.5 && s.p1l_us == 2.0 && s.p2h_us == 4.0 && s.p2l_us == 500.0,
+          "params %g %g %g %g", s.p1h_us, s.p1l_us, s.p2h_us, s.p2l_us);
+    CHECK(s.shots == before.shots + 1, "shots %u after %u", s.shots, before.shots);
+    CHECK(s.source == "params", "source %s", s.source.c_str());
+    CHECK(s.total_ticks == (uint64_t)((7.5 + 2.0 + 4.0 + 500.0) * 80), "total_ticks %llu",
+          (unsigned long long)s.total_ticks);
+
+    // Out-of-range values are ignored, as on the device
+    recipe.p1h_us = 0.001;
+    r = client.set(recipe).get();
+    s = client.status().get();
+    CHECK(r.ok() && s.p1h_us == 7.5, "p1h %g after an out-of-range set", s.p1h_us);
+
+    r = client.request("GET", "/nope").get();
+    CHECK(r.status == 404, "unknown path: %d", r.status);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 4) {
+        fprintf(stderr, "usage: %s <python3> <loopback_server.py> <port>\n", argv[0]);
+        return 2;
+    }
+
+    pid_t server = fork();
+    if (server == 0) {
+        execl(argv[1], argv[1], argv[2], "--port", argv[3], (char *)nullptr);
+        _exit(127);
+    }
+    if (server < 0) {
+        perror("fork");
+        return 2;
+    }
+
+    {
+        dpt::Client client("127.0.0.1", (uint16_t)atoi(argv[3]));
+        if (wait_for_server(client)) {
+            try {
+                run(client);
+            } catch (const std::exception &e) {
+                CHECK(false, "%s", e.what());
+            }
+        } else {
+            CHECK(false, "no loopback server on port %s", argv[3]);
+        }
+    }
+
+    kill(server, SIGTERM);
+    waitpid(server, nullptr, 0);
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("Pipelined client requests match the loopback server\n");
+    return 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file test_idle_levels.c
+ * @brief Gate outputs stay at their idle levels through RMT setup
+ *
+ * Runs the firmware's RMT backend on the simulated peripherals with the
+ * loopback edge counters on both pads, as GET /selftest/pins does on the
+ * device: init, reconfigurations and layout changes must not put a single
+ * edge on P or N, and a shot must put exactly the plan's edges there.
+ */
+
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "driver/gpio.h"
+#include "dpt_loopback.h"
+#include "dpt_plan.h"
+#include "dpt_rmt.h"
+
+#define RECONFIGS   20
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+static const gpio_num_t pad[DPT_NUM_CHANNELS] = { RMT_TX_GPIO_P, RMT_TX_GPIO_N };
+static const int idle[DPT_NUM_CHANNELS] = { DPT_IDLE_LEVEL_P, DPT_IDLE_LEVEL_N };
+
+static dpt_plan_t short_plan, carrier_plan;
+
+static void check_idle(const char *when) {
+    uint32_t edges[DPT_NUM_CHANNELS];
+    dpt_loopback_read(edges);
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        CHECK(edges[ch] == 0, "%s: %u edge(s) on GPIO%d", when, edges[ch], pad[ch]);
+        CHECK(gpio_get_level(pad[ch]) == idle[ch], "%s: GPIO%d at %d, idles at %d", when, pad[ch],
+              gpio_get_level(pad[ch]), idle[ch]);
+    }
+}
+
+static void check_shot(const dpt_plan_t *plan) {
+    uint32_t before[DPT_NUM_CHANNELS], after[DPT_NUM_CHANNELS];
+    dpt_loopback_read(before);
+    CHECK(dpt_rmt_load(plan, false) == ESP_OK, "load");
+    CHECK(dpt_rmt_start() == ESP_OK && dpt_rmt_wait_done(1000) == ESP_OK, "shot");
+    dpt_loopback_read(after);
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        uint32_t planned = dpt_plan_count_edges(plan, ch);
+        CHECK(after[ch] - before[ch] == planned, "shot: %u edge(s) on GPIO%d, plan has %u",
+              after[ch] - before[ch], pad[ch], planned);
+        CHECK(gpio_get_level(pad[ch]) == idle[ch], "after the shot: GPIO%d at %d", pad[ch], gpio_get_level(pad[ch]));
+    }
+}
+
+int main(void) {
+    dpt_recipe_t recipe;
+    dpt_recipe_double_pulse(&recipe, 20.0f, 1.0f, 20.0f, 100.0f);
+    CHECK(dpt_plan_compile(&short_plan, &recipe) == ESP_OK, "compile");
+    // More words than one RMT block: loading it changes the channel layout
+    CHECK(dpt_recipe_apply_carrier(&recipe, DPT_CHANNEL_P, 40, 20) == ESP_OK, "carrier");
+    CHECK(dpt_plan_compile(&carrier_plan, &recipe) == ESP_OK, "compile carrier");
+
+    dpt_rmt_pins_safe();
+    CHECK(gpio_install_isr_service(0) == ESP_OK, "ISR service");
+    CHECK(dpt_loopback_start() == ESP_OK, "loopback");
+    CHECK(dpt_rmt_init() == ESP_OK, "RMT init");
+    check_idle("init");
+
+    CHECK(dpt_rmt_claim(0) == ESP_OK, "claim");
+    for (int i = 0; i < RECONFIGS; i++) {
+        CHECK(dpt_rmt_reconfigure() == ESP_OK, "reconfigure");
+        CHECK(dpt_rmt_load(&short_plan, false) == ESP_OK, "load");
+    }
+    check_idle("reconfigure");
+
+    uint32_t changes_before, changes;
+    dpt_rmt_layout_t layout;
+    dpt_rmt_get_layout(&layout, &changes_before);
+    for (int i = 0; i < RECONFIGS; i++) {
+        CHECK(dpt_rmt_load(i % 2 ? &short_plan : &carrier_plan, false) == ESP_OK, "load");
+    }
+    dpt_rmt_get_layout(&layout, &changes);
+    CHECK(changes - changes_before == RECONFIGS, "%u layout change(s), expected %d", changes - changes_before,
+          RECONFIGS);
+    check_idle("layout change");
+
+    // The counters see real edges
+    check_shot(&short_plan);
+    check_shot(&carrier_plan);
+    dpt_rmt_release();
+    dpt_loopback_stop();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("Outputs held their idle levels through init, %d reconfigurations and %d layout changes\n",
+           RECONFIGS, RECONFIGS);
+    return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file test_plan_patch.c
+ * @brief dpt_plan_update() against a full compile
+ *
+ * Changes one segment at a time and checks that the patch touches only
+ * that segment's words, and that the patched plan is word for word the
+ * plan a full compile of the new recipe gives.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "dpt_plan.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+static dpt_plan_t before, patched, compiled;
+
+static bool same_plan(const dpt_plan_t *a, const dpt_plan_t *b) {
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        if (a->num_words[ch] != b->num_words[ch] ||
+            memcmp(a->words[ch], b->words[ch], a->num_words[ch] * sizeof(uint32_t)) != 0) {
+            return false;
+        }
+    }
+    return a->hash == b->hash;
+}
+
+// Words outside [dirty_first, dirty_last] must not have moved
+static bool only_dirty_changed(const dpt_plan_t *old, const dpt_plan_t *plan) {
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        for (int i = 0; i < plan->num_words[ch]; i++) {
+            bool dirty = i >= plan->dirty_first && i <= plan->dirty_last;
+            if (!dirty && old->words[ch][i] != plan->words[ch][i]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Change segment k by delta ticks; expect a patch unless the item count changes
+static void check_change(const char *name, const dpt_recipe_t *recipe, int k, int32_t delta, bool expect_full) {
+    dpt_recipe_t next = *recipe;
+    next.seg[k].ticks += delta;
+
+    CHECK(dpt_plan_compile(&before, recipe) == ESP_OK, "%s: compile", name);
+    patched = before;
+    dpt_patch_stats_t stats;
+    CHECK(dpt_plan_update(&patched, &next, &stats) == ESP_OK, "%s seg %d: update", name, k);
+    CHECK(dpt_plan_compile(&compiled, &next) == ESP_OK, "%s seg %d: compile after", name, k);
+
+    CHECK(stats.full == expect_full, "%s seg %d %+d: full %d, expected %d", name, k, (int)delta, stats.full,
+          expect_full);
+    CHECK(same_plan(&patched, &compiled), "%s seg %d %+d: patched plan differs from a full compile", name, k,
+          (int)delta);
+    CHECK(dpt_plan_rehash(&patched) == patched.hash, "%s seg %d: running hash is off", name, k);
+    if (!expect_full) {
+        CHECK(stats.segments_changed == 1, "%s seg %d: %u segments changed", name, k, stats.segments_changed);
+        CHECK(only_dirty_changed(&before, &patched), "%s seg %d: a word outside the dirty range changed", name, k);
+        uint32_t first = before.seg_first_half[k] >> 1;
+        uint32_t last = (before.seg_first_half[k] + before.seg_num_halves[k] - 1) >> 1;
+        CHECK(patched.dirty_first == first && patched.dirty_last == last,
+              "%s seg %d: dirty %u-%u, segment covers %u-%u", name, k, patched.dirty_first, patched.dirty_last,
+              first, last);
+    }
+}
+
+static void check_every_segment(const char *name, const dpt_recipe_t *recipe) {
+    for (int k = 0; k < recipe->num_segments; k++) {
+        // Far enough from an item boundary that the half count stays
+        bool room = recipe->seg[k].ticks % DPT_ITEM_MAX_TICKS > 64 &&
+                    recipe->seg[k].ticks % DPT_ITEM_MAX_TICKS < DPT_ITEM_MAX_TICKS - 64;
+        if (room) {
+            check_change(name, recipe, k, 37, false);
+            check_change(name, recipe, k, -29, false);
+        }
+    }
+}
+
+int main(void) {
+    dpt_recipe_t recipe;
+
+    dpt_recipe_double_pulse(&recipe, 5.0f, 1.0f, 3.0f, 10000.0f);
+    check_every_segment("double pulse", &recipe);
+
+    CHECK(dpt_recipe_apply_dead_time(&recipe, 16) == ESP_OK, "dead time");
+    check_every_segment("double pulse, dead time", &recipe);
+
+    dpt_recipe_double_pulse(&recipe, 20.0f, 2.0f, 20.0f, 100.0f);
+    CHECK(dpt_recipe_apply_carrier(&recipe, DPT_CHANNEL_P, 800, 400) == ESP_OK, "carrier");
+    check_every_segment("carrier", &recipe);
+
+    // Crossing a 32767-tick item boundary changes the layout: full compile
+    dpt_recipe_double_pulse(&recipe, 5.0f, 1.0f, 3.0f, 10000.0f);
+    int last = recipe.num_segments - 1;
+    int32_t to_boundary = DPT_ITEM_MAX_TICKS - recipe.seg[last].ticks % DPT_ITEM_MAX_TICKS + 1;
+    check_change("item boundary", &recipe, last, to_boundary, true);
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("Plan patches match full compiles\n");
+    return 0;
+}
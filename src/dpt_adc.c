@@ -0,0 +1,363 @@
+/**
+ * @file dpt_adc.c
+ * @brief Continuous ADC capture of the analog feedback signals
+ *
+ * The reader task owns the driver handle and the calibration: a new
+ * configuration is handed to it and applied between two frames, so
+ * nothing else ever touches the handle. The frame-done interrupt counts
+ * conversions as they complete; a shot window closes once the task has
+ * processed a frame that completed after the window's end.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "soc/soc_caps.h"
+#include "dpt_adc.h"
+#include "dpt_interlock.h"
+#include "dpt_pins.h"
+
+#if SOC_ADC_DMA_SUPPORTED
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#endif
+
+#define TAG "DPT_ADC"
+
+#define READER_PRIORITY     11      // Below the sweep executor, above the web server
+
+static dpt_adc_config_t config = {
+    .in = {
+        [DPT_ADC_CURRENT] = { .gpio = -1, .scale = 1.0f },
+        [DPT_ADC_VBUS] = { .gpio = -1, .scale = 1.0f },
+    },
+};
+static dpt_adc_stats_t stats;
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Shot window, under stats_mux
+static bool window_open = false;
+static int window_raw[DPT_ADC_SIGNALS];
+static float window_peak[DPT_ADC_SIGNALS];
+static volatile uint32_t frames_done = 0;       // Counted by the frame-done interrupt
+static uint32_t frames_read = 0;                // Counted by the reader task
+static SemaphoreHandle_t frame_read = NULL;
+
+// Frame waiters, one at a time
+static SemaphoreHandle_t frame_ready = NULL;
+static SemaphoreHandle_t wait_mutex = NULL;
+
+bool dpt_adc_has(dpt_adc_signal_t signal) {
+    return config.enabled && config.in[signal].gpio >= 0;
+}
+
+void dpt_adc_get_config(dpt_adc_config_t *out) {
+    portENTER_CRITICAL(&stats_mux);
+    *out = config;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+void dpt_adc_get_stats(dpt_adc_stats_t *out) {
+    portENTER_CRITICAL(&stats_mux);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+// ---------------------- Shot Window ----------------------
+void dpt_adc_peak_begin(void) {
+    portENTER_CRITICAL(&stats_mux);
+    window_open = config.enabled;
+    for (int s = 0; s < DPT_ADC_SIGNALS; s++) {
+        window_raw[s] = -1;
+        window_peak[s] = 0.0f;
+    }
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+esp_err_t dpt_adc_peak_end(float peak[DPT_ADC_SIGNALS]) {
+    portENTER_CRITICAL(&stats_mux);
+    bool open = window_open;
+    uint32_t target = frames_done + 1;      // Still converting at the end, so it covers it
+    portEXIT_CRITICAL(&stats_mux);
+    if (!open) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(DPT_ADC_PEAK_TIMEOUT_MS);
+    bool covered = false;
+    while (1) {
+        portENTER_CRITICAL(&stats_mux);
+        covered = (int32_t)(frames_read - target) >= 0;
+        portEXIT_CRITICAL(&stats_mux);
+        TickType_t waited = xTaskGetTickCount() - start;
+        if (covered || waited >= timeout) {
+            break;
+        }
+        xSemaphoreTake(frame_read, timeout - waited);
+    }
+
+    portENTER_CRITICAL(&stats_mux);
+    window_open = false;
+    stats.peaks++;
+    stats.peak_timeouts += covered ? 0 : 1;
+    for (int s = 0; s < DPT_ADC_SIGNALS; s++) {
+        peak[s] = stats.last_peak[s] = window_peak[s];
+    }
+    portEXIT_CRITICAL(&stats_mux);
+    return covered ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+// ---------------------- Monitoring ----------------------
+esp_err_t dpt_adc_wait_frame(uint32_t timeout_ms, float value[DPT_ADC_SIGNALS]) {
+    if (!config.enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(wait_mutex, portMAX_DELAY);
+    xSemaphoreTake(frame_ready, 0);         // A give from before the call is stale
+    bool fresh = xSemaphoreTake(frame_ready, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+    xSemaphoreGive(wait_mutex);
+
+    portENTER_CRITICAL(&stats_mux);
+    for (int s = 0; s < DPT_ADC_SIGNALS; s++) {
+        value[s] = stats.value[s];
+    }
+    portEXIT_CRITICAL(&stats_mux);
+    return fresh ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+static esp_err_t create_semaphores(void) {
+    frame_read = xSemaphoreCreateBinary();
+    frame_ready = xSemaphoreCreateBinary();
+    wait_mutex = xSemaphoreCreateMutex();
+    return (frame_read && frame_ready && wait_mutex) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+// ---------------------- Driver ----------------------
+#if SOC_ADC_DMA_SUPPORTED
+
+static adc_continuous_handle_t handle = NULL;
+static adc_cali_handle_t cali[DPT_ADC_SIGNALS];
+static adc_channel_t channel_of[DPT_ADC_SIGNALS];
+static volatile uint32_t overflows = 0;
+
+// Configuration hand-over to the reader task
+static SemaphoreHandle_t config_mutex = NULL;
+static SemaphoreHandle_t config_request = NULL;
+static SemaphoreHandle_t config_done = NULL;
+static dpt_adc_config_t config_pending;
+static esp_err_t config_result;
+
+static bool IRAM_ATTR on_conv_done(adc_continuous_handle_t h, const adc_continuous_evt_data_t *ev, void *arg) {
+    frames_done++;
+    return false;
+}
+
+static bool IRAM_ATTR on_pool_ovf(adc_continuous_handle_t h, const adc_continuous_evt_data_t *ev, void *arg) {
+    overflows++;
+    return false;
+}
+
+static void stop_driver(void) {
+    if (handle != NULL) {
+        adc_continuous_stop(handle);
+        adc_continuous_deinit(handle);
+        handle = NULL;
+    }
+    for (int s = 0; s < DPT_ADC_SIGNALS; s++) {
+        if (cali[s] != NULL) {
+            adc_cali_delete_scheme_curve_fitting(cali[s]);
+            cali[s] = NULL;
+        }
+    }
+}
+
+// Reader task only
+static esp_err_t apply_config(const dpt_adc_config_t *cfg) {
+    adc_digi_pattern_config_t pattern[DPT_ADC_SIGNALS];
+    adc_channel_t channel[DPT_ADC_SIGNALS];
+    int n = 0;
+    for (int s = 0; s < DPT_ADC_SIGNALS; s++) {
+        adc_unit_t unit;
+        if (cfg->in[s].gpio < 0) {
+            continue;
+        }
+        // ADC2 is shared with WiFi
+        if (adc_continuous_io_to_channel(cfg->in[s].gpio, &unit, &channel[s]) != ESP_OK || unit != ADC_UNIT_1) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        pattern[n++] = (adc_digi_pattern_config_t){
+            .atten = ADC_ATTEN_DB_12,
+            .channel = channel[s],
+            .unit = ADC_UNIT_1,
+            .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+        };
+    }
+
+    stop_driver();
+    if (!cfg->enabled || n == 0) {
+        return ESP_OK;
+    }
+
+    adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = 4 * DPT_ADC_FRAME_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES,
+        .conv_frame_size = DPT_ADC_FRAME_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES,
+    };
+    adc_continuous_config_t adc_cfg = {
+        .pattern_num = n,
+        .adc_pattern = pattern,
+        .sample_freq_hz = DPT_ADC_SAMPLE_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+    };
+    adc_continuous_evt_cbs_t cbs = { .on_conv_done = on_conv_done, .on_pool_ovf = on_pool_ovf };
+    esp_err_t err = adc_continuous_new_handle(&handle_cfg, &handle);
+    if (err == ESP_OK) err = adc_continuous_config(handle, &adc_cfg);
+    if (err == ESP_OK) err = adc_continuous_register_event_callbacks(handle, &cbs, NULL);
+    for (int s = 0; s < DPT_ADC_SIGNALS && err == ESP_OK; s++) {
+        if (cfg->in[s].gpio < 0) {
+            continue;
+        }
+        adc_cali_curve_fitting_config_t cali_cfg = {
+            .unit_id = ADC_UNIT_1,
+            .chan = channel[s],
+            .atten = ADC_ATTEN_DB_12,
+            .bitwidth = ADC_BITWIDTH_DEFAULT,
+        };
+        err = adc_cali_create_scheme_curve_fitting(&cali_cfg, &cali[s]);
+        channel_of[s] = channel[s];
+    }
+    if (err == ESP_OK) err = adc_continuous_start(handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "ADC setup failed: %s", esp_err_to_name(err));
+        stop_driver();
+    }
+    return err;
+}
+
+static float to_units(const dpt_adc_config_t *cfg, int s, int raw) {
+    int mv = 0;
+    adc_cali_raw_to_voltage(cali[s], raw, &mv);
+    return (mv - cfg->in[s].offset_mv) * cfg->in[s].scale / 1000.0f;
+}
+
+static void reader_task(void *arg) {
+    static uint8_t buf[DPT_ADC_FRAME_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES];
+    dpt_adc_config_t cfg = config;
+    while (1) {
+        if (xSemaphoreTake(config_request, handle ? 0 : portMAX_DELAY) == pdTRUE) {
+            config_result = apply_config(&config_pending);
+            if (config_result == ESP_OK) {
+                cfg = config_pending;
+                portENTER_CRITICAL(&stats_mux);
+                config = cfg;
+                portEXIT_CRITICAL(&stats_mux);
+            }
+            dpt_interlock_frame(false, 0.0f);      // Until the new configuration delivers frames
+            xSemaphoreGive(config_done);
+            continue;
+        }
+
+        uint32_t len = 0;
+        if (adc_continuous_read(handle, buf, sizeof(buf), &len, DPT_ADC_PEAK_TIMEOUT_MS) != ESP_OK) {
+            dpt_interlock_frame(false, 0.0f);
+            continue;
+        }
+        uint32_t sum[DPT_ADC_SIGNALS] = { 0 };
+        uint32_t count[DPT_ADC_SIGNALS] = { 0 };
+        int max[DPT_ADC_SIGNALS] = { 0 };
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+            const adc_digi_output_data_t *d = (const adc_digi_output_data_t *)&buf[i];
+            for (int s = 0; s < DPT_ADC_SIGNALS; s++) {
+                if (cfg.in[s].gpio >= 0 && d->type2.channel == channel_of[s]) {
+                    sum[s] += d->type2.data;
+                    count[s]++;
+                    if ((int)d->type2.data > max[s]) max[s] = d->type2.data;
+                }
+            }
+        }
+        float value[DPT_ADC_SIGNALS];
+        float peak[DPT_ADC_SIGNALS];
+        for (int s = 0; s < DPT_ADC_SIGNALS; s++) {
+            value[s] = count[s] ? to_units(&cfg, s, sum[s] / count[s]) : 0.0f;
+            peak[s] = count[s] ? to_units(&cfg, s, max[s]) : 0.0f;
+        }
+
+        portENTER_CRITICAL(&stats_mux);
+        stats.frames++;
+        stats.samples += len / SOC_ADC_DIGI_RESULT_BYTES;
+        stats.overflows = overflows;
+        for (int s = 0; s < DPT_ADC_SIGNALS; s++) {
+            if (count[s] == 0) {
+                continue;
+            }
+            stats.value[s] = value[s];
+            if (window_open && max[s] > window_raw[s]) {
+                window_raw[s] = max[s];
+                window_peak[s] = peak[s];
+            }
+        }
+        frames_read++;
+        portEXIT_CRITICAL(&stats_mux);
+        dpt_interlock_frame(count[DPT_ADC_VBUS] > 0, value[DPT_ADC_VBUS]);
+        xSemaphoreGive(frame_read);
+        xSemaphoreGive(frame_ready);
+    }
+}
+
+esp_err_t dpt_adc_init(void) {
+    config_mutex = xSemaphoreCreateMutex();
+    config_request = xSemaphoreCreateBinary();
+    config_done = xSemaphoreCreateBinary();
+    if (create_semaphores() != ESP_OK || !config_mutex || !config_request || !config_done ||
+        xTaskCreate(reader_task, "adc_reader", 3072, NULL, READER_PRIORITY, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+// The sensor inputs, while enabled
+static esp_err_t claim_pins(const dpt_adc_config_t *cfg) {
+    int8_t pins[DPT_ADC_SIGNALS];
+    for (int s = 0; s < DPT_ADC_SIGNALS; s++) {
+        pins[s] = cfg->enabled ? cfg->in[s].gpio : -1;
+    }
+    return dpt_pins_claim_set(DPT_PIN_ADC, pins, DPT_ADC_SIGNALS);
+}
+
+esp_err_t dpt_adc_configure(const dpt_adc_config_t *cfg) {
+    xSemaphoreTake(config_mutex, portMAX_DELAY);
+    esp_err_t err = claim_pins(cfg);
+    if (err == ESP_OK) {
+        config_pending = *cfg;
+        xSemaphoreGive(config_request);
+        xSemaphoreTake(config_done, portMAX_DELAY);     // At most one frame read away
+        err = config_result;
+        if (err != ESP_OK) {
+            claim_pins(&config);    // Back to the pins the old configuration holds
+        }
+    }
+    xSemaphoreGive(config_mutex);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "ADC capture %s: current on GPIO%d, bus voltage on GPIO%d",
+                 cfg->enabled ? "enabled" : "disabled", cfg->in[DPT_ADC_CURRENT].gpio, cfg->in[DPT_ADC_VBUS].gpio);
+    }
+    return err;
+}
+
+#else
+
+esp_err_t dpt_adc_init(void) {
+    ESP_LOGI(TAG, "No continuous ADC on this target; analog signals cannot be captured");
+    return create_semaphores();
+}
+
+esp_err_t dpt_adc_configure(const dpt_adc_config_t *cfg) {
+    return cfg->enabled ? ESP_ERR_NOT_SUPPORTED : ESP_OK;
+}
+
+#endif
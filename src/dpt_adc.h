@@ -0,0 +1,110 @@
+/**
+ * @file dpt_adc.h
+ * @brief Continuous ADC capture of the analog feedback signals
+ *
+ * ADC1 runs in continuous mode with one pattern entry per configured
+ * signal, DPT_ADC_SAMPLE_HZ in total, and GDMA hands over a frame of
+ * conversions about every 0.8 ms. A task reduces each frame to the
+ * latest value per signal and, while a shot window is open, the peak.
+ * Peaks are tracked on raw codes and calibrated once at the end, since
+ * the calibration curve is monotonic.
+ *
+ * The sample rate cannot resolve a microsecond pulse. Load current is
+ * meant to be measured on the load inductor: after each turn-off it
+ * freewheels through the diode and holds its value for many samples.
+ *
+ * Targets without the ADC continuous driver (the host emulator) cannot
+ * capture and report ESP_ERR_NOT_SUPPORTED.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    DPT_ADC_CURRENT,            // Load current sensor, in A
+    DPT_ADC_VBUS,               // DC-link voltage divider, in V
+    DPT_ADC_SIGNALS,
+} dpt_adc_signal_t;
+
+#define DPT_ADC_SAMPLE_HZ       80000   // All signals together; the ESP32-S3 limit is 83.3 kHz
+#define DPT_ADC_FRAME_SAMPLES   64
+#define DPT_ADC_PEAK_TIMEOUT_MS 100
+
+typedef struct {
+    int8_t gpio;                // ADC1 pad (GPIO 1-10), -1 = unused
+    float scale;                // Units per volt at the pad
+    float offset_mv;            // Pad voltage that reads as zero
+} dpt_adc_input_t;
+
+typedef struct {
+    bool enabled;
+    dpt_adc_input_t in[DPT_ADC_SIGNALS];
+} dpt_adc_config_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t samples;
+    uint32_t overflows;         // Frames the driver dropped because the task fell behind
+    uint32_t peaks;             // Shot windows closed
+    uint32_t peak_timeouts;     // Windows closed before a frame covered their end
+    float value[DPT_ADC_SIGNALS];       // Mean of the latest frame
+    float last_peak[DPT_ADC_SIGNALS];   // Of the last shot window
+} dpt_adc_stats_t;
+
+/**
+ * @brief Create the reader task; capture starts once configured
+ */
+esp_err_t dpt_adc_init(void);
+
+/**
+ * @brief Start, reconfigure or stop capture
+ *
+ * @return ESP_ERR_INVALID_ARG for a pad that is not on ADC1,
+ *         ESP_ERR_NOT_SUPPORTED without the ADC driver
+ */
+esp_err_t dpt_adc_configure(const dpt_adc_config_t *cfg);
+
+void dpt_adc_get_config(dpt_adc_config_t *out);
+
+/**
+ * @brief True if capture runs and the signal has a pad
+ */
+bool dpt_adc_has(dpt_adc_signal_t signal);
+
+/**
+ * @brief Open a shot window; call right before the RMT starts
+ */
+void dpt_adc_peak_begin(void);
+
+/**
+ * @brief Close the window once a frame has covered its end; peaks per signal
+ *
+ * Waits at most DPT_ADC_PEAK_TIMEOUT_MS, about one frame normally.
+ *
+ * @return ESP_ERR_INVALID_STATE if capture is off,
+ *         ESP_ERR_TIMEOUT if no frame arrived (peak covers what did)
+ */
+esp_err_t dpt_adc_peak_end(float peak[DPT_ADC_SIGNALS]);
+
+void dpt_adc_get_stats(dpt_adc_stats_t *out);
+
+/**
+ * @brief Wait for the next frame and return its mean per signal
+ *
+ * For monitoring between shots; callers are served one at a time.
+ *
+ * @return ESP_ERR_INVALID_STATE if capture is off,
+ *         ESP_ERR_TIMEOUT if no frame arrived within timeout_ms
+ */
+esp_err_t dpt_adc_wait_frame(uint32_t timeout_ms, float value[DPT_ADC_SIGNALS]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,36 @@
+/**
+ * @file dpt_baked.c
+ * @brief Plans compiled into the firmware image at build time
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "esp_log.h"
+#include "dpt_baked.h"
+
+#define TAG "DPT_BAKED"
+
+const dpt_baked_recipe_t *dpt_baked_find(const char *name) {
+    for (size_t i = 0; i < dpt_baked_count; i++) {
+        if (strcmp(dpt_baked_recipes[i].name, name) == 0) {
+            return &dpt_baked_recipes[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t dpt_baked_verify(void) {
+    esp_err_t err = ESP_OK;
+    for (size_t i = 0; i < dpt_baked_count; i++) {
+        const dpt_baked_recipe_t *baked = &dpt_baked_recipes[i];
+        uint32_t hash = dpt_plan_rehash(baked->plan);
+        if (hash != baked->plan->hash) {
+            ESP_LOGE(TAG, "%s: hash 0x%08" PRIx32 ", built as 0x%08" PRIx32, baked->name, hash, baked->plan->hash);
+            err = ESP_ERR_INVALID_CRC;
+            continue;
+        }
+        ESP_LOGI(TAG, "%s: %u word(s)/channel, hash=0x%08" PRIx32, baked->name,
+                 baked->plan->num_words[DPT_CHANNEL_P], hash);
+    }
+    return err;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file dpt_baked.h
+ * @brief Plans compiled into the firmware image at build time
+ *
+ * The build compiles every recipe in recipes/ with dptc -c (the host build
+ * of this firmware's own plan compiler) into const plans, which the linker
+ * places in flash. Arming one copies it; nothing is compiled on the
+ * device, and every unit built from the same recipes sends identical item
+ * words. The recipe directory is the DPT_RECIPE_DIR CMake variable.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include "esp_err.h"
+#include "dpt_plan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    const char *name;           // Recipe file name without extension
+    const dpt_plan_t *plan;
+} dpt_baked_recipe_t;
+
+// Generated table (dpt_baked_recipes.c in the build directory)
+extern const dpt_baked_recipe_t dpt_baked_recipes[];
+extern const size_t dpt_baked_count;
+
+/**
+ * @brief Look up a baked recipe by name; NULL if there is none
+ */
+const dpt_baked_recipe_t *dpt_baked_find(const char *name);
+
+/**
+ * @brief Recompute every baked plan's hash and compare it with the one
+ *        computed at build time
+ *
+ * @return ESP_ERR_INVALID_CRC if any plan in flash does not match
+ */
+esp_err_t dpt_baked_verify(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,456 @@
+/**
+ * @file dpt_batch.c
+ * @brief Multi-DUT batch runs through a relay/MUX matrix
+ *
+ * One task runs the batch, like the sweep and target loops; shots claim
+ * the RMT, so manual triggers interleave with a batch. Each shot's record
+ * is opened and closed in the shot log while the claim is held.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "dpt_plan.h"
+#include "dpt_rmt.h"
+#include "dpt_adc.h"
+#include "dpt_delay.h"
+#include "dpt_interlock.h"
+#include "dpt_logic.h"
+#include "dpt_pace.h"
+#include "dpt_pins.h"
+#include "dpt_shotlog.h"
+#include "dpt_thermal.h"
+#include "dpt_batch.h"
+
+#define TAG "DPT_BATCH"
+
+#define BATCH_CORE          1
+#define BATCH_PRIORITY      12      // Same as the sweep executor
+#define CLAIM_TIMEOUT_MS    1000
+#define NS_PER_TICK         (1000.0f / DPT_TICKS_PER_US)
+
+static dpt_batch_config_t config = {
+    .matrix = DPT_BATCH_ONE_HOT,
+    .enable_gpio = -1,
+    .settle_ms = 50,
+    .shots = 1,
+    .interval_ms = 1000,
+};
+static volatile bool stop_requested;
+static SemaphoreHandle_t run_go;
+static int64_t run_start_us;
+static dpt_batch_status_t status;
+static portMUX_TYPE status_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *state_names[] = {
+    [DPT_BATCH_IDLE] = "idle",
+    [DPT_BATCH_RUNNING] = "running",
+    [DPT_BATCH_DONE] = "done",
+    [DPT_BATCH_STOPPED] = "stopped",
+};
+
+static const char *metric_names[] = {
+    [DPT_BATCH_PEAK_A] = "peak_a",
+    [DPT_BATCH_VBUS_V] = "vbus_v",
+    [DPT_BATCH_TD_ON_NS] = "td_on_ns",
+    [DPT_BATCH_TD_OFF_NS] = "td_off_ns",
+    [DPT_BATCH_TJ_C] = "tj_c",
+};
+
+static const char *verdict_names[] = {
+    [DPT_BATCH_PENDING] = "pending",
+    [DPT_BATCH_PASS] = "pass",
+    [DPT_BATCH_FAIL] = "fail",
+    [DPT_BATCH_ERROR] = "error",
+};
+
+const char *dpt_batch_state_name(dpt_batch_state_t state) {
+    return state <= DPT_BATCH_STOPPED ? state_names[state] : "?";
+}
+
+const char *dpt_batch_metric_name(dpt_batch_metric_t metric) {
+    return metric < DPT_BATCH_METRICS ? metric_names[metric] : "?";
+}
+
+const char *dpt_batch_verdict_name(dpt_batch_verdict_t verdict) {
+    return verdict <= DPT_BATCH_ERROR ? verdict_names[verdict] : "?";
+}
+
+// ---------------------- Matrix ----------------------
+static void drive_line(int line, bool on) {
+    gpio_set_level(config.select_gpio[line], on != config.active_low);
+}
+
+static void drive_enable(bool on) {
+    if (config.enable_gpio >= 0) {
+        gpio_set_level(config.enable_gpio, on != config.active_low);
+    }
+}
+
+static void matrix_release(void) {
+    drive_enable(false);
+    for (int k = 0; k < config.num_lines; k++) {
+        drive_line(k, false);
+    }
+}
+
+// Break before make: everything is released before the position's lines close
+static void matrix_select(int position) {
+    matrix_release();
+    for (int k = 0; k < config.num_lines; k++) {
+        bool on = config.matrix == DPT_BATCH_ONE_HOT ? k == position : (position >> k) & 1;
+        if (on) drive_line(k, true);
+    }
+    drive_enable(true);
+}
+
+static esp_err_t matrix_setup(void) {
+    uint64_t mask = config.enable_gpio >= 0 ? 1ULL << config.enable_gpio : 0;
+    for (int k = 0; k < config.num_lines; k++) {
+        mask |= 1ULL << config.select_gpio[k];
+    }
+    gpio_config_t io_conf = {
+        .pin_bit_mask = mask,
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    // Released before the pads turn into outputs, so no relay closes on the way
+    matrix_release();
+    return gpio_config(&io_conf);
+}
+
+// ---------------------- Limits ----------------------
+bool dpt_batch_check(const dpt_batch_config_t *cfg, int recipe, const dpt_batch_measure_t *m, int *fail_metric) {
+    *fail_metric = -1;
+    for (int k = 0; k < cfg->num_limits; k++) {
+        const dpt_batch_limit_t *lim = &cfg->limit[k];
+        if (lim->recipe != DPT_BATCH_ALL_RECIPES && lim->recipe != recipe) {
+            continue;
+        }
+        float v = m->value[lim->metric];
+        if (!(m->valid & (1u << lim->metric)) || v < lim->min || v > lim->max) {
+            *fail_metric = lim->metric;
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------- Shots ----------------------
+static void set_metric(dpt_batch_measure_t *m, dpt_batch_metric_t metric, float value) {
+    m->value[metric] = value;
+    m->valid |= 1u << metric;
+}
+
+// First turn-on and first turn-off of the shot, on the gate comparator
+static void gate_delays(const dpt_plan_t *plan, dpt_batch_measure_t *m) {
+    dpt_delay_config_t dcfg;
+    dpt_delay_get_config(&dcfg);
+    if (!dcfg.enabled || dcfg.gpio[DPT_DELAY_GATE] < 0) {
+        return;
+    }
+    static dpt_delay_stats_t stats;     // Batch task only
+    dpt_delay_get_stats(&stats);
+    if (stats.last_plan_hash != plan->hash) {
+        return;
+    }
+    bool seen[2] = { false, false };
+    for (uint32_t k = 0; k < stats.last_num_edges && k < DPT_DELAY_MAX_EDGES; k++) {
+        const dpt_delay_edge_t *e = &stats.last[k];
+        int32_t d = e->delay_ticks[DPT_DELAY_GATE];
+        if (seen[e->rising] || d == DPT_DELAY_NONE) {
+            continue;
+        }
+        seen[e->rising] = true;
+        set_metric(m, e->rising ? DPT_BATCH_TD_ON_NS : DPT_BATCH_TD_OFF_NS, d * NS_PER_TICK);
+    }
+}
+
+static esp_err_t fire(int dut, int recipe, uint32_t shot, dpt_batch_measure_t *m) {
+    const dpt_plan_t *plan = config.recipe[recipe]->plan;
+    memset(m, 0, sizeof(*m));
+
+    dpt_interlock_wait_t bus;
+    esp_err_t err = dpt_interlock_wait(&bus);
+    dpt_thermal_load_t load;
+    if (err == ESP_OK) {
+        dpt_thermal_load_of(plan, &load);
+        err = dpt_thermal_wait(&load, NULL);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    uint32_t timeout_ms = (uint32_t)(dpt_plan_total_ticks(plan) / (DPT_TICKS_PER_US * 1000)) + 100;
+    err = dpt_rmt_claim(CLAIM_TIMEOUT_MS);
+    if (err != ESP_OK) {
+        return err;
+    }
+    dpt_shotlog_begin();
+    dpt_shotlog_bus_wait(bus.wait_us, bus.vbus_v);
+    float peak[DPT_ADC_SIGNALS];
+    err = dpt_rmt_load(plan, false);
+    dpt_delay_begin();
+    dpt_adc_peak_begin();
+    if (err == ESP_OK) err = dpt_rmt_start();
+    if (err == ESP_OK) dpt_shotlog_started();
+    if (err == ESP_OK) err = dpt_rmt_wait_done(timeout_ms);
+    bool completed = err == ESP_OK;
+    if (completed) dpt_delay_end(plan);
+    esp_err_t adc_err = dpt_adc_peak_end(peak);
+
+    if (completed) {
+        dpt_thermal_shot(&load);
+        if (adc_err == ESP_OK && dpt_adc_has(DPT_ADC_CURRENT)) {
+            set_metric(m, DPT_BATCH_PEAK_A, peak[DPT_ADC_CURRENT]);
+        }
+        if (dpt_interlock_enabled()) {
+            set_metric(m, DPT_BATCH_VBUS_V, bus.vbus_v);
+        } else if (dpt_adc_has(DPT_ADC_VBUS)) {
+            dpt_adc_stats_t adc;
+            dpt_adc_get_stats(&adc);
+            set_metric(m, DPT_BATCH_VBUS_V, adc.value[DPT_ADC_VBUS]);
+        }
+        gate_delays(plan, m);
+        dpt_thermal_config_t tcfg;
+        dpt_thermal_status_t tstat;
+        if (dpt_thermal_get_config(dut, &tcfg) == ESP_OK && tcfg.enabled &&
+            dpt_thermal_get_status(dut, &tstat) == ESP_OK) {
+            set_metric(m, DPT_BATCH_TJ_C, tstat.tj_c);
+        }
+    }
+    int fail_metric;
+    m->pass = completed && dpt_batch_check(&config, recipe, m, &fail_metric);
+    dpt_shotlog_batch(dut, recipe, m->pass);
+    dpt_shotlog_end(shot, plan->hash, completed);
+    dpt_rmt_release();
+    return err;
+}
+
+// ---------------------- Loop ----------------------
+static void wait_interval(int64_t last_start_us) {
+    if (last_start_us == 0 || config.interval_ms == 0) {
+        return;
+    }
+    dpt_pace(last_start_us, config.interval_ms);
+}
+
+// Every recipe shots times on one position; false once a stop was asked for
+static bool test_position(int index, uint32_t *shot, int64_t *last_start_us) {
+    int position = config.dut[index];
+    dpt_batch_dut_t result = { .position = position, .verdict = DPT_BATCH_PASS, .fail_metric = -1,
+                               .fail_recipe = -1 };
+
+    for (int r = 0; r < config.num_recipes; r++) {
+        for (int s = 0; s < config.shots; s++) {
+            if (stop_requested) {
+                return false;
+            }
+            wait_interval(*last_start_us);
+            *last_start_us = esp_timer_get_time();
+            dpt_batch_measure_t m;
+            esp_err_t err = fire(position, r, ++*shot, &m);
+            result.last[r] = m;
+
+            portENTER_CRITICAL(&status_mux);
+            status.shots = *shot;
+            portEXIT_CRITICAL(&status_mux);
+
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Position %d, %s: shot failed: %s", position, config.recipe[r]->name,
+                         esp_err_to_name(err));
+                result.verdict = DPT_BATCH_ERROR;
+                result.fail_recipe = r;
+                result.error = err;
+                break;
+            }
+            int fail_metric;
+            if (!dpt_batch_check(&config, r, &m, &fail_metric) && result.verdict == DPT_BATCH_PASS) {
+                ESP_LOGW(TAG, "Position %d, %s: %s %s", position, config.recipe[r]->name,
+                         dpt_batch_metric_name(fail_metric),
+                         (m.valid & (1u << fail_metric)) ? "out of limits" : "not captured");
+                result.verdict = DPT_BATCH_FAIL;
+                result.fail_metric = fail_metric;
+                result.fail_recipe = r;
+            }
+        }
+        if (result.verdict == DPT_BATCH_ERROR) {
+            break;
+        }
+    }
+
+    portENTER_CRITICAL(&status_mux);
+    status.dut[index] = result;
+    status.done = index + 1;
+    if (result.verdict == DPT_BATCH_PASS) status.passed++;
+    else status.failed++;
+    portEXIT_CRITICAL(&status_mux);
+    ESP_LOGI(TAG, "Position %d: %s", position, dpt_batch_verdict_name(result.verdict));
+    return true;
+}
+
+static void batch_task(void *arg) {
+    while (1) {
+        xSemaphoreTake(run_go, portMAX_DELAY);
+        int64_t last_start_us = 0;
+        uint32_t shot = 0;
+        int selected = dpt_thermal_selected();
+        dpt_batch_state_t state = DPT_BATCH_DONE;
+
+        esp_err_t err = matrix_setup();
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Select lines not set up: %s", esp_err_to_name(err));
+        }
+        for (int k = 0; err == ESP_OK && k < config.num_duts; k++) {
+            if (stop_requested) {
+                state = DPT_BATCH_STOPPED;
+                break;
+            }
+            matrix_select(config.dut[k]);
+            dpt_thermal_select(config.dut[k]);
+            vTaskDelay(dpt_ms_to_ticks_ceil(config.settle_ms));
+            if (!test_position(k, &shot, &last_start_us)) {
+                state = DPT_BATCH_STOPPED;
+                break;
+            }
+        }
+        matrix_release();
+        dpt_thermal_select(selected);
+
+        portENTER_CRITICAL(&status_mux);
+        status.state = state;
+        status.elapsed_us = esp_timer_get_time() - run_start_us;
+        uint8_t done = status.done, passed = status.passed, failed = status.failed;
+        portEXIT_CRITICAL(&status_mux);
+        ESP_LOGI(TAG, "Batch %s: %u of %u position(s) tested, %u passed, %u failed, %" PRIu32 " shot(s)",
+                 dpt_batch_state_name(state), done, config.num_duts, passed, failed, shot);
+    }
+}
+
+// ---------------------- Control ----------------------
+esp_err_t dpt_batch_init(void) {
+    run_go = xSemaphoreCreateBinary();
+    if (!run_go ||
+        xTaskCreatePinnedToCore(batch_task, "batch", 4096, NULL, BATCH_PRIORITY, NULL, BATCH_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t validate(const dpt_batch_config_t *c) {
+    if (c->num_lines < 1 || c->num_lines > DPT_BATCH_SELECT_LINES ||
+        c->num_duts < 1 || c->num_duts > DPT_BATCH_MAX_DUTS ||
+        c->num_recipes < 1 || c->num_recipes > DPT_BATCH_MAX_RECIPES ||
+        c->num_limits > DPT_BATCH_MAX_LIMITS || c->shots < 1 ||
+        (c->matrix != DPT_BATCH_ONE_HOT && c->matrix != DPT_BATCH_BINARY)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int k = 0; k < c->num_lines; k++) {
+        if (c->select_gpio[k] < 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    int positions = c->matrix == DPT_BATCH_ONE_HOT ? c->num_lines : 1 << c->num_lines;
+    for (int k = 0; k < c->num_duts; k++) {
+        if (c->dut[k] >= positions || c->dut[k] >= DPT_BATCH_MAX_DUTS) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    for (int k = 0; k < c->num_limits; k++) {
+        const dpt_batch_limit_t *lim = &c->limit[k];
+        if (lim->metric >= DPT_BATCH_METRICS || lim->recipe >= c->num_recipes ||
+            lim->recipe < DPT_BATCH_ALL_RECIPES || lim->min > lim->max) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    for (int k = 0; k < c->num_recipes; k++) {
+        if (!c->recipe[k]) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (dpt_plan_rehash(c->recipe[k]->plan) != c->recipe[k]->plan->hash) {
+            ESP_LOGE(TAG, "Baked recipe '%s' does not match its hash", c->recipe[k]->name);
+            return ESP_ERR_INVALID_CRC;
+        }
+    }
+    return ESP_OK;
+}
+
+// The select lines and the enable line; they stay outputs after the run
+static esp_err_t claim_pins(const dpt_batch_config_t *c) {
+    int8_t pins[DPT_BATCH_SELECT_LINES + 1];
+    memcpy(pins, c->select_gpio, c->num_lines);
+    pins[c->num_lines] = c->enable_gpio;
+    return dpt_pins_claim_set(DPT_PIN_BATCH, pins, c->num_lines + 1);
+}
+
+esp_err_t dpt_batch_start(const dpt_batch_config_t *new_config) {
+    esp_err_t err = validate(new_config);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // A running batch drives its own lines, which must not change hands
+    portENTER_CRITICAL(&status_mux);
+    bool busy = status.state == DPT_BATCH_RUNNING;
+    portEXIT_CRITICAL(&status_mux);
+    if (busy) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    err = claim_pins(new_config);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    portENTER_CRITICAL(&status_mux);
+    busy = status.state == DPT_BATCH_RUNNING;
+    if (!busy) {
+        memset(&status, 0, sizeof(status));
+        status.state = DPT_BATCH_RUNNING;
+        status.num_duts = new_config->num_duts;
+        for (int k = 0; k < new_config->num_duts; k++) {
+            status.dut[k] = (dpt_batch_dut_t){ .position = new_config->dut[k], .fail_metric = -1,
+                                               .fail_recipe = -1 };
+        }
+    }
+    portEXIT_CRITICAL(&status_mux);
+    if (busy) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // The task is idle: nothing reads the config now
+    config = *new_config;
+    stop_requested = false;
+    run_start_us = esp_timer_get_time();
+    xSemaphoreGive(run_go);
+    ESP_LOGI(TAG, "Batch of %u position(s) x %u recipe(s) x %u shot(s), %s matrix on %u line(s), settle %" PRIu32
+             " ms, %u limit(s)", config.num_duts, config.num_recipes, config.shots,
+             config.matrix == DPT_BATCH_ONE_HOT ? "one-hot" : "binary", config.num_lines, config.settle_ms,
+             config.num_limits);
+    return ESP_OK;
+}
+
+void dpt_batch_stop(void) {
+    stop_requested = true;
+}
+
+void dpt_batch_get_config(dpt_batch_config_t *out) {
+    portENTER_CRITICAL(&status_mux);
+    *out = config;
+    portEXIT_CRITICAL(&status_mux);
+}
+
+void dpt_batch_get_status(dpt_batch_status_t *out) {
+    portENTER_CRITICAL(&status_mux);
+    *out = status;
+    if (status.state == DPT_BATCH_RUNNING) {
+        out->elapsed_us = esp_timer_get_time() - run_start_us;
+    }
+    portEXIT_CRITICAL(&status_mux);
+}
@@ -0,0 +1,156 @@
+/**
+ * @file dpt_batch.h
+ * @brief Multi-DUT batch runs through a relay/MUX matrix
+ *
+ * A batch steps through a list of DUT positions. For each one it drives
+ * the matrix select lines (spare GPIOs) to connect that DUT and waits
+ * settle_ms for the contacts. It then fires every recipe of the list
+ * shots times and checks the metrics captured on each shot against the
+ * limits. The matrix is either one relay per position (one-hot: line k
+ * closes position k) or a MUX addressed in binary. All lines, and the
+ * optional enable line, are released before the next position is
+ * selected, so two DUTs are never connected at once. Without an enable
+ * line a binary MUX rests on address 0 between positions.
+ *
+ * Metrics come from the capture modules that are enabled: peak load
+ * current (src/dpt_adc.h), bus voltage (src/dpt_interlock.h, or the ADC),
+ * gate td(on)/td(off) of the first turn-on and turn-off (src/dpt_delay.h)
+ * and the junction temperature estimate (src/dpt_thermal.h, whose DUT
+ * index follows the position). A limit on a metric that was not
+ * captured fails. Every shot is recorded in the shot log with its
+ * position, recipe and verdict; the per-position summary is kept here.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "dpt_baked.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DPT_BATCH_MAX_DUTS      8       // Positions; each has its own thermal model
+#define DPT_BATCH_MAX_RECIPES   8
+#define DPT_BATCH_MAX_LIMITS    8
+#define DPT_BATCH_SELECT_LINES  8
+#define DPT_BATCH_ALL_RECIPES   (-1)
+
+typedef enum {
+    DPT_BATCH_PEAK_A,
+    DPT_BATCH_VBUS_V,
+    DPT_BATCH_TD_ON_NS,
+    DPT_BATCH_TD_OFF_NS,
+    DPT_BATCH_TJ_C,
+    DPT_BATCH_METRICS,
+} dpt_batch_metric_t;
+
+typedef enum {
+    DPT_BATCH_ONE_HOT,          // Line k selects position k
+    DPT_BATCH_BINARY,           // Lines are the position's address bits, LSB first
+} dpt_batch_matrix_t;
+
+typedef struct {
+    dpt_batch_metric_t metric;
+    int8_t recipe;              // Index in the recipe list, or DPT_BATCH_ALL_RECIPES
+    float min, max;             // ±INFINITY for an open side
+} dpt_batch_limit_t;
+
+typedef struct {
+    // Matrix
+    dpt_batch_matrix_t matrix;
+    uint8_t num_lines;
+    int8_t select_gpio[DPT_BATCH_SELECT_LINES];
+    int8_t enable_gpio;         // -1 = none; closed once the select lines are set
+    bool active_low;            // Applies to the enable line too
+    uint32_t settle_ms;
+    // Run
+    uint8_t num_duts;
+    uint8_t dut[DPT_BATCH_MAX_DUTS];        // Positions, in test order
+    uint8_t num_recipes;
+    const dpt_baked_recipe_t *recipe[DPT_BATCH_MAX_RECIPES];
+    uint8_t shots;              // Per recipe and position
+    uint32_t interval_ms;       // Minimum between shot starts
+    uint8_t num_limits;
+    dpt_batch_limit_t limit[DPT_BATCH_MAX_LIMITS];
+} dpt_batch_config_t;
+
+typedef enum {
+    DPT_BATCH_IDLE,
+    DPT_BATCH_RUNNING,
+    DPT_BATCH_DONE,
+    DPT_BATCH_STOPPED,
+} dpt_batch_state_t;
+
+typedef enum {
+    DPT_BATCH_PENDING,
+    DPT_BATCH_PASS,
+    DPT_BATCH_FAIL,             // A metric outside its limits
+    DPT_BATCH_ERROR,            // A shot was not fired or did not complete
+} dpt_batch_verdict_t;
+
+typedef struct {
+    float value[DPT_BATCH_METRICS];
+    uint8_t valid;              // Bit per metric
+    bool pass;
+} dpt_batch_measure_t;
+
+typedef struct {
+    uint8_t position;
+    dpt_batch_verdict_t verdict;
+    int8_t fail_metric;         // First limit broken, -1 if none
+    int8_t fail_recipe;
+    esp_err_t error;
+    dpt_batch_measure_t last[DPT_BATCH_MAX_RECIPES];    // Last shot of each recipe
+} dpt_batch_dut_t;
+
+typedef struct {
+    dpt_batch_state_t state;
+    uint8_t num_duts;
+    uint8_t done;
+    uint8_t passed;
+    uint8_t failed;             // FAIL and ERROR
+    uint32_t shots;
+    int64_t elapsed_us;
+    dpt_batch_dut_t dut[DPT_BATCH_MAX_DUTS];
+} dpt_batch_status_t;
+
+esp_err_t dpt_batch_init(void);
+
+/**
+ * @brief Start a batch
+ *
+ * @return ESP_ERR_INVALID_STATE while one runs, ESP_ERR_INVALID_ARG for a
+ *         bad matrix, a position the matrix cannot select, no recipes or
+ *         a limit on a recipe not in the list, ESP_ERR_INVALID_CRC for a
+ *         baked recipe that does not match its hash
+ */
+esp_err_t dpt_batch_start(const dpt_batch_config_t *config);
+
+/**
+ * @brief Stop after the shot in progress; the matrix is released
+ */
+void dpt_batch_stop(void);
+
+void dpt_batch_get_config(dpt_batch_config_t *out);
+
+void dpt_batch_get_status(dpt_batch_status_t *out);
+
+const char *dpt_batch_state_name(dpt_batch_state_t state);
+
+const char *dpt_batch_metric_name(dpt_batch_metric_t metric);
+
+const char *dpt_batch_verdict_name(dpt_batch_verdict_t verdict);
+
+/**
+ * @brief Check one shot's metrics against the limits that apply to a recipe
+ *
+ * @param[out] fail_metric  First metric out of its limits or not captured, -1 if all pass
+ */
+bool dpt_batch_check(const dpt_batch_config_t *config, int recipe, const dpt_batch_measure_t *m, int *fail_metric);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,402 @@
+/**
+ * @file dpt_bench.c
+ * @brief Timing benchmark: one baked recipe fired thousands of times
+ *
+ * The benchmark task and the timer's interrupt run on core 1, away from
+ * WiFi. The task holds the RMT claim only between shots, to load the plan
+ * and collect the captured edges, so the ISR finds the channels free when
+ * the alarm goes off unless a manual shot got in between.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "soc/soc_caps.h"
+#include "dpt_plan.h"
+#include "dpt_rmt.h"
+#include "dpt_delay.h"
+#include "dpt_interlock.h"
+#include "dpt_pace.h"
+#include "dpt_pool.h"
+#include "dpt_thermal.h"
+#include "dpt_bench.h"
+
+#if SOC_GPTIMER_SUPPORTED
+#include "driver/gptimer.h"
+#endif
+
+#define TAG "DPT_BENCH"
+
+#define BENCH_CORE          1
+#define BENCH_PRIORITY      12      // Same as the sweep executor
+#define CLAIM_TIMEOUT_MS    1000
+#define TIMER_HZ            40000000    // APB / 2, the finest GPTimer resolution
+#define ALARM_LEAD_US       200     // Alarm set this far ahead of its count
+#define NS_PER_TICK         (1000.0f / DPT_TICKS_PER_US)
+
+static dpt_bench_config_t config;
+// Copy of the recipe's plan in a pool block (DRAM): baked plans live in
+// flash, and the alarm ISR must not read flash when it is IRAM-safe
+static const dpt_plan_t *run_plan;
+static volatile bool stop_requested;
+static SemaphoreHandle_t run_go;
+static TaskHandle_t bench_task_handle;
+static int64_t run_start_us;
+static dpt_bench_status_t status;
+static portMUX_TYPE status_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *state_names[] = {
+    [DPT_BENCH_IDLE] = "idle",
+    [DPT_BENCH_RUNNING] = "running",
+    [DPT_BENCH_DONE] = "done",
+    [DPT_BENCH_STOPPED] = "stopped",
+    [DPT_BENCH_FAILED] = "failed",
+};
+
+const char *dpt_bench_state_name(dpt_bench_state_t state) {
+    return state <= DPT_BENCH_FAILED ? state_names[state] : "?";
+}
+
+static void stat_add(dpt_bench_stat_t *s, float ns) {
+    if (s->count == 0 || ns < s->min_ns) s->min_ns = ns;
+    if (s->count == 0 || ns > s->max_ns) s->max_ns = ns;
+    s->count++;
+    float d = ns - s->mean_ns;
+    s->mean_ns += d / s->count;
+    s->m2 += d * (ns - s->mean_ns);
+}
+
+// ---------------------- Trigger ----------------------
+typedef struct {
+    esp_err_t err;
+    float entry_ns;             // Negative if not measured
+    float start_ns;
+    float wake_ns;
+} shot_timing_t;
+
+#if SOC_GPTIMER_SUPPORTED
+
+static gptimer_handle_t timer;
+static const dpt_plan_t *volatile isr_plan;
+static volatile shot_timing_t isr_timing;
+static volatile uint64_t isr_alarm;
+
+static bool IRAM_ATTR alarm_isr(gptimer_handle_t t, const gptimer_alarm_event_data_t *edata, void *arg) {
+    uint32_t entry_cycles = esp_cpu_get_cycle_count();
+    uint64_t entry;
+    gptimer_get_raw_count(t, &entry);
+    esp_err_t err = dpt_rmt_fire_from_isr(isr_plan);
+    uint32_t start_cycles = esp_cpu_get_cycle_count() - entry_cycles;
+
+    float entry_ns = (entry - edata->alarm_value) * (1e9f / TIMER_HZ);
+    isr_timing.err = err;
+    isr_timing.entry_ns = entry_ns;
+    isr_timing.start_ns = entry_ns + start_cycles * 1000.0f / esp_rom_get_cpu_ticks_per_us();
+    isr_alarm = edata->alarm_value;
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(bench_task_handle, &woken);
+    return woken == pdTRUE;
+}
+
+static esp_err_t trigger_setup(void) {
+    gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = TIMER_HZ,
+    };
+    esp_err_t err = gptimer_new_timer(&timer_config, &timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    gptimer_event_callbacks_t cbs = { .on_alarm = alarm_isr };
+    err = gptimer_register_event_callbacks(timer, &cbs, NULL);
+    if (err == ESP_OK) err = gptimer_enable(timer);
+    if (err == ESP_OK) err = gptimer_start(timer);
+    if (err != ESP_OK) {
+        gptimer_del_timer(timer);
+    }
+    return err;
+}
+
+static void trigger_teardown(void) {
+    gptimer_stop(timer);
+    gptimer_disable(timer);
+    gptimer_del_timer(timer);
+}
+
+// Arm a one-shot alarm and sleep until its ISR has fired the plan
+static esp_err_t trigger_shot(const dpt_plan_t *plan, shot_timing_t *out) {
+    isr_plan = plan;
+    uint64_t now;
+    gptimer_get_raw_count(timer, &now);
+    gptimer_alarm_config_t alarm = { .alarm_count = now + (uint64_t)ALARM_LEAD_US * (TIMER_HZ / 1000000) };
+    ulTaskNotifyTake(pdTRUE, 0);
+    esp_err_t err = gptimer_set_alarm_action(timer, &alarm);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CLAIM_TIMEOUT_MS)) == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+    uint64_t woke;
+    gptimer_get_raw_count(timer, &woke);
+    out->err = isr_timing.err;
+    out->entry_ns = isr_timing.entry_ns;
+    out->start_ns = isr_timing.start_ns;
+    out->wake_ns = (woke - isr_alarm) * (1e9f / TIMER_HZ);
+    return ESP_OK;
+}
+
+#else
+
+// No general-purpose timer: the task is its own trigger
+static esp_err_t trigger_setup(void) {
+    return ESP_OK;
+}
+
+static void trigger_teardown(void) {
+}
+
+static esp_err_t trigger_shot(const dpt_plan_t *plan, shot_timing_t *out) {
+    uint32_t begin = esp_cpu_get_cycle_count();
+    out->err = dpt_rmt_fire_from_isr(plan);
+    out->start_ns = (esp_cpu_get_cycle_count() - begin) * 1000.0f / esp_rom_get_cpu_ticks_per_us();
+    out->entry_ns = -1.0f;
+    out->wake_ns = -1.0f;
+    return ESP_OK;
+}
+
+#endif // SOC_GPTIMER_SUPPORTED
+
+// ---------------------- Edge Jitter ----------------------
+// Captured P pad edges against the plan's; false if the counts differ
+static bool edge_errors(const dpt_plan_t *plan, dpt_bench_stat_t *stat) {
+    static dpt_delay_stats_t stats;     // Benchmark task only
+    dpt_delay_get_stats(&stats);
+    uint32_t plan_edges = dpt_plan_count_edges(plan, DPT_CHANNEL_P);
+    uint32_t expected = plan_edges < DPT_DELAY_MAX_EDGES ? plan_edges : DPT_DELAY_MAX_EDGES;
+    if (stats.last_plan_hash != plan->hash || stats.last_num_edges != expected) {
+        return false;
+    }
+
+    dpt_edge_iter_t it;
+    dpt_edge_iter_init(&it, plan, DPT_CHANNEL_P);
+    uint32_t tick, first = 0;
+    uint8_t level;
+    for (uint32_t k = 0; k < expected && dpt_edge_iter_next(&it, &tick, &level); k++) {
+        if (k == 0) {
+            first = tick;
+        }
+        stat_add(stat, ((int64_t)stats.last[k].tick - (int64_t)(tick - first)) * NS_PER_TICK);
+    }
+    return true;
+}
+
+// ---------------------- Loop ----------------------
+static esp_err_t run_shot(const dpt_plan_t *plan, bool capture) {
+    dpt_interlock_wait_t bus;
+    esp_err_t err = dpt_interlock_wait(&bus);
+    dpt_thermal_load_t load;
+    if (err == ESP_OK) {
+        dpt_thermal_load_of(plan, &load);
+        err = dpt_thermal_wait(&load, NULL);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Loaded under the claim, so the ISR only starts the channels. Always
+    // from this plan: the ISR copies again if another plan with the same
+    // hash (an armed copy of the recipe) was loaded last.
+    err = dpt_rmt_claim(CLAIM_TIMEOUT_MS);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = dpt_rmt_load(plan, false);
+    dpt_delay_begin();
+    dpt_rmt_release();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    shot_timing_t timing;
+    err = trigger_shot(plan, &timing);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (timing.err != ESP_OK) {
+        portENTER_CRITICAL(&status_mux);
+        status.busy++;
+        portEXIT_CRITICAL(&status_mux);
+        return ESP_OK;
+    }
+
+    // The claim is free again once both channels have reported TX end
+    esp_rom_delay_us((uint32_t)(dpt_plan_total_ticks(plan) / DPT_TICKS_PER_US) + 1);
+    err = dpt_rmt_claim(CLAIM_TIMEOUT_MS);
+    if (err != ESP_OK) {
+        return err;
+    }
+    dpt_delay_end(plan);
+    dpt_rmt_release();
+    dpt_thermal_shot(&load);
+
+    dpt_bench_stat_t edge_error;
+    portENTER_CRITICAL(&status_mux);
+    edge_error = status.edge_error;
+    portEXIT_CRITICAL(&status_mux);
+    bool edges_ok = !capture || edge_errors(plan, &edge_error);
+
+    portENTER_CRITICAL(&status_mux);
+    status.shots++;
+    if (timing.entry_ns >= 0.0f) stat_add(&status.entry, timing.entry_ns);
+    stat_add(&status.start, timing.start_ns);
+    if (timing.wake_ns >= 0.0f) stat_add(&status.wake, timing.wake_ns);
+    if (capture) status.edge_error = edge_error;
+    if (!edges_ok) status.edge_mismatches++;
+    portEXIT_CRITICAL(&status_mux);
+    return ESP_OK;
+}
+
+// Turn the P pad capture on for the run; false if this target has none
+static bool capture_on(dpt_delay_config_t *saved) {
+    dpt_delay_get_config(saved);
+    if (saved->enabled) {
+        return true;
+    }
+    dpt_delay_config_t cfg = *saved;
+    cfg.enabled = true;
+    for (int in = 0; in < DPT_DELAY_INPUTS; in++) {
+        cfg.gpio[in] = -1;
+    }
+    return dpt_delay_configure(&cfg) == ESP_OK;
+}
+
+static void bench_task(void *arg) {
+    while (1) {
+        xSemaphoreTake(run_go, portMAX_DELAY);
+        const dpt_plan_t *plan = run_plan;
+        dpt_delay_config_t saved_capture;
+        bool capture = capture_on(&saved_capture);
+        if (!capture) {
+            ESP_LOGW(TAG, "No edge capture on this target; edge jitter not measured");
+        }
+
+        dpt_bench_state_t state = DPT_BENCH_DONE;
+        esp_err_t err = trigger_setup();
+        bool timer_up = err == ESP_OK;
+        if (!timer_up) {
+            ESP_LOGE(TAG, "Trigger timer not set up: %s", esp_err_to_name(err));
+            state = DPT_BENCH_FAILED;
+        }
+        int64_t last_start_us = 0;
+        for (uint32_t k = 0; timer_up && k < config.shots; k++) {
+            if (stop_requested) {
+                state = DPT_BENCH_STOPPED;
+                break;
+            }
+            if (k > 0) {
+                dpt_pace(last_start_us, config.interval_ms);
+            }
+            last_start_us = esp_timer_get_time();
+            err = run_shot(plan, capture);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Shot %" PRIu32 " failed: %s", k + 1, esp_err_to_name(err));
+                state = DPT_BENCH_FAILED;
+                break;
+            }
+        }
+        if (timer_up) {
+            trigger_teardown();
+        }
+        if (capture && !saved_capture.enabled) {
+            dpt_delay_configure(&saved_capture);
+        }
+
+        portENTER_CRITICAL(&status_mux);
+        status.state = state;
+        status.last_error = err;
+        status.elapsed_us = esp_timer_get_time() - run_start_us;
+        dpt_bench_status_t st = status;
+        portEXIT_CRITICAL(&status_mux);
+        ESP_LOGI(TAG, "Benchmark %s: %" PRIu32 " shot(s), start latency %.0f/%.0f/%.0f ns (min/mean/max), "
+                 "edge error %.1f..%.1f ns, %" PRIu32 " busy, %" PRIu32 " edge mismatch(es)",
+                 dpt_bench_state_name(state), st.shots, st.start.min_ns, st.start.mean_ns, st.start.max_ns,
+                 st.edge_error.min_ns, st.edge_error.max_ns, st.busy, st.edge_mismatches);
+        run_plan = NULL;
+        dpt_pool_free((void *)plan);
+    }
+}
+
+// ---------------------- Control ----------------------
+esp_err_t dpt_bench_init(void) {
+    run_go = xSemaphoreCreateBinary();
+    if (!run_go || xTaskCreatePinnedToCore(bench_task, "bench", 4096, NULL, BENCH_PRIORITY, &bench_task_handle,
+                                           BENCH_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t dpt_bench_start(const dpt_bench_config_t *new_config) {
+    const dpt_bench_config_t *c = new_config;
+    if (!c->recipe || c->shots < 1 || c->shots > DPT_BENCH_MAX_SHOTS || c->interval_ms < 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!dpt_rmt_fits(c->recipe->plan)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (dpt_plan_rehash(c->recipe->plan) != c->recipe->plan->hash) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    dpt_plan_t *copy;
+    esp_err_t err = dpt_pool_alloc(sizeof(*copy), (void **)&copy);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    portENTER_CRITICAL(&status_mux);
+    bool busy = status.state == DPT_BENCH_RUNNING;
+    if (!busy) {
+        memset(&status, 0, sizeof(status));
+        status.state = DPT_BENCH_RUNNING;
+        status.recipe = c->recipe->name;
+    }
+    portEXIT_CRITICAL(&status_mux);
+    if (busy) {
+        dpt_pool_free(copy);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // The task is idle: nothing reads the config now
+    *copy = *c->recipe->plan;
+    run_plan = copy;
+    config = *c;
+    stop_requested = false;
+    run_start_us = esp_timer_get_time();
+    xSemaphoreGive(run_go);
+    ESP_LOGI(TAG, "Benchmark: '%s' %" PRIu32 " time(s), every %" PRIu32 " ms", c->recipe->name, c->shots,
+             c->interval_ms);
+    return ESP_OK;
+}
+
+void dpt_bench_stop(void) {
+    stop_requested = true;
+}
+
+void dpt_bench_get_status(dpt_bench_status_t *out) {
+    portENTER_CRITICAL(&status_mux);
+    *out = status;
+    if (status.state == DPT_BENCH_RUNNING) {
+        out->elapsed_us = esp_timer_get_time() - run_start_us;
+    }
+    portEXIT_CRITICAL(&status_mux);
+}
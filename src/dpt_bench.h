@@ -0,0 +1,96 @@
+/**
+ * @file dpt_bench.h
+ * @brief Timing benchmark: one baked recipe fired thousands of times
+ *
+ * Each shot is triggered by a hardware timer alarm whose ISR fires the
+ * plan with dpt_rmt_fire_from_isr(), the path trigger inputs use. The
+ * timer counts at 40 MHz, so the latencies below share one time base
+ * with the alarm:
+ *
+ *   entry: alarm to the ISR running
+ *   start: alarm to both channels started (the trigger latency)
+ *   wake:  alarm to the benchmark task running, woken by the ISR; what a
+ *          shot fired from a task would add
+ *
+ * The P output pad is read back through the switching delay capture
+ * (src/dpt_delay.h) for edge jitter: every captured edge, timed from the
+ * first one, is compared with the edge the plan commands there. Only the
+ * first DPT_DELAY_MAX_EDGES edges of a shot are compared, at the capture
+ * resolution of 12.5 ns. The capture is enabled for the run if it was off.
+ *
+ * Shots pass the bus interlock and the thermal model like any other, both
+ * before the timed window, and are not recorded in the shot log. Without
+ * a general-purpose timer (the host emulator) the task fires the shot
+ * itself and only the start latency is measured.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "dpt_baked.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DPT_BENCH_MAX_SHOTS     100000
+
+typedef struct {
+    const dpt_baked_recipe_t *recipe;
+    uint32_t shots;
+    uint32_t interval_ms;       // Between shot triggers
+} dpt_bench_config_t;
+
+typedef enum {
+    DPT_BENCH_IDLE,
+    DPT_BENCH_RUNNING,
+    DPT_BENCH_DONE,
+    DPT_BENCH_STOPPED,
+    DPT_BENCH_FAILED,
+} dpt_bench_state_t;
+
+typedef struct {
+    uint32_t count;
+    float min_ns, max_ns;
+    float mean_ns;
+    float m2;                   // Sum of squared deviations from the mean
+} dpt_bench_stat_t;
+
+typedef struct {
+    dpt_bench_state_t state;
+    const char *recipe;
+    uint32_t shots;             // Fired
+    uint32_t busy;              // Alarms that found the RMT taken by another shot
+    uint32_t edge_mismatches;   // Shots with a different number of edges than the plan
+    esp_err_t last_error;
+    int64_t elapsed_us;
+    dpt_bench_stat_t entry;
+    dpt_bench_stat_t start;
+    dpt_bench_stat_t wake;
+    dpt_bench_stat_t edge_error;    // Captured minus commanded edge time
+} dpt_bench_status_t;
+
+esp_err_t dpt_bench_init(void);
+
+/**
+ * @brief Start a run
+ *
+ * @return ESP_ERR_INVALID_STATE while one runs, ESP_ERR_INVALID_ARG without
+ *         a recipe, for 0 or more than DPT_BENCH_MAX_SHOTS shots or an
+ *         interval of 0, ESP_ERR_INVALID_SIZE for a plan that does not fit
+ *         the RMT RAM, ESP_ERR_INVALID_CRC for a baked recipe that does
+ *         not match its hash, ESP_ERR_NO_MEM if no pool block is free
+ *         for the copy of the plan
+ */
+esp_err_t dpt_bench_start(const dpt_bench_config_t *config);
+
+void dpt_bench_stop(void);
+
+void dpt_bench_get_status(dpt_bench_status_t *out);
+
+const char *dpt_bench_state_name(dpt_bench_state_t state);
+
+#ifdef __cplusplus
+}
+#endif
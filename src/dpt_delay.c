@@ -0,0 +1,285 @@
+/**
+ * @file dpt_delay.c
+ * @brief DUT switching delays from comparator feedback edges
+ *
+ * The capture interrupt appends to a per-shot event list under a spinlock.
+ * Begin and end run with the RMT claimed, so shots never overlap here;
+ * readers copy the statistics under the same kind of lock.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "soc/soc_caps.h"
+#include "dpt_delay.h"
+#include "dpt_pins.h"
+#include "dpt_rmt.h"
+
+#if SOC_MCPWM_SUPPORTED
+#include "driver/gpio.h"
+#include "driver/mcpwm_cap.h"
+#endif
+
+#define TAG "DPT_DELAY"
+
+#define INPUT_COMMAND   (-1)
+
+typedef struct {
+    int8_t input;               // INPUT_COMMAND or dpt_delay_input_t
+    uint8_t rising;
+    uint32_t count;             // Capture timer
+} event_t;
+
+static dpt_delay_config_t config = {
+    .gpio = { -1, -1 },
+    .on_rising = { true, false },   // Gate voltage rises at turn-on, Vds falls
+};
+static uint32_t timer_hz = DPT_TICKS_PER_US * 1000000;
+
+static event_t events[DPT_DELAY_EVENTS];
+static uint32_t num_events = 0;
+static bool overflow = false;
+static portMUX_TYPE events_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static dpt_delay_stats_t stats;
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// ---------------------- Events ----------------------
+void IRAM_ATTR dpt_delay_record(int input, bool rising, uint32_t count) {
+    portENTER_CRITICAL_SAFE(&events_mux);
+    if (num_events < DPT_DELAY_EVENTS) {
+        events[num_events++] = (event_t){ .input = input, .rising = rising, .count = count };
+    } else {
+        overflow = true;
+    }
+    portEXIT_CRITICAL_SAFE(&events_mux);
+}
+
+void dpt_delay_begin(void) {
+    if (!config.enabled) {
+        return;
+    }
+    portENTER_CRITICAL(&events_mux);
+    num_events = 0;
+    overflow = false;
+    portEXIT_CRITICAL(&events_mux);
+}
+
+static void stat_add(dpt_delay_stat_t *s, uint32_t ticks) {
+    if (s->count == 0 || ticks < s->min_ticks) s->min_ticks = ticks;
+    if (s->count == 0 || ticks > s->max_ticks) s->max_ticks = ticks;
+    s->count++;
+    float d = ticks - s->mean_ticks;
+    s->mean_ticks += d / s->count;
+    s->m2 += d * (ticks - s->mean_ticks);
+}
+
+// First edge of the given polarity on an input in [from, to); to == from means no limit
+static int32_t find_edge(const event_t *ev, uint32_t n, int input, bool rising, uint32_t from, uint32_t to) {
+    for (uint32_t i = 0; i < n; i++) {
+        if (ev[i].input != input || ev[i].rising != rising) {
+            continue;
+        }
+        uint32_t since = ev[i].count - from;
+        if ((int32_t)since >= 0 && (to == from || (int32_t)(ev[i].count - to) < 0)) {
+            return (int32_t)((uint64_t)since * (DPT_TICKS_PER_US * 1000000) / timer_hz);
+        }
+    }
+    return DPT_DELAY_NONE;
+}
+
+void dpt_delay_end(const dpt_plan_t *plan) {
+    if (!config.enabled) {
+        return;
+    }
+    esp_rom_delay_us(DPT_DELAY_SETTLE_US);
+
+    static event_t ev[DPT_DELAY_EVENTS];     // The caller holds the RMT claim; one shot at a time
+    portENTER_CRITICAL(&events_mux);
+    uint32_t n = num_events;
+    bool lost = overflow;
+    memcpy(ev, events, n * sizeof(ev[0]));
+    num_events = DPT_DELAY_EVENTS;          // Nothing more until the next begin
+    portEXIT_CRITICAL(&events_mux);
+
+    // Commanded edges in capture order, which is time order on one channel
+    static dpt_delay_edge_t edges[DPT_DELAY_MAX_EDGES];
+    uint32_t cmd[DPT_DELAY_MAX_EDGES];
+    uint32_t num_edges = 0;
+    for (uint32_t i = 0; i < n && num_edges < DPT_DELAY_MAX_EDGES; i++) {
+        if (ev[i].input == INPUT_COMMAND) {
+            cmd[num_edges] = ev[i].count;
+            edges[num_edges].rising = ev[i].rising;
+            edges[num_edges].tick = (uint32_t)((uint64_t)(ev[i].count - cmd[0]) * (DPT_TICKS_PER_US * 1000000) / timer_hz);
+            num_edges++;
+        }
+    }
+
+    uint32_t missed = 0;
+    for (uint32_t k = 0; k < num_edges; k++) {
+        uint32_t to = (k + 1 < num_edges) ? cmd[k + 1] : cmd[k];
+        for (int in = 0; in < DPT_DELAY_INPUTS; in++) {
+            edges[k].delay_ticks[in] = DPT_DELAY_NONE;
+            if (config.gpio[in] < 0) {
+                continue;
+            }
+            bool rising = edges[k].rising ? config.on_rising[in] : !config.on_rising[in];
+            edges[k].delay_ticks[in] = find_edge(ev, n, in, rising, cmd[k], to);
+            if (edges[k].delay_ticks[in] == DPT_DELAY_NONE) {
+                missed++;
+            }
+        }
+    }
+    uint32_t plan_edges = dpt_plan_count_edges(plan, DPT_CHANNEL_P);
+
+    portENTER_CRITICAL(&stats_mux);
+    stats.shots++;
+    stats.missed += missed;
+    stats.overflows += lost ? 1 : 0;
+    stats.plan_mismatches += (num_edges != plan_edges) ? 1 : 0;
+    for (uint32_t k = 0; k < num_edges; k++) {
+        for (int in = 0; in < DPT_DELAY_INPUTS; in++) {
+            if (edges[k].delay_ticks[in] != DPT_DELAY_NONE) {
+                stat_add(&stats.stat[in][edges[k].rising], edges[k].delay_ticks[in]);
+            }
+        }
+    }
+    stats.last_plan_hash = plan->hash;
+    stats.last_plan_edges = plan_edges;
+    stats.last_num_edges = num_edges;
+    memcpy(stats.last, edges, num_edges * sizeof(edges[0]));
+    portEXIT_CRITICAL(&stats_mux);
+
+    if (num_edges != plan_edges || lost) {
+        ESP_LOGW(TAG, "Captured %" PRIu32 " of %" PRIu32 " commanded edge(s)%s", num_edges, plan_edges,
+                 lost ? ", event list overflowed" : "");
+    }
+}
+
+void dpt_delay_get_stats(dpt_delay_stats_t *out) {
+    portENTER_CRITICAL(&stats_mux);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+void dpt_delay_reset(void) {
+    portENTER_CRITICAL(&stats_mux);
+    memset(&stats, 0, sizeof(stats));
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+// ---------------------- Capture Channels ----------------------
+#if SOC_MCPWM_SUPPORTED
+
+static mcpwm_cap_timer_handle_t cap_timer = NULL;
+static mcpwm_cap_channel_handle_t command_chan = NULL;
+static mcpwm_cap_channel_handle_t input_chan[DPT_DELAY_INPUTS];
+
+static bool IRAM_ATTR on_capture(mcpwm_cap_channel_handle_t chan, const mcpwm_capture_event_data_t *ev, void *arg) {
+    dpt_delay_record((int)(intptr_t)arg, ev->cap_edge == MCPWM_CAP_EDGE_POS, ev->cap_value);
+    return false;
+}
+
+static esp_err_t new_channel(int gpio, int input, mcpwm_cap_channel_handle_t *out) {
+    mcpwm_capture_channel_config_t cfg = {
+        .gpio_num = gpio,
+        .prescale = 1,
+        .flags.pos_edge = true,
+        .flags.neg_edge = true,
+    };
+    mcpwm_capture_event_callbacks_t cbs = { .on_cap = on_capture };
+    esp_err_t err = mcpwm_new_capture_channel(cap_timer, &cfg, out);
+    if (err == ESP_OK) err = mcpwm_capture_channel_register_event_callbacks(*out, &cbs, (void *)(intptr_t)input);
+    if (err == ESP_OK) err = mcpwm_capture_channel_enable(*out);
+    return err;
+}
+
+static void delete_channel(mcpwm_cap_channel_handle_t *chan) {
+    if (*chan != NULL) {
+        mcpwm_capture_channel_disable(*chan);
+        mcpwm_del_capture_channel(*chan);
+        *chan = NULL;
+    }
+}
+
+// The timer and the channel on the P pad are set up once and kept: the
+// driver only enables the pad's input and routes it, which the output
+// already has (see dpt_rmt.c), and it is not worth touching again.
+static esp_err_t start_timer(void) {
+    mcpwm_capture_timer_config_t cfg = {
+        .group_id = 0,
+        .clk_src = MCPWM_CAPTURE_CLK_SRC_APB,
+    };
+    esp_err_t err = mcpwm_new_capture_timer(&cfg, &cap_timer);
+    if (err == ESP_OK) err = mcpwm_capture_timer_get_resolution(cap_timer, &timer_hz);
+    if (err == ESP_OK) err = new_channel(RMT_TX_GPIO_P, INPUT_COMMAND, &command_chan);
+    if (err == ESP_OK) err = mcpwm_capture_timer_enable(cap_timer);
+    if (err == ESP_OK) err = mcpwm_capture_timer_start(cap_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Capture timer setup failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGI(TAG, "Capture timer at %" PRIu32 " Hz", timer_hz);
+    return ESP_OK;
+}
+
+static esp_err_t backend_configure(const dpt_delay_config_t *cfg) {
+    if (cfg->enabled && cap_timer == NULL) {
+        esp_err_t err = start_timer();
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    for (int in = 0; in < DPT_DELAY_INPUTS; in++) {
+        delete_channel(&input_chan[in]);
+        if (cfg->enabled && cfg->gpio[in] >= 0) {
+            esp_err_t err = new_channel(cfg->gpio[in], in, &input_chan[in]);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Capture channel on GPIO%d failed: %s", cfg->gpio[in], esp_err_to_name(err));
+                return err;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+#else
+
+static esp_err_t backend_configure(const dpt_delay_config_t *cfg) {
+    return cfg->enabled ? ESP_ERR_NOT_SUPPORTED : ESP_OK;
+}
+
+#endif
+
+// The comparator inputs, while enabled
+static esp_err_t claim_pins(const dpt_delay_config_t *cfg) {
+    int8_t pins[DPT_DELAY_INPUTS];
+    for (int in = 0; in < DPT_DELAY_INPUTS; in++) {
+        pins[in] = cfg->enabled ? cfg->gpio[in] : -1;
+    }
+    return dpt_pins_claim_set(DPT_PIN_DELAY, pins, DPT_DELAY_INPUTS);
+}
+
+esp_err_t dpt_delay_configure(const dpt_delay_config_t *cfg) {
+    esp_err_t err = claim_pins(cfg);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = backend_configure(cfg);
+    if (err != ESP_OK) {
+        claim_pins(&config);    // Back to the pins the old configuration holds
+    } else {
+        config = *cfg;
+        ESP_LOGI(TAG, "Delay capture %s: gate GPIO%d (%s at turn-on), Vds GPIO%d (%s at turn-on)",
+                 cfg->enabled ? "enabled" : "disabled",
+                 cfg->gpio[DPT_DELAY_GATE], cfg->on_rising[DPT_DELAY_GATE] ? "rises" : "falls",
+                 cfg->gpio[DPT_DELAY_VDS], cfg->on_rising[DPT_DELAY_VDS] ? "rises" : "falls");
+    }
+    return err;
+}
+
+void dpt_delay_get_config(dpt_delay_config_t *out) {
+    *out = config;
+}
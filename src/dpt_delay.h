@@ -0,0 +1,115 @@
+/**
+ * @file dpt_delay.h
+ * @brief DUT switching delays from comparator feedback edges
+ *
+ * Three MCPWM capture channels share one 80 MHz capture timer, so their
+ * timestamps are in RMT ticks on a common time base. Channel 0 watches
+ * the P output pad itself: its edges are the commanded edges as they
+ * leave the chip. The other two watch external comparators, one on the
+ * gate voltage (threshold crossing) and one on Vds.
+ *
+ * After each shot every commanded edge is paired with the first edge of
+ * the turn-on or turn-off polarity on each input before the next commanded
+ * edge. The difference is td(on) for a rising command and td(off) for a
+ * falling one. The last shot's delays are kept per edge; every delay
+ * also feeds running statistics (Welford) per input and direction, which
+ * accumulate across shots and sweeps until reset.
+ *
+ * Each capture is read by an interrupt. Two edges on one input closer
+ * together than the interrupt latency (about 1 us) overwrite each other;
+ * the commanded edge then goes unpaired and counts as missed.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "dpt_plan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    DPT_DELAY_GATE,             // Gate voltage comparator
+    DPT_DELAY_VDS,              // Drain-source voltage comparator
+    DPT_DELAY_INPUTS,
+} dpt_delay_input_t;
+
+#define DPT_DELAY_MAX_EDGES     16      // Commanded edges per shot kept for the last shot
+#define DPT_DELAY_EVENTS        64      // Captured edges per shot, all inputs
+#define DPT_DELAY_SETTLE_US     20      // Waited after the RMT ends for late comparator edges
+#define DPT_DELAY_NONE          (-1)    // No edge paired
+
+typedef struct {
+    bool enabled;
+    int8_t gpio[DPT_DELAY_INPUTS];      // -1 = input unused
+    bool on_rising[DPT_DELAY_INPUTS];   // Polarity of the edge that follows a turn-on
+} dpt_delay_config_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t min_ticks;
+    uint32_t max_ticks;
+    float mean_ticks;
+    float m2;                   // Sum of squared deviations from the mean
+} dpt_delay_stat_t;
+
+typedef struct {
+    uint8_t rising;             // Commanded edge: 1 = turn-on
+    uint32_t tick;              // From the first commanded edge
+    int32_t delay_ticks[DPT_DELAY_INPUTS];      // DPT_DELAY_NONE if unpaired
+} dpt_delay_edge_t;
+
+typedef struct {
+    uint32_t shots;             // Shots measured since the last reset
+    uint32_t missed;            // Commanded edges with no input edge paired
+    uint32_t overflows;         // Shots with more than DPT_DELAY_EVENTS captured edges
+    uint32_t plan_mismatches;   // Shots whose commanded edge count differs from the plan
+    dpt_delay_stat_t stat[DPT_DELAY_INPUTS][2];     // [input][0 = td(off), 1 = td(on)]
+    // Last shot
+    uint32_t last_plan_hash;
+    uint32_t last_plan_edges;
+    uint32_t last_num_edges;    // Commanded edges captured
+    dpt_delay_edge_t last[DPT_DELAY_MAX_EDGES];
+} dpt_delay_stats_t;
+
+/**
+ * @brief Enable or disable the capture channels and set the inputs
+ *
+ * @return ESP_ERR_INVALID_ARG for a pin that is not a free GPIO,
+ *         ESP_ERR_NOT_SUPPORTED without MCPWM
+ */
+esp_err_t dpt_delay_configure(const dpt_delay_config_t *cfg);
+
+void dpt_delay_get_config(dpt_delay_config_t *out);
+
+/**
+ * @brief Forget earlier edges; call with the RMT claimed, before it starts
+ */
+void dpt_delay_begin(void);
+
+/**
+ * @brief Pair the shot's edges and update the statistics
+ *
+ * Call once the RMT is done, still holding the claim, with the plan
+ * that was fired. Waits DPT_DELAY_SETTLE_US first.
+ */
+void dpt_delay_end(const dpt_plan_t *plan);
+
+void dpt_delay_get_stats(dpt_delay_stats_t *out);
+
+void dpt_delay_reset(void);
+
+/**
+ * @brief Record a captured edge at a capture timer count; input -1 is the P output
+ *
+ * What the capture interrupt calls. Also callable directly to check the
+ * pairing against synthetic edges.
+ */
+void dpt_delay_record(int input, bool rising, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,143 @@
+/**
+ * @file dpt_interlock.c
+ * @brief Bus-voltage interlock: hold shots until the DC link has recovered
+ *
+ * Tasks waiting together take frames from dpt_adc_wait_frame() in turn,
+ * so each sees only some of them; each still needs its own run of
+ * qualifying frames before its shot goes. The ADC task also judges every
+ * frame it reads for trigger ISRs, which cannot wait.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "dpt_adc.h"
+#include "dpt_interlock.h"
+
+#define TAG "DPT_INTERLOCK"
+
+#define FRAME_TIMEOUT_MS    20      // Far above one frame; the ADC has stalled if exceeded
+
+static dpt_interlock_config_t config = {
+    .vbus_min_v = 0.0f,
+    .vbus_max_v = 1000.0f,
+    .qualify_frames = 2,
+    .timeout_ms = 5000,
+};
+static dpt_interlock_stats_t stats;
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Frames judged by the ADC task for ISR shots
+static uint8_t isr_in_window = 0;               // ADC task only
+static volatile bool isr_restart = false;       // Window changed; count the run again
+static volatile bool bus_qualified = false;
+
+esp_err_t dpt_interlock_configure(const dpt_interlock_config_t *cfg) {
+    if (!(cfg->vbus_min_v < cfg->vbus_max_v) || cfg->qualify_frames < 1 || cfg->timeout_ms < 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (cfg->enabled && !dpt_adc_has(DPT_ADC_VBUS)) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    portENTER_CRITICAL(&stats_mux);
+    config = *cfg;
+    bus_qualified = false;
+    isr_restart = true;
+    portEXIT_CRITICAL(&stats_mux);
+    ESP_LOGI(TAG, "Bus interlock %s: %.1f-%.1f V for %u frame(s), timeout %" PRIu32 " ms",
+             cfg->enabled ? "enabled" : "disabled", cfg->vbus_min_v, cfg->vbus_max_v, cfg->qualify_frames,
+             cfg->timeout_ms);
+    return ESP_OK;
+}
+
+void dpt_interlock_get_config(dpt_interlock_config_t *out) {
+    portENTER_CRITICAL(&stats_mux);
+    *out = config;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+bool dpt_interlock_enabled(void) {
+    return config.enabled;
+}
+
+esp_err_t dpt_interlock_wait(dpt_interlock_wait_t *out) {
+    dpt_interlock_config_t cfg;
+    dpt_interlock_get_config(&cfg);
+    *out = (dpt_interlock_wait_t){ .result = ESP_OK };
+    if (!cfg.enabled) {
+        return ESP_OK;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    int64_t deadline_us = start_us + (int64_t)cfg.timeout_ms * 1000;
+    uint8_t in_window = 0;
+    uint32_t frames = 0;
+    esp_err_t err = ESP_ERR_TIMEOUT;
+    while (esp_timer_get_time() < deadline_us) {
+        float value[DPT_ADC_SIGNALS];
+        esp_err_t frame_err = dpt_adc_wait_frame(FRAME_TIMEOUT_MS, value);
+        if (frame_err == ESP_ERR_INVALID_STATE) {
+            err = frame_err;
+            break;
+        }
+        if (frame_err != ESP_OK) {
+            continue;
+        }
+        frames++;
+        out->vbus_v = value[DPT_ADC_VBUS];
+        in_window = (out->vbus_v >= cfg.vbus_min_v && out->vbus_v <= cfg.vbus_max_v) ? in_window + 1 : 0;
+        if (in_window >= cfg.qualify_frames) {
+            err = ESP_OK;
+            break;
+        }
+    }
+    out->wait_us = (uint32_t)(esp_timer_get_time() - start_us);
+    out->result = err;
+
+    portENTER_CRITICAL(&stats_mux);
+    stats.waits++;
+    stats.held += frames > cfg.qualify_frames ? 1 : 0;
+    stats.timeouts += err == ESP_ERR_TIMEOUT ? 1 : 0;
+    stats.wait_us_total += out->wait_us;
+    if (out->wait_us > stats.wait_us_max) stats.wait_us_max = out->wait_us;
+    stats.last = *out;
+    portEXIT_CRITICAL(&stats_mux);
+
+    if (err == ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "ADC capture stopped; shot refused");
+    } else if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Bus at %.1f V, outside %.1f-%.1f V for %" PRIu32 " ms; shot refused", out->vbus_v,
+                 cfg.vbus_min_v, cfg.vbus_max_v, out->wait_us / 1000);
+    }
+    return err;
+}
+
+void dpt_interlock_frame(bool valid, float vbus_v) {
+    if (isr_restart) {
+        isr_restart = false;
+        isr_in_window = 0;
+    }
+    dpt_interlock_config_t cfg;
+    dpt_interlock_get_config(&cfg);
+    bool in = valid && vbus_v >= cfg.vbus_min_v && vbus_v <= cfg.vbus_max_v;
+    isr_in_window = in ? (isr_in_window < UINT8_MAX ? isr_in_window + 1 : UINT8_MAX) : 0;
+    bus_qualified = isr_in_window >= cfg.qualify_frames;
+}
+
+bool IRAM_ATTR dpt_interlock_isr_allows(void) {
+    return !config.enabled || bus_qualified;
+}
+
+void dpt_interlock_get_stats(dpt_interlock_stats_t *out) {
+    portENTER_CRITICAL(&stats_mux);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+void dpt_interlock_reset(void) {
+    portENTER_CRITICAL(&stats_mux);
+    memset(&stats, 0, sizeof(stats));
+    portEXIT_CRITICAL(&stats_mux);
+}
@@ -0,0 +1,95 @@
+/**
+ * @file dpt_interlock.h
+ * @brief Bus-voltage interlock: hold shots until the DC link has recovered
+ *
+ * Each shot draws its energy from the DC-link capacitors, and the supply
+ * recharges them through its own current limit. Instead of a fixed delay
+ * before every shot, the interlock watches the bus voltage on the ADC
+ * (src/dpt_adc.h) and lets the shot go as soon as qualify_frames frames in
+ * a row average within [vbus_min_v, vbus_max_v]. One frame is about
+ * 0.8 ms, which is the granularity of the wait. If the bus does not come
+ * into the window within timeout_ms the shot is refused.
+ *
+ * /trigger, the button, sweeps and targeting runs wait here. Trigger
+ * inputs fire their presets from the interrupt and cannot wait; the ADC
+ * task keeps a flag of whether the latest frames qualify, and the ISR
+ * refuses the shot while it is clear.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    bool enabled;
+    float vbus_min_v;
+    float vbus_max_v;
+    uint8_t qualify_frames;     // Consecutive frames inside the window
+    uint32_t timeout_ms;
+} dpt_interlock_config_t;
+
+typedef struct {
+    esp_err_t result;           // ESP_OK if the shot may fire
+    uint32_t wait_us;
+    float vbus_v;               // Mean of the last frame looked at
+} dpt_interlock_wait_t;
+
+typedef struct {
+    uint32_t waits;
+    uint32_t held;              // Waits that found the bus outside the window
+    uint32_t timeouts;
+    uint64_t wait_us_total;
+    uint32_t wait_us_max;
+    dpt_interlock_wait_t last;
+} dpt_interlock_stats_t;
+
+/**
+ * @brief Set the window; enabling needs a bus voltage input on the ADC
+ *
+ * @return ESP_ERR_INVALID_ARG for an empty window,
+ *         ESP_ERR_NOT_SUPPORTED without a bus voltage input
+ */
+esp_err_t dpt_interlock_configure(const dpt_interlock_config_t *cfg);
+
+void dpt_interlock_get_config(dpt_interlock_config_t *out);
+
+bool dpt_interlock_enabled(void);
+
+/**
+ * @brief Block until the bus voltage qualifies; call before claiming the RMT
+ *
+ * Returns at once with ESP_OK while the interlock is disabled.
+ *
+ * @return ESP_ERR_TIMEOUT if the bus stayed out of the window,
+ *         ESP_ERR_INVALID_STATE if the ADC stopped capturing
+ */
+esp_err_t dpt_interlock_wait(dpt_interlock_wait_t *out);
+
+/**
+ * @brief Judge one ADC frame for dpt_interlock_isr_allows(); ADC task only
+ *
+ * valid is false when no frame was read, which clears the flag.
+ */
+void dpt_interlock_frame(bool valid, float vbus_v);
+
+/**
+ * @brief true if a shot may fire from an ISR now: the interlock is
+ * disabled, or the last qualify_frames frames were inside the window
+ *
+ * IRAM-safe; reads one flag the ADC task updates per frame.
+ */
+bool dpt_interlock_isr_allows(void);
+
+void dpt_interlock_get_stats(dpt_interlock_stats_t *out);
+
+void dpt_interlock_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
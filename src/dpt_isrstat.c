@@ -0,0 +1,129 @@
+/**
+ * @file dpt_isrstat.c
+ * @brief Per-interrupt cycle accounting on both cores
+ *
+ * Each core has its own Xtensa interrupt handler table. An IPC call runs
+ * the install step on each core, which swaps every live entry for a
+ * wrapper that calls the original handler between two cycle counter reads
+ * and records its entry and exit in the shot trace.
+ * Which peripheral sources feed a CPU interrupt is read back from the
+ * interrupt matrix when the stats are reported.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "dpt_isrstat.h"
+#include "dpt_trace.h"
+
+#if defined(__XTENSA__)
+#include "esp_cpu.h"
+#include "esp_ipc.h"
+#include "xtensa_api.h"
+#include "soc/soc.h"
+#include "soc/interrupts.h"
+#endif
+
+#define TAG "DPT_ISRSTAT"
+
+typedef struct {
+    void (*handler)(void *);
+    void *arg;
+    uint32_t trace_id;      // DPT_TRACE_ISR_CPU_INT + CPU interrupt number
+    volatile uint32_t count;
+    volatile uint32_t cycles;
+} isr_slot_t;
+
+static isr_slot_t slots[DPT_ISRSTAT_CORES][DPT_ISRSTAT_CPU_INTS];
+
+#if defined(__XTENSA__)
+
+static const uint32_t matrix_base[DPT_ISRSTAT_CORES] = { DR_REG_INTERRUPT_CORE0_BASE, DR_REG_INTERRUPT_CORE1_BASE };
+
+static void IRAM_ATTR isr_wrapper(void *arg) {
+    isr_slot_t *slot = arg;
+    dpt_trace_isr_enter(slot->trace_id);
+    uint32_t start = esp_cpu_get_cycle_count();
+    slot->handler(slot->arg);
+    slot->cycles += esp_cpu_get_cycle_count() - start;
+    slot->count++;
+    dpt_trace_isr_exit();
+}
+
+// Runs on the core whose table it patches (esp_ipc_call_blocking)
+static void install_on_core(void *arg) {
+    int core = xPortGetCoreID();
+    int *wrapped = arg;
+    static portMUX_TYPE install_mux = portMUX_INITIALIZER_UNLOCKED;
+
+    for (int n = 0; n < DPT_ISRSTAT_CPU_INTS; n++) {
+        isr_slot_t *slot = &slots[core][n];
+        // Handler and argument are two stores; keep this core's interrupts off between them
+        portENTER_CRITICAL(&install_mux);
+        void *old_arg = xt_get_interrupt_handler_arg(n);
+        xt_handler old = xt_set_interrupt_handler(n, isr_wrapper, slot);
+        if (old == NULL) {
+            xt_set_interrupt_handler(n, NULL, NULL);        // Unused; put the default back
+        } else if (old == isr_wrapper) {
+            xt_set_interrupt_handler(n, isr_wrapper, old_arg);  // Already wrapped
+        } else {
+            slot->handler = old;
+            slot->arg = old_arg;
+            slot->trace_id = DPT_TRACE_ISR_CPU_INT + n;
+            (*wrapped)++;
+        }
+        portEXIT_CRITICAL(&install_mux);
+    }
+}
+
+esp_err_t dpt_isrstat_init(void) {
+    for (int core = 0; core < DPT_ISRSTAT_CORES; core++) {
+        int wrapped = 0;
+        esp_err_t err = (core == xPortGetCoreID()) ? (install_on_core(&wrapped), ESP_OK)
+                                                   : esp_ipc_call_blocking(core, install_on_core, &wrapped);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Cannot reach core %d: %s", core, esp_err_to_name(err));
+            return err;
+        }
+        ESP_LOGI(TAG, "Core %d: counting %d interrupt handler(s)", core, wrapped);
+    }
+    return ESP_OK;
+}
+
+int dpt_isrstat_sources(int core, int cpu_int, char *buf, size_t size) {
+    int len = 0;
+    buf[0] = '\0';
+    for (int src = 0; src < ETS_MAX_INTR_SOURCE; src++) {
+        if ((REG_READ(matrix_base[core] + 4 * src) & 0x1F) != (uint32_t)cpu_int) {
+            continue;
+        }
+        len += snprintf(buf + len, len < (int)size ? size - len : 0, "%s%s", len ? "," : "", esp_isr_names[src]);
+    }
+    if (len == 0) {
+        len = snprintf(buf, size, "cpu_int %d", cpu_int);
+    }
+    return len;
+}
+
+#else
+
+esp_err_t dpt_isrstat_init(void) {
+    ESP_LOGI(TAG, "Interrupt accounting needs the Xtensa handler table; counters stay at zero");
+    return ESP_OK;
+}
+
+int dpt_isrstat_sources(int core, int cpu_int, char *buf, size_t size) {
+    return snprintf(buf, size, "cpu_int %d", cpu_int);
+}
+
+#endif
+
+void dpt_isrstat_snapshot(dpt_isrstat_snapshot_t *out) {
+    for (int core = 0; core < DPT_ISRSTAT_CORES; core++) {
+        for (int n = 0; n < DPT_ISRSTAT_CPU_INTS; n++) {
+            out->count[core][n] = slots[core][n].count;
+            out->cycles[core][n] = slots[core][n].cycles;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+/**
+ * @file dpt_isrstat.h
+ * @brief Per-interrupt cycle accounting on both cores
+ *
+ * Every CPU interrupt that has a handler when dpt_isrstat_init() runs is
+ * wrapped with a counter of calls and CPU cycles spent in it, and its
+ * entry and exit go into the shot trace (dpt_trace). Counters only
+ * increase; callers take snapshots and subtract. Cycles of a nested
+ * higher-priority interrupt are counted in both handlers.
+ *
+ * On targets other than Xtensa (the host emulator) nothing is wrapped and
+ * all counters stay zero.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DPT_ISRSTAT_CORES       2
+#define DPT_ISRSTAT_CPU_INTS    32
+
+typedef struct {
+    uint32_t count[DPT_ISRSTAT_CORES][DPT_ISRSTAT_CPU_INTS];
+    uint32_t cycles[DPT_ISRSTAT_CORES][DPT_ISRSTAT_CPU_INTS];
+} dpt_isrstat_snapshot_t;
+
+/**
+ * @brief Wrap the interrupt handlers installed so far on both cores
+ *
+ * Call after all drivers have allocated their interrupts. Calling it again
+ * wraps handlers that were installed since.
+ */
+esp_err_t dpt_isrstat_init(void);
+
+/**
+ * @brief Copy the running counters
+ */
+void dpt_isrstat_snapshot(dpt_isrstat_snapshot_t *out);
+
+/**
+ * @brief Names of the peripheral sources routed to a CPU interrupt
+ *
+ * Comma-separated, e.g. "WIFI_MAC" or "GPIO,RMT" for a shared line, or
+ * "cpu_int N" for an interrupt with no peripheral source (internal timer,
+ * software). Returns the length written, like snprintf.
+ */
+int dpt_isrstat_sources(int core, int cpu_int, char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
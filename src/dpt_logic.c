@@ -0,0 +1,560 @@
+/**
+ * @file dpt_logic.c
+ * @brief Logic analyzer on the gate outputs and up to six auxiliary inputs
+ *
+ * The store is written by one party at a time: the encoder task during a
+ * capture, or dpt_logic_store_*() called directly. store_mutex is held
+ * from dpt_logic_arm() to the end of dpt_logic_finish() and by every
+ * reader, so a shot never waits for a download - it goes uncaptured.
+ */
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "soc/soc_caps.h"
+#include "dpt_logic.h"
+#include "dpt_pins.h"
+#include "dpt_rmt.h"
+
+#if SOC_LCDCAM_SUPPORTED
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "driver/gpio.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_gpio.h"
+#include "esp_rom_sys.h"
+#include "esp_private/gdma.h"
+#include "esp_private/periph_ctrl.h"
+#include "hal/dma_types.h"
+#include "soc/gpio_sig_map.h"
+#include "soc/lcd_cam_struct.h"
+#endif
+
+#define TAG "DPT_LOGIC"
+
+static dpt_logic_config_t config = {
+    .rate_mhz = DPT_LOGIC_DEFAULT_MHZ,
+    .aux_gpio = { -1, -1, -1, -1, -1, -1 },
+};
+static SemaphoreHandle_t store_mutex = NULL;
+static bool capturing = false;      // Between arm and finish, under store_mutex
+
+static uint8_t store[DPT_LOGIC_STORE_SIZE];
+static size_t store_len = 0;
+static dpt_logic_summary_t summary;
+static uint8_t cur_value;           // Sample value since the last change
+static uint32_t last_change;        // Sample index of the last change
+
+// ---------------------- Store ----------------------
+void dpt_logic_store_begin(uint32_t rate_hz) {
+    uint32_t skipped = summary.skipped;
+    memset(&summary, 0, sizeof(summary));
+    summary.skipped = skipped;
+    summary.rate_hz = rate_hz;
+    memcpy(summary.aux_gpio, config.aux_gpio, sizeof(summary.aux_gpio));
+    store_len = 0;
+    last_change = 0;
+}
+
+static void put_change(uint32_t delta, uint8_t value) {
+    if (summary.truncated) {
+        return;     // A later, shorter record would fit but put its change at the wrong time
+    }
+    uint8_t rec[6];
+    size_t n = 0;
+    do {
+        rec[n] = delta & 0x7F;
+        delta >>= 7;
+        rec[n++] |= delta ? 0x80 : 0;
+    } while (delta);
+    rec[n++] = value;
+    if (store_len + n > sizeof(store)) {
+        summary.truncated = true;
+        return;
+    }
+    memcpy(store + store_len, rec, n);
+    store_len += n;
+    summary.changes++;
+}
+
+void dpt_logic_store_feed(const uint8_t *samples, size_t n) {
+    size_t i = 0;
+    if (n > 0 && summary.samples == 0) {
+        summary.first_value = cur_value = samples[0];
+    }
+    uint32_t same = cur_value * 0x01010101u;
+    while (i < n) {
+        // Skip runs of the current value four samples at a time
+        uint32_t word;
+        if (((uintptr_t)(samples + i) & 3) == 0 && i + 4 <= n &&
+            (memcpy(&word, samples + i, 4), word == same)) {
+            i += 4;
+            continue;
+        }
+        if (samples[i] != cur_value) {
+            uint32_t index = summary.samples + i;
+            put_change(index - last_change, samples[i]);
+            last_change = index;
+            cur_value = samples[i];
+            same = cur_value * 0x01010101u;
+        }
+        i++;
+    }
+    summary.samples += n;
+}
+
+void dpt_logic_store_end(void) {
+    summary.stored_bytes = store_len;
+    summary.valid = true;
+}
+
+typedef struct {
+    size_t pos;
+    uint32_t sample;
+    uint8_t value;
+} cursor_t;
+
+static void cursor_init(cursor_t *c) {
+    c->pos = 0;
+    c->sample = 0;
+    c->value = summary.first_value;
+}
+
+static bool cursor_next(cursor_t *c) {
+    uint32_t delta = 0;
+    int shift = 0;
+    uint8_t b;
+    do {
+        if (c->pos >= store_len) {
+            return false;
+        }
+        b = store[c->pos++];
+        delta |= (uint32_t)(b & 0x7F) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    if (c->pos >= store_len) {
+        return false;
+    }
+    c->sample += delta;
+    c->value = store[c->pos++];
+    return true;
+}
+
+static int64_t sample_ns(uint32_t sample) {
+    return (int64_t)sample * 1000000000 / summary.rate_hz;
+}
+
+// ---------------------- Comparison ----------------------
+void dpt_logic_compare(const dpt_plan_t *plan) {
+    // Sampling and the RMT tick each quantise an edge by up to one period
+    summary.tolerance_ns = (1000000000 + summary.rate_hz - 1) / summary.rate_hz + 13;
+    summary.match = true;
+
+    // The first P edge anchors both channels, so P/N skew shows as N error
+    bool anchored = false;
+    int64_t anchor = 0;
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        dpt_logic_channel_t *res = &summary.ch[ch];
+        memset(res, 0, sizeof(*res));
+        res->plan_edges = dpt_plan_count_edges(plan, ch);
+
+        dpt_edge_iter_t it;
+        dpt_edge_iter_init(&it, plan, ch);
+        uint32_t tick;
+        uint8_t level;
+        bool planned = dpt_edge_iter_next(&it, &tick, &level);
+        bool levels_ok = true;
+
+        cursor_t c;
+        cursor_init(&c);
+        uint8_t prev = c.value;
+        while (cursor_next(&c)) {
+            bool edge = ((c.value ^ prev) >> ch) & 1;
+            prev = c.value;
+            if (!edge) {
+                continue;
+            }
+            uint32_t k = res->captured_edges++;
+            if (!planned) {
+                continue;
+            }
+            int64_t plan_ns = (int64_t)tick * 125 / 10;
+            if (!anchored) {
+                anchor = sample_ns(c.sample) - plan_ns;
+                summary.start_ns = anchor > 0 ? (uint32_t)anchor : 0;
+                anchored = true;
+            }
+            int64_t error = sample_ns(c.sample) - anchor - plan_ns;
+            if (error < 0) error = -error;
+            if (error > res->max_error_ns) {
+                res->max_error_ns = error > INT32_MAX ? INT32_MAX : (int32_t)error;
+                res->worst_edge = k;
+            }
+            if (((c.value >> ch) & 1) != level) {
+                levels_ok = false;
+            }
+            planned = dpt_edge_iter_next(&it, &tick, &level);
+        }
+        res->match = levels_ok && res->captured_edges == res->plan_edges &&
+                     (uint32_t)res->max_error_ns <= summary.tolerance_ns;
+        summary.match &= res->match;
+    }
+    summary.plan_hash = plan->hash;
+    summary.compared = true;
+}
+
+// ---------------------- VCD Export ----------------------
+typedef struct {
+    esp_err_t (*write)(void *ctx, const void *data, size_t len);
+    void *ctx;
+    char buf[512];
+    int len;
+    esp_err_t err;
+} vcd_out_t;
+
+static void vcd_flush(vcd_out_t *out) {
+    if (out->len > 0 && out->err == ESP_OK) {
+        out->err = out->write(out->ctx, out->buf, out->len);
+    }
+    out->len = 0;
+}
+
+static void vcd_printf(vcd_out_t *out, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void vcd_printf(vcd_out_t *out, const char *fmt, ...) {
+    if (out->len > (int)sizeof(out->buf) - 80) {
+        vcd_flush(out);
+    }
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(out->buf + out->len, sizeof(out->buf) - out->len, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        out->len += n < (int)sizeof(out->buf) - out->len ? n : (int)sizeof(out->buf) - out->len - 1;
+    }
+}
+
+// Bits that carry a signal: P, N and the routed auxiliary inputs
+static uint8_t vcd_bits(void) {
+    uint8_t bits = 0x03;
+    for (int i = 0; i < DPT_LOGIC_MAX_AUX; i++) {
+        if (summary.aux_gpio[i] >= 0) bits |= 1 << (i + 2);
+    }
+    return bits;
+}
+
+esp_err_t dpt_logic_export_vcd(esp_err_t (*write)(void *ctx, const void *data, size_t len), void *ctx) {
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    if (!summary.valid) {
+        xSemaphoreGive(store_mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+    static vcd_out_t out;   // Downloads run one at a time, in the web server task
+    out.write = write;
+    out.ctx = ctx;
+    out.len = 0;
+    out.err = ESP_OK;
+
+    uint8_t bits = vcd_bits();
+    vcd_printf(&out, "$version DPT logic analyzer $end\n$comment shot %" PRIu32 " plan 0x%08" PRIx32
+               " %" PRIu32 " Hz%s $end\n$timescale 1ns $end\n$scope module dpt $end\n",
+               summary.shot, summary.plan_hash, summary.rate_hz, summary.truncated ? " truncated" : "");
+    vcd_printf(&out, "$var wire 1 ! p_gpio%d $end\n$var wire 1 \" n_gpio%d $end\n", 7, 8);
+    for (int i = 0; i < DPT_LOGIC_MAX_AUX; i++) {
+        if (bits & (1 << (i + 2))) {
+            vcd_printf(&out, "$var wire 1 %c aux%d_gpio%d $end\n", '!' + i + 2, i, summary.aux_gpio[i]);
+        }
+    }
+    vcd_printf(&out, "$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n");
+    for (int b = 0; b < DPT_LOGIC_BITS; b++) {
+        if (bits & (1 << b)) vcd_printf(&out, "%d%c\n", (summary.first_value >> b) & 1, '!' + b);
+    }
+    vcd_printf(&out, "$end\n");
+
+    cursor_t c;
+    cursor_init(&c);
+    uint8_t prev = c.value;
+    while (cursor_next(&c) && out.err == ESP_OK) {
+        uint8_t changed = (c.value ^ prev) & bits;
+        prev = c.value;
+        if (!changed) {
+            continue;
+        }
+        vcd_printf(&out, "#%" PRId64 "\n", sample_ns(c.sample));
+        for (int b = 0; b < DPT_LOGIC_BITS; b++) {
+            if (changed & (1 << b)) vcd_printf(&out, "%d%c\n", (c.value >> b) & 1, '!' + b);
+        }
+    }
+    vcd_printf(&out, "#%" PRId64 "\n", sample_ns(summary.samples));
+    vcd_flush(&out);
+    xSemaphoreGive(store_mutex);
+    return out.err;
+}
+
+// ---------------------- Capture ----------------------
+#if SOC_LCDCAM_SUPPORTED
+
+#define RING_BUFFERS        8
+#define RING_BUFFER_SIZE    2048        // 102 us at 20 MHz; DPT_LOGIC_POST_US covers one at 10 MHz
+#define RING_STOP           0xFFFFFFFFu // Queued by dpt_logic_finish() behind the last buffer
+#define CAM_CLK_PLL_F160M   3           // cam_clk_sel
+
+#ifndef GPIO_MATRIX_CONST_ONE_INPUT
+#define GPIO_MATRIX_CONST_ONE_INPUT     0x38
+#define GPIO_MATRIX_CONST_ZERO_INPUT    0x3C
+#endif
+
+static uint8_t *ring_buf = NULL;
+static dma_descriptor_t *ring_desc = NULL;
+static gdma_channel_handle_t rx_chan = NULL;
+static QueueHandle_t filled = NULL;         // Index of each buffer GDMA has finished
+static SemaphoreHandle_t drained = NULL;
+static volatile bool ring_stopped;
+static volatile uint32_t ring_overruns;
+
+static bool IRAM_ATTR on_recv_eof(gdma_channel_handle_t chan, gdma_event_data_t *ev, void *arg) {
+    if (ring_stopped) {
+        return false;
+    }
+    uint32_t index = (dma_descriptor_t *)ev->rx_eof_desc_addr - ring_desc;
+    BaseType_t woken = pdFALSE;
+    // The queue holds two fewer than the ring: one buffer is being filled,
+    // one encoded. Full means GDMA is about to overwrite an unread buffer.
+    if (xQueueSendFromISR(filled, &index, &woken) != pdTRUE) {
+        ring_overruns++;
+        ring_stopped = true;
+    }
+    return woken == pdTRUE;
+}
+
+static void encode_task(void *arg) {
+    uint32_t index;
+    while (1) {
+        xQueueReceive(filled, &index, portMAX_DELAY);
+        if (index == RING_STOP) {
+            xSemaphoreGive(drained);
+        } else {
+            dpt_logic_store_feed(ring_buf + index * RING_BUFFER_SIZE, RING_BUFFER_SIZE);
+        }
+    }
+}
+
+static esp_err_t ring_alloc(void) {
+    ring_buf = heap_caps_malloc(RING_BUFFERS * RING_BUFFER_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    ring_desc = heap_caps_calloc(RING_BUFFERS, sizeof(dma_descriptor_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    filled = filled ? filled : xQueueCreate(RING_BUFFERS - 2, sizeof(uint32_t));
+    drained = drained ? drained : xSemaphoreCreateBinary();
+    if (!ring_buf || !ring_desc || !filled || !drained) {
+        ESP_LOGE(TAG, "No memory for the %d byte capture ring", RING_BUFFERS * RING_BUFFER_SIZE);
+        // The next enable tries again; ring_buf stays NULL until the whole ring exists
+        heap_caps_free(ring_buf);
+        heap_caps_free(ring_desc);
+        ring_buf = NULL;
+        ring_desc = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < RING_BUFFERS; i++) {
+        ring_desc[i].dw0.size = RING_BUFFER_SIZE;
+        ring_desc[i].dw0.length = 0;
+        ring_desc[i].dw0.owner = DMA_DESCRIPTOR_BUFFER_OWNER_DMA;
+        ring_desc[i].buffer = ring_buf + i * RING_BUFFER_SIZE;
+        ring_desc[i].next = &ring_desc[(i + 1) % RING_BUFFERS];
+    }
+
+    gdma_channel_alloc_config_t chan_cfg = { .direction = GDMA_CHANNEL_DIRECTION_RX };
+    gdma_rx_event_callbacks_t cbs = { .on_recv_eof = on_recv_eof };
+    // The ring goes round without the CPU handing buffers back
+    gdma_strategy_config_t strategy = { .owner_check = false, .auto_update_desc = false };
+    esp_err_t err = gdma_new_ahb_channel(&chan_cfg, &rx_chan);
+    if (err == ESP_OK) err = gdma_connect(rx_chan, GDMA_MAKE_TRIGGER(GDMA_TRIG_PERIPH_CAM, 0));
+    if (err == ESP_OK) err = gdma_apply_strategy(rx_chan, &strategy);
+    if (err == ESP_OK) err = gdma_register_rx_event_callbacks(rx_chan, &cbs, NULL);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "GDMA channel setup failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    periph_module_enable(PERIPH_LCD_CAM_MODULE);
+    xTaskCreate(encode_task, "logic_encode", 3072, NULL, 11, NULL);
+    return ESP_OK;
+}
+
+// Camera mode with VSYNC, HSYNC and DE tied high: every PCLK is a sample
+static void cam_setup(const dpt_logic_config_t *cfg) {
+    LCD_CAM.cam_ctrl.val = 0;
+    LCD_CAM.cam_ctrl.cam_clk_sel = CAM_CLK_PLL_F160M;
+    LCD_CAM.cam_ctrl.cam_clkm_div_num = 160 / cfg->rate_mhz;
+    LCD_CAM.cam_ctrl.cam_clkm_div_a = 0;
+    LCD_CAM.cam_ctrl.cam_clkm_div_b = 0;
+    LCD_CAM.cam_ctrl.cam_vs_eof_en = 0;     // EOF every cam_rec_data_bytelen + 1 bytes instead
+    LCD_CAM.cam_ctrl1.val = 0;
+    LCD_CAM.cam_ctrl1.cam_rec_data_bytelen = RING_BUFFER_SIZE - 1;
+    LCD_CAM.cam_ctrl1.cam_vh_de_mode_en = 1;
+    LCD_CAM.cam_rgb_yuv.val = 0;
+    LCD_CAM.cam_ctrl.cam_update = 1;
+
+    // The sample clock goes out on a spare pad and comes back as PCLK
+    esp_rom_gpio_pad_select_gpio(DPT_LOGIC_PCLK_GPIO);
+    gpio_set_direction(DPT_LOGIC_PCLK_GPIO, GPIO_MODE_INPUT_OUTPUT);
+    esp_rom_gpio_connect_out_signal(DPT_LOGIC_PCLK_GPIO, CAM_CLK_IDX, false, false);
+    esp_rom_gpio_connect_in_signal(DPT_LOGIC_PCLK_GPIO, CAM_PCLK_IDX, false);
+    esp_rom_gpio_connect_in_signal(GPIO_MATRIX_CONST_ONE_INPUT, CAM_V_SYNC_IDX, false);
+    esp_rom_gpio_connect_in_signal(GPIO_MATRIX_CONST_ONE_INPUT, CAM_H_SYNC_IDX, false);
+    esp_rom_gpio_connect_in_signal(GPIO_MATRIX_CONST_ONE_INPUT, CAM_H_ENABLE_IDX, false);
+
+    // The output pads already have their input enabled (see dpt_rmt.c)
+    esp_rom_gpio_connect_in_signal(RMT_TX_GPIO_P, CAM_DATA_IN0_IDX, false);
+    esp_rom_gpio_connect_in_signal(RMT_TX_GPIO_N, CAM_DATA_IN1_IDX, false);
+    for (int i = 0; i < DPT_LOGIC_MAX_AUX; i++) {
+        int gpio = cfg->enabled ? cfg->aux_gpio[i] : -1;     // Disabled, the pins are not ours
+        if (gpio >= 0) {
+            gpio_set_direction(gpio, GPIO_MODE_INPUT);
+        }
+        esp_rom_gpio_connect_in_signal(gpio >= 0 ? gpio : GPIO_MATRIX_CONST_ZERO_INPUT, CAM_DATA_IN2_IDX + i, false);
+    }
+}
+
+static esp_err_t backend_configure(const dpt_logic_config_t *cfg) {
+    if (cfg->enabled && ring_buf == NULL) {
+        esp_err_t err = ring_alloc();
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (ring_buf != NULL) {
+        cam_setup(cfg);
+    }
+    return ESP_OK;
+}
+
+static void backend_start(void) {
+    ring_stopped = false;
+    ring_overruns = 0;
+    xQueueReset(filled);
+    LCD_CAM.cam_ctrl1.cam_start = 0;
+    LCD_CAM.cam_ctrl1.cam_reset = 1;
+    LCD_CAM.cam_ctrl1.cam_reset = 0;
+    LCD_CAM.cam_ctrl1.cam_afifo_reset = 1;
+    LCD_CAM.cam_ctrl1.cam_afifo_reset = 0;
+    gdma_reset(rx_chan);
+    gdma_start(rx_chan, (intptr_t)&ring_desc[0]);
+    LCD_CAM.cam_ctrl.cam_update = 1;
+    LCD_CAM.cam_ctrl1.cam_start = 1;
+}
+
+// The buffer in progress at the stop is dropped: it holds only the tail
+// of DPT_LOGIC_POST_US, which is at least one whole buffer long
+static void backend_stop(void) {
+    esp_rom_delay_us(DPT_LOGIC_POST_US);
+    LCD_CAM.cam_ctrl1.cam_start = 0;
+    gdma_stop(rx_chan);
+    ring_stopped = true;
+    uint32_t stop = RING_STOP;
+    xQueueSend(filled, &stop, portMAX_DELAY);
+    xSemaphoreTake(drained, portMAX_DELAY);
+    summary.overruns = ring_overruns;
+    if (ring_overruns) {
+        summary.truncated = true;
+        ESP_LOGW(TAG, "Encoding fell behind at %u MHz; capture cut short", config.rate_mhz);
+    }
+}
+
+#else
+
+static esp_err_t backend_configure(const dpt_logic_config_t *cfg) {
+    return cfg->enabled ? ESP_ERR_NOT_SUPPORTED : ESP_OK;
+}
+
+static void backend_start(void) {
+}
+
+static void backend_stop(void) {
+}
+
+#endif
+
+// ---------------------- Control ----------------------
+// The sample clock pad always, the auxiliary inputs while enabled
+static esp_err_t claim_pins(const dpt_logic_config_t *cfg) {
+    int8_t pins[1 + DPT_LOGIC_MAX_AUX] = { DPT_LOGIC_PCLK_GPIO };
+    for (int i = 0; i < DPT_LOGIC_MAX_AUX; i++) {
+        pins[1 + i] = cfg->enabled ? cfg->aux_gpio[i] : -1;
+    }
+    return dpt_pins_claim_set(DPT_PIN_LOGIC, pins, 1 + DPT_LOGIC_MAX_AUX);
+}
+
+void dpt_logic_init(void) {
+    store_mutex = xSemaphoreCreateMutex();
+    claim_pins(&config);
+#if !SOC_LCDCAM_SUPPORTED
+    ESP_LOGI(TAG, "No LCD_CAM on this target; logic captures cannot be taken");
+#endif
+}
+
+esp_err_t dpt_logic_configure(const dpt_logic_config_t *cfg) {
+    if (cfg->rate_mhz != 10 && cfg->rate_mhz != 20 && cfg->rate_mhz != 40) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    esp_err_t err = claim_pins(cfg);
+    if (err == ESP_OK) {
+        err = backend_configure(cfg);
+        if (err != ESP_OK) {
+            claim_pins(&config);    // Back to the pins the old configuration holds
+        }
+    }
+    if (err == ESP_OK) {
+        config = *cfg;
+    }
+    xSemaphoreGive(store_mutex);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Logic analyzer %s at %u MHz", cfg->enabled ? "enabled" : "disabled", cfg->rate_mhz);
+    }
+    return err;
+}
+
+void dpt_logic_get_config(dpt_logic_config_t *out) {
+    *out = config;
+}
+
+void dpt_logic_arm(void) {
+    if (!config.enabled) {
+        return;
+    }
+    if (xSemaphoreTake(store_mutex, 0) != pdTRUE) {
+        summary.skipped++;      // Read again once the reader is done; a lost count is harmless
+        return;
+    }
+    capturing = true;
+    dpt_logic_store_begin(config.rate_mhz * 1000000u);
+    backend_start();
+}
+
+void dpt_logic_finish(const dpt_plan_t *plan, uint32_t shot) {
+    if (!capturing) {
+        return;
+    }
+    backend_stop();
+    dpt_logic_store_end();
+    summary.shot = shot;
+    dpt_logic_compare(plan);
+    capturing = false;
+    xSemaphoreGive(store_mutex);
+
+    ESP_LOGI(TAG, "Shot %" PRIu32 ": %" PRIu32 " samples, %" PRIu32 " changes in %" PRIu32 " bytes; edges P %" PRIu32
+             "/%" PRIu32 " N %" PRIu32 "/%" PRIu32 ", worst %" PRId32 "/%" PRId32 " ns: %s",
+             shot, summary.samples, summary.changes, summary.stored_bytes,
+             summary.ch[DPT_CHANNEL_P].captured_edges, summary.ch[DPT_CHANNEL_P].plan_edges,
+             summary.ch[DPT_CHANNEL_N].captured_edges, summary.ch[DPT_CHANNEL_N].plan_edges,
+             summary.ch[DPT_CHANNEL_P].max_error_ns, summary.ch[DPT_CHANNEL_N].max_error_ns,
+             summary.match ? "matches the plan" : "DIFFERS from the plan");
+}
+
+void dpt_logic_get_summary(dpt_logic_summary_t *out) {
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    *out = summary;
+    xSemaphoreGive(store_mutex);
+}
@@ -0,0 +1,134 @@
+/**
+ * @file dpt_logic.h
+ * @brief Logic analyzer on the gate outputs and up to six auxiliary inputs
+ *
+ * The LCD_CAM peripheral in camera mode samples eight GPIOs in parallel
+ * on its own clock and GDMA writes the bytes into a ring of buffers.
+ * Bit 0 is GPIO 7 (P), bit 1 is GPIO 8 (N), bits 2-7 are the auxiliary
+ * inputs. Armed with each shot fired from the web server or the button,
+ * it runs from just before the RMT starts until shortly after it ends.
+ *
+ * A task delta-encodes each filled buffer as it arrives: a capture is
+ * stored as the level changes only, each one the number of samples since
+ * the previous change (LEB128) followed by the new sample byte. Idle
+ * stretches cost nothing, so a 10 ms shot fits as easily as a 10 us one.
+ * The capture can be exported as VCD and its P/N edges are checked against
+ * the plan that was fired.
+ *
+ * Targets without LCD_CAM (the host emulator) cannot capture; the store,
+ * VCD export and comparison still work on samples fed in by hand.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "dpt_plan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DPT_LOGIC_BITS          8
+#define DPT_LOGIC_MAX_AUX       6           // Bits 2-7
+#define DPT_LOGIC_PCLK_GPIO     21          // Unconnected pad; the sample clock loops through it
+#define DPT_LOGIC_STORE_SIZE    16384       // Delta-encoded bytes per capture
+#define DPT_LOGIC_DEFAULT_MHZ   20
+#define DPT_LOGIC_POST_US       250         // Kept running after the RMT ends
+
+typedef struct {
+    bool enabled;
+    uint8_t rate_mhz;                       // 160 MHz / N: 10, 20 or 40
+    int8_t aux_gpio[DPT_LOGIC_MAX_AUX];     // -1 = bit reads 0
+} dpt_logic_config_t;
+
+// Measured edges of one output against the plan
+typedef struct {
+    uint32_t plan_edges;
+    uint32_t captured_edges;
+    int32_t max_error_ns;       // Largest |captured - planned| over the edges both have
+    uint32_t worst_edge;        // Index of that edge
+    bool match;                 // Same count, every edge within the tolerance
+} dpt_logic_channel_t;
+
+typedef struct {
+    bool valid;                 // A capture has been stored
+    uint32_t shot;
+    uint32_t plan_hash;
+    uint32_t rate_hz;
+    int8_t aux_gpio[DPT_LOGIC_MAX_AUX];     // Routing at capture time
+    uint32_t samples;
+    uint32_t changes;           // Records in the store
+    uint32_t stored_bytes;
+    uint8_t first_value;
+    bool truncated;             // Store full; later changes are missing
+    uint32_t overruns;          // Buffers overwritten before they were encoded
+    bool compared;              // Channels below are filled in
+    uint32_t start_ns;          // Capture start to the first P edge, less the plan's own offset
+    uint32_t tolerance_ns;
+    dpt_logic_channel_t ch[DPT_NUM_CHANNELS];
+    bool match;
+    uint32_t skipped;           // Shots not captured because the store was being read
+} dpt_logic_summary_t;
+
+/**
+ * @brief Create the store lock; call once before anything else here
+ */
+void dpt_logic_init(void);
+
+/**
+ * @brief Enable or disable capture, set the sample rate and auxiliary pins
+ *
+ * The first enable allocates the DMA ring in internal RAM; it stays
+ * allocated. Waits for a capture or download in progress.
+ *
+ * @return ESP_ERR_INVALID_ARG for a bad rate or pin, ESP_ERR_NOT_SUPPORTED
+ *         without LCD_CAM
+ */
+esp_err_t dpt_logic_configure(const dpt_logic_config_t *cfg);
+
+void dpt_logic_get_config(dpt_logic_config_t *out);
+
+/**
+ * @brief Start sampling; call right before the RMT starts
+ *
+ * Does nothing while disabled, or while the last capture is being read.
+ */
+void dpt_logic_arm(void);
+
+/**
+ * @brief Stop sampling after DPT_LOGIC_POST_US, encode the rest and compare
+ *
+ * Call once the RMT is done, with the plan that was fired.
+ */
+void dpt_logic_finish(const dpt_plan_t *plan, uint32_t shot);
+
+void dpt_logic_get_summary(dpt_logic_summary_t *out);
+
+/**
+ * @brief Write the capture as VCD, 1 ns timescale
+ *
+ * Same writer callback as dpt_trace_dump().
+ *
+ * @return ESP_ERR_NOT_FOUND with no capture, else the first writer error
+ */
+esp_err_t dpt_logic_export_vcd(esp_err_t (*write)(void *ctx, const void *data, size_t len), void *ctx);
+
+// ---------------------- Store ----------------------
+// What the capture backend uses; callable directly to check the encoder,
+// the export and the comparison against a synthetic capture.
+
+void dpt_logic_store_begin(uint32_t rate_hz);
+void dpt_logic_store_feed(const uint8_t *samples, size_t n);
+void dpt_logic_store_end(void);
+
+/**
+ * @brief Compare the stored P/N edges with a plan
+ */
+void dpt_logic_compare(const dpt_plan_t *plan);
+
+#ifdef __cplusplus
+}
+#endif
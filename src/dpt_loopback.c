@@ -0,0 +1,45 @@
+/**
+ * @file dpt_loopback.c
+ * @brief Edge counters on the RMT output pads
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "driver/gpio.h"
+#include "dpt_loopback.h"
+#include "dpt_rmt.h"
+
+static const gpio_num_t pad_gpio[DPT_NUM_CHANNELS] = { RMT_TX_GPIO_P, RMT_TX_GPIO_N };
+static volatile uint32_t edge_count[DPT_NUM_CHANNELS];
+
+static void IRAM_ATTR edge_isr(void *arg) {
+    edge_count[(uintptr_t)arg]++;
+}
+
+esp_err_t dpt_loopback_start(void) {
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        edge_count[ch] = 0;
+        // Only the interrupt settings; gpio_config() would route the pad back to GPIO
+        esp_err_t err = gpio_set_intr_type(pad_gpio[ch], GPIO_INTR_ANYEDGE);
+        if (err == ESP_OK) err = gpio_isr_handler_add(pad_gpio[ch], edge_isr, (void *)(uintptr_t)ch);
+        if (err == ESP_OK) err = gpio_intr_enable(pad_gpio[ch]);
+        if (err != ESP_OK) {
+            dpt_loopback_stop();
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+void dpt_loopback_read(uint32_t edges[DPT_NUM_CHANNELS]) {
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        edges[ch] = edge_count[ch];
+    }
+}
+
+void dpt_loopback_stop(void) {
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        gpio_intr_disable(pad_gpio[ch]);
+        gpio_set_intr_type(pad_gpio[ch], GPIO_INTR_DISABLE);
+        gpio_isr_handler_remove(pad_gpio[ch]);
+    }
+}
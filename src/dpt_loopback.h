@@ -0,0 +1,44 @@
+/**
+ * @file dpt_loopback.h
+ * @brief Edge counters on the RMT output pads
+ *
+ * The output pads keep their input enabled (see dpt_rmt.c), so a GPIO
+ * interrupt on each one sees every level change the pad actually makes,
+ * whoever drives it. Used to prove that setup and reconfiguration of the
+ * RMT put no edge on the gate outputs. No external wiring is needed.
+ *
+ * The GPIO interrupt status is edge-latched, so a glitch of any width
+ * counts at least once; edges closer together than the interrupt latency
+ * count once between them.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "dpt_plan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Zero the counters and start counting edges on both outputs
+ *
+ * Needs the GPIO ISR service installed.
+ */
+esp_err_t dpt_loopback_start(void);
+
+/**
+ * @brief Edges per channel (DPT_CHANNEL_x) since dpt_loopback_start()
+ */
+void dpt_loopback_read(uint32_t edges[DPT_NUM_CHANNELS]);
+
+/**
+ * @brief Stop counting and remove the interrupt handlers
+ */
+void dpt_loopback_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
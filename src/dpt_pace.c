@@ -0,0 +1,22 @@
+/**
+ * @file dpt_pace.c
+ * @brief Shot pacing and settle waits, rounded up to whole ticks
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "dpt_pace.h"
+
+TickType_t dpt_ms_to_ticks_ceil(uint32_t ms) {
+    return (ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+}
+
+void dpt_pace(int64_t last_start_us, uint32_t interval_ms) {
+    int64_t deadline_us = last_start_us + (int64_t)interval_ms * 1000;
+    // A tick delay may end early within its first tick; wait out the rest
+    int64_t remaining_us;
+    while ((remaining_us = deadline_us - esp_timer_get_time()) > 0) {
+        vTaskDelay((remaining_us + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000));
+    }
+}
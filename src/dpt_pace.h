@@ -0,0 +1,34 @@
+/**
+ * @file dpt_pace.h
+ * @brief Shot pacing and settle waits, rounded up to whole ticks
+ *
+ * pdMS_TO_TICKS() rounds down, so a wait built from it can end a tick
+ * early; these round up instead. Sweeps, current targeting, batch runs
+ * and the benchmark all pace their shots this way.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Ticks covering at least ms milliseconds
+ */
+TickType_t dpt_ms_to_ticks_ceil(uint32_t ms);
+
+/**
+ * @brief Wait until interval_ms after last_start_us (esp_timer time)
+ *
+ * Rounds the remaining time up in microseconds and delays again until
+ * the deadline has really passed. Returns at once when it already has.
+ */
+void dpt_pace(int64_t last_start_us, uint32_t interval_ms);
+
+#ifdef __cplusplus
+}
+#endif
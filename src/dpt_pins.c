@@ -0,0 +1,102 @@
+/**
+ * @file dpt_pins.c
+ * @brief Which module owns each GPIO
+ *
+ * One owner per pad in a table indexed by GPIO number. The board's
+ * reserved pads start out owned by DPT_PIN_SYSTEM and are never released.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "dpt_pins.h"
+
+#define TAG "DPT_PINS"
+
+// ESP32-S3: USB-JTAG on 19/20, flash and PSRAM on 26-32, UART0 console on 43/44
+static uint8_t owner_of[GPIO_NUM_MAX] = {
+    [19] = DPT_PIN_SYSTEM, [20] = DPT_PIN_SYSTEM,
+    [26] = DPT_PIN_SYSTEM, [27] = DPT_PIN_SYSTEM, [28] = DPT_PIN_SYSTEM, [29] = DPT_PIN_SYSTEM,
+    [30] = DPT_PIN_SYSTEM, [31] = DPT_PIN_SYSTEM, [32] = DPT_PIN_SYSTEM,
+    [43] = DPT_PIN_SYSTEM, [44] = DPT_PIN_SYSTEM,
+};
+
+static const char *const owner_names[DPT_PIN_OWNERS] = {
+    [DPT_PIN_FREE] = "free",
+    [DPT_PIN_SYSTEM] = "system",
+    [DPT_PIN_OUTPUT] = "gate outputs",
+    [DPT_PIN_TRIGGER] = "trigger inputs",
+    [DPT_PIN_LOGIC] = "logic analyzer",
+    [DPT_PIN_DELAY] = "delay capture",
+    [DPT_PIN_ADC] = "ADC capture",
+    [DPT_PIN_BATCH] = "batch matrix",
+};
+
+static portMUX_TYPE pins_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Caller holds pins_mux. Index of the first pin that cannot be taken, or -1
+static int check_set(dpt_pin_owner_t owner, const int8_t *gpio, int n) {
+    for (int k = 0; k < n; k++) {
+        if (gpio[k] < 0) {
+            continue;
+        }
+        if (!GPIO_IS_VALID_GPIO(gpio[k])) {
+            return k;
+        }
+        for (int j = 0; j < k; j++) {
+            if (gpio[j] == gpio[k]) return k;
+        }
+        if (owner_of[gpio[k]] != DPT_PIN_FREE && owner_of[gpio[k]] != owner) {
+            return k;
+        }
+    }
+    return -1;
+}
+
+esp_err_t dpt_pins_claim_set(dpt_pin_owner_t owner, const int8_t *gpio, int n) {
+    if (owner <= DPT_PIN_SYSTEM || owner >= DPT_PIN_OWNERS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&pins_mux);
+    int bad = check_set(owner, gpio, n);
+    dpt_pin_owner_t holder = bad >= 0 && GPIO_IS_VALID_GPIO(gpio[bad]) ? owner_of[gpio[bad]] : DPT_PIN_FREE;
+    if (bad < 0) {
+        for (int p = 0; p < GPIO_NUM_MAX; p++) {
+            if (owner_of[p] == owner) owner_of[p] = DPT_PIN_FREE;
+        }
+        for (int k = 0; k < n; k++) {
+            if (gpio[k] >= 0) owner_of[gpio[k]] = owner;
+        }
+    }
+    portEXIT_CRITICAL(&pins_mux);
+
+    if (bad < 0) {
+        return ESP_OK;
+    }
+    if (holder != DPT_PIN_FREE && holder != owner) {
+        ESP_LOGW(TAG, "GPIO%d not given to the %s: held by the %s", gpio[bad], owner_names[owner], owner_names[holder]);
+    } else {
+        ESP_LOGW(TAG, "GPIO%d not given to the %s: no such pin, or listed twice", gpio[bad], owner_names[owner]);
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t dpt_pins_claim(int gpio, dpt_pin_owner_t owner) {
+    if (owner <= DPT_PIN_SYSTEM || owner >= DPT_PIN_OWNERS || !GPIO_IS_VALID_GPIO(gpio)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = ESP_OK;
+    portENTER_CRITICAL(&pins_mux);
+    dpt_pin_owner_t holder = owner_of[gpio];
+    if (holder == DPT_PIN_FREE || holder == owner) {
+        owner_of[gpio] = owner;
+    } else {
+        err = ESP_ERR_INVALID_ARG;
+    }
+    portEXIT_CRITICAL(&pins_mux);
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "GPIO%d not given to the %s: held by the %s", gpio, owner_names[owner], owner_names[holder]);
+    }
+    return err;
+}
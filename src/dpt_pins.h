@@ -0,0 +1,54 @@
+/**
+ * @file dpt_pins.h
+ * @brief Which module owns each GPIO
+ *
+ * Every module that takes pads from the user (logic analyzer, delay
+ * capture, ADC, batch matrix) claims them here before it touches them,
+ * and the gate outputs and trigger inputs are claimed at boot. A pad
+ * that another module already owns, or that the board reserves (USB,
+ * flash, console), is refused, so one configure path cannot take a pin
+ * that another one drives or listens on.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    DPT_PIN_FREE,
+    DPT_PIN_SYSTEM,         // USB, flash and console pads
+    DPT_PIN_OUTPUT,         // Gate outputs
+    DPT_PIN_TRIGGER,        // Trigger inputs and the button
+    DPT_PIN_LOGIC,
+    DPT_PIN_DELAY,
+    DPT_PIN_ADC,
+    DPT_PIN_BATCH,
+    DPT_PIN_OWNERS,
+} dpt_pin_owner_t;
+
+/**
+ * @brief Make gpio[0..n-1] the owner's pins, releasing the ones it held
+ *
+ * Entries of -1 are skipped. All or nothing: nothing changes unless every
+ * pin is valid, listed once, and free or already the owner's.
+ *
+ * @return ESP_ERR_INVALID_ARG for an invalid or repeated pin, or one that
+ *         another owner holds (logged with the holder's name)
+ */
+esp_err_t dpt_pins_claim_set(dpt_pin_owner_t owner, const int8_t *gpio, int n);
+
+/**
+ * @brief Add one pin to the owner's set
+ *
+ * @return ESP_ERR_INVALID_ARG as for dpt_pins_claim_set()
+ */
+esp_err_t dpt_pins_claim(int gpio, dpt_pin_owner_t owner);
+
+#ifdef __cplusplus
+}
+#endif
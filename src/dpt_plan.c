@@ -0,0 +1,630 @@
+/**
+ * @file dpt_plan.c
+ * @brief Waveform plan compiler for the DPT signal generator
+ *
+ * Item word layout matches rmt_item32_t: bits 0-14 duration0, bit 15
+ * level0, bits 16-30 duration1, bit 31 level1. A zero duration ends the
+ * transmission, so every plan is terminated by a zero half.
+ */
+
+#include <string.h>
+#include "dpt_plan.h"
+
+// ---------------------- Item Word Helpers ----------------------
+static inline uint32_t make_half(uint8_t level, uint32_t ticks) {
+    return ((uint32_t)(level ? 1 : 0) << 15) | (ticks & DPT_ITEM_MAX_TICKS);
+}
+
+static inline void set_half(uint32_t *words, uint32_t half, uint32_t value) {
+    uint32_t shift = (half & 1) ? 16 : 0;
+    uint32_t *w = &words[half >> 1];
+    *w = (*w & ~(0xFFFFu << shift)) | (value << shift);
+}
+
+// Number of item halves a segment needs (each half holds at most 15 bits)
+static inline uint32_t halves_for(uint32_t ticks) {
+    return (ticks + DPT_ITEM_MAX_TICKS - 1) / DPT_ITEM_MAX_TICKS;
+}
+
+// Per-word hash contribution. The plan hash is the sum of all contributions,
+// so a patched word can be swapped in and out without rehashing the plan.
+static inline uint32_t word_mix(int ch, uint32_t idx, uint32_t word) {
+    uint32_t h = word ^ (idx * 0x9E3779B9u) ^ ((uint32_t)ch << 31);
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+static inline uint32_t get_half_value(uint32_t word, uint32_t half) {
+    return (word >> ((half & 1) ? 16 : 0)) & 0xFFFF;
+}
+
+static inline uint32_t get_half(const uint32_t *words, uint32_t half) {
+    return get_half_value(words[half >> 1], half);
+}
+
+// Write the halves of segment k into both channels, splitting long segments
+// into near-equal chunks so every half stays within the 15-bit field
+static void write_segment(dpt_plan_t *plan, const dpt_segment_t *seg, uint32_t first_half, uint32_t n) {
+    uint32_t base = seg->ticks / n;
+    uint32_t rem = seg->ticks % n;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t ticks = base + (i < rem ? 1 : 0);
+        set_half(plan->words[DPT_CHANNEL_P], first_half + i, make_half(seg->level, ticks));
+        set_half(plan->words[DPT_CHANNEL_N], first_half + i, make_half(seg->n_level, ticks));
+    }
+}
+
+// ---------------------- Recipes ----------------------
+uint32_t dpt_us_to_ticks(float us) {
+    return (uint32_t)(us * (float)DPT_TICKS_PER_US + 0.5f);  // Round to nearest tick
+}
+
+void dpt_recipe_double_pulse(dpt_recipe_t *recipe, float p1h_us, float p1l_us,
+                             float p2h_us, float p2l_us) {
+    uint32_t p1h = dpt_us_to_ticks(p1h_us);
+    uint32_t p2h = dpt_us_to_ticks(p2h_us);
+
+    memset(recipe, 0, sizeof(*recipe));
+    recipe->seg[0] = (dpt_segment_t){ .level = 1, .n_level = 0, .ticks = p1h < DPT_MIN_TICKS_HIGH ? DPT_MIN_TICKS_HIGH : p1h };
+    recipe->seg[1] = (dpt_segment_t){ .level = 0, .n_level = 1, .ticks = dpt_us_to_ticks(p1l_us) };
+    recipe->seg[2] = (dpt_segment_t){ .level = 1, .n_level = 0, .ticks = p2h < DPT_MIN_TICKS_HIGH ? DPT_MIN_TICKS_HIGH : p2h };
+    recipe->seg[3] = (dpt_segment_t){ .level = 0, .n_level = 1, .ticks = dpt_us_to_ticks(p2l_us) };
+    recipe->num_segments = 4;
+}
+
+static esp_err_t add_segment(dpt_recipe_t *recipe, uint8_t level, uint8_t n_level, uint32_t ticks) {
+    if (ticks == 0) {
+        return ESP_OK;
+    }
+    if (recipe->num_segments > 0) {
+        dpt_segment_t *last = &recipe->seg[recipe->num_segments - 1];
+        if (last->level == level && last->n_level == n_level) {
+            last->ticks += ticks;
+            return ESP_OK;
+        }
+    }
+    if (recipe->num_segments >= DPT_MAX_SEGMENTS) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    recipe->seg[recipe->num_segments++] = (dpt_segment_t){ .level = level, .n_level = n_level, .ticks = ticks };
+    return ESP_OK;
+}
+
+esp_err_t dpt_recipe_add(dpt_recipe_t *recipe, uint8_t level, uint32_t ticks) {
+    level = level ? 1 : 0;
+    return add_segment(recipe, level, !level, ticks);
+}
+
+// Dead-time expansion of input segment k, in forward order. next_level is
+// in[k + 1].level (or 0 past the end). Returns the number of parts or -1.
+static int dead_time_parts(const dpt_segment_t *in, uint16_t k, uint8_t next_level,
+                           uint32_t dead_ticks, dpt_segment_t parts[3]) {
+    if (in[k].n_level == in[k].level) {
+        return -1;  // Not complementary (dead time already applied?)
+    }
+    if (in[k].level) {
+        parts[0] = (dpt_segment_t){ .level = 1, .n_level = 0, .ticks = in[k].ticks };
+        return 1;
+    }
+    uint32_t lead = (k > 0 && in[k - 1].level) ? dead_ticks : 0;
+    uint32_t trail = next_level ? dead_ticks : 0;
+    if (in[k].ticks <= lead + trail) {
+        return -1;  // No room left for the negative pulse
+    }
+    int n = 0;
+    if (lead) parts[n++] = (dpt_segment_t){ .level = 0, .n_level = 0, .ticks = lead };
+    parts[n++] = (dpt_segment_t){ .level = 0, .n_level = 1, .ticks = in[k].ticks - lead - trail };
+    if (trail) parts[n++] = (dpt_segment_t){ .level = 0, .n_level = 0, .ticks = trail };
+    return n;
+}
+
+esp_err_t dpt_recipe_apply_dead_time(dpt_recipe_t *recipe, uint32_t dead_ticks) {
+    dpt_segment_t *seg = recipe->seg;
+    uint16_t n = recipe->num_segments;
+    dpt_segment_t parts[3];
+    dpt_segment_t lead_in = { .level = 0, .n_level = 0, .ticks = dead_ticks };
+    bool has_lead_in = (n > 0 && seg[0].level);
+
+    if (dead_ticks == 0 || n == 0) {
+        return ESP_OK;
+    }
+
+    // Merge equal neighbours first (same waveform), so inputs alternate and
+    // every input expands to at least one output without merging across inputs
+    uint16_t m = 0;
+    for (uint16_t k = 1; k < n; k++) {
+        if (seg[k].level == seg[m].level && seg[k].n_level == seg[m].n_level) {
+            seg[m].ticks += seg[k].ticks;
+        } else {
+            seg[++m] = seg[k];
+        }
+    }
+    n = recipe->num_segments = m + 1;
+
+    // Pass 1: count the output (adjacent equal parts merge) and check feasibility
+    uint32_t count = has_lead_in ? 1 : 0;
+    dpt_segment_t last = lead_in;
+    for (uint16_t k = 0; k < n; k++) {
+        int np = dead_time_parts(seg, k, (k + 1 < n) ? seg[k + 1].level : 0, dead_ticks, parts);
+        if (np < 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        for (int i = 0; i < np; i++) {
+            if (count == 0 || parts[i].level != last.level || parts[i].n_level != last.n_level) {
+                count++;
+            }
+            last = parts[i];
+        }
+    }
+    if (count > DPT_MAX_SEGMENTS) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Pass 2: expand in place from the back; the write index never drops
+    // below the segment being read
+    uint32_t w = count;
+    uint8_t next_level = 0;
+    for (int k = n - 1; k >= 0; k--) {
+        uint8_t level = seg[k].level;
+        int np = dead_time_parts(seg, k, next_level, dead_ticks, parts);
+        next_level = level;
+        for (int i = np - 1; i >= 0; i--) {
+            if (w < count && seg[w].level == parts[i].level && seg[w].n_level == parts[i].n_level) {
+                seg[w].ticks += parts[i].ticks;
+            } else {
+                seg[--w] = parts[i];
+            }
+        }
+    }
+    if (has_lead_in) {
+        seg[--w] = lead_in;
+    }
+    recipe->num_segments = count;
+    recipe->dead_ticks = dead_ticks;
+    return ESP_OK;
+}
+
+// Carrier modulation of segment seg on channel ch: number of parts, and
+// part i of them. Segments where the channel is low are one part.
+typedef struct {
+    int ch;
+    uint32_t period;
+    uint32_t high;
+} carrier_t;
+
+static uint32_t carrier_num_parts(const carrier_t *c, const dpt_segment_t *seg) {
+    uint8_t level = (c->ch == DPT_CHANNEL_P) ? seg->level : seg->n_level;
+    if (!level) {
+        return 1;
+    }
+    uint32_t full = seg->ticks / c->period;
+    uint32_t rem = seg->ticks % c->period;
+    if (rem == 0 || (rem < DPT_MIN_TICKS_HIGH && full > 0)) {
+        return 2 * full;            // A short remainder joins the last low
+    }
+    return 2 * full + (rem > c->high ? 2 : 1);
+}
+
+static dpt_segment_t carrier_part(const carrier_t *c, const dpt_segment_t *seg, uint32_t i, uint32_t num_parts) {
+    dpt_segment_t part = *seg;
+    uint8_t level = (c->ch == DPT_CHANNEL_P) ? seg->level : seg->n_level;
+    if (!level) {
+        return part;
+    }
+    uint32_t full = seg->ticks / c->period;
+    uint32_t rem = seg->ticks % c->period;
+    uint8_t on = (i % 2) == 0;
+    if (i / 2 < full) {
+        part.ticks = on ? c->high : c->period - c->high;
+        if (!on && i == num_parts - 1) {
+            part.ticks += rem;      // Remainder too short for a pulse
+        }
+    } else {
+        part.ticks = on ? (rem < c->high ? rem : c->high) : rem - c->high;
+    }
+    if (c->ch == DPT_CHANNEL_P) {
+        part.level = on;
+    } else {
+        part.n_level = on;
+    }
+    return part;
+}
+
+esp_err_t dpt_recipe_apply_carrier(dpt_recipe_t *recipe, int ch, uint32_t period_ticks, uint32_t high_ticks) {
+    dpt_segment_t *seg = recipe->seg;
+    uint16_t n = recipe->num_segments;
+    carrier_t c = { .ch = ch, .period = period_ticks, .high = high_ticks };
+
+    if (ch < 0 || ch >= DPT_NUM_CHANNELS || high_ticks < DPT_MIN_TICKS_HIGH || high_ticks >= period_ticks) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Pass 1: count the output, merging equal neighbours as pass 2 will
+    uint32_t count = 0;
+    dpt_segment_t last = { 0 };
+    for (uint16_t k = 0; k < n; k++) {
+        uint32_t np = carrier_num_parts(&c, &seg[k]);
+        for (uint32_t i = 0; i < np; i++) {
+            dpt_segment_t part = carrier_part(&c, &seg[k], i, np);
+            if (count == 0 || part.level != last.level || part.n_level != last.n_level) {
+                if (++count > DPT_MAX_SEGMENTS) {
+                    return ESP_ERR_INVALID_SIZE;
+                }
+            }
+            last = part;
+        }
+    }
+
+    // Pass 2: expand in place from the back, as for dead time
+    uint32_t w = count;
+    for (int k = n - 1; k >= 0; k--) {
+        dpt_segment_t in = seg[k];
+        uint32_t np = carrier_num_parts(&c, &in);
+        for (int i = np - 1; i >= 0; i--) {
+            dpt_segment_t part = carrier_part(&c, &in, i, np);
+            if (w < count && seg[w].level == part.level && seg[w].n_level == part.n_level) {
+                seg[w].ticks += part.ticks;
+            } else {
+                seg[--w] = part;
+            }
+        }
+    }
+    recipe->num_segments = count;
+    return ESP_OK;
+}
+
+// ---------------------- Compiler ----------------------
+// Words the recipe compiles to, or 0 with *err set
+static uint32_t layout_words(const dpt_recipe_t *recipe, esp_err_t *err) {
+    if (recipe->num_segments == 0 || recipe->num_segments > DPT_MAX_SEGMENTS) {
+        *err = ESP_ERR_INVALID_ARG;
+        return 0;
+    }
+    uint32_t total_halves = 0;
+    for (uint16_t k = 0; k < recipe->num_segments; k++) {
+        if (recipe->seg[k].ticks == 0) {
+            *err = ESP_ERR_INVALID_ARG;
+            return 0;
+        }
+        total_halves += halves_for(recipe->seg[k].ticks);
+    }
+    // One extra zero half terminates the transmission
+    uint32_t num_words = (total_halves + 1 + 1) / 2;
+    if (num_words > DPT_PLAN_MAX_WORDS) {
+        *err = ESP_ERR_INVALID_SIZE;
+        return 0;
+    }
+    *err = ESP_OK;
+    return num_words;
+}
+
+esp_err_t dpt_plan_check(const dpt_recipe_t *recipe) {
+    esp_err_t err;
+    layout_words(recipe, &err);
+    return err;
+}
+
+esp_err_t dpt_plan_compile(dpt_plan_t *plan, const dpt_recipe_t *recipe) {
+    // Lay out the halves first so an oversized recipe leaves the plan untouched
+    esp_err_t err;
+    uint32_t num_words = layout_words(recipe, &err);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    memset(plan->words, 0, sizeof(plan->words));
+    uint32_t half = 0;
+    for (uint16_t k = 0; k < recipe->num_segments; k++) {
+        uint32_t n = halves_for(recipe->seg[k].ticks);
+        plan->seg_first_half[k] = half;
+        plan->seg_num_halves[k] = n;
+        write_segment(plan, &recipe->seg[k], half, n);
+        half += n;
+    }
+
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        plan->num_words[ch] = num_words;
+    }
+    plan->hash = dpt_plan_rehash(plan);
+    memcpy(&plan->recipe, recipe, sizeof(*recipe));
+    plan->dirty_first = 0;
+    plan->dirty_last = num_words - 1;
+    return ESP_OK;
+}
+
+esp_err_t dpt_plan_update(dpt_plan_t *plan, const dpt_recipe_t *recipe,
+                          dpt_patch_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    // Pass 1: check that every changed segment can be patched in place
+    bool patchable = (plan->recipe.num_segments == recipe->num_segments);
+    for (uint16_t k = 0; patchable && k < recipe->num_segments; k++) {
+        const dpt_segment_t *old_seg = &plan->recipe.seg[k];
+        const dpt_segment_t *new_seg = &recipe->seg[k];
+        if (old_seg->level == new_seg->level && old_seg->n_level == new_seg->n_level &&
+            old_seg->ticks == new_seg->ticks) {
+            continue;
+        }
+        if (new_seg->ticks == 0 || old_seg->level != new_seg->level || old_seg->n_level != new_seg->n_level ||
+            halves_for(new_seg->ticks) != plan->seg_num_halves[k]) {
+            patchable = false;
+        }
+    }
+
+    if (!patchable || plan->recipe.dead_ticks != recipe->dead_ticks) {
+        esp_err_t err = dpt_plan_compile(plan, recipe);
+        if (err == ESP_OK) {
+            stats->full = true;
+            stats->segments_changed = recipe->num_segments;
+            stats->words_patched = plan->num_words[DPT_CHANNEL_P];
+        }
+        return err;
+    }
+
+    // Pass 2: rewrite only the words covered by changed segments
+    uint32_t dirty_first = UINT32_MAX;
+    uint32_t dirty_last = 0;
+    for (uint16_t k = 0; k < recipe->num_segments; k++) {
+        if (plan->recipe.seg[k].ticks == recipe->seg[k].ticks) {
+            continue;
+        }
+        uint32_t first_word = plan->seg_first_half[k] >> 1;
+        uint32_t last_word = (plan->seg_first_half[k] + plan->seg_num_halves[k] - 1) >> 1;
+
+        for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+            for (uint32_t i = first_word; i <= last_word; i++) {
+                plan->hash -= word_mix(ch, i, plan->words[ch][i]);
+            }
+        }
+        write_segment(plan, &recipe->seg[k], plan->seg_first_half[k], plan->seg_num_halves[k]);
+        for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+            for (uint32_t i = first_word; i <= last_word; i++) {
+                plan->hash += word_mix(ch, i, plan->words[ch][i]);
+            }
+        }
+
+        plan->recipe.seg[k].ticks = recipe->seg[k].ticks;
+        stats->segments_changed++;
+        stats->words_patched += last_word - first_word + 1;
+        if (first_word < dirty_first) dirty_first = first_word;
+        if (last_word > dirty_last) dirty_last = last_word;
+    }
+
+    if (stats->segments_changed == 0) {
+        // Nothing to load: an empty range
+        plan->dirty_first = 1;
+        plan->dirty_last = 0;
+    } else {
+        plan->dirty_first = dirty_first;
+        plan->dirty_last = dirty_last;
+    }
+    return ESP_OK;
+}
+
+uint32_t dpt_plan_rehash(const dpt_plan_t *plan) {
+    uint32_t hash = 0;
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        for (uint32_t i = 0; i < plan->num_words[ch]; i++) {
+            hash += word_mix(ch, i, plan->words[ch][i]);
+        }
+    }
+    return hash;
+}
+
+uint64_t dpt_plan_total_ticks(const dpt_plan_t *plan) {
+    uint64_t total = 0;
+    for (uint16_t k = 0; k < plan->recipe.num_segments; k++) {
+        total += plan->recipe.seg[k].ticks;
+    }
+    return total;
+}
+
+// ---------------------- Binary Plans ----------------------
+static void put_u16(uint8_t *p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void put_u32(uint8_t *p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+static uint16_t get_u16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t get_u32(const uint8_t *p) { return (uint32_t)get_u16(p) | ((uint32_t)get_u16(p + 2) << 16); }
+
+uint32_t dpt_crc32(uint32_t crc, const uint8_t *data, size_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+size_t dpt_plan_serialize(const dpt_plan_t *plan, uint8_t *buf, size_t len) {
+    uint16_t num_words = plan->num_words[DPT_CHANNEL_P];
+    uint16_t num_segments = plan->recipe.num_segments;
+    size_t size = DPT_BLOB_SIZE(num_words, num_segments);
+    if (len < size) {
+        return 0;
+    }
+
+    uint8_t *p = buf;
+    memcpy(p, "DPTP", 4);
+    p[4] = 1;
+    p[5] = DPT_NUM_CHANNELS;
+    put_u16(p + 6, num_segments);
+    put_u16(p + 8, num_words);
+    put_u16(p + 10, 0);
+    put_u32(p + 12, plan->hash);
+    put_u32(p + 16, plan->recipe.dead_ticks);
+    p += DPT_BLOB_HEADER_SIZE;
+
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        for (uint16_t i = 0; i < num_words; i++, p += 4) {
+            put_u32(p, plan->words[ch][i]);
+        }
+    }
+    for (uint16_t k = 0; k < num_segments; k++, p += 8) {
+        put_u32(p, plan->recipe.seg[k].ticks);
+        p[4] = plan->recipe.seg[k].level;
+        p[5] = plan->recipe.seg[k].n_level;
+        put_u16(p + 6, 0);
+    }
+    put_u32(p, dpt_crc32(0, buf, p - buf));
+    return size;
+}
+
+// Item half h of channel ch straight from a serialized word array
+static inline uint32_t blob_half(const uint8_t *words, uint16_t num_words, int ch, uint32_t h) {
+    return get_half_value(get_u32(words + 4 * (ch * num_words + (h >> 1))), h);
+}
+
+esp_err_t dpt_plan_deserialize(dpt_plan_t *plan, const uint8_t *buf, size_t len) {
+    if (len < DPT_BLOB_HEADER_SIZE + 4 || memcmp(buf, "DPTP", 4) != 0 || buf[4] != 1 ||
+        buf[5] != DPT_NUM_CHANNELS) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    uint16_t num_segments = get_u16(buf + 6);
+    uint16_t num_words = get_u16(buf + 8);
+    if (num_segments == 0 || num_segments > DPT_MAX_SEGMENTS || num_words == 0 ||
+        num_words > DPT_PLAN_MAX_WORDS || len != (size_t)DPT_BLOB_SIZE(num_words, num_segments)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (dpt_crc32(0, buf, len - 4) != get_u32(buf + len - 4)) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    const uint8_t *words = buf + DPT_BLOB_HEADER_SIZE;
+    const uint8_t *segs = words + 4 * DPT_NUM_CHANNELS * num_words;
+
+    // Every segment's halves must carry its levels and add up to its ticks
+    uint32_t half = 0;
+    for (uint16_t k = 0; k < num_segments; k++) {
+        uint32_t ticks = get_u32(segs + 8 * k);
+        uint8_t level = segs[8 * k + 4];
+        uint8_t n_level = segs[8 * k + 5];
+        if (ticks == 0 || level > 1 || n_level > 1) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        uint32_t sum = 0;
+        while (sum < ticks) {
+            if (half >= (uint32_t)num_words * 2) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            uint32_t hp = blob_half(words, num_words, DPT_CHANNEL_P, half);
+            uint32_t hn = blob_half(words, num_words, DPT_CHANNEL_N, half);
+            if ((hp & DPT_ITEM_MAX_TICKS) == 0 || (hp & DPT_ITEM_MAX_TICKS) != (hn & DPT_ITEM_MAX_TICKS) ||
+                (hp >> 15) != level || (hn >> 15) != n_level) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            sum += hp & DPT_ITEM_MAX_TICKS;
+            half++;
+        }
+        if (sum != ticks) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    // Then the end marker, and nothing but zeros after it
+    if (num_words != (half + 2) / 2) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    for (uint32_t h = half; h < (uint32_t)num_words * 2; h++) {
+        if (blob_half(words, num_words, DPT_CHANNEL_P, h) != 0 || blob_half(words, num_words, DPT_CHANNEL_N, h) != 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    uint32_t hash = 0;
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        for (uint16_t i = 0; i < num_words; i++) {
+            hash += word_mix(ch, i, get_u32(words + 4 * (ch * num_words + i)));
+        }
+    }
+    if (hash != get_u32(buf + 12)) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    // Valid: load it
+    memset(plan->words, 0, sizeof(plan->words));
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        plan->num_words[ch] = num_words;
+        for (uint16_t i = 0; i < num_words; i++) {
+            plan->words[ch][i] = get_u32(words + 4 * (ch * num_words + i));
+        }
+    }
+    memset(&plan->recipe, 0, sizeof(plan->recipe));
+    plan->recipe.num_segments = num_segments;
+    plan->recipe.dead_ticks = get_u32(buf + 16);
+    half = 0;
+    for (uint16_t k = 0; k < num_segments; k++) {
+        dpt_segment_t *seg = &plan->recipe.seg[k];
+        seg->ticks = get_u32(segs + 8 * k);
+        seg->level = segs[8 * k + 4];
+        seg->n_level = segs[8 * k + 5];
+        plan->seg_first_half[k] = half;
+        for (uint32_t sum = 0; sum < seg->ticks; half++) {
+            sum += get_half(plan->words[DPT_CHANNEL_P], half) & DPT_ITEM_MAX_TICKS;
+        }
+        plan->seg_num_halves[k] = half - plan->seg_first_half[k];
+    }
+    plan->hash = hash;
+    plan->dirty_first = 0;
+    plan->dirty_last = num_words - 1;
+    return ESP_OK;
+}
+
+// ---------------------- Edge List ----------------------
+void dpt_edge_iter_init(dpt_edge_iter_t *it, const dpt_plan_t *plan, int ch) {
+    it->words = plan->words[ch];
+    it->num_words = plan->num_words[ch];
+    it->half = 0;
+    it->tick = 0;
+    it->idle_level = (ch == DPT_CHANNEL_N) ? DPT_IDLE_LEVEL_N : DPT_IDLE_LEVEL_P;
+    it->level = it->idle_level;
+    it->done = false;
+}
+
+bool dpt_edge_iter_next(dpt_edge_iter_t *it, uint32_t *tick, uint8_t *level) {
+    while (!it->done) {
+        uint32_t value = 0;
+        if (it->half < (uint32_t)it->num_words * 2) {
+            value = get_half(it->words, it->half);
+        }
+        uint32_t ticks = value & DPT_ITEM_MAX_TICKS;
+        uint8_t half_level = (value >> 15) & 1;
+
+        if (ticks == 0) {
+            // End marker: the output returns to idle
+            it->done = true;
+            if (it->level != it->idle_level) {
+                it->level = it->idle_level;
+                *tick = it->tick;
+                *level = it->level;
+                return true;
+            }
+            return false;
+        }
+
+        uint32_t start = it->tick;
+        it->tick += ticks;
+        it->half++;
+        if (half_level != it->level) {
+            it->level = half_level;
+            *tick = start;
+            *level = half_level;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t dpt_plan_count_edges(const dpt_plan_t *plan, int ch) {
+    dpt_edge_iter_t it;
+    uint32_t tick;
+    uint8_t level;
+    uint32_t count = 0;
+    dpt_edge_iter_init(&it, plan, ch);
+    while (dpt_edge_iter_next(&it, &tick, &level)) {
+        count++;
+    }
+    return count;
+}
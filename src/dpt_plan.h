@@ -0,0 +1,236 @@
+/**
+ * @file dpt_plan.h
+ * @brief Waveform plan compiler for the DPT signal generator
+ *
+ * Turns a recipe (a list of level/duration segments on the positive
+ * channel) into ready-to-load RMT item words for both output channels.
+ * The compiled plan remembers which item halves each segment occupies,
+ * so a later parameter change can be applied by patching only the words
+ * of the segments that actually changed.
+ *
+ * This module has no hardware dependencies.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ---------------------- Plan Limits ----------------------
+#define DPT_TICKS_PER_US        80      // 80MHz / RMT_CLK_DIV(1), 1 tick = 12.5ns
+#define DPT_ITEM_MAX_TICKS      32767   // RMT duration field is 15 bits wide
+#define DPT_MIN_TICKS_HIGH      2       // Minimum 2 ticks for pulse high (25ns)
+#define DPT_MAX_SEGMENTS        256     // Segments per recipe
+#define DPT_PLAN_MAX_WORDS      336     // Item words per channel, fits four 65535μs segments
+
+#define DPT_CHANNEL_P           0       // Positive signal channel
+#define DPT_CHANNEL_N           1       // Negative (complementary) signal channel
+#define DPT_NUM_CHANNELS        2
+
+#define DPT_IDLE_LEVEL_P        0       // Level between plans, matches the RMT idle level
+#define DPT_IDLE_LEVEL_N        1
+
+// ---------------------- Types ----------------------
+// One stretch during which both outputs hold their levels
+typedef struct {
+    uint8_t level;      // Positive channel: 1 = high, 0 = low
+    uint8_t n_level;    // Negative channel, normally !level; 0 in a dead band
+    uint32_t ticks;     // Duration in RMT ticks, may exceed DPT_ITEM_MAX_TICKS
+} dpt_segment_t;
+
+// What to emit
+typedef struct {
+    dpt_segment_t seg[DPT_MAX_SEGMENTS];
+    uint16_t num_segments;
+    uint32_t dead_ticks;    // Dead time applied by dpt_recipe_apply_dead_time()
+} dpt_recipe_t;
+
+// Compiled, ready-to-load item words for both channels
+typedef struct {
+    uint32_t words[DPT_NUM_CHANNELS][DPT_PLAN_MAX_WORDS];
+    uint16_t num_words[DPT_NUM_CHANNELS];       // Including the end marker
+    uint16_t seg_first_half[DPT_MAX_SEGMENTS];  // First item half of each segment
+    uint16_t seg_num_halves[DPT_MAX_SEGMENTS];  // Item halves used by each segment
+    dpt_recipe_t recipe;                        // Recipe the words were compiled from
+    uint32_t hash;                              // Order-sensitive hash over all words
+    uint16_t dirty_first;                       // Word range touched by the last
+    uint16_t dirty_last;                        //   compile/patch (inclusive)
+} dpt_plan_t;
+
+// Result of dpt_plan_update()
+typedef struct {
+    bool full;                  // true if the plan had to be recompiled from scratch
+    uint16_t segments_changed;
+    uint16_t words_patched;     // Per channel
+} dpt_patch_stats_t;
+
+// Walks the level changes a channel will emit, in absolute ticks from start
+typedef struct {
+    const uint32_t *words;
+    uint16_t num_words;
+    uint32_t half;
+    uint32_t tick;
+    uint8_t level;
+    uint8_t idle_level;
+    bool done;
+} dpt_edge_iter_t;
+
+// ---------------------- Recipes ----------------------
+/**
+ * @brief Convert microseconds to RMT ticks, rounding to the nearest tick
+ */
+uint32_t dpt_us_to_ticks(float us);
+
+/**
+ * @brief Build the classic double pulse recipe (high/low/high/low)
+ *
+ * High times are raised to DPT_MIN_TICKS_HIGH; low times are used as given.
+ */
+void dpt_recipe_double_pulse(dpt_recipe_t *recipe, float p1h_us, float p1l_us,
+                             float p2h_us, float p2l_us);
+
+/**
+ * @brief Append a complementary segment (the negative channel gets !level)
+ *
+ * Merges with the previous segment if the levels match.
+ *
+ * @return ESP_ERR_INVALID_SIZE when the recipe is full
+ */
+esp_err_t dpt_recipe_add(dpt_recipe_t *recipe, uint8_t level, uint32_t ticks);
+
+/**
+ * @brief Insert dead time between the complementary outputs
+ *
+ * Both outputs are held low for dead_ticks around every transition. The
+ * dead bands are carved out of the positive channel's low segments, so
+ * positive edges keep their timing. If the recipe starts high, a
+ * dead_ticks lead-in is added first because the negative output idles
+ * high. Apply at most once per recipe.
+ *
+ * @return ESP_ERR_INVALID_ARG if a low segment is shorter than its dead
+ *         bands, ESP_ERR_INVALID_SIZE if the segments no longer fit
+ */
+esp_err_t dpt_recipe_apply_dead_time(dpt_recipe_t *recipe, uint32_t dead_ticks);
+
+/**
+ * @brief Modulate one channel's on-time with a carrier
+ *
+ * Every stretch where the channel is high becomes carrier cycles of
+ * high_ticks high and period_ticks - high_ticks low, starting with a high
+ * at the gate edge, so each burst is phase-aligned to its gate. The last
+ * cycle is cut at the falling gate edge; a remainder shorter than
+ * DPT_MIN_TICKS_HIGH is added to the previous low instead. The other
+ * channel keeps its levels. Apply after dead time, once per channel.
+ *
+ * @return ESP_ERR_INVALID_ARG unless DPT_MIN_TICKS_HIGH <= high_ticks <
+ *         period_ticks, ESP_ERR_INVALID_SIZE if the segments no longer fit
+ */
+esp_err_t dpt_recipe_apply_carrier(dpt_recipe_t *recipe, int ch, uint32_t period_ticks, uint32_t high_ticks);
+
+// ---------------------- Compiler ----------------------
+/**
+ * @brief Compile a recipe into a plan from scratch
+ *
+ * @return ESP_ERR_INVALID_ARG for an empty recipe or zero-length segment,
+ *         ESP_ERR_INVALID_SIZE if the items do not fit DPT_PLAN_MAX_WORDS
+ */
+esp_err_t dpt_plan_compile(dpt_plan_t *plan, const dpt_recipe_t *recipe);
+
+/**
+ * @brief Check that a recipe compiles, without writing a plan
+ *
+ * @return What dpt_plan_compile() would return
+ */
+esp_err_t dpt_plan_check(const dpt_recipe_t *recipe);
+
+/**
+ * @brief Bring a compiled plan up to date with a new recipe
+ *
+ * Segments whose level and item-half count are unchanged are patched in
+ * place. Finding them compares every segment with the plan's recipe, so
+ * that part is linear in the segment count; the word rewrites, the hash
+ * update and the RMT load that follows cover only the changed segments.
+ * Any structural change falls back to a full compile. On success
+ * dirty_first/dirty_last describe the words that differ from before.
+ */
+esp_err_t dpt_plan_update(dpt_plan_t *plan, const dpt_recipe_t *recipe,
+                          dpt_patch_stats_t *stats);
+
+/**
+ * @brief Total plan duration in ticks
+ */
+uint64_t dpt_plan_total_ticks(const dpt_plan_t *plan);
+
+/**
+ * @brief Recompute the plan hash from its words
+ */
+uint32_t dpt_plan_rehash(const dpt_plan_t *plan);
+
+// ---------------------- Binary Plans ----------------------
+// Device-ready plans compiled on the host (little-endian):
+//   header:   "DPTP", u8 version(1), u8 channels, u16 num_segments,
+//             u16 num_words, u16 reserved, u32 hash, u32 dead_ticks
+//   words:    u32[channels][num_words]
+//   segments: num_segments x { u32 ticks, u8 level, u8 n_level, u16 reserved }
+//   trailer:  u32 CRC-32 of everything before it
+#define DPT_BLOB_HEADER_SIZE    20
+#define DPT_BLOB_SIZE(words, segs) \
+    (DPT_BLOB_HEADER_SIZE + 4 * DPT_NUM_CHANNELS * (words) + 8 * (segs) + 4)
+#define DPT_BLOB_MAX_SIZE       DPT_BLOB_SIZE(DPT_PLAN_MAX_WORDS, DPT_MAX_SEGMENTS)
+
+/**
+ * @brief CRC-32 (IEEE 802.3, as used by zlib)
+ */
+uint32_t dpt_crc32(uint32_t crc, const uint8_t *data, size_t len);
+
+/**
+ * @brief Serialize a compiled plan
+ *
+ * @return Bytes written, or 0 if buf is too small
+ */
+size_t dpt_plan_serialize(const dpt_plan_t *plan, uint8_t *buf, size_t len);
+
+/**
+ * @brief Validate a serialized plan and load it
+ *
+ * One pass over the data: header bounds, CRC, that every segment's item
+ * halves carry its levels and add up to its ticks, that the end marker is
+ * where the segments end, and that the hash matches. The plan is only
+ * written if everything checks out.
+ *
+ * @return ESP_ERR_INVALID_VERSION, ESP_ERR_INVALID_SIZE, ESP_ERR_INVALID_CRC
+ *         or ESP_ERR_INVALID_ARG describing the first problem found
+ */
+esp_err_t dpt_plan_deserialize(dpt_plan_t *plan, const uint8_t *buf, size_t len);
+
+// ---------------------- Edge List ----------------------
+/**
+ * @brief Start walking the edges of one channel of a plan
+ *
+ * The walk decodes the item words themselves, so it reports what the RMT
+ * will emit rather than what the recipe asked for. It starts from the
+ * channel's idle level and ends with the return to idle after the marker.
+ */
+void dpt_edge_iter_init(dpt_edge_iter_t *it, const dpt_plan_t *plan, int ch);
+
+/**
+ * @brief Get the next edge
+ *
+ * @return false when there are no more edges
+ */
+bool dpt_edge_iter_next(dpt_edge_iter_t *it, uint32_t *tick, uint8_t *level);
+
+/**
+ * @brief Number of edges a channel of a plan will emit
+ */
+uint32_t dpt_plan_count_edges(const dpt_plan_t *plan, int ch);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,145 @@
+/**
+ * @file dpt_pool.c
+ * @brief Fixed size-class pools for plan, upload and response buffers
+ *
+ * The classes are consecutive slices of one static arena. Bit n of a
+ * class's free_mask is set while block n is free: allocation takes the
+ * lowest set bit, free finds the class by address range and the block
+ * by division.
+ */
+
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "dpt_plan.h"
+#include "dpt_pool.h"
+
+#define TAG "DPT_POOL"
+
+// Plans and binary plan uploads share a class
+#define PLAN_BLOCK_SIZE \
+    (((sizeof(dpt_plan_t) > DPT_BLOB_MAX_SIZE ? sizeof(dpt_plan_t) : DPT_BLOB_MAX_SIZE) + 7) & ~(size_t)7)
+
+// Bytes per block (multiple of 8), blocks; smallest first
+#define POOL_CLASSES \
+    X(1024,             4)  /* JSON chunks, small uploads */ \
+    X(4096,             2)  /* Web page */ \
+    X(PLAN_BLOCK_SIZE,  3)  /* Plans, binary plan uploads */
+
+typedef struct {
+    uint8_t *base;
+    size_t block_size;
+    uint16_t blocks;
+    uint16_t in_use;
+    uint16_t peak;
+    uint32_t free_mask;
+    uint32_t allocs;
+    uint32_t failures;
+} pool_t;
+
+#define X(size, count) { .block_size = (size), .blocks = (count) },
+static pool_t pools[] = { POOL_CLASSES };
+#undef X
+#define NUM_POOLS   ((int)(sizeof(pools) / sizeof(pools[0])))
+
+#define X(size, count) _Static_assert((count) <= DPT_POOL_MAX_BLOCKS && (size) % 8 == 0, "Bad pool class");
+POOL_CLASSES
+#undef X
+
+#define X(size, count) + (size) * (count)
+static uint64_t arena[(0 POOL_CLASSES) / sizeof(uint64_t)];
+#undef X
+
+static portMUX_TYPE pool_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool initialized = false;
+
+void dpt_pool_init(void) {
+    uint8_t *next = (uint8_t *)arena;
+    for (int i = 0; i < NUM_POOLS; i++) {
+        pool_t *pool = &pools[i];
+        pool->base = next;
+        pool->free_mask = (pool->blocks == 32) ? UINT32_MAX : (1u << pool->blocks) - 1;
+        next += pool->block_size * pool->blocks;
+        ESP_LOGI(TAG, "Class %d: %u x %zu bytes", i, pool->blocks, pool->block_size);
+    }
+    initialized = true;
+    ESP_LOGI(TAG, "%zu bytes reserved in %d classes", sizeof(arena), NUM_POOLS);
+}
+
+esp_err_t IRAM_ATTR dpt_pool_alloc(size_t size, void **out) {
+    *out = NULL;
+    if (!initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    pool_t *pool = NULL;
+    for (int i = 0; i < NUM_POOLS && pool == NULL; i++) {
+        if (pools[i].block_size >= size) {
+            pool = &pools[i];
+        }
+    }
+    if (pool == NULL) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    portENTER_CRITICAL_SAFE(&pool_mux);
+    if (pool->free_mask == 0) {
+        pool->failures++;
+        portEXIT_CRITICAL_SAFE(&pool_mux);
+        return ESP_ERR_NO_MEM;
+    }
+    int n = __builtin_ctz(pool->free_mask);
+    pool->free_mask &= ~(1u << n);
+    pool->in_use++;
+    if (pool->in_use > pool->peak) {
+        pool->peak = pool->in_use;
+    }
+    pool->allocs++;
+    portEXIT_CRITICAL_SAFE(&pool_mux);
+
+    *out = pool->base + n * pool->block_size;
+    return ESP_OK;
+}
+
+esp_err_t IRAM_ATTR dpt_pool_free(void *ptr) {
+    if (ptr == NULL) {
+        return ESP_OK;
+    }
+    uint8_t *p = ptr;
+    for (int i = 0; i < NUM_POOLS; i++) {
+        pool_t *pool = &pools[i];
+        if (p < pool->base || p >= pool->base + pool->block_size * pool->blocks) {
+            continue;
+        }
+        size_t offset = p - pool->base;
+        uint32_t bit = 1u << (offset / pool->block_size);
+        esp_err_t err = ESP_OK;
+        portENTER_CRITICAL_SAFE(&pool_mux);
+        if (offset % pool->block_size != 0 || (pool->free_mask & bit)) {
+            err = ESP_ERR_INVALID_ARG;
+        } else {
+            pool->free_mask |= bit;
+            pool->in_use--;
+        }
+        portEXIT_CRITICAL_SAFE(&pool_mux);
+        return err;
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+bool dpt_pool_get_stats(int cls, dpt_pool_stats_t *out) {
+    if (cls < 0 || cls >= NUM_POOLS) {
+        return false;
+    }
+    const pool_t *pool = &pools[cls];
+    portENTER_CRITICAL_SAFE(&pool_mux);
+    *out = (dpt_pool_stats_t){
+        .block_size = pool->block_size,
+        .blocks = pool->blocks,
+        .in_use = pool->in_use,
+        .peak = pool->peak,
+        .allocs = pool->allocs,
+        .failures = pool->failures,
+    };
+    portEXIT_CRITICAL_SAFE(&pool_mux);
+    return true;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file dpt_pool.h
+ * @brief Fixed size-class pools for plan, upload and response buffers
+ *
+ * All blocks are reserved statically, so the pools never take memory from
+ * the heap that WiFi and lwIP share, and cannot fragment it. A request is
+ * served from the smallest class whose blocks are large enough; it does
+ * not spill into a larger class, so each class's budget holds under load.
+ * Allocation and free are O(1): each class tracks its free blocks in a
+ * bitmask. Both are safe from tasks and ISRs.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DPT_POOL_MAX_BLOCKS 32      // Per class
+
+typedef struct {
+    size_t block_size;
+    uint16_t blocks;
+    uint16_t in_use;
+    uint16_t peak;              // Highest in_use since boot
+    uint32_t allocs;
+    uint32_t failures;          // Requests refused because the class was full
+} dpt_pool_stats_t;
+
+/**
+ * @brief Carve the classes out of the static arena; call once at boot
+ */
+void dpt_pool_init(void);
+
+/**
+ * @brief Take a block of at least size bytes
+ *
+ * @return ESP_ERR_INVALID_SIZE if no class is that large, ESP_ERR_NO_MEM
+ *         if the class that fits has no free block, ESP_ERR_INVALID_STATE
+ *         before dpt_pool_init()
+ */
+esp_err_t dpt_pool_alloc(size_t size, void **out);
+
+/**
+ * @brief Return a block; NULL is ignored
+ *
+ * @return ESP_ERR_INVALID_ARG for a pointer that is not a block start or
+ *         a block that is already free
+ */
+esp_err_t dpt_pool_free(void *ptr);
+
+/**
+ * @brief Usage of one class, smallest first
+ *
+ * Returns false past the last class.
+ */
+bool dpt_pool_get_stats(int cls, dpt_pool_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,60 @@
+/**
+ * @file dpt_preset.c
+ * @brief Precompiled plans that trigger inputs fire from their ISR
+ *
+ * Slots are only written while the RMT channels are claimed, and a
+ * trigger ISR can only fire while they are not, so an ISR never sees a
+ * half-written slot.
+ */
+
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "dpt_preset.h"
+#include "dpt_rmt.h"
+#include "dpt_thermal.h"
+
+#define TAG "DPT_PRESET"
+
+#define PRESET_CLAIM_TIMEOUT_MS     1000
+
+static dpt_plan_t slots[DPT_PRESET_SLOTS];
+static volatile bool slot_valid[DPT_PRESET_SLOTS];
+
+esp_err_t dpt_preset_store(uint8_t id, const dpt_plan_t *plan) {
+    if (id >= DPT_PRESET_SLOTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!dpt_rmt_fits(plan)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t err = dpt_rmt_claim(PRESET_CLAIM_TIMEOUT_MS);
+    if (err != ESP_OK) {
+        return err;
+    }
+    slot_valid[id] = false;
+    slots[id] = *plan;
+    slot_valid[id] = true;
+    dpt_thermal_set_preset(id, &slots[id]);
+    dpt_rmt_release();
+    ESP_LOGI(TAG, "Preset %u: %u word(s)/channel, hash=0x%08" PRIx32, id, plan->num_words[DPT_CHANNEL_P], plan->hash);
+    return ESP_OK;
+}
+
+esp_err_t dpt_preset_clear(uint8_t id) {
+    if (id >= DPT_PRESET_SLOTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = dpt_rmt_claim(PRESET_CLAIM_TIMEOUT_MS);
+    if (err != ESP_OK) {
+        return err;
+    }
+    slot_valid[id] = false;
+    dpt_thermal_set_preset(id, NULL);
+    dpt_rmt_release();
+    return ESP_OK;
+}
+
+const dpt_plan_t *IRAM_ATTR dpt_preset_get(uint8_t id) {
+    return (id < DPT_PRESET_SLOTS && slot_valid[id]) ? &slots[id] : NULL;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file dpt_preset.h
+ * @brief Precompiled plans that trigger inputs fire from their ISR
+ *
+ * A preset is a compiled plan kept in its own slot, so firing it needs no
+ * compile, no lock and no task. Presets must fit the RMT RAM directly,
+ * since the driver's refill path cannot be started from an ISR.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "dpt_plan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DPT_PRESET_SLOTS    4
+
+/**
+ * @brief Copy a compiled plan into a preset slot
+ *
+ * Waits for a shot fired from a trigger to finish, and keeps triggers
+ * from firing while the slot is rewritten.
+ *
+ * @return ESP_ERR_INVALID_ARG for a bad id, ESP_ERR_INVALID_SIZE if the
+ *         plan does not fit the RMT RAM
+ */
+esp_err_t dpt_preset_store(uint8_t id, const dpt_plan_t *plan);
+
+/**
+ * @brief Empty a preset slot
+ */
+esp_err_t dpt_preset_clear(uint8_t id);
+
+/**
+ * @brief The plan in a slot, or NULL if the slot is empty; ISR-safe
+ */
+const dpt_plan_t *dpt_preset_get(uint8_t id);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,28 @@
+/**
+ * @file dpt_qemu_eth.h
+ * @brief Network bring-up for the QEMU build of the DPT signal generator
+ *
+ * Espressif's QEMU has no WiFi; it emulates an OpenCores Ethernet MAC
+ * instead. With CONFIG_ETH_USE_OPENETH (sdkconfig.qemu, the "qemu"
+ * PlatformIO env) app_main() starts that interface in place of the
+ * softAP, and the web server is reached through QEMU's network backend.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start the emulated Ethernet interface with DHCP
+ *
+ * Performs the same NVS/netif/event loop set-up as the WiFi path.
+ */
+esp_err_t dpt_qemu_eth_init(void);
+
+#ifdef __cplusplus
+}
+#endif
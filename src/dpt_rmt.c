@@ -0,0 +1,445 @@
+/**
+ * @file dpt_rmt.c
+ * @brief RMT output backend for the DPT signal generator
+ *
+ * Plans that fit the channel RAM are written directly into RMT RAM. Longer
+ * plans fall back to rmt_write_items(), which refills the RAM from its ISR.
+ * Both channels are in the RMT's TX sync group, so on either path the
+ * hardware holds the first channel started until the second one is, and
+ * both begin on the same RMT clock edge (targets without the group start
+ * them back to back). Each load sizes the channels' RAM
+ * from the plan: a carrier channel can take three blocks while the other
+ * keeps one. The channels are only set up again when that layout changes.
+ *
+ * The output pads are held while the channels are set up or torn down.
+ * The legacy driver routes a pin to its channel before it programs the
+ * idle level, and disabling the RMT module resets every output to low;
+ * with the pads held neither reaches the gate driver.
+ *
+ * Tasks and trigger ISRs share the channels. A task claims them for a
+ * load or a whole shot; an ISR can only fire a plan while nobody holds
+ * them, and then holds them itself until both channels report TX end.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/gpio.h"
+#include "driver/rmt.h"
+#include "soc/rmt_struct.h"
+#include "soc/soc_caps.h"
+#include "esp_log.h"
+#include "dpt_rmt.h"
+#include "dpt_pins.h"
+#include "dpt_trace.h"
+
+#if defined(__XTENSA__)
+#include "hal/gpio_ll.h"
+#include "soc/gpio_struct.h"
+#endif
+
+#define TAG "DPT_RMT"
+
+_Static_assert(RMT_BLOCK_WORDS == SOC_RMT_MEM_WORDS_PER_CHANNEL, "RMT block size mismatch");
+_Static_assert(RMT_TX_BLOCKS <= SOC_RMT_TX_CANDIDATES_PER_GROUP, "More TX blocks than TX channels");
+
+// Positive signal on channel 0; negative on the channel after P's blocks.
+// Only changed with the channels claimed, so an ISR never sees it change.
+static dpt_rmt_layout_t layout = { .channel = { RMT_CHANNEL_0, RMT_CHANNEL_1 }, .blocks = { 1, 1 } };
+static rmt_channel_t tx_channel[DPT_NUM_CHANNELS] = { RMT_CHANNEL_0, RMT_CHANNEL_1 };
+static uint32_t layout_changes = 0;
+static const gpio_num_t tx_gpio[DPT_NUM_CHANNELS] = { RMT_TX_GPIO_P, RMT_TX_GPIO_N };
+static const uint8_t tx_idle_level[DPT_NUM_CHANNELS] = { DPT_IDLE_LEVEL_P, DPT_IDLE_LEVEL_N };
+
+static portMUX_TYPE start_mux = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t tx_done_sem = NULL;
+
+// What the RMT RAM currently holds
+static bool loaded_direct = false;           // Words are in RMT RAM
+static const dpt_plan_t *loaded_src = NULL;  //   copied from this plan
+static const dpt_plan_t *loaded_plan = NULL; // Plan to stream via the driver instead
+static uint32_t loaded_hash = 0;
+
+// Who may use the channels
+typedef enum {
+    OWNER_NONE = 0,
+    OWNER_TASK,         // Between dpt_rmt_claim() and dpt_rmt_release()
+    OWNER_ISR,          // Shot fired by dpt_rmt_fire_from_isr(), until TX end
+} rmt_owner_t;
+
+static portMUX_TYPE owner_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile rmt_owner_t owner = OWNER_NONE;
+static uint8_t isr_channels_left = 0;
+static const dpt_plan_t *isr_shot_plan = NULL;     // Plan of the shot an ISR fired
+static dpt_rmt_isr_done_t isr_done_cb = NULL;
+
+// ---------------------- Direct RAM Access ----------------------
+// Channel n's RAM starts n blocks into RMTMEM; extra blocks of a channel
+// are the following channels' blocks, so the range is contiguous.
+static void IRAM_ATTR write_channel_ram(rmt_channel_t channel, const uint32_t *words,
+                                        uint32_t offset, uint32_t count) {
+    volatile uint32_t *to = (volatile uint32_t *)&RMTMEM + channel * RMT_BLOCK_WORDS + offset;
+    while (count--) {
+        *to++ = *words++;
+    }
+}
+
+static void IRAM_ATTR start_channels(void) {
+    // Start both channels from the top of their RAM. The sync group starts
+    // them together; the critical section keeps the second start from
+    // being held up, which would delay both
+    portENTER_CRITICAL_SAFE(&start_mux);
+    rmt_tx_start(tx_channel[DPT_CHANNEL_P], true);
+    rmt_tx_start(tx_channel[DPT_CHANNEL_N], true);
+    portEXIT_CRITICAL_SAFE(&start_mux);
+}
+
+static void IRAM_ATTR tx_end_callback(rmt_channel_t channel, void *arg) {
+    dpt_trace_isr_enter(DPT_TRACE_ISR_RMT_DONE);
+    if (owner == OWNER_ISR) {
+        // Nobody waits for a shot fired from an ISR; free the channels once both are done
+        const dpt_plan_t *done = NULL;
+        portENTER_CRITICAL_ISR(&owner_mux);
+        if (--isr_channels_left == 0) {
+            owner = OWNER_NONE;
+            done = isr_shot_plan;
+        }
+        portEXIT_CRITICAL_ISR(&owner_mux);
+        bool woken = done != NULL && isr_done_cb != NULL && isr_done_cb(done);
+        dpt_trace_isr_exit();
+        if (woken) {
+            portYIELD_FROM_ISR();
+        }
+        return;
+    }
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    xSemaphoreGiveFromISR(tx_done_sem, &xHigherPriorityTaskWoken);
+    dpt_trace_isr_exit();
+    if (xHigherPriorityTaskWoken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+// ---------------------- Setup ----------------------
+void dpt_rmt_pins_safe(void) {
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        // Output register first, so enabling the output drives the idle level at once
+        gpio_set_level(tx_gpio[ch], tx_idle_level[ch]);
+    }
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << RMT_TX_GPIO_P) | (1ULL << RMT_TX_GPIO_N),
+        .mode = GPIO_MODE_INPUT_OUTPUT,     // Input on, so the pads can be read back
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    gpio_config(&io_conf);
+}
+
+// Freeze both pads at their current level, or let them follow their signal again
+static void hold_pins(bool hold) {
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        if (hold) {
+            gpio_hold_en(tx_gpio[ch]);
+        } else {
+            gpio_hold_dis(tx_gpio[ch]);
+        }
+    }
+}
+
+// Both channels in the current layout, pads held
+static esp_err_t setup_channels(void) {
+    // Configure positive channel
+    rmt_config_t rmt_tx_config_p = {
+        .rmt_mode = RMT_MODE_TX,
+        .channel = tx_channel[DPT_CHANNEL_P],
+        .gpio_num = RMT_TX_GPIO_P,
+        .clk_div = RMT_CLK_DIV,
+        .mem_block_num = layout.blocks[DPT_CHANNEL_P],
+        .tx_config = {
+            .loop_en = false,
+            .carrier_en = false,
+            .idle_output_en = true,
+            .idle_level = RMT_IDLE_LEVEL_LOW,
+        }
+    };
+
+    // Configure negative channel
+    rmt_config_t rmt_tx_config_n = {
+        .rmt_mode = RMT_MODE_TX,
+        .channel = tx_channel[DPT_CHANNEL_N],
+        .gpio_num = RMT_TX_GPIO_N,
+        .clk_div = RMT_CLK_DIV,
+        .mem_block_num = layout.blocks[DPT_CHANNEL_N],
+        .tx_config = {
+            .loop_en = false,
+            .carrier_en = false,
+            .idle_output_en = true,
+            .idle_level = RMT_IDLE_LEVEL_HIGH,  // Set idle level to high for negative channel
+        }
+    };
+
+    // Configure both channels
+    esp_err_t err = rmt_config(&rmt_tx_config_p);
+    if (err == ESP_OK) err = rmt_config(&rmt_tx_config_n);
+
+    // Install RMT driver
+    if (err == ESP_OK) err = rmt_driver_install(tx_channel[DPT_CHANNEL_P], 0, 0);
+    if (err == ESP_OK) err = rmt_driver_install(tx_channel[DPT_CHANNEL_N], 0, 0);
+
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    // Started channels wait for each other (RMT_TX_SIM_CONF)
+    if (err == ESP_OK) err = rmt_add_channel_to_group(tx_channel[DPT_CHANNEL_P]);
+    if (err == ESP_OK) err = rmt_add_channel_to_group(tx_channel[DPT_CHANNEL_N]);
+#endif
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "RMT channel setup failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+#if defined(__XTENSA__)
+    // Routing to the RMT turned the pad inputs off; the GPIO driver would
+    // route the pins back to GPIO to turn them on, so set the IO_MUX bit
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        gpio_ll_input_enable(&GPIO, tx_gpio[ch]);
+    }
+#endif
+    return ESP_OK;
+}
+
+esp_err_t dpt_rmt_init(void) {
+    const int8_t outputs[DPT_NUM_CHANNELS] = { RMT_TX_GPIO_P, RMT_TX_GPIO_N };
+    esp_err_t err = dpt_pins_claim_set(DPT_PIN_OUTPUT, outputs, DPT_NUM_CHANNELS);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // The pads sit at their idle levels (dpt_rmt_pins_safe()) until the channels drive them
+    hold_pins(true);
+    err = setup_channels();
+    hold_pins(false);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // One count per channel that finishes
+    tx_done_sem = xSemaphoreCreateCounting(DPT_NUM_CHANNELS, 0);
+    if (tx_done_sem == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    rmt_register_tx_end_callback(tx_end_callback, NULL);
+
+    ESP_LOGI(TAG, "RMT TX channels configured successfully");
+    return ESP_OK;
+}
+
+// Tear down the channels of the current layout and set up those of next
+static esp_err_t apply_layout(const dpt_rmt_layout_t *next) {
+    hold_pins(true);
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+        rmt_remove_channel_from_group(tx_channel[ch]);
+#endif
+        rmt_driver_uninstall(tx_channel[ch]);
+    }
+    // Whatever the RAM held is no longer trusted
+    loaded_direct = false;
+    loaded_src = NULL;
+    loaded_plan = NULL;
+    layout = *next;
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        tx_channel[ch] = (rmt_channel_t)layout.channel[ch];
+    }
+    esp_err_t err = setup_channels();
+    hold_pins(false);
+    if (err != ESP_OK) {
+        // No valid layout has a zero block count, so the next load sets up again
+        memset(&layout, 0, sizeof(layout));
+    }
+    return err;
+}
+
+esp_err_t dpt_rmt_reconfigure(void) {
+    if (owner != OWNER_TASK) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    dpt_rmt_layout_t same = layout;
+    return apply_layout(&same);
+}
+
+static uint8_t blocks_for(uint16_t words) {
+    uint8_t blocks = (words + RMT_BLOCK_WORDS - 1) / RMT_BLOCK_WORDS;
+    return blocks ? blocks : 1;
+}
+
+void dpt_rmt_layout_for(const dpt_plan_t *plan, dpt_rmt_layout_t *out) {
+    uint8_t p = blocks_for(plan->num_words[DPT_CHANNEL_P]);
+    uint8_t n = blocks_for(plan->num_words[DPT_CHANNEL_N]);
+    if (p + n > RMT_TX_BLOCKS) {
+        // Driver refill either way; half the RAM each means the fewest refills
+        p = n = RMT_TX_BLOCKS / DPT_NUM_CHANNELS;
+    }
+    out->channel[DPT_CHANNEL_P] = RMT_CHANNEL_0;
+    out->channel[DPT_CHANNEL_N] = RMT_CHANNEL_0 + p;
+    out->blocks[DPT_CHANNEL_P] = p;
+    out->blocks[DPT_CHANNEL_N] = n;
+}
+
+void dpt_rmt_get_layout(dpt_rmt_layout_t *out, uint32_t *changes) {
+    *out = layout;
+    *changes = layout_changes;
+}
+
+// ---------------------- Ownership ----------------------
+esp_err_t dpt_rmt_claim(uint32_t timeout_ms) {
+    TickType_t start = xTaskGetTickCount();
+    while (1) {
+        portENTER_CRITICAL(&owner_mux);
+        bool free = owner == OWNER_NONE;
+        if (free) {
+            owner = OWNER_TASK;
+        }
+        portEXIT_CRITICAL(&owner_mux);
+        if (free) {
+            return ESP_OK;
+        }
+        // Only a shot fired from an ISR can hold it; it ends on its own
+        if (xTaskGetTickCount() - start >= pdMS_TO_TICKS(timeout_ms)) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(1);
+    }
+}
+
+void dpt_rmt_release(void) {
+    portENTER_CRITICAL(&owner_mux);
+    if (owner == OWNER_TASK) {
+        owner = OWNER_NONE;
+    }
+    portEXIT_CRITICAL(&owner_mux);
+}
+
+bool dpt_rmt_fits(const dpt_plan_t *plan) {
+    return plan->num_words[DPT_CHANNEL_P] <= RMT_BLOCK_WORDS && plan->num_words[DPT_CHANNEL_N] <= RMT_BLOCK_WORDS;
+}
+
+esp_err_t IRAM_ATTR dpt_rmt_fire_from_isr(const dpt_plan_t *plan) {
+    portENTER_CRITICAL_ISR(&owner_mux);
+    if (owner != OWNER_NONE) {
+        portEXIT_CRITICAL_ISR(&owner_mux);
+        return ESP_ERR_INVALID_STATE;
+    }
+    owner = OWNER_ISR;
+    isr_channels_left = DPT_NUM_CHANNELS;
+    isr_shot_plan = plan;
+    portEXIT_CRITICAL_ISR(&owner_mux);
+
+    if (!(loaded_direct && loaded_src == plan && loaded_hash == plan->hash)) {
+        for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+            write_channel_ram(tx_channel[ch], plan->words[ch], 0, plan->num_words[ch]);
+        }
+        loaded_direct = true;
+        loaded_src = plan;
+        loaded_plan = NULL;
+        loaded_hash = plan->hash;
+    }
+    start_channels();
+    return ESP_OK;
+}
+
+void dpt_rmt_set_isr_done(dpt_rmt_isr_done_t cb) {
+    isr_done_cb = cb;
+}
+
+// ---------------------- Load / Start ----------------------
+esp_err_t dpt_rmt_load(const dpt_plan_t *plan, bool partial) {
+    if (owner != OWNER_TASK) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    dpt_rmt_layout_t next;
+    dpt_rmt_layout_for(plan, &next);
+    if (memcmp(&next, &layout, sizeof(layout)) != 0) {
+        esp_err_t err = apply_layout(&next);
+        if (err != ESP_OK) {
+            return err;
+        }
+        layout_changes++;
+        ESP_LOGI(TAG, "RMT layout: P on channel %u with %u block(s), N on channel %u with %u block(s)",
+                 layout.channel[DPT_CHANNEL_P], layout.blocks[DPT_CHANNEL_P],
+                 layout.channel[DPT_CHANNEL_N], layout.blocks[DPT_CHANNEL_N]);
+    }
+
+    if (plan->num_words[DPT_CHANNEL_P] > layout.blocks[DPT_CHANNEL_P] * RMT_BLOCK_WORDS ||
+        plan->num_words[DPT_CHANNEL_N] > layout.blocks[DPT_CHANNEL_N] * RMT_BLOCK_WORDS) {
+        // Too long for the RAM blocks; the driver refills from the plan on start
+        loaded_direct = false;
+        loaded_src = NULL;
+        loaded_plan = plan;
+        loaded_hash = plan->hash;
+        return ESP_OK;
+    }
+
+    // A partial copy is only valid onto this plan's own earlier words
+    if (partial && loaded_direct && loaded_src == plan) {
+        if (plan->dirty_first <= plan->dirty_last) {
+            for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+                write_channel_ram(tx_channel[ch], &plan->words[ch][plan->dirty_first], plan->dirty_first,
+                                  plan->dirty_last - plan->dirty_first + 1);
+            }
+        }
+    } else {
+        for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+            write_channel_ram(tx_channel[ch], plan->words[ch], 0, plan->num_words[ch]);
+        }
+    }
+    loaded_direct = true;
+    loaded_src = plan;
+    loaded_plan = NULL;
+    loaded_hash = plan->hash;
+    return ESP_OK;
+}
+
+bool dpt_rmt_is_loaded(uint32_t hash) {
+    return (loaded_direct || loaded_plan != NULL) && loaded_hash == hash;
+}
+
+esp_err_t dpt_rmt_start(void) {
+    if (owner != OWNER_TASK) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (loaded_direct) {
+        start_channels();
+        return ESP_OK;
+    }
+    if (loaded_plan == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Refill path: the driver copies into (and overwrites) the RMT RAM
+    const dpt_plan_t *plan = loaded_plan;
+    ESP_LOGW(TAG, "Plan needs %u/%u words, more than the %d TX blocks hold; using driver refill",
+             plan->num_words[DPT_CHANNEL_P], plan->num_words[DPT_CHANNEL_N], RMT_TX_BLOCKS);
+    esp_err_t err = rmt_write_items(tx_channel[DPT_CHANNEL_P], (const rmt_item32_t *)plan->words[DPT_CHANNEL_P],
+                                    plan->num_words[DPT_CHANNEL_P], false);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = rmt_write_items(tx_channel[DPT_CHANNEL_N], (const rmt_item32_t *)plan->words[DPT_CHANNEL_N],
+                          plan->num_words[DPT_CHANNEL_N], false);
+    if (err != ESP_OK) {
+        // P waits in the sync group for N; do not leave it pending
+        rmt_tx_stop(tx_channel[DPT_CHANNEL_P]);
+    }
+    return err;
+}
+
+esp_err_t dpt_rmt_wait_done(uint32_t timeout_ms) {
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        if (xSemaphoreTake(tx_done_sem, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    return ESP_OK;
+}
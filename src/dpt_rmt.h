@@ -0,0 +1,160 @@
+/**
+ * @file dpt_rmt.h
+ * @brief RMT output backend for the DPT signal generator
+ *
+ * Loading and starting are separate steps: a compiled plan is copied
+ * straight into each channel's RMT RAM block ahead of time, and a trigger
+ * only has to start both channels.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "dpt_plan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ---------------------- RMT Configuration ----------------------
+#define RMT_TX_GPIO_P       7                // Positive signal GPIO
+#define RMT_TX_GPIO_N       8                // Negative signal GPIO
+#define RMT_CLK_DIV         1                // 80MHz / 1 = 80MHz, 1 tick = 12.5ns
+#define RMT_BLOCK_WORDS     48               // Item words per RMT RAM block (ESP32-S3)
+#define RMT_TX_BLOCKS       4                // RAM blocks shared by TX channels 0-3
+
+// Which RMT channel drives each output and how many RAM blocks it owns.
+// A channel with several blocks takes the following channels' blocks,
+// so N sits on the first channel after P's blocks.
+typedef struct {
+    uint8_t channel[DPT_NUM_CHANNELS];
+    uint8_t blocks[DPT_NUM_CHANNELS];
+} dpt_rmt_layout_t;
+
+/**
+ * @brief Drive both output pins to their idle levels as plain GPIOs
+ *
+ * Call first thing in app_main(); the pins float from reset until then,
+ * unless the bootloader hook already drove them. Glitch-free if the pins
+ * already sit at their idle levels.
+ */
+void dpt_rmt_pins_safe(void);
+
+/**
+ * @brief Configure both TX channels and install the driver
+ *
+ * Call dpt_rmt_pins_safe() first. The pins are held at their idle levels
+ * until the channels drive them.
+ */
+esp_err_t dpt_rmt_init(void);
+
+/**
+ * @brief Tear both channels down and set them up again
+ *
+ * For clock changes; dpt_rmt_load() changes the memory layout by itself.
+ * The pins are held at their current
+ * (idle) levels throughout, so the outputs see no edge. The plan has to
+ * be loaded again afterwards. Needs the channels claimed.
+ */
+esp_err_t dpt_rmt_reconfigure(void);
+
+/**
+ * @brief Take the channels for loading or a shot
+ *
+ * Waits while a shot fired from an ISR is in progress. dpt_rmt_load(),
+ * dpt_rmt_start() and dpt_rmt_reconfigure() fail with
+ * ESP_ERR_INVALID_STATE unless the calling task holds the claim, and
+ * trigger ISRs cannot fire while it does. Not recursive.
+ *
+ * @return ESP_ERR_TIMEOUT if the channels did not come free in time
+ */
+esp_err_t dpt_rmt_claim(uint32_t timeout_ms);
+
+/**
+ * @brief Give the channels back, after dpt_rmt_wait_done() for a shot
+ */
+void dpt_rmt_release(void);
+
+/**
+ * @brief true if a plan loads straight into RMT RAM under any layout
+ *
+ * That is one block per channel; plans fired from an ISR must fit.
+ */
+bool dpt_rmt_fits(const dpt_plan_t *plan);
+
+/**
+ * @brief Layout dpt_rmt_load() uses for a plan
+ *
+ * Each channel gets the blocks its words need. If both together need
+ * more than RMT_TX_BLOCKS, the plan goes through driver refill and the
+ * blocks are split evenly.
+ */
+void dpt_rmt_layout_for(const dpt_plan_t *plan, dpt_rmt_layout_t *out);
+
+/**
+ * @brief Current layout, and how often loads have changed it
+ */
+void dpt_rmt_get_layout(dpt_rmt_layout_t *out, uint32_t *changes);
+
+/**
+ * @brief Load and start a plan from an ISR, without waking any task
+ *
+ * The plan must fit the RMT RAM (dpt_rmt_fits()) and stay unchanged
+ * while it may be fired. Its words are only copied if the RAM holds
+ * something else. The channels stay taken until both report TX end;
+ * dpt_rmt_wait_done() does not see these shots; the dpt_rmt_set_isr_done()
+ * callback does.
+ *
+ * @return ESP_ERR_INVALID_STATE if a task holds the channels or a shot
+ *         is in progress; nothing is sent then
+ */
+esp_err_t dpt_rmt_fire_from_isr(const dpt_plan_t *plan);
+
+// Runs in the TX end interrupt when a shot fired by dpt_rmt_fire_from_isr()
+// has finished on both channels; returns true if it woke a higher-priority task
+typedef bool (*dpt_rmt_isr_done_t)(const dpt_plan_t *plan);
+
+/**
+ * @brief Set the one callback told about finished ISR shots; must be in IRAM
+ */
+void dpt_rmt_set_isr_done(dpt_rmt_isr_done_t cb);
+
+/**
+ * @brief Copy a plan's item words into the channels' RMT RAM
+ *
+ * With partial set, only plan->dirty_first..dirty_last is copied; this is
+ * only valid right after dpt_plan_update() patched the plan that is
+ * already loaded. If the plan needs another layout (dpt_rmt_layout_for()),
+ * the channels are reconfigured first, with the pads held. Plans that do
+ * not fit the RAM blocks are remembered and sent through the driver's
+ * refill path on start instead.
+ * Needs the channels claimed; not while a transmission is in progress.
+ *
+ * @return The driver's error if setting up the new layout failed; the
+ *         next load sets it up again
+ */
+esp_err_t dpt_rmt_load(const dpt_plan_t *plan, bool partial);
+
+/**
+ * @brief true if the channels' RMT RAM holds the plan with this hash
+ */
+bool dpt_rmt_is_loaded(uint32_t hash);
+
+/**
+ * @brief Start both channels on the loaded plan
+ *
+ * @return ESP_ERR_INVALID_STATE if nothing is loaded, or the driver's
+ *         error if it refused a refill plan; nothing is sent then
+ */
+esp_err_t dpt_rmt_start(void);
+
+/**
+ * @brief Wait until both channels have finished transmitting
+ */
+esp_err_t dpt_rmt_wait_done(uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,101 @@
+/**
+ * @file dpt_shotlog.c
+ * @brief Records of the most recent shots
+ *
+ * Records are opened and closed with the RMT claimed, so one open record and one pair
+ * of interrupt snapshots are enough. Readers copy records under a short
+ * critical section.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "dpt_shotlog.h"
+
+static dpt_shot_record_t records[DPT_SHOTLOG_DEPTH];
+static uint32_t num_records = 0;
+static portMUX_TYPE records_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static dpt_shot_record_t open_record;
+static int64_t started_us;
+static dpt_isrstat_snapshot_t isr_before;
+static dpt_isrstat_snapshot_t isr_after;
+
+void dpt_shotlog_begin(void) {
+    memset(&open_record, 0, sizeof(open_record));
+    open_record.core = xPortGetCoreID();
+    open_record.batch_dut = -1;
+    dpt_isrstat_snapshot(&isr_before);
+    open_record.begin_us = esp_timer_get_time();
+    started_us = 0;
+}
+
+void dpt_shotlog_bus_wait(uint32_t wait_us, float vbus_v) {
+    open_record.bus_wait_us = wait_us;
+    open_record.vbus_v = vbus_v;
+}
+
+void dpt_shotlog_batch(int dut, int recipe, bool pass) {
+    open_record.batch_dut = dut;
+    open_record.batch_recipe = recipe;
+    open_record.batch_pass = pass;
+}
+
+void dpt_shotlog_started(void) {
+    started_us = esp_timer_get_time();
+}
+
+// Keep the DPT_SHOTLOG_MAX_ISRS heaviest interrupts, by cycles
+static void add_isr(dpt_shot_record_t *rec, uint8_t core, uint8_t cpu_int, uint32_t count, uint32_t cycles) {
+    int pos = rec->num_isrs;
+    while (pos > 0 && rec->isrs[pos - 1].cycles < cycles) {
+        pos--;
+    }
+    if (pos >= DPT_SHOTLOG_MAX_ISRS) {
+        return;
+    }
+    int last = rec->num_isrs < DPT_SHOTLOG_MAX_ISRS ? rec->num_isrs : DPT_SHOTLOG_MAX_ISRS - 1;
+    memmove(&rec->isrs[pos + 1], &rec->isrs[pos], (last - pos) * sizeof(rec->isrs[0]));
+    rec->isrs[pos] = (dpt_shot_isr_t){ .core = core, .cpu_int = cpu_int, .count = count, .cycles = cycles };
+    if (rec->num_isrs < DPT_SHOTLOG_MAX_ISRS) {
+        rec->num_isrs++;
+    }
+}
+
+void dpt_shotlog_end(uint32_t shot, uint32_t hash, bool completed) {
+    int64_t end_us = esp_timer_get_time();
+    dpt_isrstat_snapshot(&isr_after);
+
+    dpt_shot_record_t *rec = &open_record;
+    rec->shot = shot;
+    rec->hash = hash;
+    rec->completed = completed;
+    if (started_us != 0) {
+        rec->start_latency_us = (uint32_t)(started_us - rec->begin_us);
+        rec->duration_us = (uint32_t)(end_us - started_us);
+    }
+    for (int core = 0; core < DPT_ISRSTAT_CORES; core++) {
+        for (int n = 0; n < DPT_ISRSTAT_CPU_INTS; n++) {
+            uint32_t count = isr_after.count[core][n] - isr_before.count[core][n];
+            if (count > 0) {
+                add_isr(rec, core, n, count, isr_after.cycles[core][n] - isr_before.cycles[core][n]);
+            }
+        }
+    }
+
+    portENTER_CRITICAL(&records_mux);
+    records[num_records % DPT_SHOTLOG_DEPTH] = *rec;
+    num_records++;
+    portEXIT_CRITICAL(&records_mux);
+}
+
+bool dpt_shotlog_get(uint32_t index, dpt_shot_record_t *out) {
+    bool found = false;
+    portENTER_CRITICAL(&records_mux);
+    if (index < num_records && index < DPT_SHOTLOG_DEPTH) {
+        *out = records[(num_records - 1 - index) % DPT_SHOTLOG_DEPTH];
+        found = true;
+    }
+    portEXIT_CRITICAL(&records_mux);
+    return found;
+}
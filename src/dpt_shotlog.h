@@ -0,0 +1,84 @@
+/**
+ * @file dpt_shotlog.h
+ * @brief Records of the most recent shots
+ *
+ * send_double_pulse() and the batch runner (src/dpt_batch.h) open a
+ * record when the shot begins and close it when the RMT reports the end
+ * of the transmission. A record holds the
+ * shot's timing and the interrupts that ran on either core in between,
+ * heaviest first.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dpt_isrstat.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DPT_SHOTLOG_DEPTH       16      // Records kept
+#define DPT_SHOTLOG_MAX_ISRS    8       // Interrupt entries per record
+
+typedef struct {
+    uint8_t core;
+    uint8_t cpu_int;
+    uint16_t reserved;
+    uint32_t count;
+    uint32_t cycles;
+} dpt_shot_isr_t;
+
+typedef struct {
+    uint32_t shot;              // 1-based shot number; batch shots count within their batch
+    uint32_t hash;              // Plan that was sent
+    int64_t begin_us;           // esp_timer time the shot began
+    uint32_t start_latency_us;  // Begin to both channels started
+    uint32_t duration_us;       // Channels started to TX end
+    uint32_t bus_wait_us;       // Held before the shot began by the bus interlock; 0 with it disabled
+    float vbus_v;               // Bus voltage the interlock released at, 0 if it was off
+    uint8_t core;               // Core the shot ran on
+    bool completed;             // false if the RMT timed out
+    int8_t batch_dut;           // Matrix position of a batch shot, -1 otherwise
+    uint8_t batch_recipe;       // Index in the batch's recipe list
+    bool batch_pass;            // The shot's metrics were within the batch limits
+    uint8_t num_isrs;
+    dpt_shot_isr_t isrs[DPT_SHOTLOG_MAX_ISRS];
+} dpt_shot_record_t;
+
+/**
+ * @brief Open a record; snapshots the interrupt counters
+ */
+void dpt_shotlog_begin(void);
+
+/**
+ * @brief Note how long the shot was held before it began
+ */
+void dpt_shotlog_bus_wait(uint32_t wait_us, float vbus_v);
+
+/**
+ * @brief Mark the shot as part of a batch
+ */
+void dpt_shotlog_batch(int dut, int recipe, bool pass);
+
+/**
+ * @brief Both channels have been started
+ */
+void dpt_shotlog_started(void);
+
+/**
+ * @brief Close the record opened by dpt_shotlog_begin()
+ */
+void dpt_shotlog_end(uint32_t shot, uint32_t hash, bool completed);
+
+/**
+ * @brief Copy a record; index 0 is the most recent shot
+ *
+ * Returns false if fewer than index + 1 shots have been recorded.
+ */
+bool dpt_shotlog_get(uint32_t index, dpt_shot_record_t *out);
+
+#ifdef __cplusplus
+}
+#endif
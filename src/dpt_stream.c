@@ -0,0 +1,92 @@
+/**
+ * @file dpt_stream.c
+ * @brief Chunked HTTP downloads with throughput accounting
+ *
+ * Downloads run in the web server task only, one at a time, so the
+ * totals need no lock beyond a short critical section for readers.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "dpt_stream.h"
+
+#define TAG "DPT_STREAM"
+
+static dpt_stream_stats_t stats[DPT_STREAM_KINDS] = {
+    [DPT_STREAM_TRACE] = { .name = "trace" },
+    [DPT_STREAM_SHOTS] = { .name = "shots" },
+    [DPT_STREAM_PLAN] = { .name = "plan" },
+    [DPT_STREAM_LOGIC] = { .name = "logic" },
+};
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void dpt_stream_begin(dpt_stream_t *s, httpd_req_t *req, dpt_stream_kind_t kind) {
+    memset(s, 0, sizeof(*s));
+    s->req = req;
+    s->kind = kind;
+    s->start_us = esp_timer_get_time();
+}
+
+esp_err_t dpt_stream_write(void *ctx, const void *data, size_t len) {
+    dpt_stream_t *s = ctx;
+    const char *p = data;
+    while (len > 0 && s->err == ESP_OK) {
+        size_t n = len < DPT_STREAM_MAX_CHUNK ? len : DPT_STREAM_MAX_CHUNK;
+        int64_t t0 = esp_timer_get_time();
+        s->err = httpd_resp_send_chunk(s->req, p, n);
+        uint32_t send_us = (uint32_t)(esp_timer_get_time() - t0);
+        if (send_us > s->max_send_us) {
+            s->max_send_us = send_us;
+        }
+        if (s->err == ESP_OK) {
+            s->bytes += n;
+        }
+        p += n;
+        len -= n;
+    }
+    return s->err;
+}
+
+esp_err_t dpt_stream_end(dpt_stream_t *s) {
+    if (s->err == ESP_OK) {
+        s->err = httpd_resp_send_chunk(s->req, NULL, 0);
+    }
+    uint32_t us = (uint32_t)(esp_timer_get_time() - s->start_us);
+    uint32_t rate = us > 0 ? (uint32_t)((uint64_t)s->bytes * 1000000 / us) : 0;
+
+    portENTER_CRITICAL(&stats_mux);
+    dpt_stream_stats_t *st = &stats[s->kind];
+    st->downloads++;
+    st->bytes += s->bytes;
+    if (s->err != ESP_OK) {
+        st->failed++;
+    } else {
+        st->last_bytes = s->bytes;
+        st->last_us = us;
+        st->last_bytes_per_s = rate;
+        if (rate > st->best_bytes_per_s) st->best_bytes_per_s = rate;
+    }
+    if (s->max_send_us > st->max_send_us) st->max_send_us = s->max_send_us;
+    portEXIT_CRITICAL(&stats_mux);
+
+    if (s->err != ESP_OK) {
+        ESP_LOGW(TAG, "%s download aborted after %" PRIu32 " bytes: %s", st->name, s->bytes, esp_err_to_name(s->err));
+    } else {
+        ESP_LOGI(TAG, "%s download: %" PRIu32 " bytes in %" PRIu32 " us (%" PRIu32 " B/s), longest send %" PRIu32 " us",
+                 st->name, s->bytes, us, rate, s->max_send_us);
+    }
+    return s->err;
+}
+
+bool dpt_stream_get_stats(int kind, dpt_stream_stats_t *out) {
+    if (kind < 0 || kind >= DPT_STREAM_KINDS) {
+        return false;
+    }
+    portENTER_CRITICAL(&stats_mux);
+    *out = stats[kind];
+    portEXIT_CRITICAL(&stats_mux);
+    return true;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file dpt_stream.h
+ * @brief Chunked HTTP downloads with throughput accounting
+ *
+ * A download is a series of dpt_stream_write() calls that go straight to
+ * httpd_resp_send_chunk() from the caller's buffer - for the trace, the
+ * ring itself - so no download builds its response in RAM first. Each
+ * send returns once lwIP has taken the data; over a slow link that is
+ * where a download waits, so callers must not hold the plan mutex or the
+ * RMT claim while they stream. Per download type the module keeps the
+ * bytes sent, the time taken and the longest single send.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DPT_STREAM_MAX_CHUNK    4096    // Larger writes go out in pieces of this size
+
+typedef enum {
+    DPT_STREAM_TRACE,
+    DPT_STREAM_SHOTS,
+    DPT_STREAM_PLAN,
+    DPT_STREAM_LOGIC,
+    DPT_STREAM_KINDS,
+} dpt_stream_kind_t;
+
+typedef struct {
+    httpd_req_t *req;
+    dpt_stream_kind_t kind;
+    int64_t start_us;
+    uint32_t bytes;
+    uint32_t max_send_us;
+    esp_err_t err;              // First failed send; later writes are dropped
+} dpt_stream_t;
+
+typedef struct {
+    const char *name;
+    uint32_t downloads;
+    uint32_t failed;            // Client went away or a send timed out
+    uint64_t bytes;
+    uint32_t last_bytes;
+    uint32_t last_us;
+    uint32_t last_bytes_per_s;
+    uint32_t best_bytes_per_s;
+    uint32_t max_send_us;       // Longest single send: how far the link pushed back
+} dpt_stream_stats_t;
+
+/**
+ * @brief Start a download; set the content type first
+ */
+void dpt_stream_begin(dpt_stream_t *s, httpd_req_t *req, dpt_stream_kind_t kind);
+
+/**
+ * @brief Send data as it is; ctx is the dpt_stream_t
+ *
+ * Matches the writer callback of dpt_trace_dump().
+ */
+esp_err_t dpt_stream_write(void *ctx, const void *data, size_t len);
+
+/**
+ * @brief Finish the response and record the download
+ */
+esp_err_t dpt_stream_end(dpt_stream_t *s);
+
+/**
+ * @brief Totals of one download type; false past the last type
+ */
+bool dpt_stream_get_stats(int kind, dpt_stream_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,267 @@
+/**
+ * @file dpt_sweep.c
+ * @brief Parameter sweeps with compile and fire overlapped on both cores
+ *
+ * ring_head counts plans the producer has compiled and ring_tail plans
+ * the executor has fired; each is written by one task only. The producer
+ * publishes a slot with a release store of ring_head after filling it,
+ * and the executor frees it with a release store of ring_tail after
+ * firing it, so neither side ever sees a half-written slot. The binary
+ * semaphores only wake a waiting side; every wakeup re-checks the
+ * indices, so a stale give costs one extra check.
+ */
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "dpt_plan.h"
+#include "dpt_rmt.h"
+#include "dpt_sweep.h"
+#include "dpt_delay.h"
+#include "dpt_interlock.h"
+#include "dpt_pace.h"
+#include "dpt_thermal.h"
+
+#define TAG "DPT_SWEEP"
+
+#define PRODUCER_CORE       0       // Shares the core with WiFi; compiling can wait
+#define EXECUTOR_CORE       1
+#define PRODUCER_PRIORITY   5
+#define EXECUTOR_PRIORITY   12      // Above the button and web server tasks
+#define RING_MASK           (DPT_SWEEP_RING_SLOTS - 1)
+#define CLAIM_TIMEOUT_MS    1000
+
+_Static_assert((DPT_SWEEP_RING_SLOTS & RING_MASK) == 0, "Ring size must be a power of two");
+
+static dpt_plan_t ring[DPT_SWEEP_RING_SLOTS];
+static esp_err_t ring_err[DPT_SWEEP_RING_SLOTS];    // Compile result of each slot
+static atomic_uint ring_head;       // Written by the producer only
+static atomic_uint ring_tail;       // Written by the executor only
+
+static SemaphoreHandle_t ring_space;        // Executor freed a slot
+static SemaphoreHandle_t ring_data;         // Producer filled a slot
+static SemaphoreHandle_t producer_go;
+static SemaphoreHandle_t executor_go;
+static SemaphoreHandle_t producer_done;
+
+static dpt_sweep_config_t config;
+static volatile bool stop_requested;
+static dpt_sweep_stats_t stats;
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// ---------------------- Producer (core 0) ----------------------
+static float point_value(uint32_t k) {
+    return config.start_us + k * config.step_us;
+}
+
+static esp_err_t compile_point(dpt_plan_t *plan, uint16_t k) {
+    static dpt_recipe_t recipe;     // Producer only; too large for its stack
+    float v[4] = { config.p1h, config.p1l, config.p2h, config.p2l };
+    v[config.param] = point_value(k);
+    dpt_recipe_double_pulse(&recipe, v[0], v[1], v[2], v[3]);
+    return dpt_plan_compile(plan, &recipe);
+}
+
+static void producer_task(void *arg) {
+    while (1) {
+        xSemaphoreTake(producer_go, portMAX_DELAY);
+        for (uint16_t k = 0; k < config.points && !stop_requested; k++) {
+            unsigned head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+            bool waited = false;
+            while (head - atomic_load_explicit(&ring_tail, memory_order_acquire) >= DPT_SWEEP_RING_SLOTS &&
+                   !stop_requested) {
+                waited = true;
+                xSemaphoreTake(ring_space, portMAX_DELAY);
+            }
+            if (stop_requested) {
+                break;
+            }
+
+            int64_t t0 = esp_timer_get_time();
+            ring_err[head & RING_MASK] = compile_point(&ring[head & RING_MASK], k);
+            uint32_t compile_us = (uint32_t)(esp_timer_get_time() - t0);
+            uint16_t depth = head + 1 - atomic_load_explicit(&ring_tail, memory_order_relaxed);
+
+            portENTER_CRITICAL(&stats_mux);
+            stats.compiled++;
+            stats.producer_waits += waited;
+            stats.compile_us_total += compile_us;
+            if (compile_us > stats.compile_us_max) stats.compile_us_max = compile_us;
+            if (depth > stats.ring_max) stats.ring_max = depth;
+            portEXIT_CRITICAL(&stats_mux);
+
+            atomic_store_explicit(&ring_head, head + 1, memory_order_release);
+            xSemaphoreGive(ring_data);
+        }
+        xSemaphoreGive(producer_done);
+    }
+}
+
+// ---------------------- Executor (core 1) ----------------------
+static esp_err_t fire(const dpt_plan_t *plan) {
+    uint32_t timeout_ms = (uint32_t)(dpt_plan_total_ticks(plan) / (DPT_TICKS_PER_US * 1000)) + 100;
+    esp_err_t err = dpt_rmt_claim(CLAIM_TIMEOUT_MS);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = dpt_rmt_load(plan, false);
+    dpt_delay_begin();
+    if (err == ESP_OK) err = dpt_rmt_start();
+    if (err == ESP_OK) err = dpt_rmt_wait_done(timeout_ms);
+    if (err == ESP_OK) dpt_delay_end(plan);
+    dpt_rmt_release();
+    return err;
+}
+
+static void executor_task(void *arg) {
+    while (1) {
+        xSemaphoreTake(executor_go, portMAX_DELAY);
+        int64_t sweep_start_us = esp_timer_get_time();
+        int64_t last_start_us = 0;
+        for (uint16_t k = 0; k < config.points && !stop_requested; k++) {
+            unsigned tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+            int64_t wait_start_us = esp_timer_get_time();
+            bool waited = false;
+            while (atomic_load_explicit(&ring_head, memory_order_acquire) == tail && !stop_requested) {
+                waited = true;
+                xSemaphoreTake(ring_data, portMAX_DELAY);
+            }
+            if (stop_requested) {
+                break;
+            }
+            uint32_t wait_us = (uint32_t)(esp_timer_get_time() - wait_start_us);
+
+            if (k > 0 && config.interval_ms > 0) {
+                dpt_pace(last_start_us, config.interval_ms);
+            }
+            // The interval is a floor; the bus or the DUT may need longer to recover
+            dpt_interlock_wait_t bus;
+            dpt_thermal_load_t load;
+            esp_err_t err = ring_err[tail & RING_MASK];
+            if (err == ESP_OK) {
+                err = dpt_interlock_wait(&bus);
+            }
+            if (err == ESP_OK) {
+                dpt_thermal_load_of(&ring[tail & RING_MASK], &load);
+                err = dpt_thermal_wait(&load, NULL);
+            }
+            last_start_us = esp_timer_get_time();
+            if (err == ESP_OK) {
+                err = fire(&ring[tail & RING_MASK]);
+            }
+            if (err == ESP_OK) {
+                dpt_thermal_shot(&load);
+            }
+            uint32_t shot_us = (uint32_t)(esp_timer_get_time() - last_start_us);
+            if (err != ESP_OK) {
+                ESP_LOGW(TAG, "Point %u not fired: %s", k, esp_err_to_name(err));
+            }
+
+            portENTER_CRITICAL(&stats_mux);
+            // The first point always waits for the first compile; that is the pipeline filling
+            if (waited && k > 0) {
+                stats.executor_waits++;
+                stats.executor_wait_us += wait_us;
+            }
+            if (err == ESP_OK) {
+                stats.fired++;
+                stats.shot_us_total += shot_us;
+                if (shot_us > stats.shot_us_max) stats.shot_us_max = shot_us;
+            } else {
+                stats.failed++;
+                stats.last_error = err;
+            }
+            if (ring_err[tail & RING_MASK] == ESP_OK) {
+                stats.bus_wait_us_total += bus.wait_us;
+                if (bus.wait_us > stats.bus_wait_us_max) stats.bus_wait_us_max = bus.wait_us;
+            }
+            stats.elapsed_us = esp_timer_get_time() - sweep_start_us;
+            portEXIT_CRITICAL(&stats_mux);
+
+            atomic_store_explicit(&ring_tail, tail + 1, memory_order_release);
+            xSemaphoreGive(ring_space);
+        }
+
+        // Wake the producer if it waits for space, and let it finish
+        stop_requested = true;
+        xSemaphoreGive(ring_space);
+        xSemaphoreTake(producer_done, portMAX_DELAY);
+        portENTER_CRITICAL(&stats_mux);
+        stats.running = false;
+        portEXIT_CRITICAL(&stats_mux);
+        ESP_LOGI(TAG, "Sweep done: %u/%u fired in %" PRId64 " us, executor waited %" PRIu32 " time(s), producer %" PRIu32,
+                 stats.fired, stats.points, stats.elapsed_us, stats.executor_waits, stats.producer_waits);
+    }
+}
+
+// ---------------------- Control ----------------------
+esp_err_t dpt_sweep_init(void) {
+    ring_space = xSemaphoreCreateBinary();
+    ring_data = xSemaphoreCreateBinary();
+    producer_go = xSemaphoreCreateBinary();
+    executor_go = xSemaphoreCreateBinary();
+    producer_done = xSemaphoreCreateBinary();
+    if (!ring_space || !ring_data || !producer_go || !executor_go || !producer_done) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreatePinnedToCore(producer_task, "sweep_compile", 4096, NULL, PRODUCER_PRIORITY, NULL,
+                                PRODUCER_CORE) != pdPASS ||
+        xTaskCreatePinnedToCore(executor_task, "sweep_fire", 4096, NULL, EXECUTOR_PRIORITY, NULL,
+                                EXECUTOR_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static bool valid_time(float us) {
+    return us >= 0.0125f && us <= 65535.0f;
+}
+
+esp_err_t dpt_sweep_start(const dpt_sweep_config_t *new_config) {
+    if (new_config->points < 1 || new_config->points > DPT_SWEEP_MAX_POINTS ||
+        new_config->param > DPT_SWEEP_P2L ||
+        !valid_time(new_config->start_us) ||
+        !valid_time(new_config->start_us + (new_config->points - 1) * new_config->step_us)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&stats_mux);
+    bool busy = stats.running;
+    if (!busy) {
+        memset(&stats, 0, sizeof(stats));
+        stats.running = true;
+        stats.points = new_config->points;
+    }
+    portEXIT_CRITICAL(&stats_mux);
+    if (busy) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Both tasks are idle: nothing reads the config or the ring now
+    config = *new_config;
+    atomic_store(&ring_head, 0);
+    atomic_store(&ring_tail, 0);
+    stop_requested = false;
+    xSemaphoreGive(producer_go);
+    xSemaphoreGive(executor_go);
+    ESP_LOGI(TAG, "Sweep started: %u point(s) from %.3f μs in steps of %.3f μs, interval %" PRIu32 " ms",
+             config.points, config.start_us, config.step_us, config.interval_ms);
+    return ESP_OK;
+}
+
+void dpt_sweep_stop(void) {
+    stop_requested = true;
+    xSemaphoreGive(ring_space);
+    xSemaphoreGive(ring_data);
+}
+
+void dpt_sweep_get_stats(dpt_sweep_stats_t *out) {
+    portENTER_CRITICAL(&stats_mux);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_mux);
+}
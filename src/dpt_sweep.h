@@ -0,0 +1,89 @@
+/**
+ * @file dpt_sweep.h
+ * @brief Parameter sweeps with compile and fire overlapped on both cores
+ *
+ * A sweep fires one double pulse per point while one parameter steps
+ * from point to point. A producer task on core 0 compiles upcoming points
+ * into a ring of plans; an executor task on core 1 takes each plan off
+ * the ring, loads it and fires it. The ring has one writer and one
+ * reader, so it needs no lock: each side only advances its own index.
+ * When the ring is full the producer waits for the executor (the sweep
+ * runs at the shot rate); when it is empty the executor waits for the
+ * producer (compiling is the bottleneck). Both waits are counted.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DPT_SWEEP_RING_SLOTS    4       // Compiled plans ahead of the executor (power of two)
+#define DPT_SWEEP_MAX_POINTS    10000
+
+typedef enum {
+    DPT_SWEEP_P1H,
+    DPT_SWEEP_P1L,
+    DPT_SWEEP_P2H,
+    DPT_SWEEP_P2L,
+} dpt_sweep_param_t;
+
+typedef struct {
+    float p1h, p1l, p2h, p2l;       // Values of the parameters that do not step, μs
+    dpt_sweep_param_t param;        // Parameter that steps
+    float start_us;
+    float step_us;                  // May be negative
+    uint16_t points;
+    uint32_t interval_ms;           // Minimum time between shot starts; 0 = back to back
+} dpt_sweep_config_t;
+
+typedef struct {
+    bool running;
+    uint16_t points;
+    uint16_t compiled;
+    uint16_t fired;
+    uint16_t failed;                // Points not fired (compile or RMT error)
+    esp_err_t last_error;
+    uint16_t ring_max;              // Most plans waiting in the ring at once
+    uint32_t producer_waits;        // Ring full: the producer was ahead (back-pressure)
+    uint32_t executor_waits;        // Ring empty: the executor waited for a compile
+    uint32_t executor_wait_us;      // Time the executor spent waiting for plans
+    uint32_t compile_us_max;
+    uint32_t compile_us_total;
+    uint32_t shot_us_max;           // Claim to TX end
+    uint32_t shot_us_total;
+    uint32_t bus_wait_us_max;       // Held by the bus interlock before a shot
+    uint32_t bus_wait_us_total;
+    int64_t elapsed_us;             // Start of the sweep to its last shot
+} dpt_sweep_stats_t;
+
+/**
+ * @brief Create the producer and executor tasks
+ */
+esp_err_t dpt_sweep_init(void);
+
+/**
+ * @brief Start a sweep
+ *
+ * @return ESP_ERR_INVALID_STATE while a sweep is running,
+ *         ESP_ERR_INVALID_ARG for a bad point count or parameter
+ */
+esp_err_t dpt_sweep_start(const dpt_sweep_config_t *config);
+
+/**
+ * @brief Stop after the shot in progress
+ */
+void dpt_sweep_stop(void);
+
+/**
+ * @brief Statistics of the running or the last sweep
+ */
+void dpt_sweep_get_stats(dpt_sweep_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,253 @@
+/**
+ * @file dpt_target.c
+ * @brief Closed-loop first-pulse width for a target load current
+ *
+ * One task runs the loop; the status is copied out under a spinlock. Each
+ * shot claims the RMT like a sweep point does, so manual triggers and
+ * sweeps simply interleave with a run.
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "dpt_plan.h"
+#include "dpt_rmt.h"
+#include "dpt_adc.h"
+#include "dpt_delay.h"
+#include "dpt_interlock.h"
+#include "dpt_pace.h"
+#include "dpt_thermal.h"
+#include "dpt_target.h"
+
+#define TAG "DPT_TARGET"
+
+#define TARGET_CORE         1
+#define TARGET_PRIORITY     12      // Same as the sweep executor
+#define CLAIM_TIMEOUT_MS    1000
+#define MIN_PEAK_A          0.01f   // Below this the reading is noise, not a slope
+
+static dpt_target_config_t config;
+static volatile bool stop_requested;
+static SemaphoreHandle_t run_go;
+static dpt_target_status_t status;
+static portMUX_TYPE status_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *state_names[] = {
+    [DPT_TARGET_IDLE] = "idle",
+    [DPT_TARGET_RUNNING] = "running",
+    [DPT_TARGET_CONVERGED] = "converged",
+    [DPT_TARGET_AT_LIMIT] = "at_limit",
+    [DPT_TARGET_OVER_CURRENT] = "over_current",
+    [DPT_TARGET_NOT_CONVERGED] = "not_converged",
+    [DPT_TARGET_STOPPED] = "stopped",
+    [DPT_TARGET_FAILED] = "failed",
+};
+
+const char *dpt_target_state_name(dpt_target_state_t state) {
+    return state <= DPT_TARGET_FAILED ? state_names[state] : "?";
+}
+
+// ---------------------- Controller ----------------------
+float dpt_target_next(const dpt_target_config_t *cfg, const dpt_target_step_t *steps, int num_steps) {
+    const dpt_target_step_t *last = &steps[num_steps - 1];
+    float p1h = last->p1h_us;
+    float next;
+
+    if (last->peak_a < MIN_PEAK_A) {
+        next = p1h * (1.0f + cfg->max_step);
+    } else {
+        next = p1h * cfg->target_a / last->peak_a;
+        if (num_steps >= 2) {
+            const dpt_target_step_t *prev = &steps[num_steps - 2];
+            float dt = p1h - prev->p1h_us;
+            float slope = dt != 0.0f ? (last->peak_a - prev->peak_a) / dt : 0.0f;
+            // A flat or falling slope is noise or a saturated sensor; keep the ratio then
+            if (slope > 0.0f) {
+                next = p1h + (cfg->target_a - last->peak_a) / slope;
+            }
+        }
+        // Never aim past the current limit, assuming current proportional to width
+        float limit = p1h * cfg->limit_a / last->peak_a;
+        if (next > limit) next = limit;
+    }
+
+    float lo = p1h * (1.0f - cfg->max_step);
+    float hi = p1h * (1.0f + cfg->max_step);
+    if (next < lo) next = lo;
+    if (next > hi) next = hi;
+    if (next < cfg->p1h_min) next = cfg->p1h_min;
+    if (next > cfg->p1h_max) next = cfg->p1h_max;
+    return next;
+}
+
+// ---------------------- Loop ----------------------
+static esp_err_t fire(float p1h, float *peak_a) {
+    static dpt_recipe_t recipe;     // Target task only; too large for its stack
+    static dpt_plan_t plan;
+    dpt_recipe_double_pulse(&recipe, p1h, config.p1l, config.p2h, config.p2l);
+    esp_err_t err = dpt_plan_compile(&plan, &recipe);
+    dpt_thermal_load_t load;
+    if (err == ESP_OK) {
+        dpt_thermal_load_of(&plan, &load);
+        err = dpt_thermal_wait(&load, NULL);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    uint32_t timeout_ms = (uint32_t)(dpt_plan_total_ticks(&plan) / (DPT_TICKS_PER_US * 1000)) + 100;
+    err = dpt_rmt_claim(CLAIM_TIMEOUT_MS);
+    if (err != ESP_OK) {
+        return err;
+    }
+    float peak[DPT_ADC_SIGNALS];
+    err = dpt_rmt_load(&plan, false);
+    dpt_delay_begin();
+    dpt_adc_peak_begin();
+    if (err == ESP_OK) err = dpt_rmt_start();
+    if (err == ESP_OK) err = dpt_rmt_wait_done(timeout_ms);
+    if (err == ESP_OK) dpt_delay_end(&plan);
+    esp_err_t adc_err = dpt_adc_peak_end(peak);
+    dpt_rmt_release();
+    if (err == ESP_OK) dpt_thermal_shot(&load);
+
+    if (err == ESP_OK) err = adc_err;
+    *peak_a = peak[DPT_ADC_CURRENT];
+    return err;
+}
+
+static void finish(dpt_target_state_t state, esp_err_t err) {
+    portENTER_CRITICAL(&status_mux);
+    status.state = state;
+    status.last_error = err;
+    portEXIT_CRITICAL(&status_mux);
+}
+
+static void target_task(void *arg) {
+    while (1) {
+        xSemaphoreTake(run_go, portMAX_DELAY);
+        float p1h = config.p1h_start;
+        dpt_target_state_t state = DPT_TARGET_NOT_CONVERGED;
+        esp_err_t err = ESP_OK;
+        int64_t last_start_us = 0;
+
+        for (int k = 0; k < config.max_shots; k++) {
+            if (stop_requested) {
+                state = DPT_TARGET_STOPPED;
+                break;
+            }
+            if (k > 0 && config.interval_ms > 0) {
+                dpt_pace(last_start_us, config.interval_ms);
+            }
+            dpt_interlock_wait_t bus;
+            err = dpt_interlock_wait(&bus);
+            last_start_us = esp_timer_get_time();
+
+            float peak_a = 0.0f;
+            if (err == ESP_OK) {
+                err = fire(p1h, &peak_a);
+            }
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Shot %d at %.3f μs failed: %s", k + 1, p1h, esp_err_to_name(err));
+                state = DPT_TARGET_FAILED;
+                break;
+            }
+
+            portENTER_CRITICAL(&status_mux);
+            status.steps[k] = (dpt_target_step_t){ .p1h_us = p1h, .peak_a = peak_a };
+            status.shots = k + 1;
+            status.p1h_us = p1h;
+            status.peak_a = peak_a;
+            portEXIT_CRITICAL(&status_mux);
+
+            if (peak_a > config.limit_a) {
+                ESP_LOGW(TAG, "Shot %d: %.3f μs -> %.2f A, above the %.2f A limit", k + 1, p1h, peak_a,
+                         config.limit_a);
+                state = DPT_TARGET_OVER_CURRENT;
+                break;
+            }
+            if (fabsf(peak_a - config.target_a) <= config.tolerance_a) {
+                ESP_LOGI(TAG, "Shot %d: %.3f μs -> %.2f A, converged", k + 1, p1h, peak_a);
+                state = DPT_TARGET_CONVERGED;
+                break;
+            }
+            float next = dpt_target_next(&config, status.steps, k + 1);
+            ESP_LOGI(TAG, "Shot %d: %.3f μs -> %.2f A (target %.2f A), next %.3f μs", k + 1, p1h, peak_a,
+                     config.target_a, next);
+            if (next == p1h && (p1h == config.p1h_min || p1h == config.p1h_max)) {
+                ESP_LOGW(TAG, "First pulse pinned at %.3f μs, %.2f A short of the target", p1h,
+                         config.target_a - peak_a);
+                state = DPT_TARGET_AT_LIMIT;
+                break;
+            }
+            p1h = next;
+        }
+        finish(state, err);
+        ESP_LOGI(TAG, "Targeting %s after %u shot(s)", dpt_target_state_name(state), status.shots);
+    }
+}
+
+// ---------------------- Control ----------------------
+esp_err_t dpt_target_init(void) {
+    run_go = xSemaphoreCreateBinary();
+    if (!run_go ||
+        xTaskCreatePinnedToCore(target_task, "target", 4096, NULL, TARGET_PRIORITY, NULL, TARGET_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static bool valid_time(float us) {
+    return us >= 0.0125f && us <= 65535.0f;
+}
+
+esp_err_t dpt_target_start(const dpt_target_config_t *new_config) {
+    const dpt_target_config_t *c = new_config;
+    if (!valid_time(c->p1l) || !valid_time(c->p2h) || !valid_time(c->p2l) ||
+        !valid_time(c->p1h_min) || !valid_time(c->p1h_max) || c->p1h_min > c->p1h_max ||
+        c->p1h_start < c->p1h_min || c->p1h_start > c->p1h_max ||
+        !(c->target_a > 0.0f) || !(c->tolerance_a > 0.0f) || !(c->limit_a > c->target_a) ||
+        !(c->max_step > 0.0f && c->max_step <= 1.0f) ||
+        c->max_shots < 1 || c->max_shots > DPT_TARGET_MAX_SHOTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!dpt_adc_has(DPT_ADC_CURRENT)) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    portENTER_CRITICAL(&status_mux);
+    bool busy = status.state == DPT_TARGET_RUNNING;
+    if (!busy) {
+        memset(&status, 0, sizeof(status));
+        status.state = DPT_TARGET_RUNNING;
+        status.target_a = c->target_a;
+    }
+    portEXIT_CRITICAL(&status_mux);
+    if (busy) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // The task is idle: nothing reads the config now
+    config = *c;
+    stop_requested = false;
+    xSemaphoreGive(run_go);
+    ESP_LOGI(TAG, "Targeting %.2f A ± %.2f A from %.3f μs, width %.3f-%.3f μs, limit %.2f A, %u shot(s)",
+             config.target_a, config.tolerance_a, config.p1h_start, config.p1h_min, config.p1h_max,
+             config.limit_a, config.max_shots);
+    return ESP_OK;
+}
+
+void dpt_target_stop(void) {
+    stop_requested = true;
+}
+
+void dpt_target_get_status(dpt_target_status_t *out) {
+    portENTER_CRITICAL(&status_mux);
+    *out = status;
+    portEXIT_CRITICAL(&status_mux);
+}
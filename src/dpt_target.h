@@ -0,0 +1,96 @@
+/**
+ * @file dpt_target.h
+ * @brief Closed-loop first-pulse width for a target load current
+ *
+ * The load current at the first turn-off rises about linearly with the
+ * first pulse, I = Vbus * t / L. Each iteration fires one double pulse,
+ * takes the peak load current from the ADC (src/dpt_adc.h) and picks the
+ * next first-pulse width: the ratio target / measured for the first step,
+ * then the secant through the last two points, which also absorbs an
+ * offset. Every step is bounded to max_step of the current width and to
+ * [p1h_min, p1h_max], so a bad reading cannot command a long pulse. The
+ * run ends when the peak is within the tolerance, when it exceeds the
+ * current limit, when the width is pinned at a limit, or after max_shots.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DPT_TARGET_MAX_SHOTS    32
+
+typedef struct {
+    float p1l, p2h, p2l;            // Fixed parts of the double pulse, μs
+    float p1h_start;                // First width tried, μs
+    float p1h_min, p1h_max;         // Hard bounds on the width, μs
+    float target_a;
+    float tolerance_a;              // Converged when |peak - target| is within this
+    float limit_a;                  // Stop at once if a peak exceeds this
+    float max_step;                 // Largest change per shot, fraction of the width
+    uint8_t max_shots;
+    uint32_t interval_ms;           // Between shots, for the bus and the DUT to recover
+} dpt_target_config_t;
+
+typedef enum {
+    DPT_TARGET_IDLE,
+    DPT_TARGET_RUNNING,
+    DPT_TARGET_CONVERGED,
+    DPT_TARGET_AT_LIMIT,            // Width pinned at p1h_min/p1h_max and still off target
+    DPT_TARGET_OVER_CURRENT,        // A peak exceeded limit_a
+    DPT_TARGET_NOT_CONVERGED,       // max_shots used up
+    DPT_TARGET_STOPPED,
+    DPT_TARGET_FAILED,              // Compile, RMT or ADC error
+} dpt_target_state_t;
+
+typedef struct {
+    float p1h_us;
+    float peak_a;
+} dpt_target_step_t;
+
+typedef struct {
+    dpt_target_state_t state;
+    float target_a;
+    uint8_t shots;
+    float p1h_us;                   // Width of the last shot
+    float peak_a;                   // Its peak
+    esp_err_t last_error;
+    dpt_target_step_t steps[DPT_TARGET_MAX_SHOTS];
+} dpt_target_status_t;
+
+esp_err_t dpt_target_init(void);
+
+/**
+ * @brief Start a run
+ *
+ * @return ESP_ERR_INVALID_STATE while one runs, ESP_ERR_INVALID_ARG for
+ *         inconsistent limits, ESP_ERR_NOT_SUPPORTED without a current input
+ */
+esp_err_t dpt_target_start(const dpt_target_config_t *config);
+
+/**
+ * @brief Stop after the shot in progress
+ */
+void dpt_target_stop(void);
+
+void dpt_target_get_status(dpt_target_status_t *out);
+
+const char *dpt_target_state_name(dpt_target_state_t state);
+
+/**
+ * @brief The controller step: next width from the history of a run
+ *
+ * Pure; exposed so it can be checked against a model of the load.
+ *
+ * @param steps  Shots so far, the last one being the newest (at least one)
+ */
+float dpt_target_next(const dpt_target_config_t *config, const dpt_target_step_t *steps, int num_steps);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,407 @@
+/**
+ * @file dpt_thermal.c
+ * @brief Junction temperature estimate per DUT, throttling shots near a limit
+ *
+ * A DUT's state is the temperature rise of each stage at updated_us; it
+ * is brought forward to the present only when something reads or heats
+ * it, so idle DUTs cost nothing. The state sits under a spinlock. The
+ * check before a shot and the shot itself are not one atomic step, so two
+ * sources firing at once can each pass the check; the sweep, targeting
+ * and manual paths are rarely active together.
+ *
+ * Preset shots are judged ahead of time: the headroom task checks each
+ * preset's load against the selected DUT every HEADROOM_PERIOD_MS, or as
+ * soon as something changes, and the trigger ISR only reads the flag.
+ * The TX end interrupt counts finished preset shots per slot; the task
+ * adds them to the estimate when it next runs, a little after the shot.
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "dpt_preset.h"
+#include "dpt_rmt.h"
+#include "dpt_thermal.h"
+
+#define TAG "DPT_THERMAL"
+
+#define WAIT_RESOLUTION_US  1000
+#define HEADROOM_PERIOD_MS  10      // Cooling can only set a flag; refresh this often
+#define HEADROOM_PRIORITY   6
+
+typedef struct {
+    dpt_thermal_config_t config;
+    float rise[DPT_THERMAL_STAGES];     // K above the case, per stage
+    int64_t updated_us;
+    dpt_thermal_status_t status;
+} dut_t;
+
+static dut_t duts[DPT_THERMAL_DUTS];
+static int selected = 0;
+static portMUX_TYPE duts_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Last plan measured; loads are asked for on every shot
+static uint32_t load_hash = 0;
+static dpt_thermal_load_t load_cache;
+
+// Preset slots, for shots fired from trigger ISRs
+static const dpt_plan_t *volatile preset_plan[DPT_PRESET_SLOTS];  // NULL while the slot is empty
+static dpt_thermal_load_t preset_load[DPT_PRESET_SLOTS];           // Under duts_mux
+static volatile bool headroom[DPT_PRESET_SLOTS];
+static volatile uint32_t preset_shots[DPT_PRESET_SLOTS];          // Counted by the TX end ISR
+static SemaphoreHandle_t headroom_kick = NULL;
+
+// ---------------------- Model ----------------------
+static void decay(dut_t *d, int64_t now_us) {
+    float dt = (now_us - d->updated_us) * 1e-6f;
+    if (dt > 0.0f) {
+        for (int i = 0; i < d->config.stages; i++) {
+            d->rise[i] *= expf(-dt / d->config.stage[i].tau_s);
+        }
+    }
+    d->updated_us = now_us;
+}
+
+static float tj(const dut_t *d) {
+    float t = d->config.t_case_c;
+    for (int i = 0; i < d->config.stages; i++) {
+        t += d->rise[i];
+    }
+    return t;
+}
+
+static float energy_j(const dpt_thermal_config_t *cfg, const dpt_thermal_load_t *load) {
+    return cfg->p_on_w * load->on_s + (cfg->e_on_uj + cfg->e_off_uj) * 1e-6f * load->pulses;
+}
+
+// Junction temperature at the end of a shot starting wait_s from the state in d
+static float tj_after(const dut_t *d, const dpt_thermal_load_t *load, float wait_s) {
+    const dpt_thermal_config_t *cfg = &d->config;
+    float on_s = load->on_s > 1e-9f ? load->on_s : 1e-9f;
+    float p = energy_j(cfg, load) / on_s;
+    float t = cfg->t_case_c;
+    for (int i = 0; i < cfg->stages; i++) {
+        float tau = cfg->stage[i].tau_s;
+        float k = expf(-on_s / tau);
+        t += d->rise[i] * expf(-wait_s / tau) * k + p * cfg->stage[i].rth * (1.0f - k);
+    }
+    return t;
+}
+
+// ---------------------- Shots ----------------------
+void dpt_thermal_load_of(const dpt_plan_t *plan, dpt_thermal_load_t *out) {
+    portENTER_CRITICAL(&duts_mux);
+    bool cached = load_hash != 0 && load_hash == plan->hash;
+    if (cached) {
+        *out = load_cache;
+    }
+    portEXIT_CRITICAL(&duts_mux);
+    if (cached) {
+        return;
+    }
+
+    dpt_edge_iter_t it;
+    dpt_edge_iter_init(&it, plan, DPT_CHANNEL_P);
+    uint64_t on_ticks = 0;
+    uint32_t rise_tick = 0;
+    uint16_t pulses = 0;
+    uint32_t tick;
+    uint8_t level;
+    while (dpt_edge_iter_next(&it, &tick, &level)) {
+        if (level) {
+            rise_tick = tick;
+            pulses++;
+        } else if (pulses > 0) {
+            on_ticks += tick - rise_tick;
+        }
+    }
+    *out = (dpt_thermal_load_t){ .on_s = on_ticks / (DPT_TICKS_PER_US * 1e6f), .pulses = pulses };
+
+    portENTER_CRITICAL(&duts_mux);
+    load_hash = plan->hash;
+    load_cache = *out;
+    portEXIT_CRITICAL(&duts_mux);
+}
+
+esp_err_t dpt_thermal_wait(const dpt_thermal_load_t *load, uint32_t *wait_us) {
+    if (wait_us != NULL) {
+        *wait_us = 0;
+    }
+    portENTER_CRITICAL(&duts_mux);
+    dut_t d = duts[selected];
+    portEXIT_CRITICAL(&duts_mux);
+    if (!d.config.enabled) {
+        return ESP_OK;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    decay(&d, start_us);
+    float ceiling = d.config.limit_c - d.config.margin_c;
+    esp_err_t err = ESP_OK;
+    uint32_t hold_us = 0;
+
+    if (tj_after(&d, load, 0.0f) > ceiling) {
+        // Cooling only lowers the estimate, so double the wait until it fits and then bisect
+        uint32_t max_us = d.config.max_wait_ms * 1000;
+        uint32_t lo = 0;
+        uint32_t hi = WAIT_RESOLUTION_US;
+        while (hi < max_us && tj_after(&d, load, hi * 1e-6f) > ceiling) {
+            lo = hi;
+            hi *= 2;
+        }
+        if (hi >= max_us) {
+            hi = max_us;
+            if (tj_after(&d, load, hi * 1e-6f) > ceiling) {
+                err = tj_after(&d, load, INFINITY) > ceiling ? ESP_ERR_INVALID_SIZE : ESP_ERR_TIMEOUT;
+            }
+        }
+        while (err == ESP_OK && hi - lo > WAIT_RESOLUTION_US) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (tj_after(&d, load, mid * 1e-6f) > ceiling) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        hold_us = hi;
+    }
+
+    // A tick delay may end early within its first tick; wait out the rest
+    int64_t remaining_us;
+    while (err == ESP_OK && (remaining_us = start_us + hold_us - esp_timer_get_time()) > 0) {
+        vTaskDelay((remaining_us + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000));
+    }
+    uint32_t waited_us = (uint32_t)(esp_timer_get_time() - start_us);
+
+    portENTER_CRITICAL(&duts_mux);
+    dpt_thermal_status_t *st = &duts[selected].status;
+    if (err != ESP_OK) {
+        st->refused++;
+    } else if (hold_us > 0) {
+        st->throttled++;
+        st->throttle_us_total += waited_us;
+        if (waited_us > st->throttle_us_max) st->throttle_us_max = waited_us;
+    }
+    portEXIT_CRITICAL(&duts_mux);
+
+    if (err == ESP_ERR_INVALID_SIZE) {
+        ESP_LOGW(TAG, "DUT %d: one shot of %.3f mJ alone would pass %.1f °C; refused", selected,
+                 energy_j(&d.config, load) * 1e3f, ceiling);
+    } else if (err != ESP_OK) {
+        ESP_LOGW(TAG, "DUT %d at %.1f °C would need over %" PRIu32 " ms to cool for the shot; refused", selected,
+                 tj(&d), d.config.max_wait_ms);
+    } else if (hold_us > 0) {
+        ESP_LOGI(TAG, "DUT %d at %.1f °C: shot held %" PRIu32 " μs to stay below %.1f °C", selected, tj(&d),
+                 waited_us, ceiling);
+    }
+    if (wait_us != NULL) {
+        *wait_us = waited_us;
+    }
+    return err;
+}
+
+void dpt_thermal_shot(const dpt_thermal_load_t *load) {
+    portENTER_CRITICAL(&duts_mux);
+    dut_t *d = &duts[selected];
+    if (d->config.enabled) {
+        decay(d, esp_timer_get_time());
+        float on_s = load->on_s > 1e-9f ? load->on_s : 1e-9f;
+        float e = energy_j(&d->config, load);
+        for (int i = 0; i < d->config.stages; i++) {
+            float k = expf(-on_s / d->config.stage[i].tau_s);
+            d->rise[i] = d->rise[i] * k + e / on_s * d->config.stage[i].rth * (1.0f - k);
+        }
+        float t = tj(d);
+        d->status.shots++;
+        d->status.last_energy_mj = e * 1e3f;
+        if (t > d->status.tj_max_c) d->status.tj_max_c = t;
+    }
+    portEXIT_CRITICAL(&duts_mux);
+}
+
+// ---------------------- Preset Shots ----------------------
+// Clear every flag until the task has judged the new state
+static void invalidate_headroom(void) {
+    for (int id = 0; id < DPT_PRESET_SLOTS; id++) {
+        headroom[id] = false;
+    }
+    if (headroom_kick != NULL) {
+        xSemaphoreGive(headroom_kick);
+    }
+}
+
+void dpt_thermal_set_preset(uint8_t id, const dpt_plan_t *slot) {
+    if (id >= DPT_PRESET_SLOTS) {
+        return;
+    }
+    headroom[id] = false;
+    dpt_thermal_load_t load = { 0 };
+    if (slot != NULL) {
+        dpt_thermal_load_of(slot, &load);
+    }
+    portENTER_CRITICAL(&duts_mux);
+    preset_load[id] = load;
+    portEXIT_CRITICAL(&duts_mux);
+    preset_plan[id] = slot;
+    if (headroom_kick != NULL) {
+        xSemaphoreGive(headroom_kick);
+    }
+}
+
+bool IRAM_ATTR dpt_thermal_isr_allows(uint8_t id) {
+    return id < DPT_PRESET_SLOTS && (headroom[id] || !duts[selected].config.enabled);
+}
+
+// TX end of a shot some ISR fired; only preset slots heat the model here
+static bool IRAM_ATTR isr_shot_done(const dpt_plan_t *plan) {
+    for (int id = 0; id < DPT_PRESET_SLOTS; id++) {
+        if (plan == preset_plan[id]) {
+            preset_shots[id]++;
+            for (int k = 0; k < DPT_PRESET_SLOTS; k++) {
+                headroom[k] = false;
+            }
+            BaseType_t woken = pdFALSE;
+            xSemaphoreGiveFromISR(headroom_kick, &woken);
+            return woken == pdTRUE;
+        }
+    }
+    return false;
+}
+
+static void headroom_task(void *arg) {
+    uint32_t applied[DPT_PRESET_SLOTS] = { 0 };
+    while (1) {
+        xSemaphoreTake(headroom_kick, pdMS_TO_TICKS(HEADROOM_PERIOD_MS));
+
+        dpt_thermal_load_t load[DPT_PRESET_SLOTS];
+        portENTER_CRITICAL(&duts_mux);
+        memcpy(load, preset_load, sizeof(load));
+        portEXIT_CRITICAL(&duts_mux);
+        for (int id = 0; id < DPT_PRESET_SLOTS; id++) {
+            uint32_t shots = preset_shots[id];
+            for (; applied[id] != shots; applied[id]++) {
+                dpt_thermal_shot(&load[id]);
+            }
+        }
+
+        portENTER_CRITICAL(&duts_mux);
+        dut_t d = duts[selected];
+        portEXIT_CRITICAL(&duts_mux);
+        decay(&d, esp_timer_get_time());
+        float ceiling = d.config.limit_c - d.config.margin_c;
+        for (int id = 0; id < DPT_PRESET_SLOTS; id++) {
+            headroom[id] = preset_plan[id] != NULL &&
+                           (!d.config.enabled || tj_after(&d, &load[id], 0.0f) <= ceiling);
+        }
+    }
+}
+
+// ---------------------- Configuration ----------------------
+esp_err_t dpt_thermal_init(void) {
+    for (int k = 0; k < DPT_THERMAL_DUTS; k++) {
+        duts[k].config = (dpt_thermal_config_t){
+            .stages = 1,
+            .stage = { { .rth = 1.0f, .tau_s = 0.01f } },
+            .t_case_c = 25.0f,
+            .limit_c = 150.0f,
+            .margin_c = 10.0f,
+            .max_wait_ms = 10000,
+        };
+        duts[k].status.tj_max_c = duts[k].config.t_case_c;
+    }
+    headroom_kick = xSemaphoreCreateBinary();
+    if (headroom_kick == NULL ||
+        xTaskCreate(headroom_task, "thermal_headroom", 3072, NULL, HEADROOM_PRIORITY, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    dpt_rmt_set_isr_done(isr_shot_done);
+    return ESP_OK;
+}
+
+esp_err_t dpt_thermal_configure(int dut, const dpt_thermal_config_t *cfg) {
+    if (dut < 0 || dut >= DPT_THERMAL_DUTS || cfg->stages < 1 || cfg->stages > DPT_THERMAL_STAGES ||
+        !(cfg->limit_c - cfg->margin_c > cfg->t_case_c) || cfg->margin_c < 0.0f ||
+        cfg->p_on_w < 0.0f || cfg->e_on_uj < 0.0f || cfg->e_off_uj < 0.0f ||
+        cfg->max_wait_ms > DPT_THERMAL_MAX_WAIT_MS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < cfg->stages; i++) {
+        if (!(cfg->stage[i].rth > 0.0f) || !(cfg->stage[i].tau_s > 0.0f)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    portENTER_CRITICAL(&duts_mux);
+    dut_t *d = &duts[dut];
+    d->config = *cfg;
+    memset(d->rise, 0, sizeof(d->rise));
+    memset(&d->status, 0, sizeof(d->status));
+    d->status.tj_max_c = cfg->t_case_c;
+    d->updated_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&duts_mux);
+    invalidate_headroom();
+
+    float rth = 0.0f;
+    for (int i = 0; i < cfg->stages; i++) {
+        rth += cfg->stage[i].rth;
+    }
+    ESP_LOGI(TAG, "DUT %d model %s: %u stage(s), Rth %.3f K/W, case %.1f °C, limit %.1f °C (margin %.1f)", dut,
+             cfg->enabled ? "enabled" : "disabled", cfg->stages, rth, cfg->t_case_c, cfg->limit_c, cfg->margin_c);
+    return ESP_OK;
+}
+
+esp_err_t dpt_thermal_get_config(int dut, dpt_thermal_config_t *out) {
+    if (dut < 0 || dut >= DPT_THERMAL_DUTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&duts_mux);
+    *out = duts[dut].config;
+    portEXIT_CRITICAL(&duts_mux);
+    return ESP_OK;
+}
+
+esp_err_t dpt_thermal_select(int dut) {
+    if (dut < 0 || dut >= DPT_THERMAL_DUTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&duts_mux);
+    selected = dut;
+    portEXIT_CRITICAL(&duts_mux);
+    invalidate_headroom();
+    return ESP_OK;
+}
+
+int dpt_thermal_selected(void) {
+    return selected;
+}
+
+esp_err_t dpt_thermal_get_status(int dut, dpt_thermal_status_t *out) {
+    if (dut < 0 || dut >= DPT_THERMAL_DUTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&duts_mux);
+    dut_t *d = &duts[dut];
+    decay(d, esp_timer_get_time());
+    d->status.tj_c = tj(d);
+    *out = d->status;
+    portEXIT_CRITICAL(&duts_mux);
+    return ESP_OK;
+}
+
+esp_err_t dpt_thermal_reset(int dut) {
+    dpt_thermal_config_t cfg;
+    esp_err_t err = dpt_thermal_get_config(dut, &cfg);
+    if (err == ESP_OK) {
+        portENTER_CRITICAL(&duts_mux);
+        memset(duts[dut].rise, 0, sizeof(duts[dut].rise));
+        memset(&duts[dut].status, 0, sizeof(duts[dut].status));
+        duts[dut].status.tj_max_c = cfg.t_case_c;
+        portEXIT_CRITICAL(&duts_mux);
+        invalidate_headroom();
+    }
+    return err;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file dpt_thermal.h
+ * @brief Junction temperature estimate per DUT, throttling shots near a limit
+ *
+ * Each DUT has a Foster RC model of its junction-to-case impedance: up to
+ * DPT_THERMAL_STAGES stages of Rth (K/W) and tau (s), on a case held at
+ * t_case_c. A shot heats the DUT with its switching energy and its
+ * conduction loss over the P output's on-time:
+ *
+ *   E = p_on_w * t_on + (e_on_uj + e_off_uj) * pulses
+ *
+ * applied as one rectangular power pulse of length t_on. Between shots
+ * every stage decays with its own time constant. Both steps are closed
+ * form, so the estimate is updated once per shot and never sampled.
+ * Lumping the pulses together slightly overestimates the peak, which is
+ * on the safe side.
+ *
+ * Before a shot the estimate the shot would reach is checked against
+ * limit_c - margin_c. If it is over, the shot waits until the junction
+ * has cooled enough, at most max_wait_ms; well below the limit shots go
+ * at once.
+ *
+ * Trigger inputs fire presets from their interrupt and cannot wait. A
+ * task keeps a flag per preset slot telling whether the selected DUT has
+ * headroom for that preset's shot now, and the ISR refuses the shot while
+ * it is clear. The TX end interrupt counts finished preset shots, and the
+ * task adds each one to the estimate.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "dpt_plan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DPT_THERMAL_DUTS        8
+#define DPT_THERMAL_STAGES      4
+#define DPT_THERMAL_MAX_WAIT_MS 600000
+
+typedef struct {
+    float rth;                  // K/W
+    float tau_s;
+} dpt_thermal_stage_t;
+
+typedef struct {
+    bool enabled;
+    uint8_t stages;
+    dpt_thermal_stage_t stage[DPT_THERMAL_STAGES];
+    float p_on_w;               // Conduction loss while on
+    float e_on_uj, e_off_uj;    // Switching energy per turn-on / turn-off
+    float t_case_c;
+    float limit_c;
+    float margin_c;             // Throttle this far below the limit
+    uint32_t max_wait_ms;       // Longest a shot is held before it is refused
+} dpt_thermal_config_t;
+
+typedef struct {
+    float on_s;                 // P output high time, all pulses
+    uint16_t pulses;            // P turn-ons
+} dpt_thermal_load_t;
+
+typedef struct {
+    float tj_c;                 // Now
+    float tj_max_c;             // Highest estimate reached since the last reset
+    float last_energy_mj;
+    uint32_t shots;
+    uint32_t throttled;         // Shots held to cool down
+    uint32_t refused;           // Shots that would exceed the limit even from cold, or timed out
+    uint32_t throttle_us_max;
+    uint64_t throttle_us_total;
+} dpt_thermal_status_t;
+
+/**
+ * @brief Give every DUT the default model, disabled, and start the task
+ * that keeps the preset headroom flags
+ */
+esp_err_t dpt_thermal_init(void);
+
+/**
+ * @brief Set a DUT's model; its estimate restarts at t_case_c
+ *
+ * @return ESP_ERR_INVALID_ARG for a bad index, no stages, a non-positive
+ *         Rth or tau, a margin that leaves no room below the limit or
+ *         max_wait_ms above DPT_THERMAL_MAX_WAIT_MS
+ */
+esp_err_t dpt_thermal_configure(int dut, const dpt_thermal_config_t *cfg);
+
+esp_err_t dpt_thermal_get_config(int dut, dpt_thermal_config_t *out);
+
+/**
+ * @brief Choose the DUT that shots heat from now on
+ */
+esp_err_t dpt_thermal_select(int dut);
+
+int dpt_thermal_selected(void);
+
+/**
+ * @brief On-time and pulse count of a plan's P output
+ */
+void dpt_thermal_load_of(const dpt_plan_t *plan, dpt_thermal_load_t *out);
+
+/**
+ * @brief Hold until the selected DUT can take the shot; call before claiming the RMT
+ *
+ * Returns at once with ESP_OK while the selected DUT's model is disabled.
+ *
+ * @param[out] wait_us  How long the shot was held, may be NULL
+ * @return ESP_ERR_INVALID_SIZE if the shot alone would exceed the limit,
+ *         ESP_ERR_TIMEOUT if cooling down would take over max_wait_ms
+ */
+esp_err_t dpt_thermal_wait(const dpt_thermal_load_t *load, uint32_t *wait_us);
+
+/**
+ * @brief Add a fired shot to the selected DUT's estimate
+ */
+void dpt_thermal_shot(const dpt_thermal_load_t *load);
+
+/**
+ * @brief Measure the plan now in a preset slot, NULL when it was emptied
+ *
+ * Called by dpt_preset with the slot's own plan, while triggers cannot fire.
+ */
+void dpt_thermal_set_preset(uint8_t id, const dpt_plan_t *slot);
+
+/**
+ * @brief true if the selected DUT can take preset id's shot now; IRAM-safe
+ *
+ * Always true while the selected DUT's model is disabled. Otherwise the
+ * flag is at most 10 ms old, and cleared from a finished preset shot
+ * until that shot has been added to the estimate.
+ */
+bool dpt_thermal_isr_allows(uint8_t id);
+
+esp_err_t dpt_thermal_get_status(int dut, dpt_thermal_status_t *out);
+
+/**
+ * @brief Let a DUT's estimate restart at t_case_c and clear its counters
+ */
+esp_err_t dpt_thermal_reset(int dut);
+
+#ifdef __cplusplus
+}
+#endif
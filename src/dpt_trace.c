@@ -0,0 +1,248 @@
+/**
+ * @file dpt_trace.c
+ * @brief Shot timeline trace: context switches, ISRs and shot markers
+ *
+ * Recording is lock-free so the hooks can run inside the scheduler on
+ * either core: each event claims a slot with an atomic increment and
+ * stores the recording core's cycle counter. Cycle counters are per core,
+ * so every core also stores one (esp_timer, cycle count) pair when it
+ * records its first event of a capture; the host aligns the cores with
+ * it to within a microsecond.
+ *
+ * The event layout matches the dump format on this little-endian target,
+ * so a dump sends the events straight out of the ring, in at most two
+ * pieces. While it does, a new shot leaves the ring alone: dpt_trace_arm()
+ * skips that shot instead of waiting for a slow download.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "dpt_trace.h"
+
+#define TAG "DPT_TRACE"
+
+_Static_assert((DPT_TRACE_MAX_EVENTS & (DPT_TRACE_MAX_EVENTS - 1)) == 0, "Ring size must be a power of two");
+_Static_assert(sizeof(dpt_trace_event_t) == 12, "Trace event layout");
+_Static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Events are dumped as they lie in memory");
+
+typedef struct {
+    int64_t time_us;
+    uint32_t cycles;
+    volatile uint32_t valid;
+} core_sync_t;
+
+static dpt_trace_event_t ring[DPT_TRACE_MAX_EVENTS];
+static uint32_t head = 0;                   // Events written since the capture was armed
+static volatile bool recording = false;
+static volatile int64_t stop_at_us = 0;     // End of the post window; 0 while the shot runs
+static core_sync_t core_sync[DPT_TRACE_MAX_CORES];
+static int64_t shot_begin_us = 0;
+static volatile bool dumping = false;       // A download is reading the ring
+static uint32_t arms_skipped = 0;
+static portMUX_TYPE arm_mux = portMUX_INITIALIZER_UNLOCKED;    // Arming against the start of a dump
+
+static bool trace_enabled = true;
+static uint32_t window_pre_us = DPT_TRACE_DEFAULT_PRE_US;
+static uint32_t window_post_us = DPT_TRACE_DEFAULT_POST_US;
+
+// ---------------------- Recording ----------------------
+static inline void IRAM_ATTR record(uint8_t type, uint32_t arg) {
+    if (!recording) {
+        return;
+    }
+    uint32_t cycles = esp_cpu_get_cycle_count();
+    int core = xPortGetCoreID();
+    if (stop_at_us != 0 && esp_timer_get_time() > stop_at_us) {
+        recording = false;      // Post window over; keep the capture
+        return;
+    }
+    if (!core_sync[core].valid) {
+        core_sync[core].time_us = esp_timer_get_time();
+        core_sync[core].cycles = cycles;
+        core_sync[core].valid = 1;
+    }
+    uint32_t slot = __atomic_fetch_add(&head, 1, __ATOMIC_RELAXED) & (DPT_TRACE_MAX_EVENTS - 1);
+    ring[slot] = (dpt_trace_event_t){ .cycles = cycles, .arg = arg, .type = type, .core = core };
+}
+
+void IRAM_ATTR dpt_trace_task_switched_in(void) {
+    if (recording) {
+        record(DPT_TRACE_TASK_IN, (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle());
+    }
+}
+
+void IRAM_ATTR dpt_trace_isr_enter(uint32_t source) {
+    record(DPT_TRACE_ISR_ENTER, source);
+}
+
+void IRAM_ATTR dpt_trace_isr_exit(void) {
+    record(DPT_TRACE_ISR_EXIT, 0);
+}
+
+// ---------------------- Capture Control ----------------------
+void dpt_trace_configure(bool enabled, uint32_t pre_us, uint32_t post_us) {
+    trace_enabled = enabled;
+    window_pre_us = pre_us;
+    window_post_us = post_us;
+    if (!enabled) {
+        recording = false;
+    }
+    ESP_LOGI(TAG, "Shot trace %s: %" PRIu32 " us before, %" PRIu32 " us after, %d events",
+             enabled ? "enabled" : "disabled", pre_us, post_us, DPT_TRACE_MAX_EVENTS);
+}
+
+void dpt_trace_get_config(bool *enabled, uint32_t *pre_us, uint32_t *post_us) {
+    *enabled = trace_enabled;
+    *pre_us = window_pre_us;
+    *post_us = window_post_us;
+}
+
+void dpt_trace_arm(void) {
+    if (!trace_enabled) {
+        return;
+    }
+    portENTER_CRITICAL(&arm_mux);
+    if (dumping) {
+        arms_skipped++;     // Keep the capture being downloaded; this shot goes untraced
+        portEXIT_CRITICAL(&arm_mux);
+        return;
+    }
+    recording = false;
+    head = 0;
+    stop_at_us = 0;
+    shot_begin_us = 0;
+    for (int core = 0; core < DPT_TRACE_MAX_CORES; core++) {
+        core_sync[core].valid = 0;
+    }
+    recording = true;
+    portEXIT_CRITICAL(&arm_mux);
+    record(DPT_TRACE_MARK, DPT_TRACE_MARK_ARMED);
+}
+
+void dpt_trace_mark(dpt_trace_mark_t mark) {
+    if (!recording) {
+        return;
+    }
+    if (mark == DPT_TRACE_MARK_SHOT_BEGIN) {
+        shot_begin_us = esp_timer_get_time();
+    }
+    record(DPT_TRACE_MARK, mark);
+    if (mark == DPT_TRACE_MARK_SHOT_END) {
+        stop_at_us = esp_timer_get_time() + window_post_us;
+    }
+}
+
+bool dpt_trace_is_recording(void) {
+    // The post window ends on the first event after it; check the clock too
+    return recording && (stop_at_us == 0 || esp_timer_get_time() <= stop_at_us);
+}
+
+// ---------------------- Download ----------------------
+static int64_t event_time_us(const dpt_trace_event_t *ev, uint32_t cpu_mhz) {
+    const core_sync_t *sync = &core_sync[ev->core];
+    return sync->time_us + (int32_t)(ev->cycles - sync->cycles) / (int32_t)cpu_mhz;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void put_u32(uint8_t *p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+
+esp_err_t dpt_trace_dump(esp_err_t (*write)(void *ctx, const void *data, size_t len), void *ctx) {
+    // Pause a capture still in progress and keep new shots from re-arming;
+    // the ring must not move underneath us
+    portENTER_CRITICAL(&arm_mux);
+    dumping = true;
+    uint32_t skipped_before = arms_skipped;
+    bool was_recording = dpt_trace_is_recording();
+    recording = false;
+    portEXIT_CRITICAL(&arm_mux);
+
+    uint32_t cpu_mhz = esp_rom_get_cpu_ticks_per_us();
+    uint32_t total = head;
+    uint32_t first = total > DPT_TRACE_MAX_EVENTS ? total - DPT_TRACE_MAX_EVENTS : 0;
+    int64_t window_start = shot_begin_us ? shot_begin_us - window_pre_us : INT64_MIN;
+    uint32_t flags = was_recording ? 1 : 0;
+
+    // Drop events before the window, then name the tasks that are left
+    while (first < total && event_time_us(&ring[first & (DPT_TRACE_MAX_EVENTS - 1)], cpu_mhz) < window_start) {
+        first++;
+    }
+    uint32_t count = total - first;
+    uint32_t handles[DPT_TRACE_MAX_TASKS];
+    uint16_t num_tasks = 0;
+    for (uint32_t i = first; i < total; i++) {
+        const dpt_trace_event_t *ev = &ring[i & (DPT_TRACE_MAX_EVENTS - 1)];
+        if (ev->type == DPT_TRACE_TASK_IN && num_tasks < DPT_TRACE_MAX_TASKS) {
+            uint16_t t = 0;
+            while (t < num_tasks && handles[t] != ev->arg) {
+                t++;
+            }
+            if (t == num_tasks) {
+                handles[num_tasks++] = ev->arg;
+            }
+        }
+    }
+    uint32_t lost = total > DPT_TRACE_MAX_EVENTS ? total - DPT_TRACE_MAX_EVENTS : 0;
+    if (lost > 0 && first == total - DPT_TRACE_MAX_EVENTS) {
+        flags |= 2;     // The ring wrapped before reaching back to the window start
+    }
+
+    uint8_t buf[32];
+    memcpy(buf, "DPTT", 4);
+    buf[4] = 1;
+    buf[5] = DPT_TRACE_MAX_CORES;
+    put_u16(&buf[6], num_tasks);
+    put_u32(&buf[8], cpu_mhz * 1000000);
+    put_u32(&buf[12], count);
+    put_u32(&buf[16], lost);
+    put_u32(&buf[20], window_pre_us);
+    put_u32(&buf[24], window_post_us);
+    put_u32(&buf[28], flags);
+    esp_err_t err = write(ctx, buf, 32);
+
+    for (int core = 0; core < DPT_TRACE_MAX_CORES && err == ESP_OK; core++) {
+        put_u32(&buf[0], (uint32_t)core_sync[core].time_us);
+        put_u32(&buf[4], (uint32_t)((uint64_t)core_sync[core].time_us >> 32));
+        put_u32(&buf[8], core_sync[core].cycles);
+        put_u32(&buf[12], core_sync[core].valid);
+        err = write(ctx, buf, 16);
+    }
+
+    // Names are looked up now; none of this firmware's tasks are ever deleted
+    for (uint16_t t = 0; t < num_tasks && err == ESP_OK; t++) {
+        put_u32(&buf[0], handles[t]);
+        memset(&buf[4], 0, 16);
+        const char *name = handles[t] ? pcTaskGetName((TaskHandle_t)(uintptr_t)handles[t]) : NULL;
+        strncpy((char *)&buf[4], name ? name : "?", 15);
+        err = write(ctx, buf, 20);
+    }
+
+    // Straight from the ring: up to its end, then the wrapped part from its start
+    uint32_t from = first & (DPT_TRACE_MAX_EVENTS - 1);
+    uint32_t to_end = DPT_TRACE_MAX_EVENTS - from < count ? DPT_TRACE_MAX_EVENTS - from : count;
+    if (err == ESP_OK && to_end > 0) {
+        err = write(ctx, &ring[from], to_end * sizeof(dpt_trace_event_t));
+    }
+    if (err == ESP_OK && count > to_end) {
+        err = write(ctx, &ring[0], (count - to_end) * sizeof(dpt_trace_event_t));
+    }
+
+    // Resume unless the post window ran out meanwhile
+    if (was_recording) {
+        recording = true;   // record() stops it once the post window has passed
+    }
+    dumping = false;
+    if (arms_skipped != skipped_before) {
+        ESP_LOGI(TAG, "%" PRIu32 " shot(s) untraced: the download held the ring", arms_skipped - skipped_before);
+    }
+    return err;
+}
+
+uint32_t dpt_trace_arms_skipped(void) {
+    return arms_skipped;
+}
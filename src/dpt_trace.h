@@ -0,0 +1,119 @@
+/**
+ * @file dpt_trace.h
+ * @brief Shot timeline trace: context switches, ISRs and shot markers
+ *
+ * Events go into a RAM ring buffer. dpt_trace_arm() starts a capture when
+ * a trigger is accepted; the ring then holds the most recent events until
+ * post_us after the shot ends, when recording stops and the capture is
+ * kept for download. Events older than pre_us before the shot are dropped
+ * on download.
+ *
+ * Context switches come from the FreeRTOS trace hook in dpt_trace_hooks.h,
+ * which the top-level CMakeLists.txt injects into every component. Every
+ * interrupt records entry and exit through the dpt_isrstat wrapper once
+ * dpt_isrstat_init() has run; our own ISRs also record themselves, nested
+ * inside their CPU interrupt.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DPT_TRACE_MAX_EVENTS    1024    // 12 bytes each
+#define DPT_TRACE_MAX_TASKS     24      // Distinct tasks named in a dump
+#define DPT_TRACE_MAX_CORES     2
+#define DPT_TRACE_DEFAULT_PRE_US    5000
+#define DPT_TRACE_DEFAULT_POST_US   2000
+
+typedef enum {
+    DPT_TRACE_TASK_IN = 1,      // arg: task handle now running on the core
+    DPT_TRACE_ISR_ENTER = 2,    // arg: DPT_TRACE_ISR_*
+    DPT_TRACE_ISR_EXIT = 3,
+    DPT_TRACE_MARK = 4,         // arg: dpt_trace_mark_t
+} dpt_trace_type_t;
+
+// Handler-level ISR ids, above the SoC's interrupt source numbers
+#define DPT_TRACE_ISR_BUTTON    0x100
+#define DPT_TRACE_ISR_RMT_DONE  0x101
+#define DPT_TRACE_ISR_TRIGGER   0x102
+#define DPT_TRACE_ISR_CPU_INT   0x200   // + CPU interrupt number (dpt_isrstat wrapper)
+
+typedef enum {
+    DPT_TRACE_MARK_ARMED = 1,       // Trigger accepted, pre-trigger delay starts
+    DPT_TRACE_MARK_SHOT_BEGIN = 2,  // Delay over, taking the plan
+    DPT_TRACE_MARK_RMT_START = 3,   // Both channels started
+    DPT_TRACE_MARK_RMT_DONE = 4,    // Both channels reported TX end
+    DPT_TRACE_MARK_SHOT_END = 5,    // Plan released
+} dpt_trace_mark_t;
+
+typedef struct {
+    uint32_t cycles;    // CPU cycle count of the recording core
+    uint32_t arg;
+    uint8_t type;       // dpt_trace_type_t
+    uint8_t core;
+    uint16_t reserved;
+} dpt_trace_event_t;
+
+/**
+ * @brief Capture window around each shot, and whether shots are traced at all
+ */
+void dpt_trace_configure(bool enabled, uint32_t pre_us, uint32_t post_us);
+void dpt_trace_get_config(bool *enabled, uint32_t *pre_us, uint32_t *post_us);
+
+/**
+ * @brief Discard the previous capture and start recording for a new shot
+ */
+void dpt_trace_arm(void);
+
+/**
+ * @brief Record a shot marker; DPT_TRACE_MARK_SHOT_END starts the post window
+ */
+void dpt_trace_mark(dpt_trace_mark_t mark);
+
+/**
+ * @brief ISR entry/exit: our own handlers call these, and so does the
+ * dpt_isrstat wrapper around every CPU interrupt
+ */
+void dpt_trace_isr_enter(uint32_t source);
+void dpt_trace_isr_exit(void);
+
+/**
+ * @brief Scheduler hook (traceTASK_SWITCHED_IN)
+ */
+void dpt_trace_task_switched_in(void);
+
+/**
+ * @brief true while a capture is recording (not yet past its post window)
+ */
+bool dpt_trace_is_recording(void);
+
+/**
+ * @brief Shots that went untraced because a dump was in progress
+ */
+uint32_t dpt_trace_arms_skipped(void);
+
+/**
+ * @brief Write the last capture as a binary dump, in pieces
+ *
+ * Recording is paused while the dump is written, and a shot arming
+ * meanwhile is not traced. The events are written from the ring itself. Layout (little-endian):
+ *   header: "DPTT", u8 version(1), u8 cores, u16 tasks, u32 cpu_hz,
+ *           u32 events, u32 lost, u32 pre_us, u32 post_us, u32 flags
+ *   sync:   per core: i64 time_us, u32 cycles, u32 valid
+ *   tasks:  u32 handle, char name[16]
+ *   events: dpt_trace_event_t
+ * flags: bit 0 recording, bit 1 pre window cut short by the ring size.
+ * lost counts events the ring overwrote.
+ */
+esp_err_t dpt_trace_dump(esp_err_t (*write)(void *ctx, const void *data, size_t len), void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,35 @@
+/**
+ * @file dpt_trace_hooks.h
+ * @brief FreeRTOS trace hooks feeding dpt_trace
+ *
+ * Force-included into every component by the top-level CMakeLists.txt, so
+ * it must stay safe for assembler and C++ sources and must not include any
+ * FreeRTOS header itself. FreeRTOS only defines the hooks it does not find
+ * defined already. The kernel calls the task switch hook from the
+ * scheduler; the handler lives in IRAM.
+ *
+ * IDF's port only calls traceISR_ENTER/EXIT in SystemView builds, so
+ * interrupts are traced from the dpt_isrstat wrapper instead.
+ */
+
+#pragma once
+
+#include "sdkconfig.h"
+
+#if !defined(__ASSEMBLER__) && !CONFIG_APPTRACE_SV_ENABLE   // SystemView brings its own hooks
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void dpt_trace_task_switched_in(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define traceTASK_SWITCHED_IN()         dpt_trace_task_switched_in()
+
+#endif
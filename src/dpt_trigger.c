@@ -0,0 +1,273 @@
+/**
+ * @file dpt_trigger.c
+ * @brief Glitch-filtered trigger inputs
+ *
+ * Every input has a PCNT unit counting falling edges through the unit's
+ * glitch filter, with its high limit at 1: the first accepted edge reaches
+ * the limit, which resets the count and raises the watch point interrupt.
+ * The lockout is checked against esp_timer in the interrupt.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "soc/soc_caps.h"
+#include "dpt_trigger.h"
+#include "dpt_interlock.h"
+#include "dpt_pins.h"
+#include "dpt_preset.h"
+#include "dpt_rmt.h"
+#include "dpt_thermal.h"
+#include "dpt_trace.h"
+
+#if SOC_PCNT_SUPPORTED
+#include "driver/pulse_cnt.h"
+#endif
+
+#define TAG "DPT_TRIGGER"
+
+#define DEFAULT_FILTER_NS       10000
+#define DEFAULT_LOCKOUT_US      20000
+
+typedef struct {
+    gpio_num_t gpio;
+    volatile int preset;
+    dpt_trigger_isr_t handler;
+    void *arg;
+    int64_t last_accept_us;
+    volatile uint32_t fires;
+    volatile uint32_t bounces;
+    volatile uint32_t busy;
+    volatile uint32_t empty;
+    volatile uint32_t held;
+    volatile uint32_t hot;
+    volatile uint32_t last_start_cycles;
+#if SOC_PCNT_SUPPORTED
+    pcnt_unit_handle_t unit;
+    pcnt_channel_handle_t chan;
+#endif
+} trigger_input_t;
+
+static trigger_input_t inputs[DPT_TRIGGER_MAX_INPUTS];
+static int num_inputs = 0;
+static uint32_t filter_ns = DEFAULT_FILTER_NS;
+static volatile uint32_t lockout_us = DEFAULT_LOCKOUT_US;
+
+// ---------------------- Accepted Edge ----------------------
+// Returns true if a handler woke a higher-priority task
+static bool IRAM_ATTR on_edge(trigger_input_t *in) {
+    uint32_t entry = esp_cpu_get_cycle_count();
+    int64_t now = esp_timer_get_time();
+    if (in->last_accept_us != 0 && now - in->last_accept_us < lockout_us) {
+        in->bounces++;
+        return false;
+    }
+    in->last_accept_us = now;
+
+    if (in->handler) {
+        in->fires++;
+        return in->handler(in - inputs, in->arg);
+    }
+    const dpt_plan_t *plan = (in->preset >= 0) ? dpt_preset_get(in->preset) : NULL;
+    if (plan == NULL) {
+        in->empty++;
+        return false;
+    }
+    if (!dpt_interlock_isr_allows()) {
+        in->held++;
+        return false;
+    }
+    if (!dpt_thermal_isr_allows(in->preset)) {
+        in->hot++;
+        return false;
+    }
+    if (dpt_rmt_fire_from_isr(plan) != ESP_OK) {
+        in->busy++;
+        return false;
+    }
+    in->last_start_cycles = esp_cpu_get_cycle_count() - entry;
+    in->fires++;
+    return false;
+}
+
+// Handler inputs are the button in this firmware
+static inline uint32_t trace_id(const trigger_input_t *in) {
+    return in->handler ? DPT_TRACE_ISR_BUTTON : DPT_TRACE_ISR_TRIGGER;
+}
+
+#if SOC_PCNT_SUPPORTED
+
+// ---------------------- PCNT Inputs ----------------------
+static bool IRAM_ATTR pcnt_reach(pcnt_unit_handle_t unit, const pcnt_watch_event_data_t *edata, void *user_ctx) {
+    dpt_trace_isr_enter(trace_id(user_ctx));
+    bool woken = on_edge(user_ctx);
+    dpt_trace_isr_exit();
+    return woken;   // The driver yields on return
+}
+
+static esp_err_t setup_input(trigger_input_t *in) {
+    pcnt_unit_config_t unit_config = {
+        .low_limit = -1,
+        .high_limit = 1,    // The first edge reaches it and resets the count
+    };
+    esp_err_t err = pcnt_new_unit(&unit_config, &in->unit);
+    if (err != ESP_OK) {
+        return err;
+    }
+    pcnt_glitch_filter_config_t filter_config = { .max_glitch_ns = filter_ns };
+    pcnt_chan_config_t chan_config = { .edge_gpio_num = in->gpio, .level_gpio_num = -1 };
+    pcnt_event_callbacks_t cbs = { .on_reach = pcnt_reach };
+    if (err == ESP_OK && filter_ns > 0) err = pcnt_unit_set_glitch_filter(in->unit, &filter_config);
+    if (err == ESP_OK) err = pcnt_new_channel(in->unit, &chan_config, &in->chan);
+    // Falling edge (switch closes) counts, rising edge holds
+    if (err == ESP_OK) err = pcnt_channel_set_edge_action(in->chan, PCNT_CHANNEL_EDGE_ACTION_HOLD,
+                                                          PCNT_CHANNEL_EDGE_ACTION_INCREASE);
+    if (err == ESP_OK) err = gpio_pullup_en(in->gpio);
+    if (err == ESP_OK) err = pcnt_unit_add_watch_point(in->unit, 1);
+    if (err == ESP_OK) err = pcnt_unit_register_event_callbacks(in->unit, &cbs, in);
+    if (err == ESP_OK) err = pcnt_unit_enable(in->unit);
+    if (err == ESP_OK) err = pcnt_unit_clear_count(in->unit);
+    if (err == ESP_OK) err = pcnt_unit_start(in->unit);
+    return err;
+}
+
+// The filter can only be set on a disabled unit
+static esp_err_t apply_filter(trigger_input_t *in) {
+    pcnt_glitch_filter_config_t filter_config = { .max_glitch_ns = filter_ns };
+    esp_err_t err = pcnt_unit_stop(in->unit);
+    if (err == ESP_OK) err = pcnt_unit_disable(in->unit);
+    if (err == ESP_OK) err = pcnt_unit_set_glitch_filter(in->unit, filter_ns > 0 ? &filter_config : NULL);
+    if (err == ESP_OK) err = pcnt_unit_enable(in->unit);
+    if (err == ESP_OK) err = pcnt_unit_clear_count(in->unit);
+    if (err == ESP_OK) err = pcnt_unit_start(in->unit);
+    return err;
+}
+
+#else
+
+// ---------------------- GPIO Inputs ----------------------
+static void IRAM_ATTR gpio_edge(void *arg) {
+    dpt_trace_isr_enter(trace_id(arg));
+    bool woken = on_edge(arg);
+    dpt_trace_isr_exit();
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static esp_err_t setup_input(trigger_input_t *in) {
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << in->gpio,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_NEGEDGE,
+    };
+    esp_err_t err = gpio_config(&io_conf);
+    if (err == ESP_OK) err = gpio_isr_handler_add(in->gpio, gpio_edge, in);
+    return err;
+}
+
+static esp_err_t apply_filter(trigger_input_t *in) {
+    return ESP_OK;      // Nothing in hardware to set
+}
+
+#endif
+
+// ---------------------- Inputs ----------------------
+static esp_err_t add_input(gpio_num_t gpio, int preset, dpt_trigger_isr_t handler, void *arg, int *input) {
+    if (num_inputs >= DPT_TRIGGER_MAX_INPUTS) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (preset != DPT_TRIGGER_NO_PRESET && (preset < 0 || preset >= DPT_PRESET_SLOTS)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = dpt_pins_claim(gpio, DPT_PIN_TRIGGER);
+    if (err != ESP_OK) {
+        return err;
+    }
+    trigger_input_t *in = &inputs[num_inputs];
+    memset(in, 0, sizeof(*in));
+    in->gpio = gpio;
+    in->preset = preset;
+    in->handler = handler;
+    in->arg = arg;
+    err = setup_input(in);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "GPIO%d: %s", gpio, esp_err_to_name(err));
+        return err;
+    }
+    if (input) {
+        *input = num_inputs;
+    }
+    num_inputs++;
+    ESP_LOGI(TAG, "Input %d on GPIO%d: %s, filter %" PRIu32 " ns, lockout %" PRIu32 " us", num_inputs - 1, gpio,
+             handler ? "handler" : "preset", filter_ns, lockout_us);
+    return ESP_OK;
+}
+
+esp_err_t dpt_trigger_add(gpio_num_t gpio, int preset, int *input) {
+    return add_input(gpio, preset, NULL, NULL, input);
+}
+
+esp_err_t dpt_trigger_add_isr(gpio_num_t gpio, dpt_trigger_isr_t handler, void *arg, int *input) {
+    if (handler == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return add_input(gpio, DPT_TRIGGER_NO_PRESET, handler, arg, input);
+}
+
+esp_err_t dpt_trigger_map(int input, int preset) {
+    if (input < 0 || input >= num_inputs || inputs[input].handler != NULL ||
+        (preset != DPT_TRIGGER_NO_PRESET && (preset < 0 || preset >= DPT_PRESET_SLOTS))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    inputs[input].preset = preset;
+    return ESP_OK;
+}
+
+esp_err_t dpt_trigger_set_filter(uint32_t new_filter_ns, uint32_t new_lockout_us) {
+    if (new_filter_ns > DPT_TRIGGER_MAX_FILTER_NS || new_lockout_us > DPT_TRIGGER_MAX_LOCKOUT_US) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    lockout_us = new_lockout_us;
+    if (new_filter_ns == filter_ns) {
+        return ESP_OK;
+    }
+    filter_ns = new_filter_ns;
+    for (int i = 0; i < num_inputs; i++) {
+        esp_err_t err = apply_filter(&inputs[i]);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Input %d: cannot set filter: %s", i, esp_err_to_name(err));
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+void dpt_trigger_get_filter(uint32_t *out_filter_ns, uint32_t *out_lockout_us) {
+    *out_filter_ns = filter_ns;
+    *out_lockout_us = lockout_us;
+}
+
+bool dpt_trigger_get(int input, dpt_trigger_info_t *out) {
+    if (input < 0 || input >= num_inputs) {
+        return false;
+    }
+    const trigger_input_t *in = &inputs[input];
+    out->gpio = in->gpio;
+    out->preset = in->preset;
+    out->has_handler = in->handler != NULL;
+    out->fires = in->fires;
+    out->bounces = in->bounces;
+    out->busy = in->busy;
+    out->empty = in->empty;
+    out->held = in->held;
+    out->hot = in->hot;
+    out->last_start_ns = (uint32_t)((uint64_t)in->last_start_cycles * 1000 / esp_rom_get_cpu_ticks_per_us());
+    return true;
+}
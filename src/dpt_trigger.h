@@ -0,0 +1,93 @@
+/**
+ * @file dpt_trigger.h
+ * @brief Glitch-filtered trigger inputs
+ *
+ * Each input is a GPIO, active low with the internal pull-up, so a foot
+ * switch or a PLC open-collector output can pull it to ground. Short
+ * glitches are removed in hardware: the pin feeds a PCNT unit whose
+ * glitch filter drops pulses shorter than filter_ns, and the unit's
+ * interrupt fires on the first accepted falling edge. After an accepted
+ * edge the input ignores further edges for lockout_us, which covers
+ * contact bounce without sleeping in a task.
+ *
+ * An input either fires a preset straight from its ISR
+ * (dpt_rmt_fire_from_isr()), or calls a handler of its own. A preset is
+ * not fired while the bus interlock is enabled and the latest ADC frames
+ * do not qualify (dpt_interlock_isr_allows()); the edge is counted in
+ * held instead. Nor is it fired while the selected DUT lacks the thermal
+ * headroom for it (dpt_thermal_isr_allows()), counted in hot.
+ *
+ * Targets without PCNT (the host emulator) use a plain GPIO interrupt
+ * with the lockout only.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DPT_TRIGGER_MAX_INPUTS      4           // One PCNT unit each
+#define DPT_TRIGGER_NO_PRESET       (-1)
+#define DPT_TRIGGER_MAX_FILTER_NS   12700       // 1023 APB cycles, the PCNT filter limit
+#define DPT_TRIGGER_MAX_LOCKOUT_US  1000000
+
+// Handler of an input that does not fire a preset; runs in the ISR and
+// returns true if it woke a higher-priority task
+typedef bool (*dpt_trigger_isr_t)(int input, void *arg);
+
+typedef struct {
+    gpio_num_t gpio;
+    int preset;                 // DPT_TRIGGER_NO_PRESET for handler inputs
+    bool has_handler;
+    uint32_t fires;             // Presets fired / handler calls
+    uint32_t bounces;           // Edges dropped by the lockout
+    uint32_t busy;              // Accepted edges while a shot was in progress
+    uint32_t empty;             // Accepted edges with no preset in the mapped slot
+    uint32_t held;              // Accepted edges refused by the bus interlock
+    uint32_t hot;               // Accepted edges refused for lack of thermal headroom
+    uint32_t last_start_ns;     // Trigger ISR entry to both channels started, last fire
+} dpt_trigger_info_t;
+
+/**
+ * @brief Filter settings for all inputs
+ *
+ * Can be changed while inputs are live.
+ *
+ * @return ESP_ERR_INVALID_ARG above DPT_TRIGGER_MAX_FILTER_NS or
+ *         DPT_TRIGGER_MAX_LOCKOUT_US
+ */
+esp_err_t dpt_trigger_set_filter(uint32_t filter_ns, uint32_t lockout_us);
+
+void dpt_trigger_get_filter(uint32_t *filter_ns, uint32_t *lockout_us);
+
+/**
+ * @brief Add an input that fires a preset (or DPT_TRIGGER_NO_PRESET for none yet)
+ *
+ * @param[out] input Index for dpt_trigger_map() and dpt_trigger_get()
+ */
+esp_err_t dpt_trigger_add(gpio_num_t gpio, int preset, int *input);
+
+/**
+ * @brief Add an input that calls a handler from its ISR instead
+ */
+esp_err_t dpt_trigger_add_isr(gpio_num_t gpio, dpt_trigger_isr_t handler, void *arg, int *input);
+
+/**
+ * @brief Map a preset input to another preset slot, or DPT_TRIGGER_NO_PRESET
+ */
+esp_err_t dpt_trigger_map(int input, int preset);
+
+/**
+ * @brief Settings and counters of an input; false past the last input
+ */
+bool dpt_trigger_get(int input, dpt_trigger_info_t *out);
+
+#ifdef __cplusplus
+}
+#endif
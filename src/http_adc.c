@@ -0,0 +1,99 @@
+/**
+ * @file http_adc.c
+ * @brief GET/POST /adc: load current and bus voltage capture
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "dpt_adc.h"
+#include "http_handlers.h"
+
+#define TAG "DPT_HTTP"
+
+static const char *const adc_signal_names[DPT_ADC_SIGNALS] = { "current", "vbus" };
+
+// GET /adc: capture configuration, latest values (A, V) and the last shot's peaks
+static esp_err_t adc_handler(httpd_req_t *req) {
+    dpt_adc_config_t cfg;
+    dpt_adc_stats_t st;
+    dpt_adc_get_config(&cfg);
+    dpt_adc_get_stats(&st);
+
+    char buf[512];
+    httpd_resp_set_type(req, "application/json");
+    int len = snprintf(buf, sizeof(buf),
+        "{\"enabled\":%s,\"sample_hz\":%d,\"frames\":%" PRIu32 ",\"samples\":%" PRIu32 ",\"overflows\":%" PRIu32 ","
+        "\"peaks\":%" PRIu32 ",\"peak_timeouts\":%" PRIu32,
+        cfg.enabled ? "true" : "false", DPT_ADC_SAMPLE_HZ, st.frames, st.samples, st.overflows,
+        st.peaks, st.peak_timeouts);
+    for (int s = 0; s < DPT_ADC_SIGNALS; s++) {
+        const dpt_adc_input_t *in = &cfg.in[s];
+        len += snprintf(buf + len, sizeof(buf) - len,
+                        ",\"%s\":{\"gpio\":%d,\"scale\":%.4f,\"offset_mv\":%.1f,\"value\":%.3f,\"last_peak\":%.3f}",
+                        adc_signal_names[s], in->gpio, in->scale, in->offset_mv, st.value[s], st.last_peak[s]);
+    }
+    len += snprintf(buf + len, sizeof(buf) - len, "}");
+    httpd_resp_send(req, buf, len);
+    return ESP_OK;
+}
+
+// POST /adc: enable=0|1 and per signal (current, vbus): <signal>_gpio=GPIO
+// (-1: unused), <signal>_scale=A or V per V at the pad, <signal>_offset_mv=
+// pad mV that reads as zero
+static esp_err_t adc_config_handler(httpd_req_t *req) {
+    char content[256];
+    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
+    if (ret <= 0) {
+        ESP_LOGW(TAG, "Failed to receive request body");
+        return ESP_FAIL;
+    }
+    content[ret] = '\0';
+
+    dpt_adc_config_t cfg;
+    dpt_adc_get_config(&cfg);
+    char key[24];
+    char param_val[16];
+    if (httpd_query_key_value(content, "enable", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.enabled = atoi(param_val) != 0;
+    }
+    for (int s = 0; s < DPT_ADC_SIGNALS; s++) {
+        dpt_adc_input_t *in = &cfg.in[s];
+        snprintf(key, sizeof(key), "%s_gpio", adc_signal_names[s]);
+        if (httpd_query_key_value(content, key, param_val, sizeof(param_val)) == ESP_OK) {
+            in->gpio = atoi(param_val) < 0 ? -1 : atoi(param_val);
+        }
+        snprintf(key, sizeof(key), "%s_scale", adc_signal_names[s]);
+        if (httpd_query_key_value(content, key, param_val, sizeof(param_val)) == ESP_OK) {
+            in->scale = atof(param_val);
+        }
+        snprintf(key, sizeof(key), "%s_offset_mv", adc_signal_names[s]);
+        if (httpd_query_key_value(content, key, param_val, sizeof(param_val)) == ESP_OK) {
+            in->offset_mv = atof(param_val);
+        }
+    }
+    esp_err_t err = dpt_adc_configure(&cfg);
+    if (err == ESP_ERR_NOT_SUPPORTED) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_sendstr(req, "No continuous ADC on this target");
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "current_gpio and vbus_gpio must be different ADC1 pads (GPIO 1-10) no other function holds");
+        return ESP_FAIL;
+    }
+
+    char response[80];
+    int len = snprintf(response, sizeof(response), "ADC capture: %s, current on GPIO%d, vbus on GPIO%d",
+                       cfg.enabled ? "enabled" : "disabled", cfg.in[DPT_ADC_CURRENT].gpio, cfg.in[DPT_ADC_VBUS].gpio);
+    httpd_resp_send(req, response, len);
+    return ESP_OK;
+}
+static const httpd_uri_t uri_adc = { .uri = "/adc", .method = HTTP_GET, .handler = adc_handler };
+static const httpd_uri_t uri_adc_config = { .uri = "/adc", .method = HTTP_POST, .handler = adc_config_handler };
+
+void http_adc_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_adc);
+    httpd_register_uri_handler(server, &uri_adc_config);
+}
@@ -0,0 +1,210 @@
+/**
+ * @file http_batch.c
+ * @brief GET/POST /batch: multi-DUT batch runs through the relay matrix
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "dpt_baked.h"
+#include "dpt_batch.h"
+#include "http_handlers.h"
+
+#define TAG "DPT_HTTP"
+
+// GET /batch: the current or last batch, one entry per position
+//   {"state":"done","positions":N,"done":D,"passed":P,"failed":F,"shots":S,"elapsed_ms":T,
+//    "recipes":["name",..],"duts":[{"dut":P,"verdict":"fail","fail_metric":"peak_a",
+//    "fail_recipe":R,"error":"","last":[{"peak_a":A,"td_on_ns":null,..,"pass":false},..]},..]}
+// A metric that was not captured is null.
+static esp_err_t batch_handler(httpd_req_t *req) {
+    static dpt_batch_status_t st;       // Close to 2 KB; kept off the httpd task's stack
+    static dpt_batch_config_t cfg;
+    dpt_batch_get_status(&st);
+    dpt_batch_get_config(&cfg);
+
+    char buf[384];
+    httpd_resp_set_type(req, "application/json");
+    int len = snprintf(buf, sizeof(buf),
+        "{\"state\":\"%s\",\"positions\":%u,\"done\":%u,\"passed\":%u,\"failed\":%u,\"shots\":%" PRIu32 ","
+        "\"elapsed_ms\":%" PRId64 ",\"recipes\":[",
+        dpt_batch_state_name(st.state), st.num_duts, st.done, st.passed, st.failed, st.shots, st.elapsed_us / 1000);
+    for (int r = 0; r < cfg.num_recipes; r++) {
+        len += snprintf(buf + len, sizeof(buf) - len, "%s\"%s\"", r ? "," : "", cfg.recipe[r]->name);
+    }
+    len += snprintf(buf + len, sizeof(buf) - len, "],\"duts\":[");
+    httpd_resp_send_chunk(req, buf, len);
+
+    for (int k = 0; k < st.num_duts; k++) {
+        const dpt_batch_dut_t *d = &st.dut[k];
+        len = snprintf(buf, sizeof(buf),
+            "%s{\"dut\":%u,\"verdict\":\"%s\",\"fail_metric\":\"%s\",\"fail_recipe\":%d,\"error\":\"%s\",\"last\":[",
+            k ? "," : "", d->position, dpt_batch_verdict_name(d->verdict),
+            d->fail_metric >= 0 ? dpt_batch_metric_name(d->fail_metric) : "", d->fail_recipe,
+            d->verdict == DPT_BATCH_ERROR ? esp_err_to_name(d->error) : "");
+        int recipes = d->verdict == DPT_BATCH_PENDING ? 0 : cfg.num_recipes;
+        for (int r = 0; r < recipes; r++) {
+            const dpt_batch_measure_t *m = &d->last[r];
+            len += snprintf(buf + len, sizeof(buf) - len, "%s{", r ? "," : "");
+            for (int i = 0; i < DPT_BATCH_METRICS; i++) {
+                if (m->valid & (1u << i)) {
+                    len += snprintf(buf + len, sizeof(buf) - len, "\"%s\":%.3f,", dpt_batch_metric_name(i),
+                                    m->value[i]);
+                } else {
+                    len += snprintf(buf + len, sizeof(buf) - len, "\"%s\":null,", dpt_batch_metric_name(i));
+                }
+            }
+            len += snprintf(buf + len, sizeof(buf) - len, "\"pass\":%s}", m->pass ? "true" : "false");
+        }
+        len += snprintf(buf + len, sizeof(buf) - len, "]}");
+        httpd_resp_send_chunk(req, buf, len);
+    }
+    httpd_resp_send_chunk(req, "]}", 2);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// metric[@recipe]:min:max,.. into limits; an empty min or max is open.
+// Returns how many were read, -1 on a malformed entry.
+static int parse_limits(char *src, dpt_batch_limit_t *dst, int max) {
+    int n = 0;
+    for (char *save, *item = strtok_r(src, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        char *min = strchr(item, ':');
+        char *lim_max = min ? strchr(min + 1, ':') : NULL;
+        if (!lim_max || n >= max) {
+            return -1;
+        }
+        *min++ = '\0';
+        *lim_max++ = '\0';
+        char *at = strchr(item, '@');
+        dpt_batch_limit_t *lim = &dst[n];
+        lim->recipe = DPT_BATCH_ALL_RECIPES;
+        if (at) {
+            *at = '\0';
+            lim->recipe = atoi(at + 1);
+        }
+        lim->metric = DPT_BATCH_METRICS;
+        for (int i = 0; i < DPT_BATCH_METRICS; i++) {
+            if (strcmp(item, dpt_batch_metric_name(i)) == 0) lim->metric = i;
+        }
+        if (lim->metric == DPT_BATCH_METRICS) {
+            return -1;
+        }
+        lim->min = *min ? strtof(min, NULL) : -INFINITY;
+        lim->max = *lim_max ? strtof(lim_max, NULL) : INFINITY;
+        n++;
+    }
+    return n;
+}
+
+// POST /batch starts a batch: lines=GPIO,.. (matrix select lines),
+// enable=GPIO (-1 for none), matrix=onehot|binary, active_low=0|1,
+// settle_ms=N, duts=P,.. (positions in test order), recipes=name,..
+// (baked), shots=N per recipe, interval_ms=N,
+// limits=metric[@recipe]:min:max,.. with metrics peak_a, vbus_v,
+// td_on_ns, td_off_ns and tj_c. Omitted keys keep the last batch's
+// values; limits= with nothing clears them. stop=1 ends a batch.
+static esp_err_t batch_start_handler(httpd_req_t *req) {
+    char content[512];
+    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
+    if (ret <= 0) {
+        ESP_LOGW(TAG, "Failed to receive request body");
+        return ESP_FAIL;
+    }
+    content[ret] = '\0';
+
+    char param_val[256];
+    if (httpd_query_key_value(content, "stop", param_val, sizeof(param_val)) == ESP_OK && atoi(param_val)) {
+        dpt_batch_stop();
+        httpd_resp_sendstr(req, "Batch stopping");
+        return ESP_OK;
+    }
+
+    dpt_batch_config_t cfg;
+    dpt_batch_get_config(&cfg);
+    float values[DPT_BATCH_SELECT_LINES];
+    if (httpd_query_key_value(content, "lines", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.num_lines = http_parse_floats(param_val, values, DPT_BATCH_SELECT_LINES);
+        for (int k = 0; k < cfg.num_lines; k++) {
+            cfg.select_gpio[k] = (int8_t)values[k];
+        }
+    }
+    if (httpd_query_key_value(content, "enable", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.enable_gpio = atoi(param_val);
+    }
+    if (httpd_query_key_value(content, "matrix", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.matrix = strcmp(param_val, "binary") == 0 ? DPT_BATCH_BINARY : DPT_BATCH_ONE_HOT;
+    }
+    if (httpd_query_key_value(content, "active_low", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.active_low = atoi(param_val) != 0;
+    }
+    if (httpd_query_key_value(content, "settle_ms", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.settle_ms = strtoul(param_val, NULL, 10);
+    }
+    if (httpd_query_key_value(content, "duts", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.num_duts = http_parse_floats(param_val, values, DPT_BATCH_MAX_DUTS);
+        for (int k = 0; k < cfg.num_duts; k++) {
+            cfg.dut[k] = values[k] >= 0 ? (uint8_t)values[k] : DPT_BATCH_MAX_DUTS;
+        }
+    }
+    if (httpd_query_key_value(content, "shots", param_val, sizeof(param_val)) == ESP_OK) {
+        unsigned long shots = strtoul(param_val, NULL, 10);
+        cfg.shots = shots <= 255 ? shots : 0;
+    }
+    if (httpd_query_key_value(content, "interval_ms", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.interval_ms = strtoul(param_val, NULL, 10);
+    }
+    if (httpd_query_key_value(content, "recipes", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.num_recipes = 0;
+        for (char *save, *name = strtok_r(param_val, ",", &save); name; name = strtok_r(NULL, ",", &save)) {
+            const dpt_baked_recipe_t *baked = dpt_baked_find(name);
+            if (!baked || cfg.num_recipes >= DPT_BATCH_MAX_RECIPES) {
+                httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No baked recipe of that name, or more than 8");
+                return ESP_FAIL;
+            }
+            cfg.recipe[cfg.num_recipes++] = baked;
+        }
+    }
+    if (httpd_query_key_value(content, "limits", param_val, sizeof(param_val)) == ESP_OK) {
+        int n = parse_limits(param_val, cfg.limit, DPT_BATCH_MAX_LIMITS);
+        if (n < 0) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                                "Limits are metric[@recipe]:min:max, at most 8; metrics are peak_a, vbus_v, "
+                                "td_on_ns, td_off_ns, tj_c");
+            return ESP_FAIL;
+        }
+        cfg.num_limits = n;
+    }
+    esp_err_t err = dpt_batch_start(&cfg);
+    if (err == ESP_ERR_INVALID_STATE) {
+        httpd_resp_set_status(req, "409 Conflict");
+        httpd_resp_sendstr(req, "A batch is in progress");
+        return ESP_OK;
+    }
+    if (err == ESP_ERR_INVALID_CRC) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Baked plan does not match its hash");
+        return ESP_FAIL;
+    }
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                            "Need 1-8 distinct free lines, positions the matrix can select (one per line, or "
+                            "2^lines in binary, below 8), 1-8 recipes, shots >= 1, limits on listed recipes "
+                            "with min <= max");
+        return ESP_FAIL;
+    }
+
+    char response[96];
+    int len = snprintf(response, sizeof(response), "Batch started: %u position(s) x %u recipe(s) x %u shot(s)",
+                       cfg.num_duts, cfg.num_recipes, cfg.shots);
+    httpd_resp_send(req, response, len);
+    return ESP_OK;
+}
+static const httpd_uri_t uri_batch = { .uri = "/batch", .method = HTTP_GET, .handler = batch_handler };
+static const httpd_uri_t uri_batch_start = { .uri = "/batch", .method = HTTP_POST, .handler = batch_start_handler };
+
+void http_batch_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_batch);
+    httpd_register_uri_handler(server, &uri_batch_start);
+}
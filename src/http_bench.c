@@ -0,0 +1,128 @@
+/**
+ * @file http_bench.c
+ * @brief GET/POST /bench: A/B timing benchmark of the build profile
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "dpt_baked.h"
+#include "dpt_bench.h"
+#include "http_handlers.h"
+
+#define TAG "DPT_HTTP"
+
+#ifndef DPT_PROFILE
+#define DPT_PROFILE "default"   // Build profile name; the PlatformIO env sets it
+#endif
+
+static int bench_stat_json(char *buf, size_t size, const char *name, const dpt_bench_stat_t *s) {
+    float std = s->count > 1 ? sqrtf(s->m2 / (s->count - 1)) : 0.0f;
+    return snprintf(buf, size,
+                    ",\"%s\":{\"count\":%" PRIu32 ",\"mean_ns\":%.1f,\"std_ns\":%.1f,\"min_ns\":%.1f,\"max_ns\":%.1f}",
+                    name, s->count, s->mean_ns, std, s->min_ns, s->max_ns);
+}
+
+// GET /bench: the running or last benchmark and the build profile it ran on
+//   {"state":"done","recipe":"..","profile":{"name":"..","cpu_mhz":M,"tick_hz":H},"shots":N,
+//    "busy":B,"edge_mismatches":E,"elapsed_ms":T,"last_error":"",
+//    "entry":{"count":N,"mean_ns":..,"std_ns":..,"min_ns":..,"max_ns":..},"start":{..},"wake":{..},
+//    "edge_error":{..}}
+static esp_err_t bench_handler(httpd_req_t *req) {
+    dpt_bench_status_t st;
+    dpt_bench_get_status(&st);
+
+    char buf[768];
+    int len = snprintf(buf, sizeof(buf),
+        "{\"state\":\"%s\",\"recipe\":\"%s\",\"profile\":{\"name\":\"%s\",\"cpu_mhz\":%" PRIu32 ",\"tick_hz\":%u},"
+        "\"shots\":%" PRIu32 ",\"busy\":%" PRIu32 ",\"edge_mismatches\":%" PRIu32 ",\"elapsed_ms\":%" PRId64 ","
+        "\"last_error\":\"%s\"",
+        dpt_bench_state_name(st.state), st.recipe ? st.recipe : "", DPT_PROFILE, esp_rom_get_cpu_ticks_per_us(),
+        (unsigned)configTICK_RATE_HZ, st.shots, st.busy, st.edge_mismatches, st.elapsed_us / 1000,
+        st.state == DPT_BENCH_FAILED ? esp_err_to_name(st.last_error) : "");
+    len += bench_stat_json(buf + len, sizeof(buf) - len, "entry", &st.entry);
+    len += bench_stat_json(buf + len, sizeof(buf) - len, "start", &st.start);
+    len += bench_stat_json(buf + len, sizeof(buf) - len, "wake", &st.wake);
+    len += bench_stat_json(buf + len, sizeof(buf) - len, "edge_error", &st.edge_error);
+    len += snprintf(buf + len, sizeof(buf) - len, "}");
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, buf, len);
+    return ESP_OK;
+}
+
+// POST /bench: recipe=name (baked, default the first one), shots=N (default
+// 2000), interval_ms=N (default 5); stop=1 ends a run
+static esp_err_t bench_start_handler(httpd_req_t *req) {
+    char content[128];
+    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
+    if (ret <= 0) {
+        ESP_LOGW(TAG, "Failed to receive request body");
+        return ESP_FAIL;
+    }
+    content[ret] = '\0';
+
+    char param_val[48];
+    if (httpd_query_key_value(content, "stop", param_val, sizeof(param_val)) == ESP_OK && atoi(param_val)) {
+        dpt_bench_stop();
+        httpd_resp_sendstr(req, "Benchmark stopping");
+        return ESP_OK;
+    }
+
+    dpt_bench_config_t cfg = {
+        .recipe = dpt_baked_count > 0 ? &dpt_baked_recipes[0] : NULL,
+        .shots = 2000,
+        .interval_ms = 5,
+    };
+    if (httpd_query_key_value(content, "recipe", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.recipe = dpt_baked_find(param_val);
+        if (!cfg.recipe) {
+            httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No baked recipe of that name");
+            return ESP_FAIL;
+        }
+    }
+    if (httpd_query_key_value(content, "shots", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.shots = strtoul(param_val, NULL, 10);
+    }
+    if (httpd_query_key_value(content, "interval_ms", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.interval_ms = strtoul(param_val, NULL, 10);
+    }
+
+    esp_err_t err = dpt_bench_start(&cfg);
+    if (err == ESP_ERR_INVALID_STATE) {
+        httpd_resp_set_status(req, "409 Conflict");
+        httpd_resp_sendstr(req, "A benchmark is in progress");
+        return ESP_OK;
+    }
+    if (err == ESP_ERR_INVALID_CRC) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Baked plan does not match its hash");
+        return ESP_FAIL;
+    }
+    if (err == ESP_ERR_INVALID_SIZE) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Plan does not fit one RMT RAM block per channel");
+        return ESP_FAIL;
+    }
+    if (err == ESP_ERR_NO_MEM) {
+        return http_send_pool_error(req, sizeof(dpt_plan_t), err);
+    }
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Need shots=1..100000 and interval_ms >= 1");
+        return ESP_FAIL;
+    }
+
+    char response[96];
+    int len = snprintf(response, sizeof(response), "Benchmark started: '%s' %" PRIu32 " time(s)", cfg.recipe->name,
+                       cfg.shots);
+    httpd_resp_send(req, response, len);
+    return ESP_OK;
+}
+static const httpd_uri_t uri_bench = { .uri = "/bench", .method = HTTP_GET, .handler = bench_handler };
+static const httpd_uri_t uri_bench_start = { .uri = "/bench", .method = HTTP_POST, .handler = bench_start_handler };
+
+void http_bench_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_bench);
+    httpd_register_uri_handler(server, &uri_bench_start);
+}
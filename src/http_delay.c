@@ -0,0 +1,126 @@
+/**
+ * @file http_delay.c
+ * @brief GET/POST /delay: DUT switching delays from the comparator inputs
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "dpt_delay.h"
+#include "dpt_pool.h"
+#include "http_handlers.h"
+
+#define TAG "DPT_HTTP"
+
+static void send_delay_stat(httpd_req_t *req, char *buf, size_t size, const char *name, const dpt_delay_stat_t *st) {
+    float var = st->count > 1 ? st->m2 / (st->count - 1) : 0.0f;
+    int len = snprintf(buf, size,
+        "\"%s\":{\"count\":%" PRIu32 ",\"mean_ns\":%.1f,\"std_ns\":%.1f,\"min_ns\":%.1f,\"max_ns\":%.1f}",
+        name, st->count, st->mean_ticks * 12.5f, sqrtf(var) * 12.5f,
+        st->count ? st->min_ticks * 12.5f : 0.0f, st->count ? st->max_ticks * 12.5f : 0.0f);
+    httpd_resp_send_chunk(req, buf, len);
+}
+
+// GET /delay: td(on)/td(off) per comparator input, running statistics
+// across shots and sweeps, and the last shot's delays per commanded edge.
+// Times are RMT ticks (12.5 ns) in "edges", ns in the statistics.
+static esp_err_t delay_handler(httpd_req_t *req) {
+    static const char *const input_names[DPT_DELAY_INPUTS] = { "gate", "vds" };
+    dpt_delay_config_t cfg;
+    dpt_delay_stats_t *st;
+    esp_err_t err = dpt_pool_alloc(sizeof(*st), (void **)&st);
+    if (err != ESP_OK) {
+        return http_send_pool_error(req, sizeof(*st), err);
+    }
+    dpt_delay_get_config(&cfg);
+    dpt_delay_get_stats(st);
+
+    char buf[256];
+    httpd_resp_set_type(req, "application/json");
+    int len = snprintf(buf, sizeof(buf),
+        "{\"enabled\":%s,\"shots\":%" PRIu32 ",\"missed\":%" PRIu32 ",\"overflows\":%" PRIu32 ","
+        "\"plan_mismatches\":%" PRIu32 ",\"inputs\":[",
+        cfg.enabled ? "true" : "false", st->shots, st->missed, st->overflows, st->plan_mismatches);
+    httpd_resp_send_chunk(req, buf, len);
+    for (int in = 0; in < DPT_DELAY_INPUTS; in++) {
+        len = snprintf(buf, sizeof(buf), "%s{\"name\":\"%s\",\"gpio\":%d,\"on_edge\":\"%s\",", in ? "," : "",
+                       input_names[in], cfg.gpio[in], cfg.on_rising[in] ? "rise" : "fall");
+        httpd_resp_send_chunk(req, buf, len);
+        send_delay_stat(req, buf, sizeof(buf), "td_on", &st->stat[in][1]);
+        httpd_resp_send_chunk(req, ",", 1);
+        send_delay_stat(req, buf, sizeof(buf), "td_off", &st->stat[in][0]);
+        httpd_resp_send_chunk(req, "}", 1);
+    }
+    len = snprintf(buf, sizeof(buf), "],\"last\":{\"plan_hash\":\"%08" PRIx32 "\",\"plan_edges\":%" PRIu32 ",\"edges\":[",
+                   st->last_plan_hash, st->last_plan_edges);
+    httpd_resp_send_chunk(req, buf, len);
+    for (uint32_t k = 0; k < st->last_num_edges; k++) {
+        const dpt_delay_edge_t *e = &st->last[k];
+        len = snprintf(buf, sizeof(buf), "%s{\"tick\":%" PRIu32 ",\"dir\":\"%s\",\"gate\":%" PRId32 ",\"vds\":%" PRId32 "}",
+                       k ? "," : "", e->tick, e->rising ? "on" : "off",
+                       e->delay_ticks[DPT_DELAY_GATE], e->delay_ticks[DPT_DELAY_VDS]);
+        httpd_resp_send_chunk(req, buf, len);
+    }
+    dpt_pool_free(st);
+    httpd_resp_send_chunk(req, "]}}", 3);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// POST /delay: enable=0|1, gate=GPIO, vds=GPIO (-1: unused),
+// gate_on=rise|fall, vds_on=rise|fall, reset=1 clears the statistics
+static esp_err_t delay_config_handler(httpd_req_t *req) {
+    static const char *const gpio_keys[DPT_DELAY_INPUTS] = { "gate", "vds" };
+    static const char *const edge_keys[DPT_DELAY_INPUTS] = { "gate_on", "vds_on" };
+    char content[128];
+    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
+    if (ret <= 0) {
+        ESP_LOGW(TAG, "Failed to receive request body");
+        return ESP_FAIL;
+    }
+    content[ret] = '\0';
+
+    dpt_delay_config_t cfg;
+    dpt_delay_get_config(&cfg);
+    char param_val[12];
+    if (httpd_query_key_value(content, "reset", param_val, sizeof(param_val)) == ESP_OK && atoi(param_val)) {
+        dpt_delay_reset();
+    }
+    if (httpd_query_key_value(content, "enable", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.enabled = atoi(param_val) != 0;
+    }
+    for (int in = 0; in < DPT_DELAY_INPUTS; in++) {
+        if (httpd_query_key_value(content, gpio_keys[in], param_val, sizeof(param_val)) == ESP_OK) {
+            cfg.gpio[in] = atoi(param_val) < 0 ? -1 : atoi(param_val);
+        }
+        if (httpd_query_key_value(content, edge_keys[in], param_val, sizeof(param_val)) == ESP_OK) {
+            cfg.on_rising[in] = strcmp(param_val, "fall") != 0;
+        }
+    }
+
+    esp_err_t err = dpt_delay_configure(&cfg);
+    if (err == ESP_ERR_NOT_SUPPORTED) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_sendstr(req, "No MCPWM capture on this target");
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "gate and vds must be different GPIOs no other function holds");
+        return ESP_FAIL;
+    }
+
+    char response[80];
+    int len = snprintf(response, sizeof(response), "Delay capture: %s, gate GPIO%d, vds GPIO%d",
+                       cfg.enabled ? "enabled" : "disabled", cfg.gpio[DPT_DELAY_GATE], cfg.gpio[DPT_DELAY_VDS]);
+    httpd_resp_send(req, response, len);
+    return ESP_OK;
+}
+static const httpd_uri_t uri_delay = { .uri = "/delay", .method = HTTP_GET, .handler = delay_handler };
+static const httpd_uri_t uri_delay_config = { .uri = "/delay", .method = HTTP_POST, .handler = delay_config_handler };
+
+void http_delay_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_delay);
+    httpd_register_uri_handler(server, &uri_delay_config);
+}
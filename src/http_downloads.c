@@ -0,0 +1,37 @@
+/**
+ * @file http_downloads.c
+ * @brief GET /downloads: throughput of each download type
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "dpt_stream.h"
+#include "dpt_trace.h"
+#include "http_handlers.h"
+
+// GET /downloads reports each download type's throughput (src/dpt_stream.h):
+//   {"trace_arms_skipped":N,"streams":[{"name":"trace","downloads":N,"failed":F,"bytes":B,
+//    "last_bytes":L,"last_us":T,"last_bytes_per_s":R,"best_bytes_per_s":R,"max_send_us":S},..]}
+static esp_err_t downloads_handler(httpd_req_t *req) {
+    char buf[256];
+    dpt_stream_stats_t st;
+    httpd_resp_set_type(req, "application/json");
+    int len = snprintf(buf, sizeof(buf), "{\"trace_arms_skipped\":%" PRIu32 ",\"streams\":[", dpt_trace_arms_skipped());
+    httpd_resp_send_chunk(req, buf, len);
+    for (int i = 0; dpt_stream_get_stats(i, &st); i++) {
+        len = snprintf(buf, sizeof(buf),
+            "%s{\"name\":\"%s\",\"downloads\":%" PRIu32 ",\"failed\":%" PRIu32 ",\"bytes\":%" PRIu64 ","
+            "\"last_bytes\":%" PRIu32 ",\"last_us\":%" PRIu32 ",\"last_bytes_per_s\":%" PRIu32 ","
+            "\"best_bytes_per_s\":%" PRIu32 ",\"max_send_us\":%" PRIu32 "}",
+            i ? "," : "", st.name, st.downloads, st.failed, st.bytes, st.last_bytes, st.last_us,
+            st.last_bytes_per_s, st.best_bytes_per_s, st.max_send_us);
+        httpd_resp_send_chunk(req, buf, len);
+    }
+    httpd_resp_send_chunk(req, "]}", 2);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+static const httpd_uri_t uri_downloads = { .uri = "/downloads", .method = HTTP_GET, .handler = downloads_handler };
+
+void http_downloads_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_downloads);
+}
@@ -0,0 +1,30 @@
+/**
+ * @file http_handlers.c
+ * @brief Helpers shared by the http_*.c endpoint files
+ */
+
+#include <stdlib.h>
+#include "esp_log.h"
+#include "http_handlers.h"
+
+#define TAG "DPT_HTTP"
+
+esp_err_t http_send_pool_error(httpd_req_t *req, size_t size, esp_err_t err) {
+    ESP_LOGW(TAG, "No %zu-byte buffer for %s: %s", size, req->uri, esp_err_to_name(err));
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_sendstr(req, err == ESP_ERR_NO_MEM ? "All buffers of this size are in use, retry" : esp_err_to_name(err));
+    return ESP_FAIL;
+}
+
+int http_parse_floats(const char *src, float *dst, int max) {
+    int n = 0;
+    while (n < max && *src) {
+        char *end;
+        dst[n++] = strtof(src, &end);
+        if (*end != ',') {
+            break;
+        }
+        src = end + 1;
+    }
+    return n;
+}
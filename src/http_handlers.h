@@ -0,0 +1,104 @@
+/**
+ * @file http_handlers.h
+ * @brief Web API endpoints, one http_*.c file per feature
+ *
+ * start_webserver() in main_rmt.c registers the core endpoints (/, /set,
+ * /trigger, /status) itself and calls each feature's register function
+ * for the rest. Every handler keeps to its feature's module API.
+ */
+
+#pragma once
+
+#include "esp_http_server.h"
+#include "dpt_plan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ---------------------- Helpers ----------------------
+/**
+ * @brief Answer 503 for a buffer the pools could not provide
+ *
+ * A pool class is exhausted or too small: the client can retry, rather
+ * than see the request fail without a reason.
+ *
+ * @return ESP_FAIL, for the handler to return
+ */
+esp_err_t http_send_pool_error(httpd_req_t *req, size_t size, esp_err_t err);
+
+/**
+ * @brief Read up to max comma-separated floats from src into dst
+ *
+ * @return How many were read
+ */
+int http_parse_floats(const char *src, float *dst, int max);
+
+// ---------------------- Parameters and Armed Plan ----------------------
+// In main_rmt.c
+
+/**
+ * @brief The pulse widths (μs) last set with /set
+ */
+void get_pulse_params(float *p1h, float *p1l, float *p2h, float *p2l);
+
+#define RMT_CLAIM_TIMEOUT_MS    1000    // Longest a trigger-fired shot may keep the RMT
+
+/**
+ * @brief Compile the parameters if a /set is still waiting for its window
+ *
+ * @return The compile error: the armed plan is then stale and must not fire
+ */
+esp_err_t compile_pending(void);
+
+/**
+ * @brief Take the armed plan, waiting for a shot that holds it
+ *
+ * Shots hold it while they own the RMT, so claiming the RMT under it
+ * cannot wait on a shot.
+ */
+dpt_plan_t *armed_plan_lock(void);
+void armed_plan_unlock(void);
+
+/**
+ * @brief Hash of the armed plan, read without waiting for a shot
+ */
+uint32_t armed_plan_hash(void);
+
+/**
+ * @brief Record that the plan under the lock was uploaded with POST /plan
+ *
+ * As armed_plan_set_baked(), without a recipe name.
+ */
+void armed_plan_set_uploaded(void);
+
+/**
+ * @brief Record that the plan under the lock is a baked recipe
+ *
+ * /status reports its name, and a /set that did not compile no longer
+ * holds up shots. The next /set replaces the plan again.
+ */
+void armed_plan_set_baked(const char *name);
+
+// ---------------------- Endpoints ----------------------
+void http_trace_register(httpd_handle_t server);        // /trace
+void http_shots_register(httpd_handle_t server);        // /shots
+void http_selftest_register(httpd_handle_t server);     // /selftest/pins
+void http_triggers_register(httpd_handle_t server);     // /preset, /triggers
+void http_recipes_register(httpd_handle_t server);      // /recipes
+void http_pools_register(httpd_handle_t server);        // /pools
+void http_sweep_register(httpd_handle_t server);        // /sweep
+void http_downloads_register(httpd_handle_t server);    // /downloads
+void http_logic_register(httpd_handle_t server);        // /logic
+void http_delay_register(httpd_handle_t server);        // /delay
+void http_adc_register(httpd_handle_t server);          // /adc
+void http_target_register(httpd_handle_t server);       // /target
+void http_interlock_register(httpd_handle_t server);    // /interlock
+void http_thermal_register(httpd_handle_t server);      // /thermal
+void http_batch_register(httpd_handle_t server);        // /batch
+void http_bench_register(httpd_handle_t server);        // /bench
+void http_plan_register(httpd_handle_t server);         // /plan
+
+#ifdef __cplusplus
+}
+#endif
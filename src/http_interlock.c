@@ -0,0 +1,94 @@
+/**
+ * @file http_interlock.c
+ * @brief GET/POST /interlock: bus voltage window that shots wait for
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "dpt_interlock.h"
+#include "http_handlers.h"
+
+#define TAG "DPT_HTTP"
+
+// GET /interlock: bus window and how long shots were held for it
+static esp_err_t interlock_handler(httpd_req_t *req) {
+    dpt_interlock_config_t cfg;
+    dpt_interlock_stats_t st;
+    dpt_interlock_get_config(&cfg);
+    dpt_interlock_get_stats(&st);
+
+    char buf[384];
+    httpd_resp_set_type(req, "application/json");
+    int len = snprintf(buf, sizeof(buf),
+        "{\"enabled\":%s,\"vbus_min_v\":%.1f,\"vbus_max_v\":%.1f,\"qualify_frames\":%u,\"timeout_ms\":%" PRIu32 ","
+        "\"waits\":%" PRIu32 ",\"held\":%" PRIu32 ",\"timeouts\":%" PRIu32 ","
+        "\"wait_us\":{\"max\":%" PRIu32 ",\"mean\":%.1f},"
+        "\"last\":{\"result\":\"%s\",\"wait_us\":%" PRIu32 ",\"vbus_v\":%.2f}}",
+        cfg.enabled ? "true" : "false", cfg.vbus_min_v, cfg.vbus_max_v, cfg.qualify_frames, cfg.timeout_ms,
+        st.waits, st.held, st.timeouts,
+        st.wait_us_max, st.waits ? (float)st.wait_us_total / st.waits : 0.0f,
+        esp_err_to_name(st.last.result), st.last.wait_us, st.last.vbus_v);
+    httpd_resp_send(req, buf, len);
+    return ESP_OK;
+}
+
+// POST /interlock: enable=0|1, vbus_min=V, vbus_max=V, frames=N (in a row
+// inside the window), timeout_ms=N, reset=1 clears the statistics
+static esp_err_t interlock_config_handler(httpd_req_t *req) {
+    char content[128];
+    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
+    if (ret <= 0) {
+        ESP_LOGW(TAG, "Failed to receive request body");
+        return ESP_FAIL;
+    }
+    content[ret] = '\0';
+
+    dpt_interlock_config_t cfg;
+    dpt_interlock_get_config(&cfg);
+    char param_val[16];
+    if (httpd_query_key_value(content, "reset", param_val, sizeof(param_val)) == ESP_OK && atoi(param_val)) {
+        dpt_interlock_reset();
+    }
+    if (httpd_query_key_value(content, "enable", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.enabled = atoi(param_val) != 0;
+    }
+    if (httpd_query_key_value(content, "vbus_min", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.vbus_min_v = atof(param_val);
+    }
+    if (httpd_query_key_value(content, "vbus_max", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.vbus_max_v = atof(param_val);
+    }
+    if (httpd_query_key_value(content, "frames", param_val, sizeof(param_val)) == ESP_OK) {
+        unsigned long frames = strtoul(param_val, NULL, 10);
+        cfg.qualify_frames = frames <= UINT8_MAX ? frames : 0;
+    }
+    if (httpd_query_key_value(content, "timeout_ms", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.timeout_ms = strtoul(param_val, NULL, 10);
+    }
+
+    esp_err_t err = dpt_interlock_configure(&cfg);
+    if (err == ESP_ERR_NOT_SUPPORTED) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_sendstr(req, "No bus voltage input; configure one with POST /adc");
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Need vbus_min < vbus_max, frames=1..255, timeout_ms >= 1");
+        return ESP_FAIL;
+    }
+
+    char response[96];
+    int len = snprintf(response, sizeof(response), "Bus interlock: %s, %.1f-%.1f V",
+                       cfg.enabled ? "enabled" : "disabled", cfg.vbus_min_v, cfg.vbus_max_v);
+    httpd_resp_send(req, response, len);
+    return ESP_OK;
+}
+static const httpd_uri_t uri_interlock = { .uri = "/interlock", .method = HTTP_GET, .handler = interlock_handler };
+static const httpd_uri_t uri_interlock_config = { .uri = "/interlock", .method = HTTP_POST, .handler = interlock_config_handler };
+
+void http_interlock_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_interlock);
+    httpd_register_uri_handler(server, &uri_interlock_config);
+}
@@ -0,0 +1,127 @@
+/**
+ * @file http_logic.c
+ * @brief GET/POST /logic: logic analyzer captures and configuration
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "dpt_logic.h"
+#include "dpt_plan.h"
+#include "dpt_stream.h"
+#include "http_handlers.h"
+
+#define TAG "DPT_HTTP"
+
+// GET /logic: the last capture and how its P/N edges compare to the plan
+// that was fired; ?format=vcd streams the capture itself
+static esp_err_t logic_handler(httpd_req_t *req) {
+    char query[32];
+    char format[8] = "json";
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        httpd_query_key_value(query, "format", format, sizeof(format));
+    }
+    if (strcmp(format, "vcd") == 0) {
+        dpt_stream_t out;
+        httpd_resp_set_type(req, "text/plain");
+        httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"dpt_logic.vcd\"");
+        dpt_stream_begin(&out, req, DPT_STREAM_LOGIC);
+        if (dpt_logic_export_vcd(dpt_stream_write, &out) == ESP_ERR_NOT_FOUND) {
+            httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No capture yet: enable the logic analyzer and fire a shot");
+            return ESP_FAIL;
+        }
+        return dpt_stream_end(&out);
+    }
+
+    dpt_logic_config_t cfg;
+    dpt_logic_summary_t sum;
+    dpt_logic_get_config(&cfg);
+    dpt_logic_get_summary(&sum);
+
+    char buf[768];
+    httpd_resp_set_type(req, "application/json");
+    int len = snprintf(buf, sizeof(buf),
+        "{\"enabled\":%s,\"rate_mhz\":%u,\"aux\":[%d,%d,%d,%d,%d,%d],\"skipped\":%" PRIu32 ",\"valid\":%s",
+        cfg.enabled ? "true" : "false", cfg.rate_mhz, cfg.aux_gpio[0], cfg.aux_gpio[1], cfg.aux_gpio[2],
+        cfg.aux_gpio[3], cfg.aux_gpio[4], cfg.aux_gpio[5], sum.skipped, sum.valid ? "true" : "false");
+    if (sum.valid) {
+        len += snprintf(buf + len, sizeof(buf) - len,
+            ",\"shot\":%" PRIu32 ",\"plan_hash\":\"%08" PRIx32 "\",\"plan_is_armed\":%s,\"rate_hz\":%" PRIu32 ","
+            "\"samples\":%" PRIu32 ",\"changes\":%" PRIu32 ",\"stored_bytes\":%" PRIu32 ",\"raw_bytes\":%" PRIu32 ","
+            "\"truncated\":%s,\"overruns\":%" PRIu32 ",\"start_ns\":%" PRIu32 ",\"tolerance_ns\":%" PRIu32 ","
+            "\"match\":%s,\"channels\":[",
+            sum.shot, sum.plan_hash, sum.plan_hash == armed_plan_hash() ? "true" : "false", sum.rate_hz,
+            sum.samples, sum.changes, sum.stored_bytes, sum.samples, sum.truncated ? "true" : "false",
+            sum.overruns, sum.start_ns, sum.tolerance_ns, sum.match ? "true" : "false");
+        for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+            const dpt_logic_channel_t *c = &sum.ch[ch];
+            len += snprintf(buf + len, sizeof(buf) - len,
+                "%s{\"name\":\"%s\",\"plan_edges\":%" PRIu32 ",\"captured_edges\":%" PRIu32 ","
+                "\"max_error_ns\":%" PRId32 ",\"worst_edge\":%" PRIu32 ",\"match\":%s}",
+                ch ? "," : "", ch == DPT_CHANNEL_P ? "P" : "N", c->plan_edges, c->captured_edges,
+                c->max_error_ns, c->worst_edge, c->match ? "true" : "false");
+        }
+        len += snprintf(buf + len, sizeof(buf) - len, "]");
+    }
+    len += snprintf(buf + len, sizeof(buf) - len, "}");
+    httpd_resp_send(req, buf, len);
+    return ESP_OK;
+}
+
+// POST /logic: enable=0|1, rate_mhz=10|20|40, aux=GPIO list for bits 2-7
+// (comma separated, -1 or empty for none). Unset fields keep their values.
+static esp_err_t logic_config_handler(httpd_req_t *req) {
+    char content[128];
+    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
+    if (ret <= 0) {
+        ESP_LOGW(TAG, "Failed to receive request body");
+        return ESP_FAIL;
+    }
+    content[ret] = '\0';
+
+    dpt_logic_config_t cfg;
+    dpt_logic_get_config(&cfg);
+    char param_val[48];
+    if (httpd_query_key_value(content, "enable", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.enabled = atoi(param_val) != 0;
+    }
+    if (httpd_query_key_value(content, "rate_mhz", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.rate_mhz = atoi(param_val);
+    }
+    if (httpd_query_key_value(content, "aux", param_val, sizeof(param_val)) == ESP_OK) {
+        char *p = param_val;
+        for (int i = 0; i < DPT_LOGIC_MAX_AUX; i++) {
+            char *end;
+            long gpio = strtol(p, &end, 10);
+            cfg.aux_gpio[i] = (end != p && gpio >= 0 && gpio < 64) ? gpio : -1;
+            p = (*end == ',') ? end + 1 : end;
+        }
+    }
+
+    esp_err_t err = dpt_logic_configure(&cfg);
+    if (err == ESP_ERR_NOT_SUPPORTED) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_sendstr(req, "No LCD_CAM on this target");
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                            "rate_mhz must be 10, 20 or 40; aux pins must be GPIOs no other function holds");
+        return ESP_FAIL;
+    }
+
+    char response[64];
+    int len = snprintf(response, sizeof(response), "Logic analyzer: %s at %u MHz",
+                       cfg.enabled ? "enabled" : "disabled", cfg.rate_mhz);
+    httpd_resp_send(req, response, len);
+    return ESP_OK;
+}
+static const httpd_uri_t uri_logic = { .uri = "/logic", .method = HTTP_GET, .handler = logic_handler };
+static const httpd_uri_t uri_logic_config = { .uri = "/logic", .method = HTTP_POST, .handler = logic_config_handler };
+
+void http_logic_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_logic);
+    httpd_register_uri_handler(server, &uri_logic_config);
+}
@@ -0,0 +1,229 @@
+/**
+ * @file http_plan.c
+ * @brief GET/POST /plan: the armed plan as an edge list, and plans compiled on the host
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "dpt_plan.h"
+#include "dpt_pool.h"
+#include "dpt_rmt.h"
+#include "dpt_stream.h"
+#include "http_handlers.h"
+
+#define TAG "DPT_HTTP"
+
+// GET /plan[?format=bin] returns the armed plan as a per-channel edge list
+// with absolute tick timestamps, decoded from the loaded item words.
+//
+// JSON: {"hash":"0x..","total_ticks":N,"tick_ns":12.5,"channels":[
+//          {"name":"P","gpio":7,"idle":0,"items":N,"edges":[[tick,level],..]},..]}
+//
+// Binary (little-endian):
+//   header:  "DPTE", u8 version(1), u8 channels, u16 reserved, u32 hash, u32 total_ticks
+//   channel: u16 items, u8 gpio, u8 idle, u32 edge_count, u32 edge[] (tick << 1 | level)
+#define PLAN_EDGE_BATCH 64
+#define PLAN_MAX_EDGES  (2 * DPT_PLAN_MAX_WORDS + 1)    // One per half word, and the return to idle
+
+static const char *const plan_channel_name[DPT_NUM_CHANNELS] = { "P", "N" };
+static const uint8_t plan_channel_gpio[DPT_NUM_CHANNELS] = { RMT_TX_GPIO_P, RMT_TX_GPIO_N };
+
+// Decoded under the plan lock, sent after it is released
+typedef struct {
+    uint32_t hash;
+    uint64_t total_ticks;
+    struct {
+        uint16_t items;
+        uint8_t idle;
+        uint16_t count;
+        uint32_t edge[PLAN_MAX_EDGES];      // tick << 1 | level
+    } ch[DPT_NUM_CHANNELS];
+} plan_edges_t;
+
+// Fits the plan pool class
+_Static_assert(sizeof(plan_edges_t) <= sizeof(dpt_plan_t), "Edge list outgrew a plan block");
+
+static void copy_plan_edges(plan_edges_t *e, const dpt_plan_t *plan) {
+    e->hash = plan->hash;
+    e->total_ticks = dpt_plan_total_ticks(plan);
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        dpt_edge_iter_t it;
+        uint32_t tick;
+        uint8_t level;
+
+        dpt_edge_iter_init(&it, plan, ch);
+        e->ch[ch].items = plan->num_words[ch];
+        e->ch[ch].idle = it.idle_level;
+        e->ch[ch].count = 0;
+        while (e->ch[ch].count < PLAN_MAX_EDGES && dpt_edge_iter_next(&it, &tick, &level)) {
+            e->ch[ch].edge[e->ch[ch].count++] = (tick << 1) | level;
+        }
+    }
+}
+
+static void put_u16(uint8_t *p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void put_u32(uint8_t *p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+
+static esp_err_t send_plan_binary(dpt_stream_t *out, const plan_edges_t *e) {
+    uint8_t buf[PLAN_EDGE_BATCH * 4];
+
+    memcpy(buf, "DPTE", 4);
+    buf[4] = 1;
+    buf[5] = DPT_NUM_CHANNELS;
+    put_u16(&buf[6], 0);
+    put_u32(&buf[8], e->hash);
+    put_u32(&buf[12], (uint32_t)e->total_ticks);
+    dpt_stream_write(out, buf, 16);
+
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        put_u16(&buf[0], e->ch[ch].items);
+        buf[2] = plan_channel_gpio[ch];
+        buf[3] = e->ch[ch].idle;
+        put_u32(&buf[4], e->ch[ch].count);
+        dpt_stream_write(out, buf, 8);
+
+        size_t n = 0;
+        for (int k = 0; k < e->ch[ch].count; k++) {
+            put_u32(&buf[n], e->ch[ch].edge[k]);
+            n += 4;
+            if (n == sizeof(buf)) {
+                dpt_stream_write(out, buf, n);
+                n = 0;
+            }
+        }
+        if (n > 0) {
+            dpt_stream_write(out, buf, n);
+        }
+    }
+    return out->err;
+}
+
+static esp_err_t send_plan_json(dpt_stream_t *out, const plan_edges_t *e) {
+    char buf[PLAN_EDGE_BATCH * 24];
+    int len;
+
+    len = snprintf(buf, sizeof(buf), "{\"hash\":\"0x%08" PRIx32 "\",\"total_ticks\":%" PRIu64 ",\"tick_ns\":12.5,\"channels\":[",
+                   e->hash, e->total_ticks);
+    dpt_stream_write(out, buf, len);
+
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        len = snprintf(buf, sizeof(buf), "%s{\"name\":\"%s\",\"gpio\":%u,\"idle\":%u,\"items\":%u,\"edges\":[",
+                       ch ? "," : "", plan_channel_name[ch], plan_channel_gpio[ch], e->ch[ch].idle,
+                       e->ch[ch].items);
+        for (int k = 0; k < e->ch[ch].count; k++) {
+            uint32_t edge = e->ch[ch].edge[k];
+            len += snprintf(buf + len, sizeof(buf) - len, "%s[%" PRIu32 ",%u]", k ? "," : "",
+                            edge >> 1, (unsigned)(edge & 1));
+            if ((k + 1) % PLAN_EDGE_BATCH == 0) {
+                dpt_stream_write(out, buf, len);
+                len = 0;
+            }
+        }
+        len += snprintf(buf + len, sizeof(buf) - len, "]}");
+        dpt_stream_write(out, buf, len);
+    }
+    return dpt_stream_write(out, "]}", 2);
+}
+
+static esp_err_t plan_handler(httpd_req_t *req) {
+    char query[64];
+    char format[8] = "json";
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        httpd_query_key_value(query, "format", format, sizeof(format));
+    }
+
+    // Copy the edges out and stream the copy: holding the plan lock for
+    // the whole download would hold up shots for as long as the link is slow
+    plan_edges_t *edges;
+    esp_err_t err = dpt_pool_alloc(sizeof(*edges), (void **)&edges);
+    if (err != ESP_OK) {
+        return http_send_pool_error(req, sizeof(*edges), err);
+    }
+    compile_pending();
+    copy_plan_edges(edges, armed_plan_lock());
+    armed_plan_unlock();
+
+    bool binary = strcmp(format, "bin") == 0;
+    dpt_stream_t out;
+    httpd_resp_set_type(req, binary ? "application/octet-stream" : "application/json");
+    dpt_stream_begin(&out, req, DPT_STREAM_PLAN);
+    if (binary) {
+        send_plan_binary(&out, edges);
+    } else {
+        send_plan_json(&out, edges);
+    }
+    dpt_pool_free(edges);
+    return dpt_stream_end(&out);
+}
+
+// POST /plan arms a binary plan compiled on the host (see dpt_plan.h).
+// The body is only validated here - one pass for bounds, CRC and item
+// consistency - then loaded as is. A later /set replaces it again.
+static esp_err_t plan_upload_handler(httpd_req_t *req) {
+    if (req->content_len < DPT_BLOB_SIZE(1, 1) || req->content_len > DPT_BLOB_MAX_SIZE) {
+        ESP_LOGW(TAG, "Rejected plan upload of %zu bytes (max %d)", req->content_len, DPT_BLOB_MAX_SIZE);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Plan size out of range");
+        return ESP_FAIL;
+    }
+
+    uint8_t *blob;
+    esp_err_t err = dpt_pool_alloc(req->content_len, (void **)&blob);
+    if (err != ESP_OK) {
+        return http_send_pool_error(req, req->content_len, err);
+    }
+    size_t received = 0;
+    while (received < req->content_len) {
+        int ret = httpd_req_recv(req, (char *)blob + received, req->content_len - received);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (ret <= 0) {
+            ESP_LOGW(TAG, "Failed to receive plan upload");
+            dpt_pool_free(blob);
+            return ESP_FAIL;
+        }
+        received += ret;
+    }
+
+    compile_pending();      // Else a /set still waiting for its window would replace the upload
+    dpt_plan_t *armed_plan = armed_plan_lock();
+    int64_t t0 = esp_timer_get_time();
+    err = dpt_plan_deserialize(armed_plan, blob, received);
+    int64_t t1 = esp_timer_get_time();
+    if (err == ESP_OK) {
+        armed_plan_set_uploaded();     // Parameters that failed to compile must not replace it later
+        err = dpt_rmt_claim(RMT_CLAIM_TIMEOUT_MS);
+        if (err == ESP_OK) {
+            err = dpt_rmt_load(armed_plan, false);
+            dpt_rmt_release();
+        }
+    }
+    uint32_t hash = armed_plan->hash;
+    uint16_t words = armed_plan->num_words[DPT_CHANNEL_P];
+    armed_plan_unlock();
+    dpt_pool_free(blob);
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Rejected plan upload: %s", esp_err_to_name(err));
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Plan uploaded: %zu bytes, %u words/channel, validated in %" PRId64 " us, hash=0x%08" PRIx32,
+             received, words, t1 - t0, hash);
+
+    char response[32];
+    int len = snprintf(response, sizeof(response), "Plan armed: 0x%08" PRIx32, hash);
+    httpd_resp_send(req, response, len);
+    return ESP_OK;
+}
+
+static const httpd_uri_t uri_plan = { .uri = "/plan", .method = HTTP_GET, .handler = plan_handler };
+static const httpd_uri_t uri_plan_upload = { .uri = "/plan", .method = HTTP_POST, .handler = plan_upload_handler };
+
+void http_plan_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_plan);
+    httpd_register_uri_handler(server, &uri_plan_upload);
+}
@@ -0,0 +1,31 @@
+/**
+ * @file http_pools.c
+ * @brief GET /pools: buffer pool usage per size class
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "dpt_pool.h"
+#include "http_handlers.h"
+
+// GET /pools reports each size class of the buffer pools (src/dpt_pool.h):
+//   [{"block_size":B,"blocks":N,"in_use":U,"peak":P,"allocs":A,"failures":F},..]
+static esp_err_t pools_handler(httpd_req_t *req) {
+    char buf[128];
+    dpt_pool_stats_t stats;
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send_chunk(req, "[", 1);
+    for (int i = 0; dpt_pool_get_stats(i, &stats); i++) {
+        int len = snprintf(buf, sizeof(buf),
+            "%s{\"block_size\":%zu,\"blocks\":%u,\"in_use\":%u,\"peak\":%u,\"allocs\":%" PRIu32 ",\"failures\":%" PRIu32 "}",
+            i ? "," : "", stats.block_size, stats.blocks, stats.in_use, stats.peak, stats.allocs, stats.failures);
+        httpd_resp_send_chunk(req, buf, len);
+    }
+    httpd_resp_send_chunk(req, "]", 1);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+static const httpd_uri_t uri_pools = { .uri = "/pools", .method = HTTP_GET, .handler = pools_handler };
+
+void http_pools_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_pools);
+}
@@ -0,0 +1,94 @@
+/**
+ * @file http_recipes.c
+ * @brief GET/POST /recipes: list and arm the plans baked into flash
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "dpt_baked.h"
+#include "dpt_plan.h"
+#include "dpt_rmt.h"
+#include "http_handlers.h"
+
+#define TAG "DPT_HTTP"
+
+// GET /recipes lists the plans compiled into the image at build time:
+//   [{"name":"spwm_1khz","hash":"0x..","items":N,"total_ticks":T},..]
+static esp_err_t recipes_handler(httpd_req_t *req) {
+    char buf[160];
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send_chunk(req, "[", 1);
+    for (size_t i = 0; i < dpt_baked_count; i++) {
+        const dpt_baked_recipe_t *baked = &dpt_baked_recipes[i];
+        int len = snprintf(buf, sizeof(buf), "%s{\"name\":\"%s\",\"hash\":\"0x%08" PRIx32 "\",\"items\":%u,\"total_ticks\":%" PRIu64 "}",
+                           i ? "," : "", baked->name, baked->plan->hash, baked->plan->num_words[DPT_CHANNEL_P],
+                           dpt_plan_total_ticks(baked->plan));
+        httpd_resp_send_chunk(req, buf, len);
+    }
+    httpd_resp_send_chunk(req, "]", 1);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// POST /recipes arms a baked plan: name=spwm_1khz. The plan is copied from
+// flash as built, so no compile runs. A later /set replaces it again.
+static esp_err_t recipe_arm_handler(httpd_req_t *req) {
+    char content[96];
+    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
+    if (ret <= 0) {
+        ESP_LOGW(TAG, "Failed to receive request body");
+        return ESP_FAIL;
+    }
+    content[ret] = '\0';
+
+    char name[64];
+    const dpt_baked_recipe_t *baked = NULL;
+    if (httpd_query_key_value(content, "name", name, sizeof(name)) == ESP_OK) {
+        baked = dpt_baked_find(name);
+    }
+    if (baked == NULL) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No baked recipe of that name");
+        return ESP_FAIL;
+    }
+    // Flash is not rewritten at runtime, but a bad image must not fire
+    if (dpt_plan_rehash(baked->plan) != baked->plan->hash) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Baked plan does not match its hash");
+        return ESP_FAIL;
+    }
+
+    compile_pending();      // Else a /set still waiting for its window would replace the recipe
+    dpt_plan_t *armed_plan = armed_plan_lock();
+    int64_t t0 = esp_timer_get_time();
+    memcpy(armed_plan, baked->plan, sizeof(*armed_plan));
+    esp_err_t err = dpt_rmt_claim(RMT_CLAIM_TIMEOUT_MS);
+    if (err == ESP_OK) {
+        err = dpt_rmt_load(armed_plan, false);
+        dpt_rmt_release();
+    }
+    int64_t t1 = esp_timer_get_time();
+    if (err == ESP_OK) {
+        armed_plan_set_baked(baked->name);
+    }
+    armed_plan_unlock();
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Baked recipe %s not armed: %s", baked->name, esp_err_to_name(err));
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Baked recipe %s armed in %" PRId64 " us, hash=0x%08" PRIx32, baked->name, t1 - t0, baked->plan->hash);
+
+    char response[96];
+    int len = snprintf(response, sizeof(response), "Plan armed: %s 0x%08" PRIx32, baked->name, baked->plan->hash);
+    httpd_resp_send(req, response, len);
+    return ESP_OK;
+}
+static const httpd_uri_t uri_recipes = { .uri = "/recipes", .method = HTTP_GET, .handler = recipes_handler };
+static const httpd_uri_t uri_recipe_arm = { .uri = "/recipes", .method = HTTP_POST, .handler = recipe_arm_handler };
+
+void http_recipes_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_recipes);
+    httpd_register_uri_handler(server, &uri_recipe_arm);
+}
@@ -0,0 +1,110 @@
+/**
+ * @file http_selftest.c
+ * @brief GET /selftest/pins: no edges on the gate outputs while the RMT is reconfigured
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "dpt_loopback.h"
+#include "dpt_plan.h"
+#include "dpt_rmt.h"
+#include "http_handlers.h"
+
+#define TAG "DPT_HTTP"
+
+// GET /selftest/pins?n=N[&shot=1]: reconfigure the RMT N times while the
+// output pads count their own edges; none may appear. shot=1 then fires
+// the armed plan once to show the counters see real edges - only with
+// the power stage disconnected.
+static esp_err_t pins_selftest_handler(httpd_req_t *req) {
+    char query[32];
+    char param_val[8];
+    uint32_t reconfigs = 10;
+    bool shot = false;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "n", param_val, sizeof(param_val)) == ESP_OK) {
+            reconfigs = strtoul(param_val, NULL, 10);
+        }
+        if (httpd_query_key_value(query, "shot", param_val, sizeof(param_val)) == ESP_OK) {
+            shot = atoi(param_val) != 0;
+        }
+    }
+    if (reconfigs < 1 || reconfigs > 1000) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "n must be 1-1000");
+        return ESP_FAIL;
+    }
+
+    uint32_t idle_edges[DPT_NUM_CHANNELS];
+    uint32_t shot_edges[DPT_NUM_CHANNELS] = { 0 };
+    esp_err_t err = compile_pending();
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Latest parameters do not compile");
+        return ESP_FAIL;
+    }
+    const dpt_plan_t *armed_plan = armed_plan_lock();
+    err = dpt_rmt_claim(RMT_CLAIM_TIMEOUT_MS);
+    if (err != ESP_OK) {
+        armed_plan_unlock();
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    err = dpt_loopback_start();
+    int64_t start_us = esp_timer_get_time();
+    for (uint32_t i = 0; i < reconfigs && err == ESP_OK; i++) {
+        err = dpt_rmt_reconfigure();
+        if (err == ESP_OK) {
+            err = dpt_rmt_load(armed_plan, false);
+        }
+    }
+    int64_t reconfig_us = (esp_timer_get_time() - start_us) / reconfigs;
+    dpt_loopback_read(idle_edges);
+    if (err == ESP_OK && shot) {
+        uint32_t timeout_ms = (uint32_t)(dpt_plan_total_ticks(armed_plan) / (DPT_TICKS_PER_US * 1000)) + 100;
+        err = dpt_rmt_start();
+        if (err == ESP_OK) {
+            err = dpt_rmt_wait_done(timeout_ms);
+        }
+        dpt_loopback_read(shot_edges);
+        for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+            shot_edges[ch] -= idle_edges[ch];
+        }
+    }
+    dpt_loopback_stop();
+    dpt_rmt_release();
+    uint32_t planned_edges[DPT_NUM_CHANNELS];
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        planned_edges[ch] = dpt_plan_count_edges(armed_plan, ch);
+    }
+    armed_plan_unlock();
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Pin self-test failed: %s", esp_err_to_name(err));
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    bool pass = idle_edges[DPT_CHANNEL_P] == 0 && idle_edges[DPT_CHANNEL_N] == 0 &&
+                (!shot || (shot_edges[DPT_CHANNEL_P] > 0 && shot_edges[DPT_CHANNEL_N] > 0));
+    ESP_LOGI(TAG, "Pin self-test: %" PRIu32 " reconfiguration(s), %" PRIu32 "/%" PRIu32 " spurious edge(s) on P/N - %s",
+             reconfigs, idle_edges[DPT_CHANNEL_P], idle_edges[DPT_CHANNEL_N], pass ? "pass" : "FAIL");
+
+    char response[256];
+    int len = snprintf(response, sizeof(response),
+        "{\"reconfigs\":%" PRIu32 ",\"reconfig_us\":%" PRId64 ",\"spurious_edges\":{\"p\":%" PRIu32 ",\"n\":%" PRIu32 "},"
+        "\"shot\":%s,\"shot_edges\":{\"p\":%" PRIu32 ",\"n\":%" PRIu32 "},"
+        "\"planned_edges\":{\"p\":%" PRIu32 ",\"n\":%" PRIu32 "},\"pass\":%s}",
+        reconfigs, reconfig_us, idle_edges[DPT_CHANNEL_P], idle_edges[DPT_CHANNEL_N],
+        shot ? "true" : "false", shot_edges[DPT_CHANNEL_P], shot_edges[DPT_CHANNEL_N],
+        planned_edges[DPT_CHANNEL_P], planned_edges[DPT_CHANNEL_N],
+        pass ? "true" : "false");
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, response, len);
+    return ESP_OK;
+}
+static const httpd_uri_t uri_pins_selftest = { .uri = "/selftest/pins", .method = HTTP_GET, .handler = pins_selftest_handler };
+
+void http_selftest_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_pins_selftest);
+}
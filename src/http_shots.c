@@ -0,0 +1,71 @@
+/**
+ * @file http_shots.c
+ * @brief GET /shots: shot records with the interrupts that ran during each
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "dpt_isrstat.h"
+#include "dpt_pool.h"
+#include "dpt_shotlog.h"
+#include "dpt_stream.h"
+#include "http_handlers.h"
+
+// GET /shots[?n=N] returns the last N shot records (default all kept),
+// newest first, with the interrupts that ran on either core during each:
+//   [{"shot":N,"hash":"0x..","begin_us":T,"start_latency_us":L,"duration_us":D,
+//     "core":C,"completed":true,"isrs":[{"core":C,"cpu_int":I,"sources":"WIFI_MAC",
+//     "count":K,"cycles":Y},..]},..]
+// Shots fired by a batch also have "batch":{"dut":P,"recipe":R,"pass":true}.
+static esp_err_t shots_handler(httpd_req_t *req) {
+    char query[32];
+    char param_val[8];
+    uint32_t limit = DPT_SHOTLOG_DEPTH;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "n", param_val, sizeof(param_val)) == ESP_OK) {
+        limit = strtoul(param_val, NULL, 10);
+    }
+
+    const size_t buf_size = 1024;
+    char *buf;
+    esp_err_t err = dpt_pool_alloc(buf_size, (void **)&buf);
+    if (err != ESP_OK) {
+        return http_send_pool_error(req, buf_size, err);
+    }
+    dpt_stream_t out;
+    httpd_resp_set_type(req, "application/json");
+    dpt_stream_begin(&out, req, DPT_STREAM_SHOTS);
+    dpt_stream_write(&out, "[", 1);
+    dpt_shot_record_t rec;
+    for (uint32_t i = 0; i < limit && out.err == ESP_OK && dpt_shotlog_get(i, &rec); i++) {
+        int len = snprintf(buf, buf_size,
+            "%s{\"shot\":%" PRIu32 ",\"hash\":\"0x%08" PRIx32 "\",\"begin_us\":%" PRId64 ",\"start_latency_us\":%" PRIu32 ","
+            "\"duration_us\":%" PRIu32 ",\"bus_wait_us\":%" PRIu32 ",\"vbus_v\":%.1f,\"core\":%u,\"completed\":%s,",
+            i ? "," : "", rec.shot, rec.hash, rec.begin_us, rec.start_latency_us, rec.duration_us,
+            rec.bus_wait_us, rec.vbus_v, rec.core, rec.completed ? "true" : "false");
+        if (rec.batch_dut >= 0) {
+            len += snprintf(buf + len, buf_size - len, "\"batch\":{\"dut\":%d,\"recipe\":%u,\"pass\":%s},",
+                            rec.batch_dut, rec.batch_recipe, rec.batch_pass ? "true" : "false");
+        }
+        len += snprintf(buf + len, buf_size - len, "\"isrs\":[");
+        for (int k = 0; k < rec.num_isrs; k++) {
+            const dpt_shot_isr_t *isr = &rec.isrs[k];
+            char sources[96];
+            dpt_isrstat_sources(isr->core, isr->cpu_int, sources, sizeof(sources));
+            len += snprintf(buf + len, buf_size - len,
+                            "%s{\"core\":%u,\"cpu_int\":%u,\"sources\":\"%s\",\"count\":%" PRIu32 ",\"cycles\":%" PRIu32 "}",
+                            k ? "," : "", isr->core, isr->cpu_int, sources, isr->count, isr->cycles);
+        }
+        len += snprintf(buf + len, buf_size - len, "]}");
+        dpt_stream_write(&out, buf, len);
+    }
+    dpt_stream_write(&out, "]", 1);
+    dpt_pool_free(buf);
+    return dpt_stream_end(&out);
+}
+static const httpd_uri_t uri_shots = { .uri = "/shots", .method = HTTP_GET, .handler = shots_handler };
+
+void http_shots_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_shots);
+}
@@ -0,0 +1,109 @@
+/**
+ * @file http_sweep.c
+ * @brief GET/POST /sweep: dual-core parameter sweeps
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "dpt_sweep.h"
+#include "http_handlers.h"
+
+#define TAG "DPT_HTTP"
+
+// GET /sweep: progress and pipeline statistics of the running or last sweep
+static esp_err_t sweep_handler(httpd_req_t *req) {
+    dpt_sweep_stats_t st;
+    dpt_sweep_get_stats(&st);
+    float rate = st.elapsed_us > 0 ? st.fired * 1e6f / st.elapsed_us : 0.0f;
+
+    char buf[640];
+    httpd_resp_set_type(req, "application/json");
+    int len = snprintf(buf, sizeof(buf),
+        "{\"running\":%s,\"points\":%u,\"compiled\":%u,\"fired\":%u,\"failed\":%u,\"last_error\":\"%s\","
+        "\"elapsed_us\":%" PRId64 ",\"points_per_s\":%.1f,\"ring_max\":%u,"
+        "\"producer_waits\":%" PRIu32 ",\"executor_waits\":%" PRIu32 ",\"executor_wait_us\":%" PRIu32 ","
+        "\"compile_us\":{\"max\":%" PRIu32 ",\"mean\":%.1f},\"shot_us\":{\"max\":%" PRIu32 ",\"mean\":%.1f},"
+        "\"bus_wait_us\":{\"max\":%" PRIu32 ",\"mean\":%.1f}}",
+        st.running ? "true" : "false", st.points, st.compiled, st.fired, st.failed,
+        st.failed ? esp_err_to_name(st.last_error) : "", st.elapsed_us, rate, st.ring_max,
+        st.producer_waits, st.executor_waits, st.executor_wait_us,
+        st.compile_us_max, st.compiled ? (float)st.compile_us_total / st.compiled : 0.0f,
+        st.shot_us_max, st.fired ? (float)st.shot_us_total / st.fired : 0.0f,
+        st.bus_wait_us_max, st.fired ? (float)st.bus_wait_us_total / st.fired : 0.0f);
+    httpd_resp_send(req, buf, len);
+    return ESP_OK;
+}
+
+// POST /sweep: param=p1h|p1l|p2h|p2l, start=μs, step=μs, points=N,
+// interval_ms=N. The other three parameters keep their /set values.
+// stop=1 ends a running sweep after the shot in progress.
+static esp_err_t sweep_start_handler(httpd_req_t *req) {
+    static const char *const param_names[] = { "p1h", "p1l", "p2h", "p2l" };
+    char content[128];
+    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
+    if (ret <= 0) {
+        ESP_LOGW(TAG, "Failed to receive request body");
+        return ESP_FAIL;
+    }
+    content[ret] = '\0';
+
+    char param_val[16];
+    if (httpd_query_key_value(content, "stop", param_val, sizeof(param_val)) == ESP_OK && atoi(param_val)) {
+        dpt_sweep_stop();
+        httpd_resp_sendstr(req, "Sweep stopping");
+        return ESP_OK;
+    }
+
+    dpt_sweep_config_t cfg = {
+        .param = DPT_SWEEP_P2L + 1,     // Rejected unless param= names one
+    };
+    get_pulse_params(&cfg.p1h, &cfg.p1l, &cfg.p2h, &cfg.p2l);
+    if (httpd_query_key_value(content, "param", param_val, sizeof(param_val)) == ESP_OK) {
+        for (int i = 0; i < 4; i++) {
+            if (strcmp(param_val, param_names[i]) == 0) {
+                cfg.param = i;
+            }
+        }
+    }
+    if (httpd_query_key_value(content, "start", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.start_us = atof(param_val);
+    }
+    if (httpd_query_key_value(content, "step", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.step_us = atof(param_val);
+    }
+    if (httpd_query_key_value(content, "points", param_val, sizeof(param_val)) == ESP_OK) {
+        unsigned long points = strtoul(param_val, NULL, 10);
+        cfg.points = points <= DPT_SWEEP_MAX_POINTS ? points : 0;
+    }
+    if (httpd_query_key_value(content, "interval_ms", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.interval_ms = strtoul(param_val, NULL, 10);
+    }
+
+    esp_err_t err = dpt_sweep_start(&cfg);
+    if (err == ESP_ERR_INVALID_STATE) {
+        httpd_resp_set_status(req, "409 Conflict");
+        httpd_resp_sendstr(req, "A sweep is running");
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                            "Need param=p1h|p1l|p2h|p2l, start, points=1..10000; every point within 0.0125..65535 us");
+        return ESP_FAIL;
+    }
+
+    char response[96];
+    int len = snprintf(response, sizeof(response), "Sweep: %s from %.3f us, step %.3f us, %u point(s)",
+                       param_names[cfg.param], cfg.start_us, cfg.step_us, cfg.points);
+    httpd_resp_send(req, response, len);
+    return ESP_OK;
+}
+static const httpd_uri_t uri_sweep = { .uri = "/sweep", .method = HTTP_GET, .handler = sweep_handler };
+static const httpd_uri_t uri_sweep_start = { .uri = "/sweep", .method = HTTP_POST, .handler = sweep_start_handler };
+
+void http_sweep_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_sweep);
+    httpd_register_uri_handler(server, &uri_sweep_start);
+}
@@ -0,0 +1,123 @@
+/**
+ * @file http_target.c
+ * @brief GET/POST /target: closed-loop load current targeting
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "dpt_target.h"
+#include "http_handlers.h"
+
+#define TAG "DPT_HTTP"
+
+// GET /target: state of the running or last targeting run, one entry per shot
+static esp_err_t target_handler(httpd_req_t *req) {
+    dpt_target_status_t st;
+    dpt_target_get_status(&st);
+
+    char buf[192];
+    httpd_resp_set_type(req, "application/json");
+    int len = snprintf(buf, sizeof(buf),
+        "{\"state\":\"%s\",\"target_a\":%.3f,\"shots\":%u,\"p1h_us\":%.4f,\"peak_a\":%.3f,\"last_error\":\"%s\",\"steps\":[",
+        dpt_target_state_name(st.state), st.target_a, st.shots, st.p1h_us, st.peak_a,
+        st.state == DPT_TARGET_FAILED ? esp_err_to_name(st.last_error) : "");
+    httpd_resp_send_chunk(req, buf, len);
+    for (int k = 0; k < st.shots; k++) {
+        len = snprintf(buf, sizeof(buf), "%s{\"p1h_us\":%.4f,\"peak_a\":%.3f}", k ? "," : "",
+                       st.steps[k].p1h_us, st.steps[k].peak_a);
+        httpd_resp_send_chunk(req, buf, len);
+    }
+    httpd_resp_send_chunk(req, "]}", 2);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// POST /target: target_a=A, tol_a=A, limit_a=A, p1h_min=μs, p1h_max=μs,
+// max_step=fraction per shot, shots=N, interval_ms=N. Starts from the /set
+// first pulse (p1h_max defaults to twice it) and keeps the other three /set
+// values; stop=1 ends a run.
+static esp_err_t target_start_handler(httpd_req_t *req) {
+    char content[192];
+    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
+    if (ret <= 0) {
+        ESP_LOGW(TAG, "Failed to receive request body");
+        return ESP_FAIL;
+    }
+    content[ret] = '\0';
+
+    char param_val[16];
+    if (httpd_query_key_value(content, "stop", param_val, sizeof(param_val)) == ESP_OK && atoi(param_val)) {
+        dpt_target_stop();
+        httpd_resp_sendstr(req, "Targeting stopping");
+        return ESP_OK;
+    }
+
+    dpt_target_config_t cfg = {
+        .p1h_min = 0.1f,
+        .max_step = 0.5f,
+        .max_shots = 8,
+        .interval_ms = 100,
+    };
+    get_pulse_params(&cfg.p1h_start, &cfg.p1l, &cfg.p2h, &cfg.p2l);
+    cfg.p1h_max = fminf(2.0f * cfg.p1h_start, 65535.0f);
+    if (httpd_query_key_value(content, "target_a", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.target_a = atof(param_val);
+    }
+    cfg.tolerance_a = 0.02f * cfg.target_a;
+    cfg.limit_a = 1.2f * cfg.target_a;
+    if (httpd_query_key_value(content, "tol_a", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.tolerance_a = atof(param_val);
+    }
+    if (httpd_query_key_value(content, "limit_a", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.limit_a = atof(param_val);
+    }
+    if (httpd_query_key_value(content, "p1h_min", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.p1h_min = atof(param_val);
+    }
+    if (httpd_query_key_value(content, "p1h_max", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.p1h_max = atof(param_val);
+    }
+    if (httpd_query_key_value(content, "max_step", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.max_step = atof(param_val);
+    }
+    if (httpd_query_key_value(content, "shots", param_val, sizeof(param_val)) == ESP_OK) {
+        unsigned long shots = strtoul(param_val, NULL, 10);
+        cfg.max_shots = shots <= DPT_TARGET_MAX_SHOTS ? shots : 0;
+    }
+    if (httpd_query_key_value(content, "interval_ms", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.interval_ms = strtoul(param_val, NULL, 10);
+    }
+
+    esp_err_t err = dpt_target_start(&cfg);
+    if (err == ESP_ERR_INVALID_STATE) {
+        httpd_resp_set_status(req, "409 Conflict");
+        httpd_resp_sendstr(req, "A targeting run is in progress");
+        return ESP_OK;
+    }
+    if (err == ESP_ERR_NOT_SUPPORTED) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_sendstr(req, "No load current input; configure one with POST /adc");
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                            "Need target_a > 0, tol_a > 0, limit_a > target_a, p1h_min <= /set p1h <= p1h_max, "
+                            "max_step in (0, 1], shots=1..32");
+        return ESP_FAIL;
+    }
+
+    char response[96];
+    int len = snprintf(response, sizeof(response), "Targeting %.2f A from %.3f us, at most %u shot(s)",
+                       cfg.target_a, cfg.p1h_start, cfg.max_shots);
+    httpd_resp_send(req, response, len);
+    return ESP_OK;
+}
+static const httpd_uri_t uri_target = { .uri = "/target", .method = HTTP_GET, .handler = target_handler };
+static const httpd_uri_t uri_target_start = { .uri = "/target", .method = HTTP_POST, .handler = target_start_handler };
+
+void http_target_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_target);
+    httpd_register_uri_handler(server, &uri_target_start);
+}
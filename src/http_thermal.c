@@ -0,0 +1,147 @@
+/**
+ * @file http_thermal.c
+ * @brief GET/POST /thermal: DUT junction temperature models and estimates
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "dpt_thermal.h"
+#include "http_handlers.h"
+
+#define TAG "DPT_HTTP"
+
+// GET /thermal: each DUT's model and junction temperature estimate
+static esp_err_t thermal_handler(httpd_req_t *req) {
+    char buf[512];
+    httpd_resp_set_type(req, "application/json");
+    int len = snprintf(buf, sizeof(buf), "{\"selected\":%d,\"duts\":[", dpt_thermal_selected());
+    httpd_resp_send_chunk(req, buf, len);
+    for (int k = 0; k < DPT_THERMAL_DUTS; k++) {
+        dpt_thermal_config_t cfg;
+        dpt_thermal_status_t st;
+        dpt_thermal_get_config(k, &cfg);
+        dpt_thermal_get_status(k, &st);
+        len = snprintf(buf, sizeof(buf), "%s{\"dut\":%d,\"enabled\":%s,\"stages\":[", k ? "," : "", k,
+                       cfg.enabled ? "true" : "false");
+        for (int i = 0; i < cfg.stages; i++) {
+            len += snprintf(buf + len, sizeof(buf) - len, "%s{\"rth\":%.4f,\"tau_ms\":%.3f}", i ? "," : "",
+                            cfg.stage[i].rth, cfg.stage[i].tau_s * 1e3f);
+        }
+        len += snprintf(buf + len, sizeof(buf) - len,
+            "],\"p_on_w\":%.2f,\"e_on_uj\":%.1f,\"e_off_uj\":%.1f,\"t_case_c\":%.1f,\"limit_c\":%.1f,\"margin_c\":%.1f,"
+            "\"max_wait_ms\":%" PRIu32 ",\"tj_c\":%.2f,\"tj_max_c\":%.2f,\"last_energy_mj\":%.3f,"
+            "\"shots\":%" PRIu32 ",\"throttled\":%" PRIu32 ",\"refused\":%" PRIu32 ","
+            "\"throttle_us\":{\"max\":%" PRIu32 ",\"mean\":%.1f}}",
+            cfg.p_on_w, cfg.e_on_uj, cfg.e_off_uj, cfg.t_case_c, cfg.limit_c, cfg.margin_c, cfg.max_wait_ms,
+            st.tj_c, st.tj_max_c, st.last_energy_mj, st.shots, st.throttled, st.refused,
+            st.throttle_us_max, st.throttled ? (float)st.throttle_us_total / st.throttled : 0.0f);
+        httpd_resp_send_chunk(req, buf, len);
+    }
+    httpd_resp_send_chunk(req, "]}", 2);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// POST /thermal: dut=N (default: the selected one), select=1 makes it the
+// DUT shots heat, enable=0|1, rth=K/W,.. and tau_ms=ms,.. per stage (up to
+// 4), p_on_w=W, e_on_uj=μJ, e_off_uj=μJ, t_case=°C, limit=°C, margin=°C,
+// max_wait_ms=N, reset=1 restarts the estimate at the case temperature
+static esp_err_t thermal_config_handler(httpd_req_t *req) {
+    char content[256];
+    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
+    if (ret <= 0) {
+        ESP_LOGW(TAG, "Failed to receive request body");
+        return ESP_FAIL;
+    }
+    content[ret] = '\0';
+
+    char param_val[64];
+    int dut = dpt_thermal_selected();
+    if (httpd_query_key_value(content, "dut", param_val, sizeof(param_val)) == ESP_OK) {
+        dut = atoi(param_val);
+    }
+    dpt_thermal_config_t cfg;
+    if (dpt_thermal_get_config(dut, &cfg) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "dut must be 0..7");
+        return ESP_FAIL;
+    }
+
+    bool model_changed = false;
+    float values[DPT_THERMAL_STAGES];
+    if (httpd_query_key_value(content, "rth", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.stages = http_parse_floats(param_val, values, DPT_THERMAL_STAGES);
+        for (int i = 0; i < cfg.stages; i++) {
+            cfg.stage[i].rth = values[i];
+        }
+        model_changed = true;
+    }
+    if (httpd_query_key_value(content, "tau_ms", param_val, sizeof(param_val)) == ESP_OK) {
+        int n = http_parse_floats(param_val, values, DPT_THERMAL_STAGES);
+        for (int i = 0; i < n; i++) {
+            cfg.stage[i].tau_s = values[i] * 1e-3f;
+        }
+        cfg.stages = n < cfg.stages ? n : cfg.stages;
+        model_changed = true;
+    }
+    if (httpd_query_key_value(content, "p_on_w", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.p_on_w = atof(param_val);
+        model_changed = true;
+    }
+    if (httpd_query_key_value(content, "e_on_uj", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.e_on_uj = atof(param_val);
+        model_changed = true;
+    }
+    if (httpd_query_key_value(content, "e_off_uj", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.e_off_uj = atof(param_val);
+        model_changed = true;
+    }
+    if (httpd_query_key_value(content, "t_case", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.t_case_c = atof(param_val);
+        model_changed = true;
+    }
+    if (httpd_query_key_value(content, "limit", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.limit_c = atof(param_val);
+        model_changed = true;
+    }
+    if (httpd_query_key_value(content, "margin", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.margin_c = atof(param_val);
+        model_changed = true;
+    }
+    if (httpd_query_key_value(content, "max_wait_ms", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.max_wait_ms = strtoul(param_val, NULL, 10);
+        model_changed = true;
+    }
+    if (httpd_query_key_value(content, "enable", param_val, sizeof(param_val)) == ESP_OK) {
+        cfg.enabled = atoi(param_val) != 0;
+        model_changed = true;
+    }
+
+    // A new model restarts the estimate; only reset=1 does that otherwise
+    if (model_changed && dpt_thermal_configure(dut, &cfg) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                            "Need 1-4 stages with rth > 0 and tau_ms > 0, t_case < limit - margin, "
+                            "non-negative losses, max_wait_ms <= 600000");
+        return ESP_FAIL;
+    }
+    if (httpd_query_key_value(content, "reset", param_val, sizeof(param_val)) == ESP_OK && atoi(param_val)) {
+        dpt_thermal_reset(dut);
+    }
+    if (httpd_query_key_value(content, "select", param_val, sizeof(param_val)) == ESP_OK && atoi(param_val)) {
+        dpt_thermal_select(dut);
+    }
+
+    char response[96];
+    int len = snprintf(response, sizeof(response), "DUT %d thermal model: %s, limit %.1f C%s", dut,
+                       cfg.enabled ? "enabled" : "disabled", cfg.limit_c,
+                       dut == dpt_thermal_selected() ? ", selected" : "");
+    httpd_resp_send(req, response, len);
+    return ESP_OK;
+}
+static const httpd_uri_t uri_thermal = { .uri = "/thermal", .method = HTTP_GET, .handler = thermal_handler };
+static const httpd_uri_t uri_thermal_config = { .uri = "/thermal", .method = HTTP_POST, .handler = thermal_config_handler };
+
+void http_thermal_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_thermal);
+    httpd_register_uri_handler(server, &uri_thermal_config);
+}
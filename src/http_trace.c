@@ -0,0 +1,67 @@
+/**
+ * @file http_trace.c
+ * @brief GET/POST /trace: shot timeline download and capture window
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "dpt_trace.h"
+#include "dpt_stream.h"
+#include "http_handlers.h"
+
+#define TAG "DPT_HTTP"
+
+// GET /trace downloads the last shot's timeline (binary, see dpt_trace.h).
+// POST /trace sets the capture window: enable=0|1, pre_us=N, post_us=N.
+static esp_err_t trace_handler(httpd_req_t *req) {
+    dpt_stream_t out;
+    httpd_resp_set_type(req, "application/octet-stream");
+    dpt_stream_begin(&out, req, DPT_STREAM_TRACE);
+    dpt_trace_dump(dpt_stream_write, &out);
+    return dpt_stream_end(&out);
+}
+
+static esp_err_t trace_config_handler(httpd_req_t *req) {
+    char content[128];
+    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
+    if (ret <= 0) {
+        ESP_LOGW(TAG, "Failed to receive request body");
+        return ESP_FAIL;
+    }
+    content[ret] = '\0';
+
+    bool enabled;
+    uint32_t pre_us, post_us;
+    char param_val[12];
+    dpt_trace_get_config(&enabled, &pre_us, &post_us);
+    if (httpd_query_key_value(content, "enable", param_val, sizeof(param_val)) == ESP_OK) {
+        enabled = atoi(param_val) != 0;
+    }
+    if (httpd_query_key_value(content, "pre_us", param_val, sizeof(param_val)) == ESP_OK) {
+        pre_us = strtoul(param_val, NULL, 10);
+    }
+    if (httpd_query_key_value(content, "post_us", param_val, sizeof(param_val)) == ESP_OK) {
+        post_us = strtoul(param_val, NULL, 10);
+    }
+    if (pre_us > 10000000 || post_us > 10000000) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Window must be at most 10 s");
+        return ESP_FAIL;
+    }
+    dpt_trace_configure(enabled, pre_us, post_us);
+
+    char response[64];
+    int len = snprintf(response, sizeof(response), "Trace %s: pre_us=%" PRIu32 " post_us=%" PRIu32,
+                       enabled ? "on" : "off", pre_us, post_us);
+    httpd_resp_send(req, response, len);
+    return ESP_OK;
+}
+
+static const httpd_uri_t uri_trace = { .uri = "/trace", .method = HTTP_GET, .handler = trace_handler };
+static const httpd_uri_t uri_trace_config = { .uri = "/trace", .method = HTTP_POST, .handler = trace_config_handler };
+
+void http_trace_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_trace);
+    httpd_register_uri_handler(server, &uri_trace_config);
+}
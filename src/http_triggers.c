@@ -0,0 +1,217 @@
+/**
+ * @file http_triggers.c
+ * @brief POST /preset and GET/POST /triggers: preset slots and the trigger inputs that fire them
+ *
+ * POST /preset?id=N stores a plan in preset slot N: the body is a binary
+ * plan like POST /plan, or empty to store the armed plan; &recipe=name
+ * stores a baked plan instead. ?clear=1 empties the slot. Trigger inputs
+ * mapped to the slot fire it from their ISR.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "dpt_baked.h"
+#include "dpt_plan.h"
+#include "dpt_pool.h"
+#include "dpt_preset.h"
+#include "dpt_trigger.h"
+#include "http_handlers.h"
+
+#define TAG "DPT_HTTP"
+
+static esp_err_t preset_handler(httpd_req_t *req) {
+    char query[96];
+    char param_val[8];
+    char recipe_name[64];
+    const dpt_baked_recipe_t *baked = NULL;
+    int id = -1;
+    bool clear = false;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "recipe", recipe_name, sizeof(recipe_name)) == ESP_OK &&
+            (baked = dpt_baked_find(recipe_name)) == NULL) {
+            httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No baked recipe of that name");
+            return ESP_FAIL;
+        }
+        if (httpd_query_key_value(query, "id", param_val, sizeof(param_val)) == ESP_OK) {
+            id = atoi(param_val);
+        }
+        if (httpd_query_key_value(query, "clear", param_val, sizeof(param_val)) == ESP_OK) {
+            clear = atoi(param_val) != 0;
+        }
+    }
+    if (id < 0 || id >= DPT_PRESET_SLOTS) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "id must be 0-3");
+        return ESP_FAIL;
+    }
+    if (clear) {
+        dpt_preset_clear(id);
+        ESP_LOGI(TAG, "Preset %d cleared", id);
+        httpd_resp_sendstr(req, "Preset cleared");
+        return ESP_OK;
+    }
+    if (req->content_len > DPT_BLOB_MAX_SIZE) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Plan size out of range");
+        return ESP_FAIL;
+    }
+
+    // An upload needs the blob and a plan to decode it into, both too
+    // large for the httpd stack
+    uint8_t *blob = NULL;
+    dpt_plan_t *staging = NULL;
+    size_t received = 0;
+    if (req->content_len > 0) {
+        esp_err_t err = dpt_pool_alloc(req->content_len, (void **)&blob);
+        if (err == ESP_OK) {
+            err = dpt_pool_alloc(sizeof(dpt_plan_t), (void **)&staging);
+        }
+        if (err != ESP_OK) {
+            dpt_pool_free(blob);
+            return http_send_pool_error(req, blob ? sizeof(dpt_plan_t) : req->content_len, err);
+        }
+        while (received < req->content_len) {
+            int ret = httpd_req_recv(req, (char *)blob + received, req->content_len - received);
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+                continue;
+            }
+            if (ret <= 0) {
+                ESP_LOGW(TAG, "Failed to receive preset upload");
+                dpt_pool_free(staging);
+                dpt_pool_free(blob);
+                return ESP_FAIL;
+            }
+            received += ret;
+        }
+    }
+
+    // Shots hold the plan mutex while they own the channels, so taking it
+    // first keeps dpt_preset_store() from waiting on a long shot
+    esp_err_t err = baked || blob ? ESP_OK : compile_pending();
+    const dpt_plan_t *armed_plan = armed_plan_lock();
+    const dpt_plan_t *plan = baked ? baked->plan : blob ? staging : armed_plan;
+    if (err == ESP_OK && blob) {
+        err = dpt_plan_deserialize(staging, blob, received);
+    }
+    if (err == ESP_OK) {
+        err = dpt_preset_store(id, plan);
+    }
+    uint32_t hash = plan->hash;
+    armed_plan_unlock();
+    const char *source = baked ? baked->name : blob ? "upload" : "armed plan";
+    dpt_pool_free(staging);
+    dpt_pool_free(blob);
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Rejected preset %d: %s", id, esp_err_to_name(err));
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Preset %d stored: hash=0x%08" PRIx32 " (%s)", id, hash, source);
+
+    char response[40];
+    int len = snprintf(response, sizeof(response), "Preset %d: 0x%08" PRIx32, id, hash);
+    httpd_resp_send(req, response, len);
+    return ESP_OK;
+}
+
+// GET /triggers reports the filter, each input and the preset slots:
+//   {"filter_ns":F,"lockout_us":L,"inputs":[{"gpio":G,"preset":P,"handler":false,
+//    "fires":N,"bounces":B,"busy":Y,"empty":E,"held":H,"hot":T,"last_start_ns":S},..],
+//    "presets":[{"id":0,"hash":"0x.."},null,..]}
+static esp_err_t triggers_handler(httpd_req_t *req) {
+    uint32_t filter_ns, lockout_us;
+    dpt_trigger_get_filter(&filter_ns, &lockout_us);
+
+    char buf[256];
+    httpd_resp_set_type(req, "application/json");
+    int len = snprintf(buf, sizeof(buf), "{\"filter_ns\":%" PRIu32 ",\"lockout_us\":%" PRIu32 ",\"inputs\":[",
+                       filter_ns, lockout_us);
+    httpd_resp_send_chunk(req, buf, len);
+    dpt_trigger_info_t info;
+    for (int i = 0; dpt_trigger_get(i, &info); i++) {
+        len = snprintf(buf, sizeof(buf),
+            "%s{\"gpio\":%d,\"preset\":%d,\"handler\":%s,\"fires\":%" PRIu32 ",\"bounces\":%" PRIu32 ","
+            "\"busy\":%" PRIu32 ",\"empty\":%" PRIu32 ",\"held\":%" PRIu32 ",\"hot\":%" PRIu32 ","
+            "\"last_start_ns\":%" PRIu32 "}",
+            i ? "," : "", info.gpio, info.preset, info.has_handler ? "true" : "false", info.fires, info.bounces,
+            info.busy, info.empty, info.held, info.hot, info.last_start_ns);
+        httpd_resp_send_chunk(req, buf, len);
+    }
+    httpd_resp_send_chunk(req, "],\"presets\":[", 13);
+    for (int id = 0; id < DPT_PRESET_SLOTS; id++) {
+        const dpt_plan_t *plan = dpt_preset_get(id);
+        if (plan) {
+            len = snprintf(buf, sizeof(buf), "%s{\"id\":%d,\"hash\":\"0x%08" PRIx32 "\",\"edges\":{\"p\":%" PRIu32 ",\"n\":%" PRIu32 "}}",
+                           id ? "," : "", id, plan->hash,
+                           dpt_plan_count_edges(plan, DPT_CHANNEL_P), dpt_plan_count_edges(plan, DPT_CHANNEL_N));
+        } else {
+            len = snprintf(buf, sizeof(buf), "%snull", id ? "," : "");
+        }
+        httpd_resp_send_chunk(req, buf, len);
+    }
+    httpd_resp_send_chunk(req, "]}", 2);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// POST /triggers: filter_ns=N, lockout_us=N, and gpioG=P to make the input
+// on GPIO G fire preset P (-1 disconnects it). Nothing changes unless all
+// values are valid.
+static esp_err_t triggers_config_handler(httpd_req_t *req) {
+    char content[128];
+    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
+    if (ret <= 0) {
+        ESP_LOGW(TAG, "Failed to receive request body");
+        return ESP_FAIL;
+    }
+    content[ret] = '\0';
+
+    uint32_t filter_ns, lockout_us;
+    char param_val[12];
+    dpt_trigger_get_filter(&filter_ns, &lockout_us);
+    if (httpd_query_key_value(content, "filter_ns", param_val, sizeof(param_val)) == ESP_OK) {
+        filter_ns = strtoul(param_val, NULL, 10);
+    }
+    if (httpd_query_key_value(content, "lockout_us", param_val, sizeof(param_val)) == ESP_OK) {
+        lockout_us = strtoul(param_val, NULL, 10);
+    }
+    int presets[DPT_TRIGGER_MAX_INPUTS];
+    dpt_trigger_info_t info;
+    for (int i = 0; dpt_trigger_get(i, &info); i++) {
+        char key[12];
+        snprintf(key, sizeof(key), "gpio%d", info.gpio);
+        presets[i] = info.preset;
+        if (httpd_query_key_value(content, key, param_val, sizeof(param_val)) != ESP_OK) {
+            continue;
+        }
+        presets[i] = atoi(param_val);
+        if (info.has_handler || presets[i] < DPT_TRIGGER_NO_PRESET || presets[i] >= DPT_PRESET_SLOTS) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Not a preset input, or preset out of range");
+            return ESP_FAIL;
+        }
+    }
+    if (dpt_trigger_set_filter(filter_ns, lockout_us) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "filter_ns must be at most 12700, lockout_us at most 1000000");
+        return ESP_FAIL;
+    }
+    for (int i = 0; dpt_trigger_get(i, &info); i++) {
+        if (!info.has_handler) {
+            dpt_trigger_map(i, presets[i]);
+        }
+    }
+
+    char response[64];
+    int len = snprintf(response, sizeof(response), "Triggers: filter_ns=%" PRIu32 " lockout_us=%" PRIu32,
+                       filter_ns, lockout_us);
+    httpd_resp_send(req, response, len);
+    return ESP_OK;
+}
+static const httpd_uri_t uri_preset = { .uri = "/preset", .method = HTTP_POST, .handler = preset_handler };
+static const httpd_uri_t uri_triggers = { .uri = "/triggers", .method = HTTP_GET, .handler = triggers_handler };
+static const httpd_uri_t uri_triggers_config = { .uri = "/triggers", .method = HTTP_POST, .handler = triggers_config_handler };
+
+void http_triggers_register(httpd_handle_t server) {
+    httpd_register_uri_handler(server, &uri_preset);
+    httpd_register_uri_handler(server, &uri_triggers);
+    httpd_register_uri_handler(server, &uri_triggers_config);
+}
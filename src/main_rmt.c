@@ -17,18 +17,43 @@
  * - Hardware button trigger support
  */
 
+#include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
-#include "driver/rmt.h"
+#include "freertos/semphr.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "nvs_flash.h"
 #include "esp_netif.h"
 #include "esp_http_server.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "dpt_plan.h"
+#include "dpt_rmt.h"
+#include "dpt_trace.h"
+#include "dpt_isrstat.h"
+#include "dpt_shotlog.h"
+#include "dpt_loopback.h"
+#include "dpt_baked.h"
+#include "dpt_pool.h"
+#include "dpt_trigger.h"
+#include "dpt_stream.h"
+#include "dpt_sweep.h"
+#include "dpt_logic.h"
+#include "dpt_delay.h"
+#include "dpt_adc.h"
+#include "dpt_target.h"
+#include "dpt_interlock.h"
+#include "dpt_thermal.h"
+#include "dpt_batch.h"
+#include "dpt_bench.h"
+#include "dpt_qemu_eth.h"
+#include "http_handlers.h"
 
 #define TAG "DPT_SYSTEM"
 
@@ -39,14 +64,6 @@
 #define WIFI_CHANNEL 1
 #define MAX_STA_CONN 4
 
-// ---------------------- RMT Configuration ----------------------
-// Define two RMT channels
-#define RMT_TX_CHANNEL_P    RMT_CHANNEL_0    // Positive signal channel
-#define RMT_TX_CHANNEL_N    RMT_CHANNEL_1    // Negative signal channel
-#define RMT_TX_GPIO_P       7                // Positive signal GPIO
-#define RMT_TX_GPIO_N       8                // Negative signal GPIO
-#define RMT_CLK_DIV         1               // 80MHz / 1 = 80MHz, 1 tick = 12.5ns
-
 // Double Pulse parameters (default values)
 // Note: Pulse High min 0.025μs, Pulse Low min 0.125μs (25ns resolution) - testing mode
 static float pulse1_high = 5.0f;      // 5μs (minimum 0.025μs)
@@ -54,23 +71,92 @@ static float pulse1_low = 1.0f;       // 1μs (minimum 0.125μs)
 static float pulse2_high = 3.0f;      // 3μs (minimum 0.025μs)
 static float pulse2_low = 10000.0f;   // 10000μs (minimum 0.125μs)
 
+// Carrier on the gate on-time, for pulse-transformer gate drives
+static float carrier_khz = 0.0f;      // 0 = off
+static float carrier_duty = 50.0f;    // Percent of the carrier period high
+static uint8_t carrier_channels = 1 << DPT_CHANNEL_P;   // Bit per channel
+static portMUX_TYPE params_mux = portMUX_INITIALIZER_UNLOCKED;  // /set writes all of the above at once
+
+// /set only stores the parameters; compile_task compiles them once the
+// updates pause for coalesce_ms, so a burst of /set costs one compile.
+// Anything that uses the armed plan calls compile_pending() first.
+#define COALESCE_DEFAULT_MS     50
+#define COALESCE_MAX_MS         1000
+#define COALESCE_MAX_WINDOWS    4       // A steady stream of /set still compiles this often
+
+typedef struct {
+    uint32_t updates;       // /set requests
+    uint32_t compiles;      // Compiles they caused
+    uint32_t merged;        // Updates superseded before they were compiled
+    uint32_t errors;
+    esp_err_t last_error;
+} coalesce_stats_t;
+
+static uint32_t coalesce_ms = COALESCE_DEFAULT_MS;     // 0 = compile inside /set
+static uint32_t pending_updates = 0;                   // Under params_mux
+static coalesce_stats_t coalesce;                      // updates: /set handler; the rest under compile_mutex
+static SemaphoreHandle_t compile_mutex = NULL;
+static SemaphoreHandle_t compile_kick = NULL;
+
+// The armed plan always reflects the current parameters; /set patches it
+// in place so a trigger only has to hand the words to the RMT driver.
+static dpt_plan_t armed_plan;
+static SemaphoreHandle_t plan_mutex = NULL;
+static uint32_t shot_count = 0;
+static const char *plan_source = "params";  // "params" (from /set), "upload" (POST /plan) or "baked"
+static const char *baked_name = "";         // Baked recipe armed with POST /recipes
+
+// Where send_double_pulse() stopped when it did not fire
+typedef enum {
+    SHOT_NOT_COMPILED,      // The last /set did not compile
+    SHOT_RMT_BUSY,          // A triggered shot kept the RMT
+    SHOT_RMT_FAILED,        // The driver refused to load or start the plan
+    SHOT_TX_TIMEOUT,        // Fired, but the RMT never reported TX end
+} shot_failure_t;
+
 // Function declarations
-void send_double_pulse(void);
-static void setup_rmt(void);
+esp_err_t send_double_pulse(const dpt_interlock_wait_t *wait, shot_failure_t *failure);
+static esp_err_t apply_carrier(dpt_recipe_t *recipe, float khz, float duty, uint8_t carrier_ch);
+static esp_err_t update_armed_plan(void);
+static void drop_pending(void);
 
 // ---------------------- Button Interrupt ----------------------
 #define BUTTON_GPIO       0  // Boot button
 
 static QueueHandle_t button_evt_queue = NULL;
 
-static void IRAM_ATTR button_isr_handler(void *arg) {
-    uint32_t gpio_num = (uint32_t)arg;
-    gpio_intr_disable(gpio_num);  // Disable interrupt
+// Called by the trigger input after its filter and lockout accepted a press
+static bool IRAM_ATTR button_isr_handler(int input, void *arg) {
+    uint32_t gpio_num = (uint32_t)(uintptr_t)arg;
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     xQueueSendFromISR(button_evt_queue, &gpio_num, &xHigherPriorityTaskWoken);
-    if (xHigherPriorityTaskWoken) {
-        portYIELD_FROM_ISR();
+    return xHigherPriorityTaskWoken;
+}
+
+// Holds a shot until the bus interlock releases it (with the interlock off,
+// for the fixed second manual shots have always waited), then until the
+// selected DUT's junction estimate leaves room for the armed plan. The
+// shot must not fire unless this returns ESP_OK; wait->result tells
+// whether the bus refused it.
+static esp_err_t wait_before_shot(dpt_interlock_wait_t *wait) {
+    if (dpt_interlock_enabled()) {
+        esp_err_t err = dpt_interlock_wait(wait);
+        if (err != ESP_OK) {
+            return err;
+        }
+    } else {
+        // Not a bus wait: shot records report 0 and no voltage
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        *wait = (dpt_interlock_wait_t){ .result = ESP_OK };
     }
+    // Judge the plan the shot will fire: compile a /set still inside its
+    // coalescing window now. A failure is reported by send_double_pulse()
+    compile_pending();
+    dpt_thermal_load_t load;
+    xSemaphoreTake(plan_mutex, portMAX_DELAY);
+    dpt_thermal_load_of(&armed_plan, &load);
+    xSemaphoreGive(plan_mutex);
+    return dpt_thermal_wait(&load, NULL);
 }
 
 // ---------------------- Task: Handle Button Events ----------------------
@@ -79,14 +165,37 @@ void button_event_task(void *arg) {
     while (1) {
         if (xQueueReceive(button_evt_queue, &io_num, portMAX_DELAY)) {
             ESP_LOGI(TAG, "Button pressed! Triggering DPT...");
-            vTaskDelay(pdMS_TO_TICKS(1000));  // Wait 1 second
-            send_double_pulse();
-            vTaskDelay(pdMS_TO_TICKS(200));  // Prevent bouncing
-            gpio_intr_enable(io_num);  // Re-enable interrupt
+            dpt_trace_arm();
+            dpt_interlock_wait_t wait;
+            if (wait_before_shot(&wait) == ESP_OK) {
+                shot_failure_t failure;
+                esp_err_t err = send_double_pulse(&wait, &failure);
+                if (err != ESP_OK) {
+                    ESP_LOGE(TAG, "Button shot not fired: %s", esp_err_to_name(err));
+                }
+            } else {
+                ESP_LOGE(TAG, "%s; button shot skipped",
+                         wait.result != ESP_OK ? "Bus voltage not ready" : "Junction temperature limit");
+            }
+            // Presses during the wait and the shot do not queue another shot
+            while (xQueueReceive(button_evt_queue, &io_num, 0)) {
+            }
         }
     }
 }
 
+// ---------------------- Trigger Inputs ----------------------
+// Foot switch / PLC inputs, active low; each fires its preset from the ISR
+#define TRIGGER_INPUTS      3
+static const gpio_num_t trigger_gpio[TRIGGER_INPUTS] = { 1, 2, 4 };
+
+static void setup_trigger_inputs(void) {
+    for (int i = 0; i < TRIGGER_INPUTS; i++) {
+        // Input i fires preset i until remapped with POST /triggers
+        ESP_ERROR_CHECK(dpt_trigger_add(trigger_gpio[i], i, NULL));
+    }
+}
+
 // ---------------------- WiFi AP Configuration ----------------------
 void wifi_init_softap(void) {
     ESP_ERROR_CHECK(nvs_flash_init());
@@ -142,9 +251,15 @@ void wifi_init_softap(void) {
 //     return ESP_OK;
 // }
 
+#define PAGE_SIZE   4096
+
 static esp_err_t get_handler(httpd_req_t *req) {
-    char response[4096];  // Increase buffer to 4096 bytes
-    int len = snprintf(response, sizeof(response),
+    char *response;
+    esp_err_t err = dpt_pool_alloc(PAGE_SIZE, (void **)&response);
+    if (err != ESP_OK) {
+        return http_send_pool_error(req, PAGE_SIZE, err);
+    }
+    int len = snprintf(response, PAGE_SIZE,
         "<!DOCTYPE html>"
         "<html lang='en'>"
         "<head>"
@@ -295,12 +410,14 @@ static esp_err_t get_handler(httpd_req_t *req) {
     );
 
     // Check if `snprintf()` exceeds buffer
-    if (len < 0 || len >= sizeof(response)) {
-        ESP_LOGE(TAG, "Response buffer overflow! Length required: %d, Buffer size: %d", len, sizeof(response));
+    if (len < 0 || len >= PAGE_SIZE) {
+        ESP_LOGE(TAG, "Response buffer overflow! Length required: %d, Buffer size: %d", len, PAGE_SIZE);
         httpd_resp_send(req, "Error: Response too long!", HTTPD_RESP_USE_STRLEN);
+        dpt_pool_free(response);
         return ESP_FAIL;
     }
     httpd_resp_send(req, response, HTTPD_RESP_USE_STRLEN);
+    dpt_pool_free(response);
     return ESP_OK;
 }
 
@@ -316,11 +433,15 @@ static esp_err_t set_params_handler(httpd_req_t *req) {
 
     char param_val[20];  // Increased buffer size for float values
     float temp_val;
-    
+    // Parsed into copies, then applied together so the compile task never sees half an update
+    float p1h = pulse1_high, p1l = pulse1_low, p2h = pulse2_high, p2l = pulse2_low;
+    float khz = carrier_khz, duty = carrier_duty;
+    uint8_t carrier_ch = carrier_channels;
+
     if (httpd_query_key_value(content, "p1h", param_val, sizeof(param_val)) == ESP_OK) {
         temp_val = atof(param_val);
         if (temp_val >= 0.025f && temp_val <= 65535.0f) {
-            pulse1_high = temp_val;
+            p1h = temp_val;
         } else {
             ESP_LOGW(TAG, "Invalid p1h value: %f (must be 0.025-65535)", temp_val);
         }
@@ -328,7 +449,7 @@ static esp_err_t set_params_handler(httpd_req_t *req) {
     if (httpd_query_key_value(content, "p1l", param_val, sizeof(param_val)) == ESP_OK) {
         temp_val = atof(param_val);
         if (temp_val >= 0.125f && temp_val <= 65535.0f) {
-            pulse1_low = temp_val;
+            p1l = temp_val;
         } else {
             ESP_LOGW(TAG, "Invalid p1l value: %f (must be 0.125-65535)", temp_val);
         }
@@ -336,7 +457,7 @@ static esp_err_t set_params_handler(httpd_req_t *req) {
     if (httpd_query_key_value(content, "p2h", param_val, sizeof(param_val)) == ESP_OK) {
         temp_val = atof(param_val);
         if (temp_val >= 0.025f && temp_val <= 65535.0f) {
-            pulse2_high = temp_val;
+            p2h = temp_val;
         } else {
             ESP_LOGW(TAG, "Invalid p2h value: %f (must be 0.025-65535)", temp_val);
         }
@@ -344,25 +465,174 @@ static esp_err_t set_params_handler(httpd_req_t *req) {
     if (httpd_query_key_value(content, "p2l", param_val, sizeof(param_val)) == ESP_OK) {
         temp_val = atof(param_val);
         if (temp_val >= 0.125f && temp_val <= 65535.0f) {
-            pulse2_low = temp_val;
+            p2l = temp_val;
         } else {
             ESP_LOGW(TAG, "Invalid p2l value: %f (must be 0.125-65535)", temp_val);
         }
     }
 
+    if (httpd_query_key_value(content, "carrier_khz", param_val, sizeof(param_val)) == ESP_OK) {
+        temp_val = atof(param_val);
+        if (temp_val == 0.0f || (temp_val >= 10.0f && temp_val <= 10000.0f)) {
+            khz = temp_val;
+        } else {
+            ESP_LOGW(TAG, "Invalid carrier_khz value: %f (must be 0 or 10-10000)", temp_val);
+        }
+    }
+    if (httpd_query_key_value(content, "carrier_duty", param_val, sizeof(param_val)) == ESP_OK) {
+        temp_val = atof(param_val);
+        if (temp_val >= 10.0f && temp_val <= 90.0f) {
+            duty = temp_val;
+        } else {
+            ESP_LOGW(TAG, "Invalid carrier_duty value: %f (must be 10-90)", temp_val);
+        }
+    }
+    if (httpd_query_key_value(content, "carrier_ch", param_val, sizeof(param_val)) == ESP_OK) {
+        uint8_t channels = (strchr(param_val, 'p') ? 1 << DPT_CHANNEL_P : 0) | (strchr(param_val, 'n') ? 1 << DPT_CHANNEL_N : 0);
+        if (channels) {
+            carrier_ch = channels;
+        } else {
+            ESP_LOGW(TAG, "Invalid carrier_ch value: %s (must be p, n or pn)", param_val);
+        }
+    }
+
+    uint32_t window_ms = coalesce_ms;
+    if (httpd_query_key_value(content, "coalesce_ms", param_val, sizeof(param_val)) == ESP_OK) {
+        uint32_t ms = strtoul(param_val, NULL, 10);
+        if (ms <= COALESCE_MAX_MS) {
+            window_ms = ms;
+        } else {
+            ESP_LOGW(TAG, "Invalid coalesce_ms value: %" PRIu32 " (must be 0-%d)", ms, COALESCE_MAX_MS);
+        }
+    }
+
+    // The compile may run after the reply, so check now that it will succeed;
+    // nothing changes if it would not
+    dpt_recipe_t *check;
+    esp_err_t err = dpt_pool_alloc(sizeof(*check), (void **)&check);
+    if (err != ESP_OK) {
+        return http_send_pool_error(req, sizeof(*check), err);
+    }
+    dpt_recipe_double_pulse(check, p1h, p1l, p2h, p2l);
+    err = apply_carrier(check, khz, duty, carrier_ch);
+    if (err == ESP_OK) {
+        err = dpt_plan_check(check);
+    }
+    dpt_pool_free(check);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Rejected parameters: %s", esp_err_to_name(err));
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                            err == ESP_ERR_INVALID_SIZE ? "Parameters need more segments or RMT words than a plan holds"
+                                                        : "Parameters do not compile");
+        return ESP_FAIL;
+    }
+
+    coalesce_ms = window_ms;
+    portENTER_CRITICAL(&params_mux);
+    pulse1_high = p1h;
+    pulse1_low = p1l;
+    pulse2_high = p2h;
+    pulse2_low = p2l;
+    carrier_khz = khz;
+    carrier_duty = duty;
+    carrier_channels = carrier_ch;
+    pending_updates++;
+    portEXIT_CRITICAL(&params_mux);
+    coalesce.updates++;
+
     ESP_LOGI(TAG, "Updated parameters: p1h=%.1f, p1l=%.1f, p2h=%.1f, p2l=%.1f", 
-         pulse1_high, pulse1_low, pulse2_high, pulse2_low);
+         p1h, p1l, p2h, p2l);
+    if (coalesce_ms > 0) {
+        xSemaphoreGive(compile_kick);       // compile_task picks it up once the updates pause
+    } else if (compile_pending() != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Plan compile failed");
+        return ESP_FAIL;
+    }
     httpd_resp_send(req, "Parameters Set!", HTTPD_RESP_USE_STRLEN);
     return ESP_OK;
 }
 
 static esp_err_t trigger_handler(httpd_req_t *req) {
-    vTaskDelay(pdMS_TO_TICKS(1000));
-    send_double_pulse();
+    dpt_trace_arm();
+    dpt_interlock_wait_t wait;
+    if (wait_before_shot(&wait) != ESP_OK) {
+        char response[80];
+        int len = wait.result != ESP_OK
+            ? snprintf(response, sizeof(response), "Bus voltage not ready (%.1f V after %" PRIu32 " ms); not triggered",
+                       wait.vbus_v, wait.wait_us / 1000)
+            : snprintf(response, sizeof(response), "DUT %d would pass its junction temperature limit; not triggered",
+                       dpt_thermal_selected());
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_send(req, response, len);
+        return ESP_OK;
+    }
+    shot_failure_t failure;
+    esp_err_t err = send_double_pulse(&wait, &failure);
+    if (err != ESP_OK && failure == SHOT_RMT_BUSY) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_sendstr(req, "RMT busy with a triggered shot; not triggered");
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        char response[80];
+        int len = failure == SHOT_TX_TIMEOUT
+            ? snprintf(response, sizeof(response), "Fired, but the RMT did not report the end of the shot")
+            : failure == SHOT_RMT_FAILED
+            ? snprintf(response, sizeof(response), "RMT refused the plan (%s); not triggered", esp_err_to_name(err))
+            : snprintf(response, sizeof(response), "Latest parameters do not compile (%s); not triggered",
+                       esp_err_to_name(err));
+        // Out of memory for the driver is worth a retry; anything else is not
+        httpd_resp_set_status(req, err == ESP_ERR_NO_MEM ? "503 Service Unavailable" : "500 Internal Server Error");
+        httpd_resp_send(req, response, len);
+        return ESP_OK;
+    }
     httpd_resp_send(req, "Triggered!", HTTPD_RESP_USE_STRLEN);
     return ESP_OK;
 }
 
+// GET /status returns the current parameters and armed plan summary as JSON
+static esp_err_t status_handler(httpd_req_t *req) {
+    char response[896];
+    dpt_rmt_layout_t layout;
+    uint32_t layout_changes;
+    int dut = dpt_thermal_selected();
+    dpt_thermal_config_t thermal_cfg;
+    dpt_thermal_status_t thermal;
+    dpt_thermal_get_config(dut, &thermal_cfg);
+    dpt_thermal_get_status(dut, &thermal);
+
+    xSemaphoreTake(plan_mutex, portMAX_DELAY);
+    dpt_rmt_get_layout(&layout, &layout_changes);
+    int len = snprintf(response, sizeof(response),
+        "{\"p1h\":%.3f,\"p1l\":%.3f,\"p2h\":%.3f,\"p2l\":%.3f,"
+        "\"carrier_khz\":%.3f,\"carrier_duty\":%.1f,\"carrier_ch\":\"%s%s\","
+        "\"source\":\"%s\",\"recipe\":\"%s\",\"hash\":\"0x%08" PRIx32 "\",\"items\":%u,\"total_ticks\":%" PRIu64 ",\"shots\":%" PRIu32 ","
+        "\"coalesce\":{\"window_ms\":%" PRIu32 ",\"updates\":%" PRIu32 ",\"compiles\":%" PRIu32 ",\"merged\":%" PRIu32 ","
+        "\"pending\":%" PRIu32 ",\"errors\":%" PRIu32 ",\"last_error\":\"%s\"},"
+        "\"rmt_layout\":{\"p_channel\":%u,\"p_blocks\":%u,\"n_channel\":%u,\"n_blocks\":%u,\"changes\":%" PRIu32 "},"
+        "\"thermal\":{\"dut\":%d,\"enabled\":%s,\"tj_c\":%.1f,\"limit_c\":%.1f},"
+        "\"uptime_us\":%" PRId64 ",\"free_heap\":%" PRIu32 "}",
+        pulse1_high, pulse1_low, pulse2_high, pulse2_low,
+        carrier_khz, carrier_duty, (carrier_channels & (1 << DPT_CHANNEL_P)) ? "p" : "",
+        (carrier_channels & (1 << DPT_CHANNEL_N)) ? "n" : "", plan_source, baked_name,
+        armed_plan.hash, armed_plan.num_words[DPT_CHANNEL_P], dpt_plan_total_ticks(&armed_plan), shot_count,
+        coalesce_ms, coalesce.updates, coalesce.compiles, coalesce.merged, pending_updates, coalesce.errors,
+        coalesce.errors ? esp_err_to_name(coalesce.last_error) : "",
+        layout.channel[DPT_CHANNEL_P], layout.blocks[DPT_CHANNEL_P],
+        layout.channel[DPT_CHANNEL_N], layout.blocks[DPT_CHANNEL_N], layout_changes,
+        dut, thermal_cfg.enabled ? "true" : "false", thermal.tj_c, thermal_cfg.limit_c,
+        esp_timer_get_time(), esp_get_free_heap_size());
+    xSemaphoreGive(plan_mutex);
+
+    if (len < 0 || len >= sizeof(response)) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Status too long");
+        return ESP_FAIL;
+    }
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, response, len);
+    return ESP_OK;
+}
+
 static esp_err_t favicon_handler(httpd_req_t *req) {
     httpd_resp_send_404(req);
     return ESP_OK;
@@ -377,195 +647,374 @@ httpd_uri_t uri_favicon = {
 httpd_uri_t uri_get = { .uri = "/", .method = HTTP_GET, .handler = get_handler };
 httpd_uri_t uri_set = { .uri = "/set", .method = HTTP_POST, .handler = set_params_handler };
 httpd_uri_t uri_trigger = { .uri = "/trigger", .method = HTTP_GET, .handler = trigger_handler };
+httpd_uri_t uri_status = { .uri = "/status", .method = HTTP_GET, .handler = status_handler };
 
 httpd_handle_t start_webserver(void) {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.max_uri_handlers = 12;   // Maximum number of URI handlers
+    config.max_uri_handlers = 40;   // Maximum number of URI handlers
     config.stack_size = 10240;      // Task stack size
     httpd_handle_t server = NULL;
     if (httpd_start(&server, &config) == ESP_OK) {
         httpd_register_uri_handler(server, &uri_get);
         httpd_register_uri_handler(server, &uri_set);
         httpd_register_uri_handler(server, &uri_trigger);
+        httpd_register_uri_handler(server, &uri_status);
+        http_trace_register(server);
+        http_shots_register(server);
+        http_selftest_register(server);
+        http_triggers_register(server);
+        http_recipes_register(server);
+        http_pools_register(server);
+        http_sweep_register(server);
+        http_downloads_register(server);
+        http_logic_register(server);
+        http_delay_register(server);
+        http_adc_register(server);
+        http_target_register(server);
+        http_interlock_register(server);
+        http_thermal_register(server);
+        http_batch_register(server);
+        http_bench_register(server);
+        http_plan_register(server);
         httpd_register_uri_handler(server, &uri_favicon);
     }
     return server;
 }
 
-// ✅ Add setup_rmt function definition
-static void setup_rmt(void) {
-    // Configure positive channel
-    rmt_config_t rmt_tx_config_p = {
-        .rmt_mode = RMT_MODE_TX,
-        .channel = RMT_TX_CHANNEL_P,
-        .gpio_num = RMT_TX_GPIO_P,
-        .clk_div = RMT_CLK_DIV,
-        .mem_block_num = 1,
-        .tx_config = {
-            .loop_en = false,
-            .carrier_en = false,
-            .idle_output_en = true,
-            .idle_level = RMT_IDLE_LEVEL_LOW,
+// ---------------------- Waveform Plan ----------------------
+// Chop the on-times of the selected channels into carrier cycles that start
+// at each gate edge; nothing to do with the carrier off
+static esp_err_t apply_carrier(dpt_recipe_t *recipe, float khz, float duty, uint8_t carrier_ch) {
+    if (khz <= 0.0f) {
+        return ESP_OK;
+    }
+    uint32_t period = dpt_us_to_ticks(1000.0f / khz);
+    uint32_t high = (uint32_t)(period * duty / 100.0f + 0.5f);
+    if (high < DPT_MIN_TICKS_HIGH) {
+        high = DPT_MIN_TICKS_HIGH;
+    }
+    if (high >= period) {
+        high = period - 1;
+    }
+    for (int ch = 0; ch < DPT_NUM_CHANNELS; ch++) {
+        if (!(carrier_ch & (1 << ch))) {
+            continue;
         }
-    };
+        esp_err_t err = dpt_recipe_apply_carrier(recipe, ch, period, high);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+// Compile or patch the armed plan from the current parameters
+static esp_err_t update_armed_plan(void) {
+    portENTER_CRITICAL(&params_mux);
+    float p1h = pulse1_high, p1l = pulse1_low, p2h = pulse2_high, p2l = pulse2_low;
+    float khz = carrier_khz, duty = carrier_duty;
+    uint8_t carrier_ch = carrier_channels;
+    portEXIT_CRITICAL(&params_mux);
+
+    // Too large for the main, compile and button task stacks; every caller
+    // holds compile_mutex, or is app_main before anything else can compile
+    static dpt_recipe_t recipe;
+    dpt_recipe_double_pulse(&recipe, p1h, p1l, p2h, p2l);
+
+    ESP_LOGI(TAG, "DPT Parameters: p1h=%.1fμs->%" PRIu32 " ticks, p1l=%.1fμs->%" PRIu32 " ticks, p2h=%.1fμs->%" PRIu32 " ticks, p2l=%.1fμs->%" PRIu32 " ticks",
+             p1h, recipe.seg[0].ticks, p1l, recipe.seg[1].ticks,
+             p2h, recipe.seg[2].ticks, p2l, recipe.seg[3].ticks);
+
+    // Log pulse low values for testing purposes (no automatic adjustment)
+    if (recipe.seg[1].ticks < 16) {
+        ESP_LOGI(TAG, "p1l is %" PRIu32 " ticks (%.1fμs) - testing short pulse low", recipe.seg[1].ticks, p1l);
+    }
+    if (recipe.seg[3].ticks < 16) {
+        ESP_LOGI(TAG, "p2l is %" PRIu32 " ticks (%.1fμs) - testing short pulse low", recipe.seg[3].ticks, p2l);
+    }
+
+    esp_err_t err = apply_carrier(&recipe, khz, duty, carrier_ch);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Carrier of %.1f kHz at %.0f%% does not fit: %s", khz, duty, esp_err_to_name(err));
+        return err;
+    }
+    if (khz > 0.0f) {
+        ESP_LOGI(TAG, "Carrier: %.1f kHz at %.0f%%, %u segment(s)", khz, duty, recipe.num_segments);
+    }
 
-    // Configure negative channel
-    rmt_config_t rmt_tx_config_n = {
-        .rmt_mode = RMT_MODE_TX,
-        .channel = RMT_TX_CHANNEL_N,
-        .gpio_num = RMT_TX_GPIO_N,
-        .clk_div = RMT_CLK_DIV,
-        .mem_block_num = 1,
-        .tx_config = {
-            .loop_en = false,
-            .carrier_en = false,
-            .idle_output_en = true,
-            .idle_level = RMT_IDLE_LEVEL_HIGH,  // Set idle level to high for negative channel
+    dpt_patch_stats_t stats;
+    xSemaphoreTake(plan_mutex, portMAX_DELAY);
+    int64_t t0 = esp_timer_get_time();
+    err = dpt_plan_update(&armed_plan, &recipe, &stats);
+    int64_t t1 = esp_timer_get_time();
+    if (err == ESP_OK) {
+        // Arm ahead of the trigger: a patch only copies the words it touched
+        err = dpt_rmt_claim(RMT_CLAIM_TIMEOUT_MS);
+        if (err == ESP_OK) {
+            err = dpt_rmt_load(&armed_plan, !stats.full);
+            dpt_rmt_release();
         }
-    };
+    }
+    int64_t t2 = esp_timer_get_time();
+    if (err == ESP_OK) {
+        plan_source = "params";
+        baked_name = "";
+    }
+    xSemaphoreGive(plan_mutex);
 
-    // Configure both channels
-    ESP_ERROR_CHECK(rmt_config(&rmt_tx_config_p));
-    ESP_ERROR_CHECK(rmt_config(&rmt_tx_config_n));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Plan compile failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    // t1 - t0 includes comparing all segments, not just rewriting the changed ones
+    ESP_LOGI(TAG, "Plan %s: %u of %u segment(s), %u word(s)/channel; diff and write in %" PRId64 " us, loaded in %" PRId64 " us, %u words total, hash=0x%08" PRIx32,
+             stats.full ? "compiled" : "patched", stats.segments_changed, recipe.num_segments, stats.words_patched,
+             t1 - t0, t2 - t1, armed_plan.num_words[DPT_CHANNEL_P], armed_plan.hash);
+    return ESP_OK;
+}
 
-    // Install RMT driver
-    ESP_ERROR_CHECK(rmt_driver_install(RMT_TX_CHANNEL_P, 0, 0));
-    ESP_ERROR_CHECK(rmt_driver_install(RMT_TX_CHANNEL_N, 0, 0));
+// Compiles the parameters if a /set is still waiting for its window. Holding
+// compile_mutex throughout means a caller never fires ahead of a compile
+// that compile_task has already started.
+esp_err_t compile_pending(void) {
+    xSemaphoreTake(compile_mutex, portMAX_DELAY);
+    portENTER_CRITICAL(&params_mux);
+    uint32_t updates = pending_updates;
+    pending_updates = 0;
+    portEXIT_CRITICAL(&params_mux);
+
+    esp_err_t err = ESP_OK;
+    if (updates > 0) {
+        err = update_armed_plan();
+        coalesce.compiles++;
+        coalesce.merged += updates - 1;
+        if (err != ESP_OK) {
+            coalesce.errors++;
+            coalesce.last_error = err;
+            // Still pending: the next caller retries rather than use the old plan
+            portENTER_CRITICAL(&params_mux);
+            pending_updates += updates;
+            portEXIT_CRITICAL(&params_mux);
+        }
+        if (updates > 1) {
+            ESP_LOGI(TAG, "Compiled %" PRIu32 " coalesced parameter update(s)", updates);
+        }
+    }
+    xSemaphoreGive(compile_mutex);
+    return err;
+}
 
-    ESP_LOGI(TAG, "RMT TX channels configured successfully");
+// Another plan was armed in place of the parameters; a /set that did not
+// compile no longer holds up shots
+static void drop_pending(void) {
+    portENTER_CRITICAL(&params_mux);
+    pending_updates = 0;
+    portEXIT_CRITICAL(&params_mux);
 }
 
-// Modified send function with optimized timing control
-void send_double_pulse(void) {
-    // Convert time units to count values (12.5ns per tick)
-    // For 0.1μs = 100ns, we need 100ns / 12.5ns = 8 ticks
-    // Use proper rounding to avoid truncation errors
-    uint32_t p1h = (uint32_t)(pulse1_high * 80.0f + 0.5f);  // Round to nearest tick
-    uint32_t p1l = (uint32_t)(pulse1_low * 80.0f + 0.5f);
-    uint32_t p2h = (uint32_t)(pulse2_high * 80.0f + 0.5f);
-    uint32_t p2l = (uint32_t)(pulse2_low * 80.0f + 0.5f);
-    
-    // Debug: Log the conversion results
-    ESP_LOGI(TAG, "DPT Parameters: p1h=%.1fμs->%lu ticks, p1l=%.1fμs->%lu ticks, p2h=%.1fμs->%lu ticks, p2l=%.1fμs->%lu ticks",
-             pulse1_high, p1h, pulse1_low, p1l, pulse2_high, p2h, pulse2_low, p2l);
-    
-    // Validate tick values (RMT duration field is 16-bit: 1-65535)
-    // Only apply minimum validation to pulse high, allow pulse low to be tested freely
-    const uint32_t MIN_TICKS_HIGH = 2;  // Minimum 2 ticks for pulse high (25ns)
-    
-    if (p1h < MIN_TICKS_HIGH) {
-        ESP_LOGW(TAG, "p1h too small: %lu ticks, setting to minimum %lu", p1h, MIN_TICKS_HIGH);
-        p1h = MIN_TICKS_HIGH;
-    }
-    if (p2h < MIN_TICKS_HIGH) {
-        ESP_LOGW(TAG, "p2h too small: %lu ticks, setting to minimum %lu", p2h, MIN_TICKS_HIGH);
-        p2h = MIN_TICKS_HIGH;
-    }
-    
-    // Log pulse low values for testing purposes (no automatic adjustment)
-    if (p1l < 16) {
-        ESP_LOGI(TAG, "p1l is %lu ticks (%.1fμs) - testing short pulse low", p1l, pulse1_low);
-    }
-    if (p2l < 16) {
-        ESP_LOGI(TAG, "p2l is %lu ticks (%.1fμs) - testing short pulse low", p2l, pulse2_low);
-    }
-    
-    // No automatic adjustment - user wants precise timing
-    
-    if (p1h > 65535) {
-        ESP_LOGW(TAG, "p1h too large: %lu ticks, clamping to 65535", p1h);
-        p1h = 65535;
-    }
-    if (p1l > 65535) {
-        ESP_LOGW(TAG, "p1l too large: %lu ticks, clamping to 65535", p1l);
-        p1l = 65535;
-    }
-    if (p2h > 65535) {
-        ESP_LOGW(TAG, "p2h too large: %lu ticks, clamping to 65535", p2h);
-        p2h = 65535;
-    }
-    if (p2l > 65535) {
-        ESP_LOGW(TAG, "p2l too large: %lu ticks, clamping to 65535", p2l);
-        p2l = 65535;
-    }
-    
-    ESP_LOGI(TAG, "After validation: p1h=%lu, p1l=%lu, p2h=%lu, p2l=%lu ticks", p1h, p1l, p2h, p2l);
-    
-    // Debug: Log the expected waveform sequence
-    ESP_LOGI(TAG, "Expected waveform sequence:");
-    ESP_LOGI(TAG, "  Pulse 1: HIGH for %.1fμs (%lu ticks) -> LOW for %.1fμs (%lu ticks)", 
-             pulse1_high, p1h, pulse1_low, p1l);
-    ESP_LOGI(TAG, "  Pulse 2: HIGH for %.1fμs (%lu ticks) -> LOW for %.1fμs (%lu ticks)", 
-             pulse2_high, p2h, pulse2_low, p2l);
-
-    // Positive signal items - Each item contains two time periods
-    // Item 1: First pulse (high + low)
-    // Item 2: Second pulse (high + low)
-    rmt_item32_t double_pulse_items_p[] = {
-        { .duration0 = p1h, .level0 = 1, .duration1 = p1l, .level1 = 0 },  // First pulse: high then low
-        { .duration0 = p2h, .level0 = 1, .duration1 = p2l, .level1 = 0 }   // Second pulse: high then low
-    };
+void get_pulse_params(float *p1h, float *p1l, float *p2h, float *p2l) {
+    portENTER_CRITICAL(&params_mux);
+    *p1h = pulse1_high;
+    *p1l = pulse1_low;
+    *p2h = pulse2_high;
+    *p2l = pulse2_low;
+    portEXIT_CRITICAL(&params_mux);
+}
 
-    // Negative signal items (inverted levels)
-    rmt_item32_t double_pulse_items_n[] = {
-        { .duration0 = p1h, .level0 = 0, .duration1 = p1l, .level1 = 1 },  // First pulse: low then high
-        { .duration0 = p2h, .level0 = 0, .duration1 = p2l, .level1 = 1 }   // Second pulse: low then high
-    };
+dpt_plan_t *armed_plan_lock(void) {
+    xSemaphoreTake(plan_mutex, portMAX_DELAY);
+    return &armed_plan;
+}
 
-    // Clear previous data and ensure clean state
-    rmt_tx_stop(RMT_TX_CHANNEL_P);
-    rmt_tx_stop(RMT_TX_CHANNEL_N);
-    vTaskDelay(pdMS_TO_TICKS(10));  // Wait for stop to complete
+void armed_plan_unlock(void) {
+    xSemaphoreGive(plan_mutex);
+}
 
-    // Try a different approach: send data directly without separate start
-    ESP_LOGI(TAG, "Sending RMT data directly...");
-    
-    // Send data directly (this should handle start automatically)
-    ESP_ERROR_CHECK(rmt_write_items(RMT_TX_CHANNEL_P, double_pulse_items_p, 2, true)); 
-    ESP_ERROR_CHECK(rmt_write_items(RMT_TX_CHANNEL_N, double_pulse_items_n, 2, true));
+uint32_t armed_plan_hash(void) {
+    return armed_plan.hash;
+}
 
-    // Wait for transmission completion
-    rmt_wait_tx_done(RMT_TX_CHANNEL_P, portMAX_DELAY);
-    rmt_wait_tx_done(RMT_TX_CHANNEL_N, portMAX_DELAY);
+void armed_plan_set_uploaded(void) {
+    plan_source = "upload";
+    baked_name = "";
+    drop_pending();
+}
+
+void armed_plan_set_baked(const char *name) {
+    plan_source = "baked";
+    baked_name = name;
+    drop_pending();
+}
+
+static void compile_task(void *arg) {
+    while (1) {
+        xSemaphoreTake(compile_kick, portMAX_DELAY);
+        // Wait until no /set arrives for a whole window, or COALESCE_MAX_WINDOWS have passed
+        TickType_t window = pdMS_TO_TICKS(coalesce_ms) ? pdMS_TO_TICKS(coalesce_ms) : 1;
+        TickType_t first = xTaskGetTickCount();
+        while (xTaskGetTickCount() - first < window * COALESCE_MAX_WINDOWS &&
+               xSemaphoreTake(compile_kick, window) == pdTRUE) {
+        }
+        compile_pending();
+    }
+}
 
+// Fire the armed plan once. Returns the compile error if the last /set did
+// not compile (the previous plan is not fired in its place), the driver's
+// error if the RMT refused the plan, or ESP_ERR_TIMEOUT if a triggered
+// shot kept the RMT or the RMT never reported the end of the shot;
+// *failure tells which.
+esp_err_t send_double_pulse(const dpt_interlock_wait_t *wait, shot_failure_t *failure) {
+    dpt_trace_mark(DPT_TRACE_MARK_SHOT_BEGIN);
+    // Fire what the last /set asked for, even inside its coalescing window
+    esp_err_t err = compile_pending();
+    if (err != ESP_OK) {
+        dpt_trace_mark(DPT_TRACE_MARK_SHOT_END);
+        ESP_LOGE(TAG, "Latest parameters do not compile (%s); shot refused", esp_err_to_name(err));
+        *failure = SHOT_NOT_COMPILED;
+        return err;
+    }
+    xSemaphoreTake(plan_mutex, portMAX_DELAY);
+    // A shot fired by a trigger input may still be running
+    if (dpt_rmt_claim(RMT_CLAIM_TIMEOUT_MS) != ESP_OK) {
+        xSemaphoreGive(plan_mutex);
+        dpt_trace_mark(DPT_TRACE_MARK_SHOT_END);
+        ESP_LOGE(TAG, "RMT still busy with a triggered shot; shot skipped");
+        *failure = SHOT_RMT_BUSY;
+        return ESP_ERR_TIMEOUT;
+    }
+    dpt_shotlog_begin();
+    dpt_shotlog_bus_wait(wait->wait_us, wait->vbus_v);
+
+    // Debug: Log the expected waveform sequence. Long (carrier) plans only
+    // get the count, since every line costs UART time inside the shot.
+    ESP_LOGI(TAG, "Expected waveform sequence: %u segment(s)", armed_plan.recipe.num_segments);
+    for (uint16_t k = 0; k < armed_plan.recipe.num_segments && armed_plan.recipe.num_segments <= 8; k++) {
+        const dpt_segment_t *seg = &armed_plan.recipe.seg[k];
+        ESP_LOGI(TAG, "  Segment %u: %s for %.3fμs (%" PRIu32 " ticks, %u item half/halves)", k,
+                 seg->level ? "HIGH" : "LOW", seg->ticks / (float)DPT_TICKS_PER_US, seg->ticks,
+                 armed_plan.seg_num_halves[k]);
+    }
+
+    // The plan was loaded when it was compiled; reload only if something replaced it
+    if (!dpt_rmt_is_loaded(armed_plan.hash)) {
+        err = dpt_rmt_load(&armed_plan, false);
+    }
+    dpt_logic_arm();
+    dpt_delay_begin();
+    dpt_adc_peak_begin();
+    if (err == ESP_OK) err = dpt_rmt_start();
+    bool completed = false;
+    if (err == ESP_OK) {
+        dpt_trace_mark(DPT_TRACE_MARK_RMT_START);
+        dpt_shotlog_started();
+
+        // Wait for transmission completion
+        uint32_t timeout_ms = (uint32_t)(dpt_plan_total_ticks(&armed_plan) / (DPT_TICKS_PER_US * 1000)) + 100;
+        completed = dpt_rmt_wait_done(timeout_ms) == ESP_OK;
+        if (!completed) {
+            ESP_LOGE(TAG, "Timed out waiting for RMT transmission");
+        }
+        dpt_trace_mark(DPT_TRACE_MARK_RMT_DONE);
+    } else {
+        ESP_LOGE(TAG, "RMT refused the plan (%s); shot not fired", esp_err_to_name(err));
+    }
+    if (completed) {
+        dpt_delay_end(&armed_plan);
+        dpt_thermal_load_t load;
+        dpt_thermal_load_of(&armed_plan, &load);
+        dpt_thermal_shot(&load);
+    }
+    float peak[DPT_ADC_SIGNALS];
+    if (dpt_adc_peak_end(peak) == ESP_OK) {
+        ESP_LOGI(TAG, "Peak load current %.2f A", peak[DPT_ADC_CURRENT]);
+    }
+
+    shot_count++;
+    dpt_shotlog_end(shot_count, armed_plan.hash, completed);
+    dpt_rmt_release();
+    dpt_logic_finish(&armed_plan, shot_count);
+    xSemaphoreGive(plan_mutex);
+    dpt_trace_mark(DPT_TRACE_MARK_SHOT_END);
+    if (err != ESP_OK) {
+        *failure = SHOT_RMT_FAILED;
+        return err;
+    }
+    if (!completed) {
+        *failure = SHOT_TX_TIMEOUT;
+        return ESP_ERR_TIMEOUT;
+    }
     ESP_LOGI(TAG, "Complementary double pulse sent successfully");
+    return ESP_OK;
 }
 // ---------------------- Button Interrupt Configuration ----------------------
 void setup_button_interrupt(void)
 {
-    gpio_config_t io_conf;
-    memset(&io_conf, 0, sizeof(io_conf));
-    io_conf.intr_type = GPIO_INTR_NEGEDGE;      // Falling edge trigger
-    io_conf.mode = GPIO_MODE_INPUT;
-    io_conf.pin_bit_mask = (1ULL << BUTTON_GPIO);
-    io_conf.pull_up_en = GPIO_PULLUP_ENABLE;
-    io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
-    gpio_config(&io_conf);
-
     // Create queue for passing button interrupt events
     button_evt_queue = xQueueCreate(10, sizeof(uint32_t));
-    // Install GPIO interrupt service
-    gpio_install_isr_service(0);
-    // Add interrupt handler for GPIO0
-    gpio_isr_handler_add(BUTTON_GPIO, button_isr_handler, (void *)BUTTON_GPIO);
+    // The trigger input's glitch filter and lockout replace the old
+    // disable-and-sleep debounce; the ISR only posts the press
+    ESP_ERROR_CHECK(dpt_trigger_add_isr(BUTTON_GPIO, button_isr_handler, (void *)BUTTON_GPIO, NULL));
 
-    ESP_LOGI(TAG, "Button configured on GPIO%d (interrupt mode)", BUTTON_GPIO);
+    ESP_LOGI(TAG, "Button configured on GPIO%d (filtered trigger input)", BUTTON_GPIO);
 }
 
 // ---------------------- Main Task ----------------------
 void app_main(void) {
+    // Gate outputs to their idle levels before anything else; they float
+    // from reset unless the bootloader hook drove them already
+    dpt_rmt_pins_safe();
     ESP_LOGI(TAG, "Starting DPT System...");
+    dpt_pool_init();      // Request buffers come from static pools, not the heap WiFi and lwIP share
+
+    // GPIO interrupts: the output pad edge counters, then the button
+    ESP_ERROR_CHECK(gpio_install_isr_service(0));
+
+    // Configure RMT TX channels, then compile and load the default parameters
+    // before anything can trigger. The pads count their own edges meanwhile.
+    uint32_t setup_edges[DPT_NUM_CHANNELS] = { 0 };
+    bool counting = dpt_loopback_start() == ESP_OK;
+    ESP_ERROR_CHECK(dpt_rmt_init());
+    plan_mutex = xSemaphoreCreateMutex();
+    compile_mutex = xSemaphoreCreateMutex();
+    compile_kick = xSemaphoreCreateBinary();
+    dpt_logic_init();
+    ESP_ERROR_CHECK(update_armed_plan());
+    if (dpt_baked_verify() != ESP_OK) {
+        ESP_LOGE(TAG, "Baked recipes do not match their build-time hashes; arming them will be refused");
+    }
+    if (counting) {
+        dpt_loopback_read(setup_edges);
+        dpt_loopback_stop();
+        if (setup_edges[DPT_CHANNEL_P] || setup_edges[DPT_CHANNEL_N]) {
+            ESP_LOGE(TAG, "Outputs: %" PRIu32 "/%" PRIu32 " edge(s) on P/N during RMT setup", setup_edges[DPT_CHANNEL_P], setup_edges[DPT_CHANNEL_N]);
+        } else {
+            ESP_LOGI(TAG, "Outputs: no edges during RMT setup");
+        }
+    }
 
+#if CONFIG_ETH_USE_OPENETH
+    ESP_ERROR_CHECK(dpt_qemu_eth_init());   // QEMU build: emulated Ethernet instead of the softAP
+#else
     wifi_init_softap();
+#endif
     start_webserver();
 
-    // Configure RMT TX channels
-    setup_rmt();
-
     // Configure button interrupt
     setup_button_interrupt();
+    setup_trigger_inputs();
 
     xTaskCreate(button_event_task, "button_event_task", 4096, NULL, 10, NULL);
+    xTaskCreate(compile_task, "compile_task", 4096, NULL, 5, NULL);
+    ESP_ERROR_CHECK(dpt_thermal_init());
+    ESP_ERROR_CHECK(dpt_sweep_init());
+    ESP_ERROR_CHECK(dpt_adc_init());
+    ESP_ERROR_CHECK(dpt_target_init());
+    ESP_ERROR_CHECK(dpt_batch_init());
+    ESP_ERROR_CHECK(dpt_bench_init());
+
+    // Every driver has its interrupt by now; count them per shot
+    ESP_ERROR_CHECK(dpt_isrstat_init());
 
     while (1) {
         vTaskDelay(pdMS_TO_TICKS(10000));